@@ -10,6 +10,8 @@
 
 #define MODULE main
 #include "module_state_event.h"
+#include "bridge_buf.h"
+#include "bridge_route.h"
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(MODULE);
@@ -28,6 +30,38 @@ uint8_t *usb_update_sn_string_descriptor(void)
 	return usb_serial_str;
 }
 
+#if CONFIG_BRIDGE_STATS_LOG_INTERVAL > 0
+static const char *const ep_names[] = {
+#define X(name) STRINGIFY(name),
+	BRIDGE_EP_LIST
+#undef X
+};
+
+static struct k_delayed_work stats_work;
+
+static void stats_log_handler(struct k_work *work)
+{
+	struct bridge_route_stats stats;
+
+	for (enum bridge_ep src = 0; src < BRIDGE_EP_COUNT; src++) {
+		for (enum bridge_ep dst = 0; dst < BRIDGE_EP_COUNT; dst++) {
+			if (bridge_route_stats_get(src, dst, &stats)) {
+				continue;
+			}
+
+			LOG_INF("%s -> %s: %u bytes sent, %u dropped",
+				ep_names[src], ep_names[dst],
+				stats.tx_bytes, stats.drop_bytes);
+		}
+	}
+
+	LOG_INF("Free buffer blocks: %u", bridge_buf_num_free_get());
+
+	k_delayed_work_submit(&stats_work,
+			      K_SECONDS(CONFIG_BRIDGE_STATS_LOG_INTERVAL));
+}
+#endif
+
 void main(void)
 {
 	if (event_manager_init()) {
@@ -35,4 +69,10 @@ void main(void)
 	} else {
 		module_set_state(MODULE_STATE_READY);
 	}
+
+#if CONFIG_BRIDGE_STATS_LOG_INTERVAL > 0
+	k_delayed_work_init(&stats_work, stats_log_handler);
+	k_delayed_work_submit(&stats_work,
+			      K_SECONDS(CONFIG_BRIDGE_STATS_LOG_INTERVAL));
+#endif
 }
@@ -6,7 +6,6 @@
 
 #include <zephyr.h>
 #include <zephyr/types.h>
-#include <sys/ring_buffer.h>
 
 #include <bluetooth/bluetooth.h>
 #include <bluetooth/uuid.h>
@@ -20,33 +19,21 @@
 #include "ble_ctrl_event.h"
 #include "ble_data_event.h"
 #include "uart_data_event.h"
+#include "bridge_buf.h"
+#include "bridge_route.h"
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(MODULE, CONFIG_BRIDGE_BLE_LOG_LEVEL);
 
-#define BLE_RX_BLOCK_SIZE (CONFIG_BT_L2CAP_TX_MTU - 3)
-#define BLE_RX_BUF_COUNT 4
-#define BLE_SLAB_ALIGNMENT 4
-
-#define BLE_TX_BUF_SIZE (CONFIG_BRIDGE_BUF_SIZE * 2)
-
 #define BLE_AD_IDX_FLAGS 0
 #define BLE_AD_IDX_NAME 1
 
-#define ATT_MIN_PAYLOAD 20 /* Minimum L2CAP MTU minus ATT header */
-
-static void bt_send_work_handler(struct k_work *work);
-
-K_MEM_SLAB_DEFINE(ble_rx_slab, BLE_RX_BLOCK_SIZE, BLE_RX_BUF_COUNT, BLE_SLAB_ALIGNMENT);
-RING_BUF_DECLARE(ble_tx_ring_buf, BLE_TX_BUF_SIZE);
-
-static K_SEM_DEFINE(ble_tx_sem, 0, 1);
-
-static K_WORK_DEFINE(bt_send_work, bt_send_work_handler);
-
 static struct bt_conn *current_conn;
+/* Received data is appended to an open block from the bridge pool. */
+/* Only accessed from the Bluetooth RX thread. */
+static uint8_t *rx_block;
+static size_t rx_offset;
 static struct bt_gatt_exchange_params exchange_params;
-static uint32_t nus_max_send_len;
 static atomic_t ready;
 static atomic_t active;
 
@@ -64,8 +51,8 @@ static const struct bt_data sd[] = {
 static void exchange_func(struct bt_conn *conn, uint8_t err,
 			  struct bt_gatt_exchange_params *params)
 {
-	if (!err) {
-		nus_max_send_len = bt_gatt_nus_max_send(conn);
+	if (err) {
+		LOG_WRN("MTU exchange failed (err %u)", err);
 	}
 }
 
@@ -89,7 +76,10 @@ static void connected(struct bt_conn *conn, uint8_t err)
 		LOG_WRN("bt_gatt_exchange_mtu: %d", err);
 	}
 
-	ring_buf_reset(&ble_tx_ring_buf);
+	err = bt_gatt_nus_stream_start(current_conn);
+	if (err) {
+		LOG_WRN("bt_gatt_nus_stream_start: %d", err);
+	}
 
 	struct peer_conn_event *event = new_peer_conn_event();
 
@@ -108,10 +98,16 @@ static void disconnected(struct bt_conn *conn, uint8_t reason)
 	LOG_INF("Disconnected: %s (reason %u)", log_strdup(addr), reason);
 
 	if (current_conn) {
+		bt_gatt_nus_stream_stop();
 		bt_conn_unref(current_conn);
 		current_conn = NULL;
 	}
 
+	if (rx_block) {
+		bridge_buf_unref(rx_block);
+		rx_block = NULL;
+	}
+
 	struct peer_conn_event *event = new_peer_conn_event();
 
 	event->peer_id = PEER_ID_BLE;
@@ -126,80 +122,55 @@ static struct bt_conn_cb conn_callbacks = {
 	.disconnected = disconnected,
 };
 
-static void bt_send_work_handler(struct k_work *work)
-{
-	uint16_t len;
-	uint8_t *buf;
-	int err;
-	bool notif_disabled = false;
-
-	do {
-		len = ring_buf_get_claim(&ble_tx_ring_buf, &buf, nus_max_send_len);
-
-		err = bt_gatt_nus_send(current_conn, buf, len);
-		if (err == -EINVAL) {
-			notif_disabled = true;
-			len = 0;
-		} else if (err) {
-			len = 0;
-		}
-
-		err = ring_buf_get_finish(&ble_tx_ring_buf, len);
-		if (err) {
-			LOG_ERR("ring_buf_get_finish: %d", err);
-			break;
-		}
-	} while (len != 0 && !ring_buf_is_empty(&ble_tx_ring_buf));
-
-	if (notif_disabled) {
-		/* Peer has not enabled notifications: don't accumulate data */
-		ring_buf_reset(&ble_tx_ring_buf);
-	}
-}
-
 static void bt_receive_cb(struct bt_conn *conn, const uint8_t *const data,
 			  uint16_t len)
 {
-	void *buf;
+	const uint8_t *src = data;
 	uint16_t remainder;
 
 	remainder = len;
 
-	do {
-		uint16_t copy_len;
-		int err;
+	/* The write callback only exposes a data pointer, so received data */
+	/* has to be copied once. Sinks share the block by reference. */
+	while (remainder) {
+		uint8_t *buf;
+		size_t copy_len;
 
-		err = k_mem_slab_alloc(&ble_rx_slab, &buf, K_NO_WAIT);
-		if (err) {
+		if (rx_block && (rx_offset == BRIDGE_BUF_BLOCK_SIZE)) {
+			bridge_buf_unref(rx_block);
+			rx_block = NULL;
+		}
+
+		if (!rx_block) {
+			rx_block = bridge_buf_alloc();
+			rx_offset = 0;
+		}
+
+		if (!rx_block) {
 			LOG_WRN("BLE RX overflow");
 			break;
 		}
 
-		copy_len = remainder > BLE_RX_BLOCK_SIZE ?
-			BLE_RX_BLOCK_SIZE : remainder;
+		buf = &rx_block[rx_offset];
+		copy_len = MIN(remainder, BRIDGE_BUF_BLOCK_SIZE - rx_offset);
+		memcpy(buf, src, copy_len);
+
+		src += copy_len;
 		remainder -= copy_len;
-		memcpy(buf, data, copy_len);
+		rx_offset += copy_len;
+
+		bridge_buf_ref(buf);
 
 		struct ble_data_event *event = new_ble_data_event();
 
 		event->buf = buf;
 		event->len = copy_len;
 		EVENT_SUBMIT(event);
-	} while (remainder);
-}
-
-static void bt_sent_cb(struct bt_conn *conn)
-{
-	if (ring_buf_is_empty(&ble_tx_ring_buf)) {
-		return;
 	}
-
-	k_work_submit(&bt_send_work);
 }
 
 static struct bt_gatt_nus_cb nus_cb = {
 	.received_cb = bt_receive_cb,
-	.sent_cb = bt_sent_cb,
 };
 
 static void adv_start(void)
@@ -288,8 +259,9 @@ static bool event_handler(const struct event_header *eh)
 		const struct uart_data_event *event =
 			cast_uart_data_event(eh);
 
-		/* Only one BLE Service instance, mapped to UART_0 */
-		if (event->dev_idx != 0) {
+		enum bridge_ep src = BRIDGE_EP_UART(event->dev_idx);
+
+		if (!bridge_route_exists(src, BRIDGE_EP_BLE)) {
 			return false;
 		}
 
@@ -297,22 +269,15 @@ static bool event_handler(const struct event_header *eh)
 			return false;
 		}
 
-		uint32_t written = ring_buf_put(
-			&ble_tx_ring_buf,
-			event->buf,
-			event->len);
-		if (written != event->len) {
-			LOG_WRN("UART_%d -> BLE overflow", event->dev_idx);
-		}
+		/* Data is packed into MTU-sized notifications by NUS. */
+		uint32_t written = bt_gatt_nus_stream_write(event->buf,
+							    event->len);
 
-		uint32_t buf_utilization =
-			(ring_buf_capacity_get(&ble_tx_ring_buf) -
-			ring_buf_space_get(&ble_tx_ring_buf));
+		bridge_route_account(src, BRIDGE_EP_BLE,
+				     written, event->len - written);
 
-		/* Simple check to start transmission. */
-		/* If bt_send_work is already running, this has no effect */
-		if (buf_utilization == written) {
-			k_work_submit(&bt_send_work);
+		if (written != event->len) {
+			LOG_WRN("UART_%d -> BLE overflow", event->dev_idx);
 		}
 
 		return false;
@@ -322,8 +287,8 @@ static bool event_handler(const struct event_header *eh)
 		const struct ble_data_event *event =
 			cast_ble_data_event(eh);
 
-		/* All subscribers have gotten a chance to copy data at this point */
-		k_mem_slab_free(&ble_rx_slab, (void **) &event->buf);
+		/* All subscribers have taken their references at this point */
+		bridge_buf_unref(event->buf);
 
 		return false;
 	}
@@ -364,8 +329,6 @@ static bool event_handler(const struct event_header *eh)
 
 			atomic_set(&active, false);
 
-			nus_max_send_len = ATT_MIN_PAYLOAD;
-
 			err = bt_enable(bt_ready);
 			if (err) {
 				LOG_ERR("bt_enable: %d", err);
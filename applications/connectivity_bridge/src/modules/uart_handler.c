@@ -4,8 +4,8 @@
  * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
  */
 
+#include <zephyr.h>
 #include <zephyr/types.h>
-#include <sys/ring_buffer.h>
 #include <drivers/uart.h>
 
 #define MODULE uart_handler
@@ -14,16 +14,14 @@
 #include "ble_data_event.h"
 #include "cdc_data_event.h"
 #include "uart_data_event.h"
+#include "bridge_buf.h"
+#include "bridge_route.h"
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(MODULE, CONFIG_BRIDGE_UART_LOG_LEVEL);
 
-#define UART_BUF_SIZE CONFIG_BRIDGE_BUF_SIZE
-
-#define UART_SLAB_BLOCK_SIZE sizeof(struct uart_rx_buf)
-#define UART_SLAB_BLOCK_COUNT (UART_DEVICE_COUNT * CONFIG_BRIDGE_UART_BUF_COUNT)
-#define UART_SLAB_ALIGNMENT 4
 #define UART_RX_TIMEOUT_MS 1
+#define UART_TX_QUEUE_SIZE 16
 
 #if (defined(CONFIG_DEVICE_POWER_MANAGEMENT) &&\
 	defined(CONFIG_SYS_PM_POLICY_APP))
@@ -44,6 +42,7 @@ enum uart_device_idx {
 };
 
 BUILD_ASSERT(UART_DEVICE_COUNT > 0);
+BUILD_ASSERT(UART_DEVICE_COUNT <= BRIDGE_EP_DEV_COUNT);
 
 /* List of UART device names. "UART_0", "UART_1", etc. */
 static const char *device_names[UART_DEVICE_COUNT] = {
@@ -52,102 +51,51 @@ static const char *device_names[UART_DEVICE_COUNT] = {
 #undef X
 };
 
-struct uart_rx_buf {
-	atomic_t ref_counter;
+struct uart_tx_item {
+	const uint8_t *buf;
 	size_t len;
-	uint8_t buf[UART_BUF_SIZE];
+	enum bridge_ep src;
 };
 
-struct uart_tx_buf {
-	struct ring_buf rb;
-	uint32_t buf[UART_BUF_SIZE];
+/* Each item holds a reference to a bridge buffer block. */
+/* The item at head is being transmitted whenever count is nonzero. */
+struct uart_tx_queue {
+	struct uart_tx_item item[UART_TX_QUEUE_SIZE];
+	uint8_t head;
+	uint8_t count;
 };
 
-BUILD_ASSERT((sizeof(struct uart_rx_buf) % UART_SLAB_ALIGNMENT) == 0);
-
-/* Blocks from the same slab is used for RX for all UART instances */
-/* TX has inidividual ringbuffers per UART instance */
-
-K_MEM_SLAB_DEFINE(uart_rx_slab, UART_SLAB_BLOCK_SIZE, UART_SLAB_BLOCK_COUNT, UART_SLAB_ALIGNMENT);
+/* RX blocks for all UART instances come from the shared bridge pool. */
+/* TX sends straight out of the blocks received from other endpoints. */
 
 static struct device *devices[UART_DEVICE_COUNT];
-static struct uart_tx_buf uart_tx_ringbufs[UART_DEVICE_COUNT];
+static struct uart_tx_queue uart_tx_queues[UART_DEVICE_COUNT];
+static struct k_spinlock uart_tx_lock;
 static uint32_t uart_default_baudrate[UART_DEVICE_COUNT];
 /* UART RX only enabled when there is one or more subscribers (power saving) */
 static int subscriber_count[UART_DEVICE_COUNT];
 static bool enable_rx_retry[UART_DEVICE_COUNT];
-static atomic_t uart_tx_started[UART_DEVICE_COUNT];
 
 static void enable_uart_rx(uint8_t dev_idx);
 static void disable_uart_rx(uint8_t dev_idx);
 static void set_uart_power_state(uint8_t dev_idx, bool active);
-static int uart_tx_start(uint8_t dev_idx);
-static void uart_tx_finish(uint8_t dev_idx, size_t len);
-
-static inline struct uart_rx_buf *block_start_get(uint8_t *buf)
-{
-	size_t block_num;
-
-	/* blocks are fixed size units from a continuous memory slab: */
-	/* round down to the closest unit size to find beginning of block. */
-
-	block_num =
-		(((size_t)buf - (size_t)uart_rx_slab.buffer) / UART_SLAB_BLOCK_SIZE);
-
-	return (struct uart_rx_buf *) &uart_rx_slab.buffer[block_num * UART_SLAB_BLOCK_SIZE];
-}
-
-static struct uart_rx_buf *uart_rx_buf_alloc(void)
-{
-	struct uart_rx_buf *buf;
-	int err;
-
-	/* Async UART driver returns pointers to received data as */
-	/* offsets from beginning of RX buffer block. */
-	/* This code uses a reference counter to keep track of the number of */
-	/* references within a single RX buffer block */
-
-	err = k_mem_slab_alloc(&uart_rx_slab, (void **) &buf, K_NO_WAIT);
-	if (err) {
-		return NULL;
-	}
-
-	atomic_set(&buf->ref_counter, 1);
-
-	return buf;
-}
-
-static void uart_rx_buf_ref(void *buf)
-{
-	__ASSERT_NO_MSG(buf);
-
-	atomic_inc(&(block_start_get(buf)->ref_counter));
-}
-
-static void uart_rx_buf_unref(void *buf)
-{
-	__ASSERT_NO_MSG(buf);
-
-	struct uart_rx_buf *uart_buf = block_start_get(buf);
-	atomic_t ref_counter = atomic_dec(&uart_buf->ref_counter);
-
-	/* ref_counter is the uart_buf->ref_counter value prior to decrement */
-	if (ref_counter == 1) {
-		k_mem_slab_free(&uart_rx_slab, (void **)&uart_buf);
-	}
-}
+static void uart_tx_done(uint8_t dev_idx, size_t len);
+static void uart_tx_flush(uint8_t dev_idx);
 
 static void uart_callback(struct device *dev, struct uart_event *evt,
 			  void *user_data)
 {
 	int dev_idx = (int) user_data;
 	struct uart_data_event *event;
-	struct uart_rx_buf *buf;
+	uint8_t *buf;
 	int err;
 
 	switch (evt->type) {
 	case UART_RX_RDY:
-		uart_rx_buf_ref(evt->data.rx.buf);
+		/* Async UART driver returns pointers to received data as */
+		/* offsets from beginning of RX buffer block. */
+		/* Each event holds its own reference to the block. */
+		bridge_buf_ref(evt->data.rx.buf);
 
 		event = new_uart_data_event();
 		event->dev_idx = dev_idx;
@@ -157,20 +105,20 @@ static void uart_callback(struct device *dev, struct uart_event *evt,
 		break;
 	case UART_RX_BUF_RELEASED:
 		if (evt->data.rx_buf.buf) {
-			uart_rx_buf_unref(evt->data.rx_buf.buf);
+			bridge_buf_unref(evt->data.rx_buf.buf);
 		}
 		break;
 	case UART_RX_BUF_REQUEST:
-		buf = uart_rx_buf_alloc();
+		buf = bridge_buf_alloc();
 		if (buf == NULL) {
 			LOG_WRN("UART_%d RX overflow", dev_idx);
 			break;
 		}
 
-		err = uart_rx_buf_rsp(dev, buf->buf, sizeof(buf->buf));
+		err = uart_rx_buf_rsp(dev, buf, BRIDGE_BUF_BLOCK_SIZE);
 		if (err) {
 			LOG_ERR("uart_rx_buf_rsp: %d", err);
-			uart_rx_buf_unref(buf);
+			bridge_buf_unref(buf);
 		}
 		break;
 	case UART_RX_DISABLED:
@@ -182,17 +130,10 @@ static void uart_callback(struct device *dev, struct uart_event *evt,
 		}
 		break;
 	case UART_TX_DONE:
-		uart_tx_finish(dev_idx, evt->data.tx.len);
-
-		if (ring_buf_is_empty(&uart_tx_ringbufs[dev_idx].rb)) {
-			atomic_set(&uart_tx_started[dev_idx], false);
-		} else {
-			uart_tx_start(dev_idx);
-		}
+		uart_tx_done(dev_idx, evt->data.tx.len);
 		break;
 	case UART_TX_ABORTED:
-		uart_tx_finish(dev_idx, evt->data.tx.len);
-		atomic_set(&uart_tx_started[dev_idx], false);
+		uart_tx_flush(dev_idx);
 		break;
 	case UART_RX_STOPPED:
 		LOG_WRN("UART_%d stop reason %d", dev_idx, evt->data.rx_stop.reason);
@@ -275,7 +216,7 @@ static void enable_uart_rx(uint8_t dev_idx)
 {
 	struct device *dev = devices[dev_idx];
 	int err;
-	struct uart_rx_buf *buf;
+	uint8_t *buf;
 
 	err = uart_callback_set(dev, uart_callback, (void *) (int) dev_idx);
 	if (err) {
@@ -283,15 +224,15 @@ static void enable_uart_rx(uint8_t dev_idx)
 		return;
 	}
 
-	buf = uart_rx_buf_alloc();
+	buf = bridge_buf_alloc();
 	if (!buf) {
-		LOG_ERR("uart_rx_buf_alloc error");
+		LOG_ERR("bridge_buf_alloc error");
 		return;
 	}
 
-	err = uart_rx_enable(dev, buf->buf, sizeof(buf->buf), UART_RX_TIMEOUT_MS);
+	err = uart_rx_enable(dev, buf, BRIDGE_BUF_BLOCK_SIZE, UART_RX_TIMEOUT_MS);
 	if (err) {
-		uart_rx_buf_unref(buf);
+		bridge_buf_unref(buf);
 		LOG_ERR("uart_rx_enable: %d", err);
 		return;
 	}
@@ -309,66 +250,144 @@ static void disable_uart_rx(uint8_t dev_idx)
 	}
 }
 
-static int uart_tx_start(uint8_t dev_idx)
+static int uart_tx_start(uint8_t dev_idx, const struct uart_tx_item *item)
 {
-	int len;
 	int err;
-	uint8_t *buf;
-
-	len = ring_buf_get_claim(
-			&uart_tx_ringbufs[dev_idx].rb,
-			&buf,
-			sizeof(uart_tx_ringbufs[dev_idx].buf));
 
-	err = uart_tx(devices[dev_idx], buf, len, 0);
+	err = uart_tx(devices[dev_idx], item->buf, item->len, 0);
 	if (err) {
 		LOG_ERR("uart_tx: %d", err);
-		uart_tx_finish(dev_idx, 0);
+		uart_tx_flush(dev_idx);
 		return err;
 	}
 
 	return 0;
 }
 
-static void uart_tx_finish(uint8_t dev_idx, size_t len)
+static void uart_tx_done(uint8_t dev_idx, size_t len)
 {
-	int err;
+	struct uart_tx_queue *queue = &uart_tx_queues[dev_idx];
+	struct uart_tx_item *item;
+	struct uart_tx_item next;
+	k_spinlock_key_t key;
+	bool pending;
+
+	key = k_spin_lock(&uart_tx_lock);
+
+	__ASSERT_NO_MSG(queue->count > 0);
+	item = &queue->item[queue->head];
+	bridge_route_account(item->src, BRIDGE_EP_UART(dev_idx),
+			     len, item->len - len);
+	bridge_buf_unref(item->buf);
+
+	queue->head = (queue->head + 1) % UART_TX_QUEUE_SIZE;
+	queue->count--;
+
+	pending = (queue->count > 0);
+	if (pending) {
+		next = queue->item[queue->head];
+	}
 
-	err = ring_buf_get_finish(&uart_tx_ringbufs[dev_idx].rb, len);
-	if (err) {
-		LOG_ERR("ring_buf_get_finish: %d", err);
+	k_spin_unlock(&uart_tx_lock, key);
+
+	if (pending) {
+		uart_tx_start(dev_idx, &next);
 	}
 }
 
-static int uart_tx_enqueue(uint8_t *data, size_t data_len, uint8_t dev_idx)
+static void uart_tx_flush(uint8_t dev_idx)
 {
-	atomic_t started;
-	uint32_t written;
-	int err;
+	struct uart_tx_queue *queue = &uart_tx_queues[dev_idx];
+	k_spinlock_key_t key;
 
-	written = ring_buf_put(&uart_tx_ringbufs[dev_idx].rb, data, data_len);
-	if (written == 0) {
-		return -ENOMEM;
+	key = k_spin_lock(&uart_tx_lock);
+
+	while (queue->count > 0) {
+		struct uart_tx_item *item = &queue->item[queue->head];
+
+		bridge_route_account(item->src, BRIDGE_EP_UART(dev_idx),
+				     0, item->len);
+		bridge_buf_unref(item->buf);
+
+		queue->head = (queue->head + 1) % UART_TX_QUEUE_SIZE;
+		queue->count--;
 	}
 
-	started = atomic_set(&uart_tx_started[dev_idx], true);
-	if (!started) {
-		err = uart_tx_start(dev_idx);
-		if (err) {
-			LOG_ERR("uart_tx_start: %d", err);
-			atomic_set(&uart_tx_started[dev_idx], false);
+	k_spin_unlock(&uart_tx_lock, key);
+}
+
+static int uart_tx_enqueue(const uint8_t *data, size_t data_len,
+			   enum bridge_ep src, uint8_t dev_idx)
+{
+	struct uart_tx_queue *queue = &uart_tx_queues[dev_idx];
+	struct uart_tx_item *item;
+	k_spinlock_key_t key;
+	bool start;
+
+	key = k_spin_lock(&uart_tx_lock);
+
+	if (queue->count > 1) {
+		item = &queue->item[(queue->head + queue->count - 1) %
+				    UART_TX_QUEUE_SIZE];
+
+		/* Data following the tail in the same block is merged into
+		 * the tail, which already holds a reference to the block.
+		 * The head is in flight and must not be modified.
+		 */
+		if ((item->buf + item->len == data) && (item->src == src)) {
+			item->len += data_len;
+			k_spin_unlock(&uart_tx_lock, key);
+			return 0;
 		}
 	}
 
-	if (written == data_len) {
-		return 0;
-	} else {
+	if (queue->count == UART_TX_QUEUE_SIZE) {
+		k_spin_unlock(&uart_tx_lock, key);
+		bridge_route_account(src, BRIDGE_EP_UART(dev_idx), 0, data_len);
 		return -ENOMEM;
 	}
 
+	item = &queue->item[(queue->head + queue->count) % UART_TX_QUEUE_SIZE];
+	item->buf = data;
+	item->len = data_len;
+	item->src = src;
+	bridge_buf_ref(data);
+
+	start = (queue->count == 0);
+	queue->count++;
+
+	k_spin_unlock(&uart_tx_lock, key);
+
+	if (start) {
+		/* Nothing was in flight, so the item cannot change under us */
+		return uart_tx_start(dev_idx, item);
+	}
+
 	return 0;
 }
 
+static void uart_forward(enum bridge_ep src, const uint8_t *buf, size_t len)
+{
+	int err;
+
+	for (uint8_t i = 0; i < UART_DEVICE_COUNT; ++i) {
+		if (!bridge_route_exists(src, BRIDGE_EP_UART(i))) {
+			continue;
+		}
+
+		if (!devices[i]) {
+			continue;
+		}
+
+		err = uart_tx_enqueue(buf, len, src, i);
+		if (err == -ENOMEM) {
+			LOG_WRN("EP_%d->UART_%d overflow", src, i);
+		} else if (err) {
+			LOG_ERR("uart_tx_enqueue: %d", err);
+		}
+	}
+}
+
 static bool event_handler(const struct event_header *eh)
 {
 	int err;
@@ -377,8 +396,8 @@ static bool event_handler(const struct event_header *eh)
 		const struct uart_data_event *event =
 			cast_uart_data_event(eh);
 
-		/* All subscribers have gotten a chance to copy data at this point */
-		uart_rx_buf_unref(event->buf);
+		/* All subscribers have taken their references at this point */
+		bridge_buf_unref(event->buf);
 
 		return true;
 	}
@@ -387,22 +406,8 @@ static bool event_handler(const struct event_header *eh)
 		const struct cdc_data_event *event =
 			cast_cdc_data_event(eh);
 
-		if (event->dev_idx >= UART_DEVICE_COUNT) {
-			return false;
-		}
-
-		if (!devices[event->dev_idx]) {
-			return false;
-		}
-
-		err = uart_tx_enqueue(event->buf, event->len, event->dev_idx);
-		if (err == -ENOMEM) {
-			LOG_WRN("CDC_%d->UART_%d overflow",
-				event->dev_idx,
-				event->dev_idx);
-		} else if (err) {
-			LOG_ERR("uart_tx_enqueue: %d", err);
-		}
+		uart_forward(BRIDGE_EP_CDC(event->dev_idx),
+			     event->buf, event->len);
 
 		return false;
 	}
@@ -410,19 +415,8 @@ static bool event_handler(const struct event_header *eh)
 	if (is_ble_data_event(eh)) {
 		const struct ble_data_event *event =
 			cast_ble_data_event(eh);
-		/* Only one BLE Service instance: always map to UART_0 */
-		uint8_t dev_idx = 0;
 
-		if (!devices[dev_idx]) {
-			return false;
-		}
-
-		err = uart_tx_enqueue(event->buf, event->len, dev_idx);
-		if (err == -ENOMEM) {
-			LOG_WRN("BLE->UART_%d overflow", dev_idx);
-		} else if (err) {
-			LOG_ERR("uart_tx_enqueue: %d", err);
-		}
+		uart_forward(BRIDGE_EP_BLE, event->buf, event->len);
 
 		return false;
 	}
@@ -493,13 +487,6 @@ static bool event_handler(const struct event_header *eh)
 				subscriber_count[i] = 0;
 				enable_rx_retry[i] = false;
 
-				atomic_set(&uart_tx_started[i], false);
-
-				ring_buf_init(
-					&uart_tx_ringbufs[i].rb,
-					sizeof(uart_tx_ringbufs[i].buf),
-					uart_tx_ringbufs[i].buf);
-
 				if (UART_SET_PM_STATE) {
 					set_uart_power_state(i, false);
 				}
@@ -13,6 +13,8 @@
 #include "peer_conn_event.h"
 #include "cdc_data_event.h"
 #include "uart_data_event.h"
+#include "bridge_buf.h"
+#include "bridge_route.h"
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(MODULE, CONFIG_BRIDGE_CDC_LOG_LEVEL);
@@ -21,20 +23,23 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_BRIDGE_CDC_LOG_LEVEL);
 #define CDC_DEVICE_NAME_TEMPLATE CONFIG_USB_CDC_ACM_DEVICE_NAME "_%d"
 
 #define USB_CDC_DTR_POLL_MS 500
-#define USB_CDC_RX_BLOCK_SIZE CONFIG_BRIDGE_BUF_SIZE
-#define USB_CDC_RX_BLOCK_COUNT (CDC_DEVICE_COUNT * 3)
-#define USB_CDC_SLAB_ALIGNMENT 4
+/* Smallest chunk worth reading into an open RX block (one FS bulk packet) */
+#define USB_CDC_RX_CHUNK_MIN 64
+
+BUILD_ASSERT(CDC_DEVICE_COUNT <= BRIDGE_EP_DEV_COUNT);
 
 static void cdc_dtr_timer_handler(struct k_timer *timer);
 static void cdc_dtr_work_handler(struct k_work *work);
 
 static K_TIMER_DEFINE(cdc_dtr_timer, cdc_dtr_timer_handler, NULL);
 static K_WORK_DEFINE(cdc_dtr_work, cdc_dtr_work_handler);
-/* Incoming data from any CDC instance is copied into a block from this slab */
-K_MEM_SLAB_DEFINE(cdc_rx_slab, USB_CDC_RX_BLOCK_SIZE, USB_CDC_RX_BLOCK_COUNT, USB_CDC_SLAB_ALIGNMENT);
 
 static struct device *devices[CDC_DEVICE_COUNT];
 static uint32_t cdc_ready[CDC_DEVICE_COUNT];
+/* Incoming data is appended to an open block from the bridge pool. */
+/* Each data event holds its own reference to the block. */
+static uint8_t *rx_block[CDC_DEVICE_COUNT];
+static size_t rx_offset[CDC_DEVICE_COUNT];
 
 static uint8_t overflow_buf[64];
 
@@ -94,8 +99,7 @@ static void cdc_uart_interrupt_handler(struct device *dev, void *user_data)
 	uart_irq_update(dev);
 
 	while (uart_irq_rx_ready(dev)) {
-		void *rx_buf;
-		int err;
+		uint8_t *rx_buf;
 		int data_length;
 
 		if (cdc_ready[dev_idx] == 0) {
@@ -103,29 +107,42 @@ static void cdc_uart_interrupt_handler(struct device *dev, void *user_data)
 			poll_dtr();
 		}
 
-		err = k_mem_slab_alloc(&cdc_rx_slab, &rx_buf, K_NO_WAIT);
-		if (err) {
+		if (rx_block[dev_idx] &&
+		    (BRIDGE_BUF_BLOCK_SIZE - rx_offset[dev_idx] < USB_CDC_RX_CHUNK_MIN)) {
+			bridge_buf_unref(rx_block[dev_idx]);
+			rx_block[dev_idx] = NULL;
+		}
+
+		if (!rx_block[dev_idx]) {
+			rx_block[dev_idx] = bridge_buf_alloc();
+			rx_offset[dev_idx] = 0;
+		}
+
+		if (!rx_block[dev_idx]) {
 			data_length = uart_fifo_read(
 				dev,
 				overflow_buf,
 				sizeof(overflow_buf));
 			LOG_WRN("CDC_%d RX overflow", dev_idx);
-		} else {
-			data_length = uart_fifo_read(
-				dev,
-				rx_buf,
-				USB_CDC_RX_BLOCK_SIZE);
-
-			if (data_length) {
-				struct cdc_data_event *event = new_cdc_data_event();
-
-				event->dev_idx = dev_idx;
-				event->buf = rx_buf;
-				event->len = data_length;
-				EVENT_SUBMIT(event);
-			} else {
-				k_mem_slab_free(&cdc_rx_slab, &rx_buf);
-			}
+			continue;
+		}
+
+		rx_buf = &rx_block[dev_idx][rx_offset[dev_idx]];
+		data_length = uart_fifo_read(
+			dev,
+			rx_buf,
+			BRIDGE_BUF_BLOCK_SIZE - rx_offset[dev_idx]);
+
+		if (data_length) {
+			struct cdc_data_event *event = new_cdc_data_event();
+
+			rx_offset[dev_idx] += data_length;
+			bridge_buf_ref(rx_buf);
+
+			event->dev_idx = dev_idx;
+			event->buf = rx_buf;
+			event->len = data_length;
+			EVENT_SUBMIT(event);
 		}
 	}
 }
@@ -175,25 +192,34 @@ static bool event_handler(const struct event_header *eh)
 	if (is_uart_data_event(eh)) {
 		const struct uart_data_event *event =
 			cast_uart_data_event(eh);
-		int tx_written;
+		enum bridge_ep src = BRIDGE_EP_UART(event->dev_idx);
 
-		if (event->dev_idx >= CDC_DEVICE_COUNT) {
-			return false;
-		}
+		for (int i = 0; i < CDC_DEVICE_COUNT; ++i) {
+			int tx_written;
 
-		if (cdc_ready[event->dev_idx] == 0) {
-			return false;
-		}
+			if (!bridge_route_exists(src, BRIDGE_EP_CDC(i))) {
+				continue;
+			}
+
+			if (cdc_ready[i] == 0) {
+				continue;
+			}
+
+			/* CDC ACM copies into its own ring buffer */
+			tx_written = uart_fifo_fill(
+				devices[i],
+				event->buf,
+				event->len);
 
-		tx_written = uart_fifo_fill(
-			devices[event->dev_idx],
-			event->buf,
-			event->len);
+			bridge_route_account(src, BRIDGE_EP_CDC(i),
+					     tx_written,
+					     event->len - tx_written);
 
-		if (tx_written != event->len) {
-			LOG_DBG("UART_%d->CDC_%d overflow",
-				event->dev_idx,
-				event->dev_idx);
+			if (tx_written != event->len) {
+				LOG_DBG("UART_%d->CDC_%d overflow",
+					event->dev_idx,
+					i);
+			}
 		}
 
 		return false;
@@ -203,8 +229,8 @@ static bool event_handler(const struct event_header *eh)
 		const struct cdc_data_event *event =
 			cast_cdc_data_event(eh);
 
-		/* All subscribers have gotten a chance to copy data at this point */
-		k_mem_slab_free(&cdc_rx_slab, (void **) &event->buf);
+		/* All subscribers have taken their references at this point */
+		bridge_buf_unref(event->buf);
 
 		return true;
 	}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <sys/atomic.h>
+
+#include "bridge_buf.h"
+
+#define BRIDGE_SLAB_BLOCK_SIZE sizeof(struct bridge_buf)
+#define BRIDGE_SLAB_ALIGNMENT 4
+
+struct bridge_buf {
+	atomic_t ref_counter;
+	uint8_t data[BRIDGE_BUF_BLOCK_SIZE];
+};
+
+BUILD_ASSERT((sizeof(struct bridge_buf) % BRIDGE_SLAB_ALIGNMENT) == 0);
+
+/* Blocks from this slab are used for data received on every endpoint. */
+/* Sinks take a reference instead of copying the data. */
+K_MEM_SLAB_DEFINE(bridge_buf_slab, BRIDGE_SLAB_BLOCK_SIZE,
+		  CONFIG_BRIDGE_BUF_COUNT, BRIDGE_SLAB_ALIGNMENT);
+
+static inline struct bridge_buf *block_start_get(const void *ptr)
+{
+	size_t block_num;
+
+	/* blocks are fixed size units from a continuous memory slab: */
+	/* round down to the closest unit size to find beginning of block. */
+
+	__ASSERT_NO_MSG(((uint8_t *)ptr >= (uint8_t *)bridge_buf_slab.buffer) &&
+			((uint8_t *)ptr < (uint8_t *)bridge_buf_slab.buffer +
+			 BRIDGE_SLAB_BLOCK_SIZE * CONFIG_BRIDGE_BUF_COUNT));
+
+	block_num = (((size_t)ptr - (size_t)bridge_buf_slab.buffer) /
+		     BRIDGE_SLAB_BLOCK_SIZE);
+
+	return (struct bridge_buf *)
+		&bridge_buf_slab.buffer[block_num * BRIDGE_SLAB_BLOCK_SIZE];
+}
+
+uint8_t *bridge_buf_alloc(void)
+{
+	struct bridge_buf *buf;
+	int err;
+
+	err = k_mem_slab_alloc(&bridge_buf_slab, (void **)&buf, K_NO_WAIT);
+	if (err) {
+		return NULL;
+	}
+
+	atomic_set(&buf->ref_counter, 1);
+
+	return buf->data;
+}
+
+void bridge_buf_ref(const void *ptr)
+{
+	__ASSERT_NO_MSG(ptr);
+
+	atomic_inc(&(block_start_get(ptr)->ref_counter));
+}
+
+void bridge_buf_unref(const void *ptr)
+{
+	__ASSERT_NO_MSG(ptr);
+
+	struct bridge_buf *buf = block_start_get(ptr);
+	atomic_val_t ref_counter = atomic_dec(&buf->ref_counter);
+
+	/* ref_counter is the buf->ref_counter value prior to decrement */
+	__ASSERT_NO_MSG(ref_counter > 0);
+	if (ref_counter == 1) {
+		k_mem_slab_free(&bridge_buf_slab, (void **)&buf);
+	}
+}
+
+uint32_t bridge_buf_num_free_get(void)
+{
+	return k_mem_slab_num_free_get(&bridge_buf_slab);
+}
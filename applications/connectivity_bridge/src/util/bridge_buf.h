@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _BRIDGE_BUF_H_
+#define _BRIDGE_BUF_H_
+
+/**
+ * @brief Bridge buffer pool
+ * @defgroup bridge_buf Bridge buffer pool
+ * @{
+ */
+
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Size of the data area of one buffer block. */
+#define BRIDGE_BUF_BLOCK_SIZE CONFIG_BRIDGE_BUF_SIZE
+
+/** @brief Allocate a buffer block from the shared pool.
+ *
+ * The block is returned with a reference count of one.
+ * Safe to call from interrupt context.
+ *
+ * @return Pointer to the start of the block data area,
+ *         or NULL if the pool is exhausted.
+ */
+uint8_t *bridge_buf_alloc(void);
+
+/** @brief Take a reference to a buffer block.
+ *
+ * @param ptr Any pointer into the data area of an allocated block.
+ */
+void bridge_buf_ref(const void *ptr);
+
+/** @brief Release a reference to a buffer block.
+ *
+ * The block is returned to the pool when the last reference is released.
+ *
+ * @param ptr Any pointer into the data area of an allocated block.
+ */
+void bridge_buf_unref(const void *ptr);
+
+/** @brief Get the number of free blocks in the pool. */
+uint32_t bridge_buf_num_free_get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _BRIDGE_BUF_H_ */
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <errno.h>
+#include <zephyr.h>
+#include <sys/atomic.h>
+
+#include "bridge_route.h"
+
+#define SINK(name) BIT(_CONCAT(BRIDGE_EP_, name))
+
+BUILD_ASSERT(BRIDGE_EP_COUNT <= 8);
+
+struct route_counters {
+	atomic_t tx_bytes;
+	atomic_t drop_bytes;
+};
+
+/* Bitmask of sinks for each source endpoint. */
+static const uint8_t route_table[BRIDGE_EP_COUNT] = {
+	[BRIDGE_EP_UART_0] = SINK(CDC_0) | SINK(BLE),
+	[BRIDGE_EP_UART_1] = SINK(CDC_1),
+	[BRIDGE_EP_CDC_0] = SINK(UART_0),
+	[BRIDGE_EP_CDC_1] = SINK(UART_1),
+	/* Only one BLE Service instance, mapped to UART_0 */
+	[BRIDGE_EP_BLE] = SINK(UART_0),
+};
+
+static struct route_counters counters[BRIDGE_EP_COUNT][BRIDGE_EP_COUNT];
+
+bool bridge_route_exists(enum bridge_ep src, enum bridge_ep dst)
+{
+	if (src >= BRIDGE_EP_COUNT || dst >= BRIDGE_EP_COUNT) {
+		return false;
+	}
+
+	return (route_table[src] & BIT(dst)) != 0;
+}
+
+void bridge_route_account(enum bridge_ep src, enum bridge_ep dst,
+			  size_t sent, size_t dropped)
+{
+	if (!bridge_route_exists(src, dst)) {
+		return;
+	}
+
+	if (sent) {
+		atomic_add(&counters[src][dst].tx_bytes, sent);
+	}
+
+	if (dropped) {
+		atomic_add(&counters[src][dst].drop_bytes, dropped);
+	}
+}
+
+int bridge_route_stats_get(enum bridge_ep src, enum bridge_ep dst,
+			   struct bridge_route_stats *stats)
+{
+	if (!bridge_route_exists(src, dst)) {
+		return -ENOENT;
+	}
+
+	stats->tx_bytes = atomic_get(&counters[src][dst].tx_bytes);
+	stats->drop_bytes = atomic_get(&counters[src][dst].drop_bytes);
+
+	return 0;
+}
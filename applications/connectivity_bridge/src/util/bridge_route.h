@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _BRIDGE_ROUTE_H_
+#define _BRIDGE_ROUTE_H_
+
+/**
+ * @brief Bridge routing table
+ * @defgroup bridge_route Bridge routing table
+ * @{
+ */
+
+#include <stdbool.h>
+#include <zephyr/types.h>
+#include <toolchain/common.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Bridge endpoint list. */
+#define BRIDGE_EP_LIST	\
+	X(UART_0)	\
+	X(UART_1)	\
+	X(CDC_0)	\
+	X(CDC_1)	\
+	X(BLE)
+
+/** Bridge endpoint IDs. */
+enum bridge_ep {
+#define X(name) _CONCAT(BRIDGE_EP_, name),
+	BRIDGE_EP_LIST
+#undef X
+
+	BRIDGE_EP_COUNT
+};
+
+/** Number of UART and CDC endpoints. */
+#define BRIDGE_EP_DEV_COUNT 2
+
+/** Endpoint ID of UART instance @p idx. */
+#define BRIDGE_EP_UART(idx) ((enum bridge_ep)(BRIDGE_EP_UART_0 + (idx)))
+
+/** Endpoint ID of CDC ACM instance @p idx. */
+#define BRIDGE_EP_CDC(idx) ((enum bridge_ep)(BRIDGE_EP_CDC_0 + (idx)))
+
+/** Per-route traffic counters. */
+struct bridge_route_stats {
+	/** Number of bytes accepted by the sink. */
+	uint32_t tx_bytes;
+	/** Number of bytes dropped by the sink. */
+	uint32_t drop_bytes;
+};
+
+/** @brief Check whether data from @p src is forwarded to @p dst.
+ *
+ * @param src Source endpoint.
+ * @param dst Sink endpoint.
+ *
+ * @return true if a route exists, false otherwise.
+ */
+bool bridge_route_exists(enum bridge_ep src, enum bridge_ep dst);
+
+/** @brief Account data forwarded along a route.
+ *
+ * Called by the sink once it has accepted or dropped data.
+ * Safe to call from interrupt context.
+ *
+ * @param src     Source endpoint.
+ * @param dst     Sink endpoint.
+ * @param sent    Number of bytes accepted by the sink.
+ * @param dropped Number of bytes dropped by the sink.
+ */
+void bridge_route_account(enum bridge_ep src, enum bridge_ep dst,
+			  size_t sent, size_t dropped);
+
+/** @brief Read the counters of a route.
+ *
+ * @param src   Source endpoint.
+ * @param dst   Sink endpoint.
+ * @param stats Counters are written here.
+ *
+ * @retval 0 on success.
+ * @retval -ENOENT if there is no such route.
+ */
+int bridge_route_stats_get(enum bridge_ep src, enum bridge_ep dst,
+			   struct bridge_route_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* _BRIDGE_ROUTE_H_ */
@@ -33,6 +33,8 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_DESKTOP_MOTION_LOG_LEVEL);
 #define THREAD_PRIORITY		K_PRIO_PREEMPT(0)
 
 #define NODATA_LIMIT		CONFIG_DESKTOP_MOTION_SENSOR_EMPTY_SAMPLES_COUNT
+#define TRIGGER_WHILE_FETCHING \
+	IS_ENABLED(CONFIG_DESKTOP_MOTION_SENSOR_TRIGGER_WHILE_FETCHING)
 
 #define MAX_KEY_LEN 20
 
@@ -185,26 +187,38 @@ static void data_ready_handler(struct device *dev, struct sensor_trigger *trig)
 {
 	k_spinlock_key_t key = k_spin_lock(&state.lock);
 
-	disable_trigger();
-
 	switch (state.state) {
 	case STATE_IDLE:
+		/* Trigger can be kept enabled while fetching, so that
+		 * the sensor driver accumulates motion between the samples.
+		 */
+		if (!TRIGGER_WHILE_FETCHING) {
+			disable_trigger();
+		}
 		state.state = STATE_FETCHING;
 		state.sample = true;
-		/* Fall-through */
+		/* Wake up thread */
+		k_sem_give(&sem);
+		break;
+
+	case STATE_FETCHING:
+		/* Motion is sampled when the previous report is sent. */
+		__ASSERT_NO_MSG(TRIGGER_WHILE_FETCHING);
+		break;
 
 	case STATE_DISCONNECTED:
+		disable_trigger();
 		/* Wake up thread */
 		k_sem_give(&sem);
 		break;
 
 	case STATE_SUSPENDED:
 	case STATE_SUSPENDED_DISCONNECTED:
+		disable_trigger();
 		/* Wake up system - this will wake up thread */
 		EVENT_SUBMIT(new_wake_up_event());
 		break;
 
-	case STATE_FETCHING:
 	case STATE_DISABLED:
 	case STATE_DISABLED_SUSPENDED:
 		/* Invalid state */
@@ -630,7 +644,12 @@ static bool event_handler(const struct event_header *eh)
 		k_spinlock_key_t key = k_spin_lock(&state.lock);
 		if ((state.state == STATE_SUSPENDED) ||
 		    (state.state == STATE_SUSPENDED_DISCONNECTED)) {
-			disable_trigger();
+			if ((state.state == STATE_SUSPENDED) &&
+			    TRIGGER_WHILE_FETCHING) {
+				enable_trigger();
+			} else {
+				disable_trigger();
+			}
 			if (state.state == STATE_SUSPENDED) {
 				state.state = STATE_FETCHING;
 				state.sample = true;
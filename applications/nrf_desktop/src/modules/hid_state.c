@@ -14,7 +14,6 @@
 #include <sys/types.h>
 
 #include <zephyr/types.h>
-#include <sys/slist.h>
 #include <sys/util.h>
 #include <sys/byteorder.h>
 
@@ -81,15 +80,15 @@ struct items {
 
 /**@brief Enqueued HID state item. */
 struct item_event {
-	sys_snode_t node; /**< Event queue linked list node. */
 	struct item item; /**< HID state item which has been enqueued. */
 	uint32_t timestamp; /**< HID event timestamp. */
 };
 
 /**@brief Event queue. */
 struct eventq {
-	sys_slist_t root;
-	size_t len;
+	struct item_event event[CONFIG_DESKTOP_HID_EVENT_QUEUE_SIZE]; /**< Ring of events. */
+	uint8_t head; /**< Position of the oldest event. */
+	uint8_t len; /**< Number of enqueued events. */
 };
 
 /**@brief Axis data. */
@@ -134,6 +133,12 @@ static uint8_t report_data_index[REPORT_ID_COUNT];
 static uint8_t report_state_index[REPORT_ID_COUNT];
 static struct hid_state state;
 
+/* Position of the Key ID in hid_keymap increased by one, zero if unmapped.
+ * Positions that do not fit in an entry are marked with KEYMAP_LUT_SEARCH.
+ */
+#define KEYMAP_LUT_SEARCH UINT8_MAX
+static uint8_t keymap_lut[CONFIG_DESKTOP_HID_KEYMAP_LUT_SIZE];
+
 
 static bool report_send(struct report_data *rd, bool check_state, bool send_always);
 
@@ -185,21 +190,41 @@ static int hid_keymap_compare(const void *a, const void *b)
 }
 
 /**@brief Translate Key ID to HID Usage ID and target report. */
-static struct hid_keymap *hid_keymap_get(uint16_t key_id)
+static const struct hid_keymap *hid_keymap_get(uint16_t key_id)
 {
+	if (key_id < ARRAY_SIZE(keymap_lut)) {
+		uint8_t pos = keymap_lut[key_id];
+
+		if (pos != KEYMAP_LUT_SEARCH) {
+			return (pos) ? (&hid_keymap[pos - 1]) : (NULL);
+		}
+	}
+
+	/* Key IDs that are not resolved by the lookup table are searched for. */
 	struct hid_keymap key = {
 		.key_id = key_id
 	};
 
-	struct hid_keymap *map = bsearch(&key,
-					 (uint8_t *)hid_keymap,
-					 ARRAY_SIZE(hid_keymap),
-					 sizeof(key),
-					 hid_keymap_compare);
+	const struct hid_keymap *map = bsearch(&key,
+					       (uint8_t *)hid_keymap,
+					       ARRAY_SIZE(hid_keymap),
+					       sizeof(key),
+					       hid_keymap_compare);
 
 	return map;
 }
 
+static void hid_keymap_lut_init(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(hid_keymap); i++) {
+		uint16_t key_id = hid_keymap[i].key_id;
+
+		if (key_id < ARRAY_SIZE(keymap_lut)) {
+			keymap_lut[key_id] = MIN(i + 1, KEYMAP_LUT_SEARCH);
+		}
+	}
+}
+
 /**@brief Compare two usage values. */
 static int usage_id_compare(const void *a, const void *b)
 {
@@ -209,86 +234,66 @@ static int usage_id_compare(const void *a, const void *b)
 	return (p_a->usage_id - p_b->usage_id);
 }
 
-static void eventq_reset(struct eventq *eventq)
+static struct item_event *eventq_at(struct eventq *eventq, size_t pos)
 {
-	struct item_event *event;
-	struct item_event *tmp;
+	__ASSERT_NO_MSG(pos < eventq->len);
 
-	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&eventq->root, event, tmp, node) {
-		sys_slist_remove(&eventq->root, NULL, &event->node);
-
-		k_free(event);
-	}
+	return &eventq->event[(eventq->head + pos) % ARRAY_SIZE(eventq->event)];
+}
 
-	sys_slist_init(&eventq->root);
+static void eventq_reset(struct eventq *eventq)
+{
+	eventq->head = 0;
 	eventq->len = 0;
 }
 
 static bool eventq_is_full(const struct eventq *eventq)
 {
-	return (eventq->len >= CONFIG_DESKTOP_HID_EVENT_QUEUE_SIZE);
+	return (eventq->len >= ARRAY_SIZE(eventq->event));
 }
 
 
-static bool eventq_is_empty(struct eventq *eventq)
+static bool eventq_is_empty(const struct eventq *eventq)
 {
-	bool empty = sys_slist_is_empty(&eventq->root);
-
-	__ASSERT_NO_MSG(!empty == (eventq->len != 0));
-
-	return empty;
+	return (eventq->len == 0);
 }
 
-static struct item_event *eventq_get(struct eventq *eventq)
+static bool eventq_get(struct eventq *eventq, struct item_event *event)
 {
-	sys_snode_t *node = sys_slist_get(&eventq->root);
-
-	if (!node) {
-		return NULL;
+	if (eventq_is_empty(eventq)) {
+		return false;
 	}
 
+	*event = eventq->event[eventq->head];
+
+	eventq->head = (eventq->head + 1) % ARRAY_SIZE(eventq->event);
 	eventq->len--;
 
-	return CONTAINER_OF(node, struct item_event, node);
+	return true;
 }
 
 static void eventq_append(struct eventq *eventq, uint16_t usage_id, int16_t value)
 {
-	struct item_event *hid_event = k_malloc(sizeof(*hid_event));
-
-	if (!hid_event) {
-		LOG_WRN("Failed to allocate HID event");
+	if (eventq_is_full(eventq)) {
+		LOG_WRN("HID event queue is full");
 		return;
 	}
 
+	size_t pos = (eventq->head + eventq->len) % ARRAY_SIZE(eventq->event);
+	struct item_event *hid_event = &eventq->event[pos];
+
 	hid_event->item.usage_id = usage_id;
 	hid_event->item.value = value;
 	hid_event->timestamp = k_uptime_get_32();
 
-	/* Add a new event to the queue. */
-	sys_slist_append(&eventq->root, &hid_event->node);
-
 	eventq->len++;
 }
 
-static void eventq_region_purge(struct eventq *eventq,
-				sys_snode_t *last_to_purge)
+static void eventq_region_purge(struct eventq *eventq, size_t cnt)
 {
-	sys_snode_t *tmp;
-	sys_snode_t *tmp_safe;
-	size_t cnt = 0;
-
-	SYS_SLIST_FOR_EACH_NODE_SAFE(&eventq->root, tmp, tmp_safe) {
-		sys_slist_remove(&eventq->root, NULL, tmp);
-
-		k_free(CONTAINER_OF(tmp, struct item_event, node));
-		cnt++;
-
-		if (tmp == last_to_purge) {
-			break;
-		}
-	}
+	__ASSERT_NO_MSG(cnt <= eventq->len);
 
+	eventq->head = (eventq->head + cnt) % ARRAY_SIZE(eventq->event);
 	eventq->len -= cnt;
 
 	LOG_WRN("%u stale events removed from the queue!", cnt);
@@ -299,11 +304,11 @@ static void eventq_cleanup(struct eventq *eventq, uint32_t timestamp)
 {
 	/* Find timed out events. */
 
-	sys_snode_t *first_valid;
+	size_t first_valid;
 
-	SYS_SLIST_FOR_EACH_NODE(&eventq->root, first_valid) {
-		uint32_t diff = timestamp - CONTAINER_OF(
-			first_valid, struct item_event, node)->timestamp;
+	for (first_valid = 0; first_valid < eventq->len; first_valid++) {
+		uint32_t diff = timestamp -
+				eventq_at(eventq, first_valid)->timestamp;
 
 		if (diff < CONFIG_DESKTOP_HID_REPORT_EXPIRATION) {
 			break;
@@ -314,17 +319,11 @@ static void eventq_cleanup(struct eventq *eventq, uint32_t timestamp)
 	 * key down.
 	 */
 
-	sys_snode_t *maxfound = sys_slist_peek_head(&eventq->root);
-	size_t maxfound_pos = 0;
+	size_t maxfound = 0;
+	size_t purge_cnt = 0;
 
-	sys_snode_t *cur;
-	size_t cur_pos = 0;
-
-	sys_snode_t *tmp_safe;
-
-	SYS_SLIST_FOR_EACH_NODE_SAFE(&eventq->root, cur, tmp_safe) {
-		const struct item cur_item =
-			CONTAINER_OF(cur, struct item_event, node)->item;
+	for (size_t cur = 0; cur < first_valid; cur++) {
+		const struct item cur_item = eventq_at(eventq, cur)->item;
 
 		if (cur_item.value > 0) {
 			/* Every key down must be paired with key up.
@@ -333,19 +332,11 @@ static void eventq_cleanup(struct eventq *eventq, uint32_t timestamp)
 			 */
 
 			unsigned int hit_count = cur_item.value;
-			sys_snode_t *j = cur;
-			size_t j_pos = cur_pos;
-
-			SYS_SLIST_ITERATE_FROM_NODE(&eventq->root, j) {
-				j_pos++;
-				if (j == first_valid) {
-					break;
-				}
+			size_t j;
 
+			for (j = cur + 1; j < first_valid; j++) {
 				const struct item item =
-					CONTAINER_OF(j,
-						     struct item_event,
-						     node)->item;
+					eventq_at(eventq, j)->item;
 
 				if (cur_item.usage_id == item.usage_id) {
 					hit_count += item.value;
@@ -364,44 +355,21 @@ static void eventq_cleanup(struct eventq *eventq, uint32_t timestamp)
 				break;
 			}
 
-			if (j_pos > maxfound_pos) {
+			if (j > maxfound) {
 				maxfound = j;
-				maxfound_pos = j_pos;
 			}
 		}
 
-
-		if (cur == first_valid) {
-			break;
-		}
-
 		if (cur == maxfound) {
 			/* All events up to this point have pairs and can
 			 * be deleted.
 			 */
-			eventq_region_purge(eventq, maxfound);
+			purge_cnt = maxfound + 1;
 		}
-
-		cur_pos++;
 	}
-}
-
-static void sort_by_usage_id(struct item items[], size_t array_size)
-{
-	for (size_t k = 0; k < array_size; k++) {
-		size_t id = k;
 
-		for (size_t l = k + 1; l < array_size; l++) {
-			if (items[l].usage_id < items[id].usage_id) {
-				id = l;
-			}
-		}
-		if (id != k) {
-			struct item tmp = items[k];
-
-			items[k] = items[id];
-			items[id] = tmp;
-		}
+	if (purge_cnt > 0) {
+		eventq_region_purge(eventq, purge_cnt);
 	}
 }
 
@@ -599,8 +567,19 @@ static bool key_value_set(struct items *items, uint16_t usage_id, int16_t value)
 		p_item->value += value;
 		if (p_item->value == 0) {
 			__ASSERT_NO_MSG(items->item_count != 0);
+
+			/* Move the smaller items up to keep the free slots
+			 * at the beginning of the array.
+			 */
+			struct item *first = &items->item[ARRAY_SIZE(items->item) -
+							  prev_item_count];
+
+			for (; p_item > first; p_item--) {
+				*p_item = *(p_item - 1);
+			}
+			memset(first, 0, sizeof(*first));
+
 			items->item_count -= 1;
-			p_item->usage_id = 0;
 		}
 
 		update_needed = true;
@@ -617,13 +596,20 @@ static bool key_value_set(struct items *items, uint16_t usage_id, int16_t value)
 		 */
 		LOG_WRN("No place on the list to store HID item!");
 	} else {
-		/* After sort operation, free slots (zeros) are stored
-		 * at the beginning of the array.
+		/* Items are kept sorted, free slots (zeros) are stored
+		 * at the beginning of the array. Move the smaller items
+		 * down to make place for the new one.
 		 */
-		size_t const idx = ARRAY_SIZE(items->item) - prev_item_count - 1;
+		size_t idx = ARRAY_SIZE(items->item) - prev_item_count - 1;
 
 		__ASSERT_NO_MSG(items->item[idx].usage_id == 0);
 
+		while ((idx + 1 < ARRAY_SIZE(items->item)) &&
+		       (items->item[idx + 1].usage_id < usage_id)) {
+			items->item[idx] = items->item[idx + 1];
+			idx++;
+		}
+
 		/* Record this value change. */
 		items->item[idx].usage_id = usage_id;
 		items->item[idx].value = value;
@@ -632,13 +618,6 @@ static bool key_value_set(struct items *items, uint16_t usage_id, int16_t value)
 		update_needed = true;
 	}
 
-	if (prev_item_count != items->item_count) {
-		/* Sort elements on the list. Use simple algorithm
-		 * with small footprint.
-		 */
-		sort_by_usage_id(items->item, ARRAY_SIZE(items->item));
-	}
-
 	return update_needed;
 }
 
@@ -878,21 +857,16 @@ static bool update_report(struct report_data *rd)
 {
 	bool update_needed = false;
 
-	while (!update_needed && !eventq_is_empty(&rd->eventq)) {
-		/* There are enqueued events to handle. */
-		struct item_event *event = eventq_get(&rd->eventq);
-
-		__ASSERT_NO_MSG(event);
+	struct item_event event;
 
+	while (!update_needed && eventq_get(&rd->eventq, &event)) {
+		/* There are enqueued events to handle. */
 		update_needed = key_value_set(&rd->items,
-					      event->item.usage_id,
-					      event->item.value);
+					      event.item.usage_id,
+					      event.item.value);
 
 		rd->update_needed = rd->update_needed || update_needed;
 
-
-		k_free(event);
-
 		/* If no item was changed, try next event. */
 	}
 
@@ -1141,16 +1115,12 @@ static void enqueue(struct report_data *rd, uint16_t usage_id, int16_t value,
 			 * Try to remove queued items starting from the
 			 * oldest one.
 			 */
-			sys_snode_t *i;
-
-			SYS_SLIST_FOR_EACH_NODE(&rd->eventq.root, i) {
+			for (size_t i = 0; i < rd->eventq.len; i++) {
 				/* Initial cleanup was done above. Queue will
 				 * not contain events with expired timestamp.
 				 */
 				uint32_t timestamp =
-					CONTAINER_OF(i,
-						     struct item_event,
-						     node)->timestamp +
+					eventq_at(&rd->eventq, i)->timestamp +
 					CONFIG_DESKTOP_HID_REPORT_EXPIRATION;
 
 				eventq_cleanup(&rd->eventq, timestamp);
@@ -1158,7 +1128,7 @@ static void enqueue(struct report_data *rd, uint16_t usage_id, int16_t value,
 				if (!eventq_is_full(&rd->eventq)) {
 					/* At least one element was removed
 					 * from the queue. Do not continue
-					 * list traverse, content was modified!
+					 * queue traverse, content was modified!
 					 */
 					break;
 				}
@@ -1219,6 +1189,8 @@ static void init(void)
 		}
 	}
 
+	hid_keymap_lut_init();
+
 	/* Mark unused report IDs. */
 	for (size_t i = 0; i < ARRAY_SIZE(report_data_index); i++) {
 		report_data_index[i] = INPUT_REPORT_DATA_COUNT;
@@ -1318,7 +1290,7 @@ static bool handle_wheel_event(const struct wheel_event *event)
 static bool handle_button_event(const struct button_event *event)
 {
 	/* Get usage ID and target report from HID Keymap */
-	struct hid_keymap *map = hid_keymap_get(event->key_id);
+	const struct hid_keymap *map = hid_keymap_get(event->key_id);
 
 	if (!map || !map->usage_id) {
 		LOG_WRN("No mapping, button ignored");
@@ -13,6 +13,7 @@
 #include <init.h>
 #include <modem/at_cmd.h>
 #include <modem/at_notif.h>
+#include <sys/ring_buffer.h>
 
 LOG_MODULE_REGISTER(at_host, CONFIG_SLM_LOG_LEVEL);
 
@@ -52,6 +53,16 @@ LOG_MODULE_REGISTER(at_host, CONFIG_SLM_LOG_LEVEL);
 #define UART_RX_BUF_NUM	2
 #define UART_RX_LEN	256
 #define UART_RX_TIMEOUT 1
+#define UART_TX_BUF_NUM	2
+#define UART_TX_LEN	CONFIG_SLM_UART_TX_BUF_SIZE
+
+/* Free space needed in the data mode ring buffer to keep UART RX running:
+ * the remainder of the current RX buffer plus the next one.
+ */
+#define DATAMODE_RX_HEADROOM	(2 * UART_RX_LEN)
+
+BUILD_ASSERT(CONFIG_SLM_DATAMODE_BUF_SIZE >= 2 * DATAMODE_RX_HEADROOM,
+	     "Data mode buffer too small to resume UART RX");
 
 /** @brief Termination Modes. */
 enum term_modes {
@@ -76,12 +87,37 @@ static size_t at_buf_len;
 static struct k_work cmd_send_work;
 static const char termination[3] = { '\0', '\r', '\n' };
 
+/* AT command framer state, only accessed from the UART callback */
+static uint8_t at_rx_buf[AT_MAX_CMD_LEN];
+static size_t at_rx_len;
+static bool at_rx_quotes;
+static bool at_rx_overflow;
+
+/* Complete commands waiting to be handled, each one stored as a 16-bit
+ * length followed by the command.
+ */
+RING_BUF_DECLARE(at_cmd_queue, CONFIG_SLM_AT_CMD_QUEUE_SIZE);
+BUILD_ASSERT(CONFIG_SLM_AT_CMD_QUEUE_SIZE >= AT_MAX_CMD_LEN + sizeof(uint16_t),
+	     "AT command queue cannot hold a command of the maximum length");
+static atomic_t at_cmd_dropped;
+
 static uint8_t uart_rx_buf[UART_RX_BUF_NUM][UART_RX_LEN];
 static uint8_t *next_buf = uart_rx_buf[1];
-static uint8_t *uart_tx_buf;
 
+/* Double-buffered UART TX: one buffer can be filled while the other one
+ * is being transmitted.
+ */
+K_MEM_SLAB_DEFINE(uart_tx_slab, UART_TX_LEN, UART_TX_BUF_NUM, 4);
 static K_SEM_DEFINE(tx_done, 0, 1);
 
+/* Data mode */
+RING_BUF_DECLARE(datamode_rx_buf, CONFIG_SLM_DATAMODE_BUF_SIZE);
+static slm_datamode_handler_t datamode_handler;
+static struct k_work datamode_send_work;
+static struct k_work datamode_exit_work;
+static bool datamode_rx_paused;
+static bool uart_rx_disabled;
+
 /* global functions defined in different files */
 void enter_idle(void);
 void enter_sleep(void);
@@ -92,30 +128,198 @@ extern struct at_param_list at_param_list;
 /* forward declaration */
 void slm_at_host_uninit(void);
 
-void rsp_send(const uint8_t *str, size_t len)
+uint8_t *slm_uart_tx_buf_alloc(size_t *size)
+{
+	uint8_t *buf;
+
+	if (k_mem_slab_alloc(&uart_tx_slab, (void **)&buf, K_FOREVER)) {
+		return NULL;
+	}
+
+	*size = UART_TX_LEN;
+
+	return buf;
+}
+
+int slm_uart_tx_buf_send(uint8_t *buf, size_t len)
 {
 	int ret;
 
+	if (len == 0) {
+		k_mem_slab_free(&uart_tx_slab, (void **)&buf);
+		return 0;
+	}
+
 	k_sem_take(&tx_done, K_FOREVER);
 
-	uart_tx_buf = k_malloc(len);
-	if (uart_tx_buf == NULL) {
-		LOG_WRN("No ram buffer");
+	LOG_HEXDUMP_DBG(buf, len, "TX");
+
+	/* The buffer is released in the UART callback */
+	ret = uart_tx(uart_dev, buf, len, SYS_FOREVER_MS);
+	if (ret) {
+		LOG_WRN("uart_tx failed: %d", ret);
+		k_mem_slab_free(&uart_tx_slab, (void **)&buf);
 		k_sem_give(&tx_done);
+	}
+
+	return ret;
+}
+
+void rsp_send(const uint8_t *str, size_t len)
+{
+	uint8_t *buf;
+	size_t size;
+	size_t chunk;
+
+	while (len > 0) {
+		buf = slm_uart_tx_buf_alloc(&size);
+		if (buf == NULL) {
+			LOG_WRN("No TX buffer");
+			return;
+		}
+
+		chunk = MIN(len, size);
+		memcpy(buf, str, chunk);
+		if (slm_uart_tx_buf_send(buf, chunk)) {
+			return;
+		}
+
+		str += chunk;
+		len -= chunk;
+	}
+}
+
+static int uart_rx_start(void)
+{
+	uart_rx_disabled = false;
+	/* All RX buffers have been released when RX is disabled */
+	next_buf = uart_rx_buf[1];
+
+	return uart_rx_enable(uart_dev, uart_rx_buf[0],
+			      sizeof(uart_rx_buf[0]), UART_RX_TIMEOUT);
+}
+
+static void datamode_rx_resume(void)
+{
+	int err;
+
+	if (!datamode_rx_paused || !uart_rx_disabled ||
+	    ring_buf_space_get(&datamode_rx_buf) < DATAMODE_RX_HEADROOM) {
 		return;
 	}
 
-	LOG_HEXDUMP_DBG(str, len, "TX");
+	datamode_rx_paused = false;
+	err = uart_rx_start();
+	if (err) {
+		LOG_ERR("UART RX failed: %d", err);
+	}
+}
 
-	memcpy(uart_tx_buf, str, len);
-	ret = uart_tx(uart_dev, uart_tx_buf, len, SYS_FOREVER_MS);
-	if (ret) {
-		LOG_WRN("uart_tx failed: %d", ret);
-		k_free(uart_tx_buf);
-		k_sem_give(&tx_done);
+static void datamode_send(struct k_work *work)
+{
+	uint8_t *data;
+	uint32_t size;
+	int sent;
+
+	ARG_UNUSED(work);
+
+	while (datamode_handler != NULL) {
+		/* Pass data to the handler straight from the ring buffer */
+		size = ring_buf_get_claim(&datamode_rx_buf, &data,
+					  CONFIG_SLM_DATAMODE_BUF_SIZE);
+		if (size == 0) {
+			break;
+		}
+
+		sent = datamode_handler(DATAMODE_SEND, data, size);
+		if (sent <= 0) {
+			/* The data cannot be sent, drop it and leave data
+			 * mode instead of passing it to the handler again.
+			 */
+			LOG_WRN("Data mode send failed: %d", sent);
+			exit_datamode();
+			rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
+			return;
+		}
+		ring_buf_get_finish(&datamode_rx_buf, MIN(sent, size));
+	}
+
+	datamode_rx_resume();
+}
+
+static void datamode_exit(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	if (datamode_handler != NULL) {
+		exit_datamode();
+		rsp_send(OK_STR, sizeof(OK_STR) - 1);
 	}
 }
 
+/* Data mode RX buffer is filled from the UART callback. Reset it with
+ * interrupts locked so that the callback does not put data in the middle
+ * of the reset.
+ */
+static void datamode_rx_buf_reset(void)
+{
+	unsigned int key;
+
+	key = irq_lock();
+	ring_buf_reset(&datamode_rx_buf);
+	irq_unlock(key);
+}
+
+static void datamode_rx_handler(const uint8_t *data, size_t len)
+{
+	uint32_t put;
+
+	if ((len == sizeof(CONFIG_SLM_DATAMODE_TERMINATOR) - 1) &&
+	    (memcmp(data, CONFIG_SLM_DATAMODE_TERMINATOR, len) == 0)) {
+		k_work_submit(&datamode_exit_work);
+		return;
+	}
+
+	put = ring_buf_put(&datamode_rx_buf, data, len);
+	if (put < len) {
+		LOG_WRN("Data mode RX overrun, %d bytes dropped", len - put);
+	}
+
+	k_work_submit(&datamode_send_work);
+}
+
+int enter_datamode(slm_datamode_handler_t handler)
+{
+	if (handler == NULL) {
+		return -EINVAL;
+	}
+
+	if (datamode_handler != NULL) {
+		return -EALREADY;
+	}
+
+	datamode_rx_buf_reset();
+	datamode_handler = handler;
+	LOG_INF("Enter data mode");
+
+	return 0;
+}
+
+void exit_datamode(void)
+{
+	slm_datamode_handler_t handler = datamode_handler;
+
+	if (handler == NULL) {
+		return;
+	}
+
+	datamode_handler = NULL;
+	(void)handler(DATAMODE_EXIT, NULL, 0);
+	datamode_rx_buf_reset();
+	datamode_rx_resume();
+	LOG_INF("Exit data mode");
+}
+
 static int set_uart_baudrate(uint32_t baudrate)
 {
 	int err = -EINVAL;
@@ -297,7 +501,7 @@ static int handle_at_slmuart(const char *at_cmd, uint32_t *baudrate)
 	return ret;
 }
 
-static void cmd_send(struct k_work *work)
+static void cmd_handle(void)
 {
 	size_t chars;
 	char str[24];
@@ -305,8 +509,6 @@ static void cmd_send(struct k_work *work)
 	enum at_cmd_state state;
 	int err;
 
-	ARG_UNUSED(work);
-
 	/* Make sure the string is 0-terminated */
 	at_buf[MIN(at_buf_len, AT_MAX_CMD_LEN - 1)] = 0;
 
@@ -315,7 +517,7 @@ static void cmd_send(struct k_work *work)
 	if (slm_util_cmd_casecmp(at_buf, AT_CMD_SLMVER)) {
 		rsp_send(SLM_VERSION, sizeof(SLM_VERSION) - 1);
 		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
+		return;
 	}
 
 	if (slm_util_cmd_casecmp(at_buf, AT_CMD_SLMUART)) {
@@ -324,19 +526,26 @@ static void cmd_send(struct k_work *work)
 		err = handle_at_slmuart(at_buf, &baudrate);
 		if (err != 0) {
 			rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-			goto done;
+			return;
 		} else {
 			rsp_send(OK_STR, sizeof(OK_STR) - 1);
 			k_sleep(K_MSEC(50));
+			uart_rx_disable(uart_dev);
+			k_sleep(K_MSEC(10));
 			set_uart_baudrate(baudrate);
-			goto done;
+			err = uart_rx_start();
+			if (err) {
+				LOG_ERR("UART RX failed: %d", err);
+				rsp_send(FATAL_STR, sizeof(FATAL_STR) - 1);
+			}
+			return;
 		}
 	}
 
 	if (slm_util_cmd_casecmp(at_buf, AT_CMD_CLAC)) {
 		handle_at_clac();
 		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
+		return;
 	}
 
 	if (slm_util_cmd_casecmp(at_buf, AT_CMD_SLEEP)) {
@@ -345,12 +554,12 @@ static void cmd_send(struct k_work *work)
 		err = handle_at_sleep(at_buf, &mode);
 		if (err) {
 			rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-			goto done;
+			return;
 		} else {
 			if (mode == SHUTDOWN_MODE_INVALID) {
 				/*Test command*/
 				rsp_send(OK_STR, sizeof(OK_STR) - 1);
-				goto done;
+				return;
 			} else {
 				/*Entered IDLE*/
 				return;
@@ -361,71 +570,71 @@ static void cmd_send(struct k_work *work)
 #if defined(CONFIG_SLM_TCP_PROXY)
 	err = slm_at_tcp_proxy_parse(at_buf, at_buf_len);
 	if (err > 0) {
-		goto done;
+		return;
 	} else if (err == 0) {
 		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
+		return;
 	} else if (err != -ENOENT) {
 		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+		return;
 	}
 #endif
 
 #if defined(CONFIG_SLM_UDP_PROXY)
 	err = slm_at_udp_proxy_parse(at_buf, at_buf_len);
 	if (err > 0) {
-		goto done;
+		return;
 	} else if (err == 0) {
 		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
+		return;
 	} else if (err != -ENOENT) {
 		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+		return;
 	}
 #endif
 
 	err = slm_at_tcpip_parse(at_buf);
 	if (err == 0) {
 		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
+		return;
 	} else if (err != -ENOENT) {
 		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+		return;
 	}
 
 	err = slm_at_icmp_parse(at_buf);
 	if (err == 0) {
-		goto done;
+		return;
 	} else if (err != -ENOENT) {
 		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+		return;
 	}
 
 	err = slm_at_gps_parse(at_buf);
 	if (err == 0) {
 		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
+		return;
 	} else if (err != -ENOENT) {
 		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+		return;
 	}
 
 	err = slm_at_mqtt_parse(at_buf);
 	if (err == 0) {
 		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
+		return;
 	} else if (err != -ENOENT) {
 		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+		return;
 	}
 
 	err = slm_at_ftp_parse(at_buf);
 	if (err == 0) {
 		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
+		return;
 	} else if (err != -ENOENT) {
 		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+		return;
 	}
 
 	/* Send to modem */
@@ -454,78 +663,163 @@ static void cmd_send(struct k_work *work)
 	default:
 		break;
 	}
+}
 
-done:
-	err = uart_rx_enable(uart_dev, uart_rx_buf[0],
-				sizeof(uart_rx_buf[0]), UART_RX_TIMEOUT);
-	if (err) {
-		LOG_ERR("UART RX failed: %d", err);
-		rsp_send(FATAL_STR, sizeof(FATAL_STR) - 1);
+static bool cmd_queue_get(void)
+{
+	uint16_t len;
+	unsigned int key;
+	bool found = false;
+
+	key = irq_lock();
+	if (ring_buf_get(&at_cmd_queue, (uint8_t *)&len, sizeof(len)) ==
+	    sizeof(len)) {
+		at_buf_len = ring_buf_get(&at_cmd_queue, at_buf, len);
+		found = true;
+	}
+	irq_unlock(key);
+
+	return found;
+}
+
+static void cmd_send(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	/* Commands dropped because the queue was full */
+	while (atomic_get(&at_cmd_dropped) > 0) {
+		atomic_dec(&at_cmd_dropped);
+		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
+	}
+
+	while (cmd_queue_get()) {
+		cmd_handle();
+	}
+}
+
+static void cmd_queue_put(void)
+{
+	uint16_t len = at_rx_len;
+
+	if (ring_buf_space_get(&at_cmd_queue) < sizeof(len) + len) {
+		LOG_WRN("AT command queue full, command dropped");
+		atomic_inc(&at_cmd_dropped);
+	} else {
+		ring_buf_put(&at_cmd_queue, (uint8_t *)&len, sizeof(len));
+		ring_buf_put(&at_cmd_queue, at_rx_buf, len);
+	}
+
+	k_work_submit(&cmd_send_work);
+}
+
+/* Test if any byte in a word is lower than n, n <= 128 */
+#define WORD_HAS_LESS(w, n) \
+	(((w) - 0x01010101UL * (n)) & ~(w) & 0x80808080UL)
+/* Test if any byte in a word equals n */
+#define WORD_HAS_BYTE(w, n) \
+	WORD_HAS_LESS((w) ^ (0x01010101UL * (n)), 1)
+
+/* Find the length of the leading run of bytes that need no processing
+ * by the framer. A word at a time is checked for control characters,
+ * '"' and DEL. Words containing ' ' or '!' are also sent to the byte-wise
+ * path, which is harmless.
+ */
+static size_t framer_plain_len(const uint8_t *data, size_t len)
+{
+	size_t i = 0;
+
+	while ((i < len) && ((uintptr_t)(data + i) & 0x3)) {
+		if (data[i] <= '"' || data[i] == 0x7F) {
+			return i;
+		}
+		i++;
+	}
+
+	for (; i + sizeof(uint32_t) <= len; i += sizeof(uint32_t)) {
+		uint32_t w = *(const uint32_t *)(data + i);
+
+		if (WORD_HAS_LESS(w, '"' + 1) || WORD_HAS_BYTE(w, 0x7F)) {
+			break;
+		}
+	}
+
+	for (; i < len; i++) {
+		if (data[i] <= '"' || data[i] == 0x7F) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+static void framer_store(const uint8_t *data, size_t len)
+{
+	size_t space = sizeof(at_rx_buf) - at_rx_len;
+
+	if (len > space) {
+		if (!at_rx_overflow) {
+			LOG_ERR("AT command buffer overflow");
+		}
+		at_rx_overflow = true;
+		len = space;
 	}
+
+	memcpy(at_rx_buf + at_rx_len, data, len);
+	at_rx_len += len;
 }
 
-static void uart_rx_handler(uint8_t character)
+static void framer_cmd_end(void)
 {
-	static bool inside_quotes;
-	static size_t cmd_len;
-	size_t pos;
+	if (at_rx_overflow) {
+		/* Report the truncated command as failed */
+		atomic_inc(&at_cmd_dropped);
+		k_work_submit(&cmd_send_work);
+	} else if (at_rx_len > 0) {
+		cmd_queue_put();
+	}
 
-	cmd_len += 1;
-	pos = cmd_len - 1;
+	at_rx_len = 0;
+	at_rx_quotes = false;
+	at_rx_overflow = false;
+}
+
+static void framer_special_char(uint8_t character)
+{
+	bool terminated = false;
 
 	/* Handle special characters. */
 	switch (character) {
 	case 0x08: /* Backspace. */
 		/* Fall through. */
 	case 0x7F: /* DEL character */
-		pos = pos ? pos - 1 : 0;
-		at_buf[pos] = 0;
-		cmd_len = cmd_len <= 1 ? 0 : cmd_len - 2;
-		break;
+		if (at_rx_len > 0) {
+			at_rx_len--;
+		}
+		return;
 	case '"':
-		inside_quotes = !inside_quotes;
-		 /* Fall through. */
+		at_rx_quotes = !at_rx_quotes;
+		break;
 	default:
-		/* Detect AT command buffer overflow or zero length */
-		if (cmd_len > AT_MAX_CMD_LEN) {
-			LOG_ERR("Buffer overflow, dropping '%c'\n", character);
-			cmd_len = AT_MAX_CMD_LEN;
-			return;
-		} else if (cmd_len < 1) {
-			LOG_ERR("Invalid AT command length: %d", cmd_len);
-			cmd_len = 0;
-			return;
-		}
-
-		at_buf[pos] = character;
 		break;
 	}
 
-	if (inside_quotes) {
+	if (at_rx_quotes || character == '"') {
+		framer_store(&character, 1);
 		return;
 	}
 
 	/* Check if the character marks line termination. */
 	switch (term_mode) {
 	case MODE_NULL_TERM:
-		goto send;
 	case MODE_CR:
-		if (character == termination[term_mode]) {
-			cmd_len--;
-			goto send;
-		}
-		break;
 	case MODE_LF:
-		if ((at_buf[pos - 1]) &&
-			character == termination[term_mode]) {
-			cmd_len--;
-			goto send;
-		}
+		terminated = (character == termination[term_mode]);
 		break;
 	case MODE_CR_LF:
-		if ((at_buf[pos - 1] == '\r') && (character == '\n')) {
-			cmd_len -= 2;
-			goto send;
+		if ((character == '\n') && (at_rx_len > 0) &&
+		    (at_rx_buf[at_rx_len - 1] == '\r')) {
+			at_rx_len--;
+			terminated = true;
 		}
 		break;
 	default:
@@ -533,12 +827,34 @@ static void uart_rx_handler(uint8_t character)
 		break;
 	}
 
-	return;
-send:
-	uart_rx_disable(uart_dev);
-	k_work_submit(&cmd_send_work);
-	at_buf_len = cmd_len;
-	cmd_len = 0;
+	if (terminated) {
+		framer_cmd_end();
+	} else {
+		framer_store(&character, 1);
+	}
+}
+
+/* Split a chunk of received data into AT commands. Runs of ordinary
+ * characters are copied in one go; only special characters are handled
+ * one at a time.
+ */
+static void uart_rx_framer(const uint8_t *data, size_t len)
+{
+	size_t plain;
+
+	while (len > 0) {
+		plain = at_rx_quotes ? 0 : framer_plain_len(data, len);
+		if (plain > 0) {
+			framer_store(data, plain);
+			data += plain;
+			len -= plain;
+			continue;
+		}
+
+		framer_special_char(*data);
+		data++;
+		len--;
+	}
 }
 
 static void uart_callback(struct device *dev, struct uart_event *evt,
@@ -547,28 +863,40 @@ static void uart_callback(struct device *dev, struct uart_event *evt,
 	ARG_UNUSED(dev);
 
 	int err;
-	static uint16_t pos;
 
 	ARG_UNUSED(user_data);
 
 	switch (evt->type) {
 	case UART_TX_DONE:
-		k_free(uart_tx_buf);
+		k_mem_slab_free(&uart_tx_slab, (void **)&evt->data.tx.buf);
 		k_sem_give(&tx_done);
 		break;
 	case UART_TX_ABORTED:
-		k_free(uart_tx_buf);
+		k_mem_slab_free(&uart_tx_slab, (void **)&evt->data.tx.buf);
 		k_sem_give(&tx_done);
 		LOG_INF("TX_ABORTED");
 		break;
 	case UART_RX_RDY:
-		for (int i = pos; i < (pos + evt->data.rx.len); i++) {
-			uart_rx_handler(evt->data.rx.buf[i]);
+		if (datamode_handler != NULL) {
+			datamode_rx_handler(evt->data.rx.buf +
+					    evt->data.rx.offset,
+					    evt->data.rx.len);
+		} else {
+			uart_rx_framer(evt->data.rx.buf + evt->data.rx.offset,
+				       evt->data.rx.len);
 		}
-		pos += evt->data.rx.len;
 		break;
 	case UART_RX_BUF_REQUEST:
-		pos = 0;
+		/* In data mode, let RX stop at the end of the current buffer
+		 * if the data cannot be forwarded fast enough. The hardware
+		 * flow control holds off the host until RX is resumed.
+		 */
+		if (datamode_handler != NULL &&
+		    ring_buf_space_get(&datamode_rx_buf) <
+		    DATAMODE_RX_HEADROOM) {
+			datamode_rx_paused = true;
+			break;
+		}
 		err = uart_rx_buf_rsp(uart_dev, next_buf,
 					sizeof(uart_rx_buf[0]));
 		if (err) {
@@ -583,6 +911,10 @@ static void uart_callback(struct device *dev, struct uart_event *evt,
 		break;
 	case UART_RX_DISABLED:
 		LOG_DBG("RX_DISABLED");
+		uart_rx_disabled = true;
+		if (datamode_rx_paused) {
+			k_work_submit(&datamode_send_work);
+		}
 		break;
 	default:
 		break;
@@ -639,8 +971,9 @@ int slm_at_host_init(void)
 	/* Power on UART module */
 	device_set_power_state(uart_dev, DEVICE_PM_ACTIVE_STATE,
 				NULL, NULL);
-	err = uart_rx_enable(uart_dev, uart_rx_buf[0],
-				sizeof(uart_rx_buf[0]), UART_RX_TIMEOUT);
+	/* Commands may be queued as soon as RX is enabled */
+	k_work_init(&cmd_send_work, cmd_send);
+	err = uart_rx_start();
 	if (err) {
 		LOG_ERR("Cannot enable rx: %d", err);
 		return -EFAULT;
@@ -693,7 +1026,8 @@ int slm_at_host_init(void)
 		return -EFAULT;
 	}
 
-	k_work_init(&cmd_send_work, cmd_send);
+	k_work_init(&datamode_send_work, datamode_send);
+	k_work_init(&datamode_exit_work, datamode_exit);
 	k_sem_give(&tx_done);
 	rsp_send(SLM_SYNC_STR, sizeof(SLM_SYNC_STR)-1);
 
@@ -745,6 +1079,8 @@ void slm_at_host_uninit(void)
 	/* Power off UART module */
 	uart_rx_disable(uart_dev);
 	k_sleep(K_MSEC(100));
+	ring_buf_reset(&at_cmd_queue);
+	atomic_clear(&at_cmd_dropped);
 	err = device_set_power_state(uart_dev, DEVICE_PM_OFF_STATE,
 				NULL, NULL);
 	if (err) {
@@ -37,6 +37,26 @@ enum slm_data_type_t {
 	DATATYPE_OMATLV
 };
 
+/**@brief Data mode operations. */
+enum slm_datamode_op {
+	DATAMODE_SEND,	/* Send data received from UART */
+	DATAMODE_EXIT	/* Data mode has been terminated */
+};
+
+/**
+ * @brief Data mode handler type.
+ *
+ * @param op Data mode operation.
+ * @param data Data received from UART, valid only for DATAMODE_SEND.
+ * @param len Length of data.
+ *
+ * @return Number of bytes consumed, or a (negative) error code.
+ *         Bytes not consumed are passed to the handler again. If no bytes
+ *         are consumed, the pending data is dropped and data mode is left.
+ */
+typedef int (*slm_datamode_handler_t)(uint8_t op, const uint8_t *data,
+				      int len);
+
 /**
  * @brief Initialize AT host for serial LTE modem
  *
@@ -45,6 +65,55 @@ enum slm_data_type_t {
  */
 int slm_at_host_init(void);
 
+/**
+ * @brief Enter data mode
+ *
+ * In data mode, data received from UART is passed to the handler as it
+ * arrives, without AT command framing. UART reception is paused while the
+ * handler cannot keep up, so hardware flow control should be enabled.
+ * Data mode is terminated when CONFIG_SLM_DATAMODE_TERMINATOR is received
+ * on its own.
+ *
+ * @param handler Data mode handler.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int enter_datamode(slm_datamode_handler_t handler);
+
+/**
+ * @brief Exit data mode
+ *
+ * The data mode handler is called with DATAMODE_EXIT.
+ */
+void exit_datamode(void);
+
+/**
+ * @brief Allocate a UART TX buffer
+ *
+ * The caller can fill the buffer directly, for example with recv(), and
+ * pass it to slm_uart_tx_buf_send() without further copying.
+ *
+ * @param[out] size Size of the buffer.
+ *
+ * @return Pointer to the buffer, or NULL on failure.
+ */
+uint8_t *slm_uart_tx_buf_alloc(size_t *size);
+
+/**
+ * @brief Send a UART TX buffer
+ *
+ * The buffer is released once transmitted. A zero length releases the
+ * buffer without sending.
+ *
+ * @param buf Buffer allocated by slm_uart_tx_buf_alloc().
+ * @param len Number of bytes to send.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_uart_tx_buf_send(uint8_t *buf, size_t len);
+
 /** @} */
 
 #endif /* SLM_AT_HOST_ */
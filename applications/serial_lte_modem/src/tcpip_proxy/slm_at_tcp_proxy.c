@@ -173,6 +173,7 @@ static int do_tcp_server_stop(int error)
 	int ret = 0;
 
 	if (proxy.sock > 0) {
+		exit_datamode();
 		k_timer_stop(&conn_timer);
 		k_thread_abort(tcp_thread_id);
 		if (proxy.sock_peer != INVALID_SOCKET) {
@@ -287,6 +288,7 @@ static int do_tcp_client_disconnect(int error)
 	int ret = 0;
 
 	if (proxy.sock > 0) {
+		exit_datamode();
 		k_thread_abort(tcp_thread_id);
 		ret = close(proxy.sock);
 		if (ret < 0) {
@@ -381,8 +383,13 @@ static int do_tcp_send_datamode(const uint8_t *data, int datalen)
 	while (offset < datalen) {
 		ret = send(sock, data + offset, datalen - offset, 0);
 		if (ret < 0) {
-			LOG_ERR("send() failed: %d", -errno);
 			ret = -errno;
+			LOG_ERR("send() failed: %d", ret);
+			break;
+		}
+		if (ret == 0) {
+			LOG_ERR("send() sent nothing");
+			ret = -EIO;
 			break;
 		}
 		offset += ret;
@@ -394,7 +401,48 @@ static int do_tcp_send_datamode(const uint8_t *data, int datalen)
 			K_NO_WAIT);
 	}
 
-	return offset;
+	/* Report the error if nothing was sent, the caller passes the rest of
+	 * the data again otherwise.
+	 */
+	return (offset > 0) ? offset : ret;
+}
+
+static int tcp_datamode_handler(uint8_t op, const uint8_t *data, int len)
+{
+	if (op == DATAMODE_SEND) {
+		return do_tcp_send_datamode(data, len);
+	}
+
+	/* Back to AT command mode, the connection is kept */
+	proxy.datamode = false;
+
+	return 0;
+}
+
+/* Receive straight into a UART TX buffer, so data mode payload is not
+ * copied on its way from the modem to the UART.
+ */
+static int tcp_recv_datamode(int sock)
+{
+	uint8_t *buf;
+	size_t size;
+	int ret;
+
+	buf = slm_uart_tx_buf_alloc(&size);
+	if (buf == NULL) {
+		return -ENOMEM;
+	}
+
+	ret = recv(sock, buf, size, 0);
+	if (ret < 0) {
+		ret = -errno;
+		(void)slm_uart_tx_buf_send(buf, 0);
+		return ret;
+	}
+
+	(void)slm_uart_tx_buf_send(buf, ret);
+
+	return ret;
 }
 
 static int tcp_data_save(uint8_t *data, uint32_t length)
@@ -476,6 +524,13 @@ thread_entry:
 			if (proxy.role == AT_TCP_ROLE_SERVER) {
 				k_timer_stop(&conn_timer);
 			}
+			if (proxy.datamode) {
+				ret = tcp_recv_datamode(sock);
+				if (ret < 0) {
+					LOG_WRN("recv() error: %d", ret);
+				}
+				goto restart_timer;
+			}
 			ret = recv(sock, data, NET_IPV4_MTU, 0);
 			if (ret < 0) {
 				LOG_WRN("recv() error: %d", -errno);
@@ -484,9 +539,7 @@ thread_entry:
 			if (ret == 0) {
 				continue;
 			}
-			if (proxy.datamode) {
-				rsp_send(data, ret);
-			} else if (slm_util_hex_check(data, ret)) {
+			if (slm_util_hex_check(data, ret)) {
 				ret = slm_util_htoa(data, ret, data_hex,
 					DATA_HEX_MAX_SIZE);
 				if (ret < 0) {
@@ -514,6 +567,7 @@ thread_entry:
 				}
 				rsp_send(rsp_buf, strlen(rsp_buf));
 			}
+restart_timer:
 			/* restart activity timer */
 			if (proxy.role == AT_TCP_ROLE_SERVER) {
 				k_timer_start(
@@ -562,7 +616,8 @@ static int handle_at_tcp_server(enum at_cmd_type cmd_type)
 			}
 			err = do_tcp_server_start(port, sec_tag);
 			if (err == 0 && op == AT_SERVER_START_WITH_DATAMODE) {
-				proxy.datamode = true;
+				err = enter_datamode(tcp_datamode_handler);
+				proxy.datamode = (err == 0);
 			}
 		} else if (op == AT_SERVER_STOP) {
 			if (proxy.sock < 0) {
@@ -646,7 +701,8 @@ static int handle_at_tcp_client(enum at_cmd_type cmd_type)
 			err = do_tcp_client_connect(url, port, sec_tag);
 			if (err == 0 &&
 			    op == AT_CLIENT_CONNECT_WITH_DATAMODE) {
-				proxy.datamode = true;
+				err = enter_datamode(tcp_datamode_handler);
+				proxy.datamode = (err == 0);
 			}
 		} else if (op == AT_CLIENT_DISCONNECT) {
 			if (proxy.sock < 0) {
@@ -777,6 +833,8 @@ int slm_at_tcp_proxy_parse(const char *at_cmd, uint16_t length)
 	int ret = -ENOENT;
 	enum at_cmd_type type;
 
+	ARG_UNUSED(length);
+
 	for (int i = 0; i < AT_TCP_PROXY_MAX; i++) {
 		if (slm_util_cmd_casecmp(at_cmd,
 			m_tcp_proxy_at_list[i].string)) {
@@ -792,11 +850,6 @@ int slm_at_tcp_proxy_parse(const char *at_cmd, uint16_t length)
 		}
 	}
 
-	/* handle sending in data mode */
-	if (ret == -ENOENT && proxy.datamode) {
-		ret = do_tcp_send_datamode(at_cmd, length);
-	}
-
 	return ret;
 }
 
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <logging/log.h>
+
+#include "gps_pvt_queue.h"
+
+LOG_MODULE_REGISTER(gps_pvt_queue, CONFIG_GPS_PVT_QUEUE_LOG_LEVEL);
+
+/* HDOP limit is given in Kconfig in tenths. */
+#define MAX_HDOP (CONFIG_GPS_PVT_QUEUE_MAX_HDOP / 10.0f)
+
+static bool pvt_quality_ok(const struct gps_pvt *pvt)
+{
+	uint8_t sv_used = 0;
+
+	if ((CONFIG_GPS_PVT_QUEUE_MAX_HDOP > 0) && (pvt->hdop > MAX_HDOP)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < GPS_PVT_MAX_SV_COUNT; i++) {
+		if (pvt->sv[i].sv && pvt->sv[i].in_fix) {
+			sv_used++;
+		}
+	}
+
+	return sv_used >= CONFIG_GPS_PVT_QUEUE_MIN_SV_COUNT;
+}
+
+void gps_pvt_queue_reset(struct gps_pvt_queue *queue)
+{
+	k_spinlock_key_t key = k_spin_lock(&queue->lock);
+
+	queue->head = 0;
+	queue->count = 0;
+	queue->decimation_cnt = 0;
+
+	k_spin_unlock(&queue->lock, key);
+}
+
+size_t gps_pvt_queue_put(struct gps_pvt_queue *queue,
+			 const struct gps_pvt *pvt)
+{
+	k_spinlock_key_t key;
+	size_t count;
+	uint16_t idx;
+
+	key = k_spin_lock(&queue->lock);
+
+	queue->stats.received++;
+
+	if (!pvt_quality_ok(pvt)) {
+		queue->stats.rejected++;
+		k_spin_unlock(&queue->lock, key);
+		LOG_DBG("Fix rejected, HDOP too high or too few satellites");
+		return 0;
+	}
+
+	if (queue->decimation_cnt > 0) {
+		queue->decimation_cnt--;
+		queue->stats.decimated++;
+		k_spin_unlock(&queue->lock, key);
+		return 0;
+	}
+
+	queue->decimation_cnt = CONFIG_GPS_PVT_QUEUE_DECIMATION - 1;
+
+	if (queue->count == ARRAY_SIZE(queue->samples)) {
+		/* Drop the oldest sample to make room for the new one. */
+		queue->head = (queue->head + 1) % ARRAY_SIZE(queue->samples);
+		queue->count--;
+		queue->stats.overwritten++;
+	}
+
+	idx = (queue->head + queue->count) % ARRAY_SIZE(queue->samples);
+	memcpy(&queue->samples[idx], pvt, sizeof(queue->samples[idx]));
+	queue->count++;
+	count = queue->count;
+
+	k_spin_unlock(&queue->lock, key);
+
+	return count;
+}
+
+size_t gps_pvt_queue_get(struct gps_pvt_queue *queue, struct gps_pvt *buf,
+			 size_t count)
+{
+	k_spinlock_key_t key;
+	size_t read;
+
+	/* Move one sample at a time, so that the lock is never held for
+	 * longer than it takes to copy a single sample.
+	 */
+	for (read = 0; read < count; read++) {
+		key = k_spin_lock(&queue->lock);
+
+		if (queue->count == 0) {
+			k_spin_unlock(&queue->lock, key);
+			break;
+		}
+
+		memcpy(&buf[read], &queue->samples[queue->head],
+		       sizeof(buf[read]));
+		queue->head = (queue->head + 1) % ARRAY_SIZE(queue->samples);
+		queue->count--;
+
+		k_spin_unlock(&queue->lock, key);
+	}
+
+	return read;
+}
+
+void gps_pvt_queue_stats_get(struct gps_pvt_queue *queue,
+			     struct gps_pvt_queue_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&queue->lock);
+
+	memcpy(stats, &queue->stats, sizeof(*stats));
+
+	k_spin_unlock(&queue->lock, key);
+}
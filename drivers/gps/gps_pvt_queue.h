@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef GPS_PVT_QUEUE_H_
+#define GPS_PVT_QUEUE_H_
+
+#include <zephyr.h>
+#include <drivers/gps.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Statistics kept by the PVT queue. */
+struct gps_pvt_queue_stats {
+	/** Number of fixes offered to the queue. */
+	uint32_t received;
+	/** Number of fixes rejected by the quality filter. */
+	uint32_t rejected;
+	/** Number of fixes skipped because of decimation. */
+	uint32_t decimated;
+	/** Number of queued fixes overwritten before they were read. */
+	uint32_t overwritten;
+};
+
+/** @brief Ring of PVT samples shared between a GPS driver and the
+ *         application.
+ */
+struct gps_pvt_queue {
+	struct gps_pvt samples[CONFIG_GPS_PVT_QUEUE_SIZE];
+	uint16_t head;
+	uint16_t count;
+	uint16_t decimation_cnt;
+	struct gps_pvt_queue_stats stats;
+	struct k_spinlock lock;
+};
+
+/** @brief Empty the queue and reset the decimation counter.
+ *
+ * @param queue Pointer to the queue.
+ */
+void gps_pvt_queue_reset(struct gps_pvt_queue *queue);
+
+/** @brief Offer a position fix to the queue.
+ *
+ * The fix is stored only if it passes the quality filter and the
+ * decimation. If the queue is full, the oldest sample is overwritten.
+ *
+ * @param queue Pointer to the queue.
+ * @param pvt Position fix.
+ *
+ * @return Number of samples in the queue after storing the fix, or 0 if the
+ *	   fix was not stored.
+ */
+size_t gps_pvt_queue_put(struct gps_pvt_queue *queue,
+			 const struct gps_pvt *pvt);
+
+/** @brief Move the oldest samples from the queue to a buffer.
+ *
+ * The samples are moved one by one, so fixes stored in the meantime
+ * may be read as well.
+ *
+ * @param queue Pointer to the queue.
+ * @param buf Buffer for the samples.
+ * @param count Maximum number of samples to read.
+ *
+ * @return Number of samples read.
+ */
+size_t gps_pvt_queue_get(struct gps_pvt_queue *queue, struct gps_pvt *buf,
+			 size_t count);
+
+/** @brief Get a snapshot of the queue statistics.
+ *
+ * @param queue Pointer to the queue.
+ * @param stats Pointer to the structure where statistics are copied.
+ */
+void gps_pvt_queue_stats_get(struct gps_pvt_queue *queue,
+			     struct gps_pvt_queue_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GPS_PVT_QUEUE_H_ */
@@ -12,6 +12,9 @@
 #include <string.h>
 #include <logging/log.h>
 #include <math.h>
+#ifdef CONFIG_GPS_PVT_QUEUE
+#include "gps_pvt_queue.h"
+#endif
 
 #define BASE_GPS_SAMPLE_HOUR	(CONFIG_GPS_SIM_BASE_TIMESTAMP / 10000)
 #define BASE_GPS_SAMPLE_MINUTE	((CONFIG_GPS_SIM_BASE_TIMESTAMP / 100) % 100)
@@ -23,6 +26,10 @@
 #define GPS_NMEA_SENTENCE "$GPGGA,%02d%02d%02d.200,%8.3f,%c,%09.3f,%c,1,"      \
 			  "12,1.0,0.0,M,0.0,M,,*%02X"
 
+/* Satellite count and HDOP matching the NMEA sentence above. */
+#define GPS_SIM_SV_COUNT	12
+#define GPS_SIM_HDOP		1.0f
+
 LOG_MODULE_REGISTER(gps_sim, CONFIG_GPS_SIM_LOG_LEVEL);
 
 enum gps_sim_state {
@@ -38,6 +45,10 @@ struct gps_sim_data {
 	gps_event_handler_t handler;
 	struct gps_config cfg;
 	struct gps_nmea nmea_sample;
+#ifdef CONFIG_GPS_PVT_QUEUE
+	struct gps_pvt pvt_sample;
+	struct gps_pvt_queue pvt_queue;
+#endif
 	struct k_delayed_work start_work;
 	struct k_delayed_work stop_work;
 	struct k_delayed_work timeout_work;
@@ -104,15 +115,28 @@ static double generate_pseudo_random(void)
 	return (double)rand() / ((double)RAND_MAX / 2.0) - 1.0;
 }
 
+/**
+ * @brief Converts NMEA ddmm.mmm format to decimal degrees.
+ */
+static double nmea_to_degrees(double value)
+{
+	double degrees = floor(value / 100.0);
+
+	return degrees + (value - degrees * 100.0) / 60.0;
+}
+
 /**
  * @brief Function generatig GPS data
  *
  * @param gps_nmea Pointer to gps_nmea struct where the NMEA
  * sentence will be stored.
+ * @param gps_pvt Pointer to gps_pvt struct where the same position will be
+ * stored, or NULL.
  * @param max_variation The maximum value the latitude and longitude in the
  * generated sentence can vary for each iteration. In units of minutes.
  */
 static void generate_gps_data(struct gps_nmea *gps_data,
+			      struct gps_pvt *gps_pvt,
 			      double max_variation)
 {
 	static uint8_t hour = BASE_GPS_SAMPLE_HOUR;
@@ -156,6 +180,26 @@ static void generate_gps_data(struct gps_nmea *gps_data,
 		}
 	}
 
+	if (gps_pvt != NULL) {
+		memset(gps_pvt, 0, sizeof(*gps_pvt));
+
+		gps_pvt->latitude = nmea_to_degrees(fabs(lat));
+		gps_pvt->longitude = nmea_to_degrees(fabs(lng));
+		gps_pvt->latitude *= (lat < 0) ? -1.0 : 1.0;
+		gps_pvt->longitude *= (lng < 0) ? -1.0 : 1.0;
+		gps_pvt->hdop = GPS_SIM_HDOP;
+		gps_pvt->datetime.hour = hour;
+		gps_pvt->datetime.minute = minute;
+		gps_pvt->datetime.seconds = second;
+		gps_pvt->datetime.ms = 200;
+
+		for (size_t i = 0; i < GPS_SIM_SV_COUNT; i++) {
+			gps_pvt->sv[i].sv = i + 1;
+			gps_pvt->sv[i].signal = 1;
+			gps_pvt->sv[i].in_fix = 1;
+		}
+	}
+
 	if (lat < 0) {
 		lat *= -1.0;
 		lat_heading = 'S';
@@ -265,28 +309,84 @@ static void timeout_work_fn(struct k_work *work)
 	notify_event(drv_data->dev, &evt);
 }
 
-static void fix_work_fn(struct k_work *work)
+static void notify_nmea_fix(struct gps_sim_data *drv_data)
 {
-	struct gps_sim_data *drv_data =
-		CONTAINER_OF(work, struct gps_sim_data, fix_work);
 	struct gps_event evt = {
 		.type = GPS_EVT_NMEA_FIX,
 	};
 
+	evt.nmea.len = drv_data->nmea_sample.len;
+
+	memcpy(evt.nmea.buf, drv_data->nmea_sample.buf,
+	       drv_data->nmea_sample.len);
+	notify_event(drv_data->dev, &evt);
+}
+
+#ifdef CONFIG_GPS_PVT_QUEUE
+static bool pvt_queue_store(struct gps_sim_data *drv_data)
+{
+	struct gps_event evt = {
+		.type = GPS_EVT_PVT_QUEUE_READY,
+	};
+	size_t queued = gps_pvt_queue_put(&drv_data->pvt_queue,
+					  &drv_data->pvt_sample);
+
+	if (queued == 0) {
+		return false;
+	}
+
+	if ((queued >= CONFIG_GPS_PVT_QUEUE_WATERMARK) ||
+	    (drv_data->cfg.nav_mode != GPS_NAV_MODE_CONTINUOUS)) {
+		notify_event(drv_data->dev, &evt);
+	}
+
+	return true;
+}
+
+static int pvt_read(struct device *dev, struct gps_pvt *buf, size_t count)
+{
+	struct gps_sim_data *drv_data = dev->data;
+
+	if (drv_data->state == GPS_SIM_UNINIT) {
+		LOG_ERR("The GPS simulator must be initialized first");
+		return -ENODEV;
+	}
+
+	return gps_pvt_queue_get(&drv_data->pvt_queue, buf, count);
+}
+#endif
+
+static void fix_work_fn(struct k_work *work)
+{
+	struct gps_sim_data *drv_data =
+		CONTAINER_OF(work, struct gps_sim_data, fix_work);
+
 	if (drv_data->state != GPS_SIM_ACTIVE_SEARCH) {
 		return;
 	}
 
-	k_delayed_work_cancel(&drv_data->timeout_work);
-
-	generate_gps_data(&drv_data->nmea_sample,
+#ifdef CONFIG_GPS_PVT_QUEUE
+	generate_gps_data(&drv_data->nmea_sample, &drv_data->pvt_sample,
 			  CONFIG_GPS_SIM_MAX_STEP / 1000.0);
 
-	evt.nmea.len = drv_data->nmea_sample.len;
+	if (IS_ENABLED(CONFIG_GPS_PVT_QUEUE_NMEA_EVENTS)) {
+		notify_nmea_fix(drv_data);
+	}
 
-	memcpy(evt.nmea.buf, drv_data->nmea_sample.buf,
-	       drv_data->nmea_sample.len);
-	notify_event(drv_data->dev, &evt);
+	if (!pvt_queue_store(drv_data)) {
+		/* A fix that was filtered out does not end the search. */
+		k_delayed_work_submit_to_queue(&drv_data->work_q,
+					       &drv_data->fix_work,
+					       K_MSEC(CONFIG_GPS_SIM_FIX_TIME));
+		return;
+	}
+#else
+	generate_gps_data(&drv_data->nmea_sample, NULL,
+			  CONFIG_GPS_SIM_MAX_STEP / 1000.0);
+	notify_nmea_fix(drv_data);
+#endif
+
+	k_delayed_work_cancel(&drv_data->timeout_work);
 
 	if (drv_data->cfg.nav_mode == GPS_NAV_MODE_CONTINUOUS) {
 		k_delayed_work_submit_to_queue(&drv_data->work_q,
@@ -369,6 +469,10 @@ static int init(struct device *dev, gps_event_handler_t handler)
 	drv_data->handler = handler;
 	drv_data->state = GPS_SIM_IDLE;
 
+#ifdef CONFIG_GPS_PVT_QUEUE
+	gps_pvt_queue_reset(&drv_data->pvt_queue);
+#endif
+
 	return 0;
 }
 
@@ -395,6 +499,9 @@ static const struct gps_driver_api gps_sim_api_funcs = {
 	.init = init,
 	.start = start,
 	.stop = stop,
+#ifdef CONFIG_GPS_PVT_QUEUE
+	.pvt_read = pvt_read,
+#endif
 };
 
 /* TODO: Remove this when the GPS API has Kconfig that sets the priority */
@@ -21,6 +21,9 @@
 #include <modem/lte_lc.h>
 #endif
 #include <modem/bsdlib.h>
+#ifdef CONFIG_GPS_PVT_QUEUE
+#include "gps_pvt_queue.h"
+#endif
 
 LOG_MODULE_REGISTER(nrf9160_gps, CONFIG_NRF9160_GPS_LOG_LEVEL);
 
@@ -58,6 +61,9 @@ struct gps_drv_data {
 	struct k_delayed_work start_work;
 	struct k_delayed_work stop_work;
 	struct k_delayed_work timeout_work;
+#ifdef CONFIG_GPS_PVT_QUEUE
+	struct gps_pvt_queue pvt_queue;
+#endif
 };
 
 struct nrf9160_gps_config {
@@ -114,6 +120,10 @@ static void copy_pvt(struct gps_pvt *dest, nrf_gnss_pvt_data_frame_t *src)
 		dest->sv[i].elevation = src->sv[i].elevation;
 		dest->sv[i].azimuth = src->sv[i].azimuth;
 		dest->sv[i].signal = src->sv[i].signal;
+		dest->sv[i].in_fix = (src->sv[i].flags &
+				      NRF_GNSS_SV_FLAG_USED_IN_FIX) ? 1 : 0;
+		dest->sv[i].unhealthy = (src->sv[i].flags &
+					 NRF_GNSS_SV_FLAG_UNHEALTHY) ? 1 : 0;
 	}
 }
 
@@ -181,6 +191,44 @@ static void notify_event(struct device *dev, struct gps_event *evt)
 	}
 }
 
+#ifdef CONFIG_GPS_PVT_QUEUE
+/**@brief Stores a position fix in the PVT queue and notifies the application
+ *	  when enough fixes are available.
+ *
+ * @return true if the fix was stored, false if it was filtered out.
+ */
+static bool pvt_queue_store(struct device *dev, struct gps_pvt *pvt)
+{
+	struct gps_drv_data *drv_data = dev->data;
+	struct gps_event evt = {
+		.type = GPS_EVT_PVT_QUEUE_READY
+	};
+	size_t queued = gps_pvt_queue_put(&drv_data->pvt_queue, pvt);
+
+	if (queued == 0) {
+		return false;
+	}
+
+	if ((queued >= CONFIG_GPS_PVT_QUEUE_WATERMARK) ||
+	    (drv_data->current_cfg.nav_mode != GPS_NAV_MODE_CONTINUOUS)) {
+		notify_event(dev, &evt);
+	}
+
+	return true;
+}
+
+static void pvt_queue_print_stats(struct gps_drv_data *drv_data)
+{
+	struct gps_pvt_queue_stats stats;
+
+	gps_pvt_queue_stats_get(&drv_data->pvt_queue, &stats);
+
+	LOG_DBG("PVT queue: %u received, %u rejected, %u decimated, "
+		"%u overwritten", stats.received, stats.rejected,
+		stats.decimated, stats.overwritten);
+}
+#endif
+
 static void on_fix(struct device *dev)
 {
 	struct gps_drv_data *drv_data = dev->data;
@@ -312,12 +360,24 @@ wait:
 				evt.type = GPS_EVT_PVT_FIX;
 				fix_timestamp = k_uptime_get();
 				has_fix = true;
-				on_fix(dev);
 			} else {
 				evt.type = GPS_EVT_PVT;
 			}
 
+#ifdef CONFIG_GPS_PVT_QUEUE
+			/* Only fixes are reported, through the queue. A fix
+			 * that was filtered out does not end the search.
+			 */
+			if (has_fix && pvt_queue_store(dev, &evt.pvt)) {
+				on_fix(dev);
+			}
+#else
+			if (has_fix) {
+				on_fix(dev);
+			}
+
 			notify_event(dev, &evt);
+#endif
 			print_satellite_stats(&raw_gps_data);
 
 			break;
@@ -326,6 +386,11 @@ wait:
 				continue;
 			}
 
+			if (IS_ENABLED(CONFIG_GPS_PVT_QUEUE) &&
+			    !IS_ENABLED(CONFIG_GPS_PVT_QUEUE_NMEA_EVENTS)) {
+				continue;
+			}
+
 			memcpy(evt.nmea.buf, raw_gps_data.nmea, len);
 
 			/* Don't count null terminator. */
@@ -731,6 +796,10 @@ static int stop_gps(struct device *dev, bool is_timeout)
 		return -EIO;
 	}
 
+#ifdef CONFIG_GPS_PVT_QUEUE
+	pvt_queue_print_stats(drv_data);
+#endif
+
 	return 0;
 }
 
@@ -834,6 +903,20 @@ static int agps_write(struct device *dev, enum gps_agps_type type, void *data,
 	return 0;
 }
 
+#ifdef CONFIG_GPS_PVT_QUEUE
+static int pvt_read(struct device *dev, struct gps_pvt *buf, size_t count)
+{
+	struct gps_drv_data *drv_data = dev->data;
+
+	if (atomic_get(&drv_data->is_init) != 1) {
+		LOG_WRN("GPS must be initialized first");
+		return -ENODEV;
+	}
+
+	return gps_pvt_queue_get(&drv_data->pvt_queue, buf, count);
+}
+#endif
+
 static int init(struct device *dev, gps_event_handler_t handler)
 {
 	struct gps_drv_data *drv_data = dev->data;
@@ -864,6 +947,9 @@ static int init(struct device *dev, gps_event_handler_t handler)
 	k_delayed_work_init(&drv_data->stop_work, stop_work_fn);
 	k_delayed_work_init(&drv_data->timeout_work, timeout_work_fn);
 	k_sem_init(&drv_data->thread_run_sem, 0, 1);
+#ifdef CONFIG_GPS_PVT_QUEUE
+	gps_pvt_queue_reset(&drv_data->pvt_queue);
+#endif
 
 	err = init_thread(dev);
 	if (err) {
@@ -885,6 +971,9 @@ static const struct gps_driver_api gps_api_funcs = {
 	.start = start,
 	.stop = stop,
 	.agps_write = agps_write,
+#ifdef CONFIG_GPS_PVT_QUEUE
+	.pvt_read = pvt_read,
+#endif
 };
 
 DEVICE_AND_API_INIT(nrf9160_gps, CONFIG_NRF9160_GPS_DEV_NAME, setup,
@@ -134,6 +134,9 @@ struct pmw3360_data {
 	struct device                *spi_dev;
 	struct gpio_callback         irq_gpio_cb;
 	struct k_spinlock            lock;
+	struct k_mutex               access_lock;
+	atomic_t                     acc_x;
+	atomic_t                     acc_y;
 	int16_t                        x;
 	int16_t                        y;
 	sensor_trigger_handler_t     data_ready_handler;
@@ -143,6 +146,7 @@ struct pmw3360_data {
 	int                          err;
 	bool                         ready;
 	bool                         last_read_burst;
+	bool                         irq_rearm;
 };
 
 static const struct spi_config spi_cfg = {
@@ -373,6 +377,53 @@ static int motion_burst_read(struct pmw3360_data *dev_data, uint8_t *data,
 	return 0;
 }
 
+static bool motion_pending(struct pmw3360_data *dev_data)
+{
+	/* Motion pin is asserted (low) until motion data is read. */
+	return (gpio_pin_get_raw(dev_data->irq_gpio_dev,
+				 PMW3360_IRQ_GPIO_PIN) == 0);
+}
+
+static int motion_accumulate(struct pmw3360_data *dev_data)
+{
+	uint8_t data[PMW3360_BURST_SIZE];
+	int err = motion_burst_read(dev_data, data, sizeof(data));
+
+	if (err) {
+		return err;
+	}
+
+	int16_t x = sys_get_le16(&data[PMW3360_DX_POS]);
+	int16_t y = sys_get_le16(&data[PMW3360_DY_POS]);
+
+	if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_0)) {
+		atomic_add(&dev_data->acc_x, -x);
+		atomic_add(&dev_data->acc_y, y);
+	} else if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_90)) {
+		atomic_add(&dev_data->acc_x, y);
+		atomic_add(&dev_data->acc_y, x);
+	} else if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_180)) {
+		atomic_add(&dev_data->acc_x, x);
+		atomic_add(&dev_data->acc_y, -y);
+	} else if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_270)) {
+		atomic_add(&dev_data->acc_x, -y);
+		atomic_add(&dev_data->acc_y, -x);
+	}
+
+	return 0;
+}
+
+static int16_t motion_drain(atomic_t *acc)
+{
+	atomic_val_t val = atomic_get(acc);
+	int16_t reported = MAX(MIN(val, INT16_MAX), INT16_MIN);
+
+	/* Motion beyond the sample range is kept for the next fetch. */
+	atomic_sub(acc, reported);
+
+	return reported;
+}
+
 static int burst_write(struct pmw3360_data *dev_data, uint8_t reg, const uint8_t *buf,
 		       size_t size)
 {
@@ -706,6 +757,32 @@ static void trigger_handler(struct k_work *work)
 		return;
 	}
 
+	/* Read motion data as soon as the sensor signals it. The motion is
+	 * accumulated until the next sample fetch.
+	 */
+	k_mutex_lock(&pmw3360_data.access_lock, K_FOREVER);
+	if (pmw3360_data.ready) {
+		err = motion_accumulate(&pmw3360_data);
+	} else {
+		err = -EBUSY;
+	}
+	k_mutex_unlock(&pmw3360_data.access_lock);
+
+	/* The motion pin stays asserted until the motion is read. Enabling
+	 * the level interrupt now would only trigger this work again, so it
+	 * is enabled after the next successful sample fetch instead.
+	 */
+	bool rearm_later = (err != 0);
+
+	if (err) {
+		LOG_ERR("Cannot read motion data");
+		err = 0;
+
+		key = k_spin_lock(&pmw3360_data.lock);
+		pmw3360_data.irq_rearm = true;
+		k_spin_unlock(&pmw3360_data.lock, key);
+	}
+
 	struct sensor_trigger trig = {
 		.type = SENSOR_TRIG_DATA_READY,
 		.chan = SENSOR_CHAN_ALL,
@@ -714,7 +791,7 @@ static void trigger_handler(struct k_work *work)
 	handler(DEVICE_GET(pmw3360), &trig);
 
 	key = k_spin_lock(&pmw3360_data.lock);
-	if (pmw3360_data.data_ready_handler) {
+	if (pmw3360_data.data_ready_handler && !rearm_later) {
 		err = gpio_pin_interrupt_configure(pmw3360_data.irq_gpio_dev,
 						   PMW3360_IRQ_GPIO_PIN,
 						   GPIO_INT_LEVEL_LOW);
@@ -857,6 +934,7 @@ static int pmw3360_init(struct device *dev)
 	ARG_UNUSED(dev);
 
 	k_work_init(&dev_data->trigger_handler_work, trigger_handler);
+	k_mutex_init(&dev_data->access_lock);
 
 	err = pmw3360_init_cs(dev_data);
 	if (err) {
@@ -885,7 +963,7 @@ static int pmw3360_init(struct device *dev)
 static int pmw3360_sample_fetch(struct device *dev, enum sensor_channel chan)
 {
 	struct pmw3360_data *dev_data = &pmw3360_data;
-	uint8_t data[PMW3360_BURST_SIZE];
+	int err = 0;
 
 	ARG_UNUSED(dev);
 
@@ -894,27 +972,36 @@ static int pmw3360_sample_fetch(struct device *dev, enum sensor_channel chan)
 		return -EBUSY;
 	}
 
-	int err = motion_burst_read(dev_data, data, sizeof(data));
+	k_mutex_lock(&dev_data->access_lock, K_FOREVER);
+
+	/* SPI transfer is needed only if the sensor has unread motion. */
+	if (motion_pending(dev_data)) {
+		err = motion_accumulate(dev_data);
+	}
+
+	k_mutex_unlock(&dev_data->access_lock);
+
+	if (err) {
+		return err;
+	}
 
+	dev_data->x = motion_drain(&dev_data->acc_x);
+	dev_data->y = motion_drain(&dev_data->acc_y);
+
+	/* Motion pin is released, the interrupt can be enabled again. */
+	k_spinlock_key_t key = k_spin_lock(&dev_data->lock);
+
+	if (dev_data->irq_rearm && dev_data->data_ready_handler) {
+		err = gpio_pin_interrupt_configure(dev_data->irq_gpio_dev,
+						   PMW3360_IRQ_GPIO_PIN,
+						   GPIO_INT_LEVEL_LOW);
+	}
 	if (!err) {
-		int16_t x = sys_get_le16(&data[PMW3360_DX_POS]);
-		int16_t y = sys_get_le16(&data[PMW3360_DY_POS]);
-
-		if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_0)) {
-			dev_data->x = -x;
-			dev_data->y = y;
-		} else if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_90)) {
-			dev_data->x = y;
-			dev_data->y = x;
-		} else if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_180)) {
-			dev_data->x = x;
-			dev_data->y = -y;
-		} else if (IS_ENABLED(CONFIG_PMW3360_ORIENTATION_270)) {
-			dev_data->x = -y;
-			dev_data->y = -x;
-		}
+		dev_data->irq_rearm = false;
 	}
 
+	k_spin_unlock(&dev_data->lock, key);
+
 	return err;
 }
 
@@ -984,6 +1071,7 @@ static int pmw3360_trigger_set(struct device *dev,
 
 	if (!err) {
 		dev_data->data_ready_handler = handler;
+		dev_data->irq_rearm = false;
 	}
 
 	k_spin_unlock(&dev_data->lock, key);
@@ -1009,6 +1097,8 @@ static int pmw3360_attr_set(struct device *dev, enum sensor_channel chan,
 		return -EBUSY;
 	}
 
+	k_mutex_lock(&dev_data->access_lock, K_FOREVER);
+
 	switch ((uint32_t)attr) {
 	case PMW3360_ATTR_CPI:
 		err = update_cpi(dev_data, PMW3360_SVALUE_TO_CPI(*val));
@@ -1061,9 +1151,12 @@ static int pmw3360_attr_set(struct device *dev, enum sensor_channel chan,
 
 	default:
 		LOG_ERR("Unknown attribute");
-		return -ENOTSUP;
+		err = -ENOTSUP;
+		break;
 	}
 
+	k_mutex_unlock(&dev_data->access_lock);
+
 	return err;
 }
 
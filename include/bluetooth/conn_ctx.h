@@ -34,32 +34,60 @@ extern "C" {
 			  (_max_clients),                                      \
 			  CONFIG_BT_CONN_CTX_MEM_BUF_ALIGN);                   \
 	K_MUTEX_DEFINE(_name##_mutex);                                         \
+	static uint8_t _name##_block_ctx[_max_clients];                        \
 	static struct bt_conn_ctx_lib CONCAT(_name, _ctx_lib) =                \
 	{                                                                      \
 		.mem_slab = &CONCAT(_name, _mem_slab),                         \
-		.mutex = &_name##_mutex                                        \
+		.mutex = &_name##_mutex,                                       \
+		.block_ctx = _name##_block_ctx                                 \
 	}
 
-/** @brief Context data for a connection. */
+/** @brief Context data for a connection.
+ *
+ * Getting a context takes a reference to it without searching, as the
+ * contexts are indexed by the connection index. Reading the context data
+ * is not lock-free, though: each context has a mutex that is held from
+ * getting the context until releasing it. Users of different connections
+ * do not wait for each other.
+ */
 struct bt_conn_ctx {
 	/** Any kind of data associated with a specific connection. */
 	void *data;
 
 	 /** The connection that the data is associated with. */
 	struct bt_conn *conn;
+
+	/** Internal reference count. */
+	atomic_t ref;
+
+	/** Lock that gives a single user access to the context data. */
+	struct k_mutex lock;
 };
 
+/**
+ * @brief Callback for iterating over the connection contexts.
+ *
+ * @param ctx		Connection context.
+ * @param user_data	User data passed to @ref bt_conn_ctx_foreach.
+ */
+typedef void (*bt_conn_ctx_cb_t)(const struct bt_conn_ctx *ctx,
+				 void *user_data);
+
 /** @brief Bluetooth connection context library structure. */
 struct bt_conn_ctx_lib {
-	/** Connection contexts. */
+	/** Connection contexts, indexed by the connection index. */
 	struct bt_conn_ctx ctx[CONFIG_BT_MAX_CONN];
 
-	/** Context data mutex that ensures that only one connection context is
-	  * manipulated at a time. */
+	/** Mutex that ensures that only one connection context is allocated
+	  * or freed at a time. Access to the context data is guarded by
+	  * the lock of each context. */
 	struct k_mutex * const mutex;
 
 	/** Memory slab instance where the memory is allocated. */
 	struct k_mem_slab * const mem_slab;
+
+	/** Index of the context that owns each memory block. */
+	uint8_t * const block_ctx;
 };
 
 /**
@@ -90,6 +118,11 @@ static inline size_t bt_conn_ctx_count(struct bt_conn_ctx_lib *ctx_lib)
  * @brief Allocate memory for the connection context data.
  *
  * This function can set the pointer to the allocated memory.
+ * The context data is locked until it is released.
+ *
+ * The context is stored in the slot of the connection index. If a user of
+ * a previous connection with the same index still holds its context,
+ * another free slot is used.
  *
  * This function should be used in conjunction with
  * @ref bt_conn_ctx_release to ensure proper operation.
@@ -105,6 +138,9 @@ void *bt_conn_ctx_alloc(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn);
 /**
  * @brief Free the allocated memory for a connection.
  *
+ * If the context data is in use, the memory is released when the last user
+ * calls @ref bt_conn_ctx_release.
+ *
  * @param ctx_lib	Bluetooth connection context library instance.
  * @param conn		Bluetooth connection.
  *
@@ -124,7 +160,10 @@ void bt_conn_ctx_free_all(struct bt_conn_ctx_lib *ctx_lib);
  * @brief Get the context data of a connection from the memory pool.
  *
  * This function finds a connection's context data in the memory pool.
- * The link to find is identified by the connection object.
+ * The link to find is identified by the connection object, which is mapped
+ * directly to its context. The context data is kept allocated until it is
+ * released. The function blocks while another user holds the context, and
+ * the context data is locked until it is released.
  *
  * This function should be used in conjunction with
  * @ref bt_conn_ctx_release to ensure proper operation.
@@ -142,7 +181,9 @@ void *bt_conn_ctx_get(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn);
  *
  * This function finds the connection context and the associated connection
  * object in the memory pool. The link to find is identified
- * by its index in the connection context array.
+ * by its index in the connection context array. The function blocks while
+ * another user holds the context, and the context data is locked until it is
+ * released.
  *
  * This function should be used in conjunction with
  * @ref bt_conn_ctx_release to ensure proper operation.
@@ -158,8 +199,8 @@ const struct bt_conn_ctx *bt_conn_ctx_get_by_id(struct bt_conn_ctx_lib *ctx_lib,
 /**
  * @brief Release a connection context from the memory pool.
  *
- * This function finds and releases a connection context in the memory pool.
- * The link to find is identified by its context data.
+ * This function finds, unlocks, and releases a connection context in
+ * the memory pool. The link to find is identified by its context data.
  *
  * This function should be used in conjunction with @ref bt_conn_ctx_alloc,
  * @ref bt_conn_ctx_get, or @ref bt_conn_ctx_get_by_id to ensure proper
@@ -170,6 +211,25 @@ const struct bt_conn_ctx *bt_conn_ctx_get_by_id(struct bt_conn_ctx_lib *ctx_lib,
  */
 void bt_conn_ctx_release(struct bt_conn_ctx_lib *ctx_lib, void *data);
 
+/**
+ * @brief Call a function for each allocated connection context.
+ *
+ * The function is called with a reference to each context, which keeps its
+ * memory allocated, but without locking the context. Hence the function
+ * does not wait for the other users of a context, and can be called while
+ * holding a context. The function must not keep the context or its data
+ * after it returns, and should get the context with @ref bt_conn_ctx_get if
+ * it needs exclusive access to the context data.
+ *
+ * @param ctx_lib	Bluetooth connection context library instance.
+ * @param func		Function to call.
+ * @param user_data	Data to pass to the function.
+ *
+ * @return Number of connection contexts iterated over.
+ */
+size_t bt_conn_ctx_foreach(struct bt_conn_ctx_lib *ctx_lib,
+			   bt_conn_ctx_cb_t func, void *user_data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -264,9 +264,10 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_next(
  * This function is asynchronous. Discovery results are passed through
  * the supplied callback.
  *
- * @note Only one discovery procedure can be started simultaneously. To start
- * another one, wait for the result of the previous procedure to finish
- * and call @ref bt_gatt_dm_data_release if it was successful.
+ * @note Up to CONFIG_BT_GATT_DM_MAX_INSTANCES discovery procedures can be
+ * started simultaneously. To start another one, wait for the result of
+ * a previous procedure to finish and call @ref bt_gatt_dm_data_release
+ * if it was successful.
  *
  * @param[in]     conn Connection object.
  * @param[in]     svc_uuid UUID of target service
@@ -287,6 +288,35 @@ int bt_gatt_dm_start(struct bt_conn *conn,
 		     const struct bt_gatt_dm_cb *cb,
 		     void *context);
 
+/** @brief Start service discovery using caller-provided memory.
+ *
+ * This function works like @ref bt_gatt_dm_start, but stores the discovery
+ * data in the given memory instead of allocating it from the heap.
+ * The memory is used for this discovery and the discoveries continued
+ * with @ref bt_gatt_dm_continue, and must stay valid until the discovery
+ * data is released.
+ *
+ * @param[in]     conn Connection object.
+ * @param[in]     svc_uuid UUID of target service
+ *                or NULL if any service should be discovered.
+ * @param[in]     cb Callback structure.
+ * @param[in,out] context Context argument to be passed to
+ *                callback functions.
+ * @param[in]     arena Memory for the discovery data, 4-byte aligned.
+ * @param[in]     arena_size Size of the memory in bytes.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ *           The error callback reports -ENOMEM if the memory is too small
+ *           for the discovered service.
+ */
+int bt_gatt_dm_start_arena(struct bt_conn *conn,
+			   const struct bt_uuid *svc_uuid,
+			   const struct bt_gatt_dm_cb *cb,
+			   void *context,
+			   void *arena,
+			   size_t arena_size);
+
 /** @brief Continue service discovery.
  *
  * This function continues service discovery.
@@ -327,6 +357,26 @@ static inline void bt_gatt_dm_data_print(const struct bt_gatt_dm *dm)
 }
 #endif
 
+/** @brief Remove cached discovery results.
+ *
+ * The results are cached by the peer address returned by
+ * bt_conn_get_dst(), which is the identity address for a bonded peer
+ * whose address was resolved. Results are not cached for peers that use
+ * an unresolved random private address.
+ *
+ * Call this function when a peer is unpaired, so that its data is not
+ * kept in the cache.
+ *
+ * @param[in] addr Peer address, or NULL to clear the whole cache.
+ */
+#ifdef CONFIG_BT_GATT_DM_CACHE
+void bt_gatt_dm_cache_clear(const bt_addr_le_t *addr);
+#else
+static inline void bt_gatt_dm_cache_clear(const bt_addr_le_t *addr)
+{
+}
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -185,6 +185,19 @@ struct bt_scan_init_param {
 	const struct bt_le_conn_param *conn_param;
 };
 
+/**@brief Duplicate report filter statistics.
+ */
+struct bt_scan_duplicate_stats {
+	/** Number of reports passed on to the filters and callbacks. */
+	uint32_t passed;
+
+	/** Number of reports suppressed as duplicates. */
+	uint32_t suppressed;
+
+	/** Number of devices replaced in the full cache. */
+	uint32_t evicted;
+};
+
 /**@brief Name filter status structure, used to inform the application
  *        which name filter is matched.
  */
@@ -500,8 +513,60 @@ int bt_scan_filter_add(enum bt_scan_filter_type type,
  */
 void bt_scan_filter_remove_all(void);
 
+/**@brief Function for getting the filter hit counters.
+ *
+ * @details Each filter of the given type counts the advertising reports
+ *          it has been matched against, in the order in which the
+ *          filters were added. The counters are reset when the filters
+ *          are removed.
+ *
+ * @param[in] type Filter type.
+ * @param[out] hits Array to store the counters in.
+ * @param[in,out] count In: number of elements in the @p hits array.
+ *                      Out: number of counters stored.
+ *
+ * @return 0 If the operation was successful. Otherwise, a (negative) error
+ *	     code is returned.
+ */
+int bt_scan_filter_hits_get(enum bt_scan_filter_type type, uint32_t *hits,
+			    size_t *count);
+
 #endif /* CONFIG_BT_SCAN_FILTER_ENABLE */
 
+#if CONFIG_BT_SCAN_DUPLICATE_FILTER
+
+/**@brief Function for configuring the duplicate report filter.
+ *
+ * @details An advertising report that repeats the last report passed on
+ *          for the same device and advertising type is suppressed,
+ *          unless the RSSI has changed by at least @p rssi_threshold or
+ *          @p ttl_ms has passed since the last report passed on.
+ *          Connectable reports are not suppressed if the module connects
+ *          automatically on a filter match.
+ *          The initial values are taken from the static configuration.
+ *
+ * @param[in] ttl_ms Time after which an unchanged report is passed on
+ *                   again, in milliseconds. 0 to never pass it on.
+ * @param[in] rssi_threshold RSSI change that passes on an unchanged
+ *                           report, in dBm. 0 to ignore RSSI changes.
+ */
+void bt_scan_duplicate_filter_set(uint32_t ttl_ms, uint8_t rssi_threshold);
+
+/**@brief Function for clearing the duplicate report cache.
+ *
+ * @details The next report from every device is passed on.
+ *          The cache is also cleared by @ref bt_scan_start.
+ */
+void bt_scan_duplicate_cache_clear(void);
+
+/**@brief Function for getting the duplicate report filter statistics.
+ *
+ * @param[out] stats Statistics since the module was initialized.
+ */
+void bt_scan_duplicate_stats_get(struct bt_scan_duplicate_stats *stats);
+
+#endif /* CONFIG_BT_SCAN_DUPLICATE_FILTER */
+
 /**@brief Function for changing the scanning parameters.
  *
  * @details Use this function to change scanning parameters.
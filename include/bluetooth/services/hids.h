@@ -18,6 +18,7 @@
 extern "C" {
 #endif
 
+#include <sys/atomic.h>
 #include <bluetooth/gatt_pool.h>
 #include <bluetooth/gatt.h>
 #include <bluetooth/conn_ctx.h>
@@ -160,6 +161,19 @@ struct bt_gatt_hids_rep {
 	uint8_t size;
 };
 
+/** @brief Input Report data for @ref bt_gatt_hids_inp_rep_batch_send.
+ */
+struct bt_gatt_hids_inp_rep_data {
+	/** Index of the report descriptor. */
+	uint8_t rep_index;
+
+	/** Length of the report data. */
+	uint8_t len;
+
+	/** Pointer to the report data. */
+	uint8_t const *data;
+};
+
 /** @brief HID notification event handler.
  *
  *  @param evt Notification event.
@@ -459,6 +473,11 @@ struct bt_gatt_hids {
 
 	/** Bluetooth connection contexts. */
 	struct bt_conn_ctx_lib *conn_ctx;
+
+	/** Input Reports with notification enabled by at least one
+	 *  connected peer, updated when the CCC descriptors change.
+	 */
+	ATOMIC_DEFINE(inp_rep_notif, CONFIG_BT_GATT_HIDS_INPUT_REP_MAX);
 };
 
 /** @brief HID Connection context data structure.
@@ -553,6 +572,36 @@ int bt_gatt_hids_inp_rep_send(struct bt_gatt_hids *hids_obj,
 			      uint8_t const *rep, uint8_t len,
 			      bt_gatt_complete_func_t cb);
 
+/** @brief Send several Input Reports.
+ *
+ *  The reports are stored in the connection contexts in a single pass
+ *  and notified in the order they are given. Reports for which
+ *  notification is disabled are skipped.
+ *
+ *  @warning The function is not thread safe.
+ *	     It can not be called from multiple threads at the same time.
+ *
+ *  @param hids_obj Pointer to HIDS instance.
+ *  @param conn Pointer to Connection Object, or NULL to send the reports
+ *              to all connected peers.
+ *  @param reps Array of reports to send.
+ *  @param count Number of reports in the array.
+ *  @param cb Notification complete callback, called for every report
+ *            (can be NULL).
+ *  @param done Number of reports from the start of the array that were
+ *              notified or skipped (can be NULL). If the notification of
+ *              a report fails, this is the index of that report, so the
+ *              rest of the batch can be sent again.
+ *
+ *  @return Number of reports notified if the operation was successful.
+ *	    Otherwise, a (negative) error code is returned.
+ */
+int bt_gatt_hids_inp_rep_batch_send(struct bt_gatt_hids *hids_obj,
+				    struct bt_conn *conn,
+				    const struct bt_gatt_hids_inp_rep_data *reps,
+				    size_t count, bt_gatt_complete_func_t cb,
+				    size_t *done);
+
 /** @brief Send Boot Mouse Input Report.
  *
  *  @warning The function is not thread safe.
@@ -101,6 +101,50 @@ static inline uint32_t bt_gatt_nus_max_send(struct bt_conn *conn)
 	return bt_gatt_get_mtu(conn) - 3;
 }
 
+/**@brief Start the stream to a connected peer.
+ *
+ * @details Data written to the stream with @ref bt_gatt_nus_stream_write
+ *          is sent to the peer as notifications. Data is packed into
+ *          notifications of the ATT MTU size, and up to
+ *          CONFIG_BT_GATT_NUS_STREAM_TX_MAX notifications are sent without
+ *          waiting for the previous ones to complete. Data is dropped if
+ *          the peer has not enabled notifications.
+ *
+ * @param[in] conn Pointer to connection object.
+ *
+ * @retval 0 If the stream is started.
+ * @retval -EALREADY If the stream is already started.
+ * @retval -EINVAL If the connection object is NULL.
+ */
+int bt_gatt_nus_stream_start(struct bt_conn *conn);
+
+/**@brief Stop the stream and drop the data that was not sent yet.
+ *
+ * @details Call this function when the connection is lost. Notifications
+ *          that are still in flight are not counted by a stream started
+ *          later.
+ */
+void bt_gatt_nus_stream_stop(void);
+
+/**@brief Write data to the stream.
+ *
+ * @details The data is copied to the stream buffer and sent in the
+ *          background.
+ *
+ * @param[in] data Pointer to the data.
+ * @param[in] len  Length of the data.
+ *
+ * @return Number of bytes written, which is lower than @p len if the
+ *         stream buffer is full or zero if the stream is not started.
+ */
+uint32_t bt_gatt_nus_stream_write(const uint8_t *data, uint32_t len);
+
+/**@brief Get free space in the stream buffer.
+ *
+ * @return Number of bytes that can be written to the stream.
+ */
+uint32_t bt_gatt_nus_stream_space_get(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -162,6 +162,7 @@ enum gps_event_type {
 	GPS_EVT_OPERATION_UNBLOCKED,
 	GPS_EVT_AGPS_DATA_NEEDED,
 	GPS_EVT_ERROR,
+	GPS_EVT_PVT_QUEUE_READY,
 };
 
 /**
@@ -216,6 +217,15 @@ typedef int (*gps_stop_t)(struct device *dev);
 typedef int (*gps_agps_write_t)(struct device *dev, enum gps_agps_type type,
 				void *data, size_t data_len);
 
+/**
+ * @typedef gps_pvt_read_t
+ * @brief Callback API for reading queued position fixes.
+ *
+ * See gps_pvt_read() for argument description
+ */
+typedef int (*gps_pvt_read_t)(struct device *dev, struct gps_pvt *buf,
+			      size_t count);
+
 /**
  * @typedef gps_init_t
  * @brief Callback API for initializing GPS device.
@@ -241,6 +251,7 @@ struct gps_driver_api {
 	gps_start_t start;
 	gps_stop_t stop;
 	gps_agps_write_t agps_write;
+	gps_pvt_read_t pvt_read;
 	gps_init_t init;
 	gps_deinit_t deinit;
 };
@@ -318,6 +329,37 @@ static inline int gps_agps_write(struct device *dev, enum gps_agps_type type,
 	return api->agps_write(dev, type, data, data_len);
 }
 
+/**
+ * @brief Function to read position fixes queued by the GPS driver.
+ *
+ * Fixes are queued when CONFIG_GPS_PVT_QUEUE is enabled. The driver sends
+ * GPS_EVT_PVT_QUEUE_READY when fixes are available. This function can be
+ * called from the event handler.
+ *
+ * @param dev Pointer to GPS device
+ * @param buf Buffer for the position fixes, oldest first
+ * @param count Maximum number of position fixes to read
+ *
+ * @return Number of position fixes read or (negative) error code otherwise.
+ */
+static inline int gps_pvt_read(struct device *dev, struct gps_pvt *buf,
+			       size_t count)
+{
+	struct gps_driver_api *api;
+
+	if ((dev == NULL) || (buf == NULL)) {
+		return -EINVAL;
+	}
+
+	api = (struct gps_driver_api *)dev->api;
+
+	if (api->pvt_read == NULL) {
+		return -ENOTSUP;
+	}
+
+	return api->pvt_read(dev, buf, count);
+}
+
 /**
  * @brief Initializes GPS device.
  *
@@ -291,14 +291,45 @@ bool esb_is_idle(void);
 int esb_write_payload(const struct esb_payload *payload);
 
 /** @brief Read a payload.
+ *
+ *  The payload is copied from the RX FIFO and removed from it.
  *
  *  @param[in,out] payload	The payload to be received.
  *
  * @retval 0 If successful.
+ * @retval -EBUSY If a payload is claimed with esb_claim_rx_payload().
  *           Otherwise, a (negative) error code is returned.
  */
 int esb_read_rx_payload(struct esb_payload *payload);
 
+/** @brief Claim the oldest payload in the RX FIFO without copying it.
+ *
+ *  The radio receives packets directly into the RX FIFO. This function
+ *  lends the oldest received payload to the application, which must return
+ *  it with esb_release_rx_payload(). The payload takes up a place in the
+ *  RX FIFO until it is released. Only one payload can be claimed at a time.
+ *
+ *  @param[out] payload	Pointer to the claimed payload.
+ *
+ * @retval 0 If successful.
+ * @retval -ENODATA If the RX FIFO is empty.
+ * @retval -EBUSY If a payload is already claimed.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_claim_rx_payload(const struct esb_payload **payload);
+
+/** @brief Release a payload claimed with esb_claim_rx_payload().
+ *
+ *  The payload is removed from the RX FIFO and must not be accessed anymore.
+ *
+ *  @param[in] payload	The claimed payload.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If the payload is not the claimed one.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_release_rx_payload(const struct esb_payload *payload);
+
 /** @brief Start transmitting data.
  *
  * @retval 0 If successful.
@@ -339,6 +370,7 @@ int esb_pop_tx(void);
 /** @brief Flush the RX buffer.
  *
  * @retval 0 If successful.
+ * @retval -EBUSY If a payload is claimed with esb_claim_rx_payload().
  *           Otherwise, a (negative) error code is returned.
  */
 int esb_flush_rx(void);
@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
  */
 
+#include <zephyr/types.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -48,6 +50,38 @@ int bsdlib_get_init_ret(void);
  */
 int bsdlib_shutdown(void);
 
+/** @brief DNS cache statistics of the nRF91 socket offload layer. */
+struct nrf91_socket_dns_cache_stats {
+	/** Lookups answered from the cache. */
+	uint32_t hits;
+	/** Lookups forwarded to the modem. */
+	uint32_t misses;
+	/** Cache entries found, but no longer valid. */
+	uint32_t expired;
+	/** Valid entries replaced to make room for a new host name. */
+	uint32_t evictions;
+};
+
+/**
+ * @brief Get the DNS cache statistics.
+ *
+ * Requires CONFIG_NRF91_SOCKET_DNS_CACHE.
+ *
+ * @param stats Pointer to the structure where statistics are copied.
+ */
+void nrf91_socket_dns_cache_stats_get(
+	struct nrf91_socket_dns_cache_stats *stats);
+
+/**
+ * @brief Remove all entries from the DNS cache.
+ *
+ * Can be used when cached addresses are known to be stale, for example
+ * after a connection to a cached address has failed.
+ *
+ * Requires CONFIG_NRF91_SOCKET_DNS_CACHE.
+ */
+void nrf91_socket_dns_cache_flush(void);
+
 #ifdef __cplusplus
 }
 #endif
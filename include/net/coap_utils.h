@@ -37,6 +37,84 @@ int coap_send_request(enum coap_method method, const struct sockaddr *addr,
 		      const char *const *uri_path_options, uint8_t *payload,
 		      uint16_t payload_size, coap_reply_t reply_cb);
 
+/** @brief Send CoAP confirmable request.
+ *
+ * The request is retransmitted with exponential backoff until it is
+ * acknowledged. If it is not acknowledged after the last retransmission,
+ * @p reply_cb is called with a NULL response.
+ *
+ * @param[in] method           CoAP method type.
+ * @param[in] addr             pointer to socket address struct for IPv6.
+ * @param[in] uri_path_options pointer to CoAP URI schemes option.
+ * @param[in] payload          pointer to the CoAP message payload.
+ * @param[in] payload_size     size of the CoAP message payload.
+ * @param[in] reply_cb         function to call when the response comes.
+ *
+ * @retval 0       On success.
+ * @retval -ENOMEM No free request slot.
+ * @retval != 0    On other failure.
+ */
+int coap_send_con_request(enum coap_method method,
+			  const struct sockaddr *addr,
+			  const char *const *uri_path_options,
+			  uint8_t *payload, uint16_t payload_size,
+			  coap_reply_t reply_cb);
+
+/** @brief Observe a resource.
+ *
+ * Sends a confirmable GET request with the Observe option. @p reply_cb is
+ * called for the response and for every notification that is newer than the
+ * previous one. Stale and reordered notifications are dropped. A response
+ * without the Observe option ends the observation.
+ *
+ * @param[in] addr             pointer to socket address struct for IPv6.
+ * @param[in] uri_path_options pointer to CoAP URI schemes option.
+ * @param[in] reply_cb         function to call when notifications come.
+ *
+ * @return Handle of the observation if positive or zero,
+ *         otherwise a negative error code.
+ */
+int coap_observe(const struct sockaddr *addr,
+		 const char *const *uri_path_options, coap_reply_t reply_cb);
+
+/** @brief Cancel an observation.
+ *
+ * The server is reset on its next notification.
+ *
+ * @param[in] handle Handle returned by @ref coap_observe.
+ *
+ * @retval 0       On success.
+ * @retval -ENOENT No such observation, or the observation has already ended.
+ */
+int coap_observe_cancel(int handle);
+
+/** @brief CoAP request statistics. */
+struct coap_utils_stats {
+	/** Requests sent with a response callback. */
+	uint32_t requests;
+	/** Responses and notifications passed to callbacks. */
+	uint32_t responses;
+	/** Retransmissions of confirmable requests. */
+	uint32_t retransmissions;
+	/** Confirmable requests that were never acknowledged. */
+	uint32_t timeouts;
+	/** Round trip time of the last confirmable request, in milliseconds. */
+	uint32_t rtt_last_ms;
+	/** Sum of the round trip times, in milliseconds. */
+	uint32_t rtt_sum_ms;
+	/** Number of round trip times in the sum. */
+	uint32_t rtt_count;
+};
+
+/** @brief Get CoAP request statistics.
+ *
+ * Round trip times are measured for confirmable requests that were
+ * acknowledged without retransmission.
+ *
+ * @param[out] stats Statistics counted since initialization.
+ */
+void coap_utils_stats_get(struct coap_utils_stats *stats);
+
 #endif
 
 /**
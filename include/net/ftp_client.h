@@ -352,6 +352,75 @@ int ftp_get(const char *file);
  */
 int ftp_put(const char *file, const uint8_t *data, uint16_t length);
 
+/**@brief Get the size of a file
+ *
+ * @param file Target file name
+ * @param size Size of the file in bytes
+ *
+ * @retval ftp_return_code or negative if error
+ */
+int ftp_size(const char *file, size_t *size);
+
+/**@brief Open a streaming upload to a file
+ * Data is written with @ref ftp_stream_write over a single data connection,
+ * until the transfer is closed with @ref ftp_stream_close.
+ *
+ * @param file Target file name
+ * @param offset Offset in the file to resume an interrupted upload from,
+ *               or 0 to store the file from the start
+ *
+ * @retval 0 If the transfer is open.
+ *           Otherwise, ftp_return_code or negative if error
+ */
+int ftp_stream_put_open(const char *file, size_t offset);
+
+/**@brief Open a streaming download of a file
+ * Data is read with @ref ftp_stream_read over a single data connection,
+ * until the transfer is closed with @ref ftp_stream_close.
+ *
+ * @param file Target file name
+ * @param offset Offset in the file to resume an interrupted download from,
+ *               or 0 to retrieve the file from the start
+ *
+ * @retval 0 If the transfer is open.
+ *           Otherwise, ftp_return_code or negative if error
+ */
+int ftp_stream_get_open(const char *file, size_t offset);
+
+/**@brief Write a chunk of an open upload
+ *
+ * @param data Data to be stored
+ * @param length Length of data to be stored
+ *
+ * @retval 0 If all data was sent.
+ *           Otherwise, a negative value is returned.
+ */
+int ftp_stream_write(const uint8_t *data, size_t length);
+
+/**@brief Read a chunk of an open download
+ *
+ * @param buf Buffer for the received data
+ * @param length Size of the buffer
+ *
+ * @retval Number of bytes received, 0 at the end of the file,
+ *         or negative if error
+ */
+int ftp_stream_read(uint8_t *buf, size_t length);
+
+/**@brief Get the progress of the open or last transfer
+ *
+ * @retval Position in the file in bytes, including the restart offset
+ */
+size_t ftp_stream_progress(void);
+
+/**@brief Close a streaming transfer
+ * Closes the data connection and waits for the server to confirm the
+ * transfer.
+ *
+ * @retval ftp_return_code or negative if error
+ */
+int ftp_stream_close(void);
+
 
 #ifdef __cplusplus
 }
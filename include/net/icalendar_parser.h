@@ -102,14 +102,29 @@ typedef int (*icalendar_parser_callback_t)(
 
 /**
  * @brief iCalendar parser instance.
+ *
+ * The parser only keeps the content line being unfolded and the component
+ * being parsed, so its size does not depend on the size of the calendar.
  */
 struct icalendar_parser {
-	/** Internal Buffer for parsing incoming data stream */
+	/** Window for unfolding the current content line. */
 	char buf[CONFIG_ICAL_PARSER_BUFFER_SIZE + 1];
-	/** Offset of unparsed data in buf. */
+	/** Length of the content line in buf. */
 	size_t offset;
+	/** Content line did not fit in buf and was truncated. */
+	bool line_overflow;
+	/** Carriage return received, line break may follow. */
+	bool cr;
+	/** Line break received, the line ends unless it is folded. */
+	bool line_end;
 	/** begin of iCalendar object delimiter pair */
 	bool icalobject_begin;
+	/** Component being parsed, 0 if none. */
+	uint8_t component;
+	/** Nesting level of subcomponents, such as VALARM. */
+	uint8_t depth;
+	/** Component data being collected. */
+	struct ical_parser_evt evt;
 	/** Event handler. */
 	icalendar_parser_callback_t callback;
 };
@@ -128,15 +143,37 @@ int ical_parser_init(struct icalendar_parser *ical,
 /**
  * @brief Parse the iCalendar data stream. Return the parsed bytes.
  *
+ * The data can be split into chunks of any size, for example as received
+ * from the network. An event is sent for each component once its END line
+ * is complete, which is when the first character of the following line has
+ * been parsed, or when @ref ical_parser_finish is called.
+ *
  * @param[in,out] ical iCalendar parser instance.
  * @param[in] data Input data to be parsed.
  * @param[in] len  Length of input data stream.
  *
- * @retval size_t  Parsed bytes.
+ * @retval size_t  Parsed bytes. Less than @p len if the callback stopped
+ *                 the parsing.
  */
 size_t ical_parser_parse(struct icalendar_parser *ical,
 			const char *data, size_t len);
 
+/**
+ * @brief Finish parsing the iCalendar data stream.
+ *
+ * Call this function at the end of the stream to parse the last content
+ * line, which may also end without a line break. The parser is then ready
+ * for a new stream.
+ *
+ * @param[in,out] ical iCalendar parser instance.
+ *
+ * @retval 0 If successful.
+ * @retval -ENODATA If the stream ended inside the calendar object, before
+ *                  END:VCALENDAR.
+ * @retval -EINVAL If the parser instance is NULL.
+ */
+int ical_parser_finish(struct icalendar_parser *ical);
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,6 +15,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <init.h>
+#include <modem/bsdlib.h>
 #include <net/socket_offload.h>
 #include <nrf_socket.h>
 #include <nrf_errno.h>
@@ -38,6 +39,53 @@
 
 static const struct socket_op_vtable nrf91_socket_fd_op_vtable;
 
+/* getaddrinfo() result, allocated together with its address storage. */
+struct nrf91_addrinfo {
+	struct zsock_addrinfo ai;
+	union {
+		struct sockaddr_in in;
+		struct sockaddr_in6 in6;
+	} addr;
+};
+
+K_MEM_SLAB_DEFINE(addrinfo_slab, sizeof(struct nrf91_addrinfo),
+		  CONFIG_NRF91_SOCKET_ADDRINFO_POOL_SIZE, 4);
+
+#if defined(CONFIG_NRF91_SOCKET_DNS_CACHE)
+/* Large enough for any decimal port number. */
+#define DNS_CACHE_SERVICE_LEN 8
+
+struct dns_cache_addr {
+	int flags;
+	int family;
+	int socktype;
+	int protocol;
+	socklen_t addrlen;
+	union {
+		struct sockaddr_in in;
+		struct sockaddr_in6 in6;
+	} addr;
+};
+
+struct dns_cache_entry {
+	char node[CONFIG_NRF91_SOCKET_DNS_CACHE_HOSTNAME_LEN];
+	char service[DNS_CACHE_SERVICE_LEN];
+	/* Hints the lookup was made with. */
+	int flags;
+	int family;
+	int socktype;
+	int protocol;
+	int64_t expires;
+	int64_t last_used;
+	uint8_t addr_count;
+	struct dns_cache_addr addrs[CONFIG_NRF91_SOCKET_DNS_CACHE_ADDR_MAX];
+};
+
+static struct dns_cache_entry dns_cache[CONFIG_NRF91_SOCKET_DNS_CACHE_SIZE];
+static struct nrf91_socket_dns_cache_stats dns_cache_stats;
+static K_MUTEX_DEFINE(dns_cache_lock);
+#endif /* defined(CONFIG_NRF91_SOCKET_DNS_CACHE) */
+
 static void z_to_nrf_ipv4(const struct sockaddr *z_in,
 			  struct nrf_sockaddr_in *nrf_out)
 {
@@ -470,23 +518,15 @@ static int nrf_to_z_addrinfo(struct zsock_addrinfo *z_out,
 
 	z_out->ai_protocol = nrf_to_z_protocol(nrf_in->ai_protocol);
 	if (z_out->ai_protocol == -EPROTONOSUPPORT) {
-		z_out->ai_addr = NULL;
 		return -EPROTONOSUPPORT;
 	}
 
+	/* Address storage is provided by the caller. */
 	if (nrf_in->ai_family == NRF_AF_INET) {
-		z_out->ai_addr = k_malloc(sizeof(struct sockaddr_in));
-		if (z_out->ai_addr == NULL) {
-			return -ENOMEM;
-		}
 		z_out->ai_addrlen  = sizeof(struct sockaddr_in);
 		nrf_to_z_ipv4(z_out->ai_addr,
 			(const struct nrf_sockaddr_in *)nrf_in->ai_addr);
 	} else if (nrf_in->ai_family == NRF_AF_INET6) {
-		z_out->ai_addr = k_malloc(sizeof(struct sockaddr_in6));
-		if (z_out->ai_addr == NULL) {
-			return -ENOMEM;
-		}
 		z_out->ai_addrlen  = sizeof(struct sockaddr_in6);
 		nrf_to_z_ipv6(z_out->ai_addr,
 			(const struct nrf_sockaddr_in6 *)nrf_in->ai_addr);
@@ -817,11 +857,39 @@ error:
 	return retval;
 }
 
+/* Send the content of the sendmsg intermediate buffer. Returns the number of
+ * bytes sent, which may be less than requested, or -1 on error.
+ */
+static ssize_t sendmsg_flush(void *obj, const uint8_t *buf, size_t len,
+			     int flags, const struct msghdr *msg)
+{
+	size_t sent = 0;
+	ssize_t ret;
+
+	while (sent < len) {
+		ret = nrf91_socket_offload_sendto(obj, buf + sent, len - sent,
+						  flags, msg->msg_name,
+						  msg->msg_namelen);
+		if (ret < 0) {
+			return (sent > 0) ? sent : ret;
+		}
+
+		if (ret == 0) {
+			break;
+		}
+
+		sent += ret;
+	}
+
+	return sent;
+}
+
 static ssize_t nrf91_socket_offload_sendmsg(void *obj, const struct msghdr *msg,
 					    int flags)
 {
 	ssize_t len = 0;
 	ssize_t ret;
+	size_t buf_len = 0;
 	int i;
 	static K_MUTEX_DEFINE(sendmsg_lock);
 	static uint8_t buf[CONFIG_BSD_LIBRARY_SENDMSG_BUF_SIZE];
@@ -831,56 +899,86 @@ static ssize_t nrf91_socket_offload_sendmsg(void *obj, const struct msghdr *msg,
 		return -1;
 	}
 
-	/* Try to reduce number of `sendto` calls - copy data if they fit into
-	 * a single buffer
+	/* Reduce the number of `sendto` calls by packing consecutive small
+	 * message parts into a single buffer. Parts that are too large for
+	 * the buffer are passed to the modem directly, without copying.
+	 * A message that fits into the buffer as a whole is always sent with
+	 * a single call, which keeps datagram boundaries intact.
+	 *
+	 * `buf` is protected with a mutex, which is held only from filling
+	 * the buffer until it is flushed.
 	 */
-
 	for (i = 0; i < msg->msg_iovlen; i++) {
-		len += msg->msg_iov[i].iov_len;
-	}
+		const uint8_t *base = msg->msg_iov[i].iov_base;
+		size_t part_len = msg->msg_iov[i].iov_len;
+
+		if (part_len == 0) {
+			continue;
+		}
 
-	if (len <= sizeof(buf)) {
-		/* Protect `buf` access with a mutex. */
-		k_mutex_lock(&sendmsg_lock, K_FOREVER);
-		len = 0;
+		if (buf_len + part_len <= sizeof(buf)) {
+			if (buf_len == 0) {
+				k_mutex_lock(&sendmsg_lock, K_FOREVER);
+			}
 
-		for (i = 0; i < msg->msg_iovlen; i++) {
-			memcpy(buf + len, msg->msg_iov[i].iov_base,
-			       msg->msg_iov[i].iov_len);
-			len += msg->msg_iov[i].iov_len;
+			memcpy(buf + buf_len, base, part_len);
+			buf_len += part_len;
+			continue;
 		}
 
-		ret = nrf91_socket_offload_sendto(obj, buf, len,
-						  flags, msg->msg_name,
-						  msg->msg_namelen);
+		if (buf_len > 0) {
+			ret = sendmsg_flush(obj, buf, buf_len, flags, msg);
+			k_mutex_unlock(&sendmsg_lock);
 
-		k_mutex_unlock(&sendmsg_lock);
-		return ret;
-	}
+			if (ret < 0) {
+				goto out;
+			}
 
-	/* If the data won't fit into intermediate buffer, send the buffers
-	 * separately
-	 */
+			len += ret;
+			if ((size_t)ret < buf_len) {
+				/* Partial send, report what was accepted. */
+				return len;
+			}
 
-	len = 0;
+			buf_len = 0;
+		}
 
-	for (i = 0; i < msg->msg_iovlen; i++) {
-		if (msg->msg_iov[i].iov_len == 0) {
+		if (part_len <= sizeof(buf)) {
+			k_mutex_lock(&sendmsg_lock, K_FOREVER);
+			memcpy(buf, base, part_len);
+			buf_len = part_len;
 			continue;
 		}
 
-		ret = nrf91_socket_offload_sendto(obj, msg->msg_iov[i].iov_base,
-						  msg->msg_iov[i].iov_len,
-						  flags, msg->msg_name,
+		ret = nrf91_socket_offload_sendto(obj, base, part_len, flags,
+						  msg->msg_name,
 						  msg->msg_namelen);
 		if (ret < 0) {
-			return ret;
+			goto out;
+		}
+
+		len += ret;
+		if ((size_t)ret < part_len) {
+			return len;
+		}
+	}
+
+	if (buf_len > 0) {
+		ret = sendmsg_flush(obj, buf, buf_len, flags, msg);
+		k_mutex_unlock(&sendmsg_lock);
+
+		if (ret < 0) {
+			goto out;
 		}
 
 		len += ret;
 	}
 
 	return len;
+
+out:
+	/* Report the bytes already sent, if any, errno is kept otherwise. */
+	return (len > 0) ? len : ret;
 }
 
 static inline int nrf91_socket_offload_poll(struct pollfd *fds, int nfds,
@@ -955,19 +1053,239 @@ static inline int nrf91_socket_offload_poll(struct pollfd *fds, int nfds,
 	return retval;
 }
 
+static struct zsock_addrinfo *addrinfo_alloc(void)
+{
+	struct nrf91_addrinfo *entry;
+
+	if (k_mem_slab_alloc(&addrinfo_slab, (void **)&entry, K_NO_WAIT)) {
+		return NULL;
+	}
+
+	memset(entry, 0, sizeof(*entry));
+	entry->ai.ai_addr = (struct sockaddr *)&entry->addr;
+
+	return &entry->ai;
+}
+
 static void nrf91_socket_offload_freeaddrinfo(struct zsock_addrinfo *root)
 {
 	struct zsock_addrinfo *next = root;
 
 	while (next != NULL) {
-		struct zsock_addrinfo *this = next;
+		struct nrf91_addrinfo *this =
+			CONTAINER_OF(next, struct nrf91_addrinfo, ai);
 
 		next = next->ai_next;
-		k_free(this->ai_addr);
-		k_free(this);
+		k_mem_slab_free(&addrinfo_slab, (void **)&this);
+	}
+}
+
+#if defined(CONFIG_NRF91_SOCKET_DNS_CACHE)
+static bool dns_cache_key_match(const struct dns_cache_entry *entry,
+				const char *node, const char *service,
+				const struct zsock_addrinfo *hints)
+{
+	if (strcmp(entry->node, node) != 0) {
+		return false;
+	}
+
+	if (strcmp(entry->service, service ? service : "") != 0) {
+		return false;
+	}
+
+	if (hints == NULL) {
+		return (entry->flags == 0) && (entry->family == 0) &&
+		       (entry->socktype == 0) && (entry->protocol == 0);
+	}
+
+	return (entry->flags == hints->ai_flags) &&
+	       (entry->family == hints->ai_family) &&
+	       (entry->socktype == hints->ai_socktype) &&
+	       (entry->protocol == hints->ai_protocol);
+}
+
+static bool dns_cache_is_cacheable(const char *node, const char *service,
+				   const struct zsock_addrinfo *hints)
+{
+	if ((node == NULL) ||
+	    (strlen(node) >= CONFIG_NRF91_SOCKET_DNS_CACHE_HOSTNAME_LEN)) {
+		return false;
+	}
+
+	if ((service != NULL) && (strlen(service) >= DNS_CACHE_SERVICE_LEN)) {
+		return false;
+	}
+
+	/* Lookups bound to a specific PDN are not cached. */
+	return (hints == NULL) || (hints->ai_next == NULL);
+}
+
+/* Build a result list from a cached entry. Returns 0 on a cache hit,
+ * -ENOENT on a miss and -ENOMEM if the result could not be allocated.
+ */
+static int dns_cache_get(const char *node, const char *service,
+			 const struct zsock_addrinfo *hints,
+			 struct zsock_addrinfo **res)
+{
+	struct dns_cache_entry *entry = NULL;
+	struct zsock_addrinfo *last = NULL;
+	int64_t now = k_uptime_get();
+	int err = 0;
+
+	k_mutex_lock(&dns_cache_lock, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(dns_cache); i++) {
+		if ((dns_cache[i].addr_count > 0) &&
+		    dns_cache_key_match(&dns_cache[i], node, service, hints)) {
+			entry = &dns_cache[i];
+			break;
+		}
+	}
+
+	if ((entry != NULL) && (now >= entry->expires)) {
+		dns_cache_stats.expired++;
+		entry->addr_count = 0;
+		entry = NULL;
+	}
+
+	if (entry == NULL) {
+		dns_cache_stats.misses++;
+		k_mutex_unlock(&dns_cache_lock);
+		return -ENOENT;
+	}
+
+	*res = NULL;
+
+	for (size_t i = 0; i < entry->addr_count; i++) {
+		struct zsock_addrinfo *ai = addrinfo_alloc();
+
+		if (ai == NULL) {
+			nrf91_socket_offload_freeaddrinfo(*res);
+			*res = NULL;
+			err = -ENOMEM;
+			break;
+		}
+
+		ai->ai_flags = entry->addrs[i].flags;
+		ai->ai_family = entry->addrs[i].family;
+		ai->ai_socktype = entry->addrs[i].socktype;
+		ai->ai_protocol = entry->addrs[i].protocol;
+		ai->ai_addrlen = entry->addrs[i].addrlen;
+		memcpy(ai->ai_addr, &entry->addrs[i].addr,
+		       entry->addrs[i].addrlen);
+
+		if (last == NULL) {
+			*res = ai;
+		} else {
+			last->ai_next = ai;
+		}
+		last = ai;
 	}
+
+	if (err == 0) {
+		entry->last_used = now;
+		dns_cache_stats.hits++;
+	}
+
+	k_mutex_unlock(&dns_cache_lock);
+
+	return err;
 }
 
+static void dns_cache_put(const char *node, const char *service,
+			  const struct zsock_addrinfo *hints,
+			  const struct zsock_addrinfo *res)
+{
+	struct dns_cache_entry *entry = NULL;
+	const struct zsock_addrinfo *ai;
+	int64_t now = k_uptime_get();
+	uint8_t count = 0;
+
+	for (ai = res; ai != NULL; ai = ai->ai_next) {
+		count++;
+	}
+
+	if ((count == 0) || (count > CONFIG_NRF91_SOCKET_DNS_CACHE_ADDR_MAX)) {
+		return;
+	}
+
+	k_mutex_lock(&dns_cache_lock, K_FOREVER);
+
+	/* Prefer an existing entry for the same key, then an unused or
+	 * expired entry, then the least recently used one.
+	 */
+	for (size_t i = 0; i < ARRAY_SIZE(dns_cache); i++) {
+		if (dns_cache_key_match(&dns_cache[i], node, service, hints)) {
+			entry = &dns_cache[i];
+			break;
+		}
+	}
+
+	for (size_t i = 0; (entry == NULL) && (i < ARRAY_SIZE(dns_cache));
+	     i++) {
+		if ((dns_cache[i].addr_count == 0) ||
+		    (now >= dns_cache[i].expires)) {
+			entry = &dns_cache[i];
+		}
+	}
+
+	if (entry == NULL) {
+		entry = &dns_cache[0];
+
+		for (size_t i = 1; i < ARRAY_SIZE(dns_cache); i++) {
+			if (dns_cache[i].last_used < entry->last_used) {
+				entry = &dns_cache[i];
+			}
+		}
+
+		dns_cache_stats.evictions++;
+	}
+
+	strcpy(entry->node, node);
+	strcpy(entry->service, service ? service : "");
+	entry->flags = hints ? hints->ai_flags : 0;
+	entry->family = hints ? hints->ai_family : 0;
+	entry->socktype = hints ? hints->ai_socktype : 0;
+	entry->protocol = hints ? hints->ai_protocol : 0;
+	entry->expires = now + CONFIG_NRF91_SOCKET_DNS_CACHE_TTL * MSEC_PER_SEC;
+	entry->last_used = now;
+	entry->addr_count = count;
+
+	count = 0;
+	for (ai = res; ai != NULL; ai = ai->ai_next, count++) {
+		struct dns_cache_addr *addr = &entry->addrs[count];
+
+		addr->flags = ai->ai_flags;
+		addr->family = ai->ai_family;
+		addr->socktype = ai->ai_socktype;
+		addr->protocol = ai->ai_protocol;
+		addr->addrlen = MIN(ai->ai_addrlen, sizeof(addr->addr));
+		memcpy(&addr->addr, ai->ai_addr, addr->addrlen);
+	}
+
+	k_mutex_unlock(&dns_cache_lock);
+}
+
+void nrf91_socket_dns_cache_stats_get(
+	struct nrf91_socket_dns_cache_stats *stats)
+{
+	k_mutex_lock(&dns_cache_lock, K_FOREVER);
+	memcpy(stats, &dns_cache_stats, sizeof(*stats));
+	k_mutex_unlock(&dns_cache_lock);
+}
+
+void nrf91_socket_dns_cache_flush(void)
+{
+	k_mutex_lock(&dns_cache_lock, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(dns_cache); i++) {
+		dns_cache[i].addr_count = 0;
+	}
+
+	k_mutex_unlock(&dns_cache_lock);
+}
+#endif /* defined(CONFIG_NRF91_SOCKET_DNS_CACHE) */
+
 static int nrf91_socket_offload_getaddrinfo(const char *node,
 					    const char *service,
 					    const struct zsock_addrinfo *hints,
@@ -981,6 +1299,19 @@ static int nrf91_socket_offload_getaddrinfo(const char *node,
 
 	memset(&nrf_hints, 0, sizeof(struct nrf_addrinfo));
 
+#if defined(CONFIG_NRF91_SOCKET_DNS_CACHE)
+	bool cacheable = dns_cache_is_cacheable(node, service, hints);
+
+	if (cacheable) {
+		error = dns_cache_get(node, service, hints, res);
+		if (error == 0) {
+			return 0;
+		} else if (error == -ENOMEM) {
+			return DNS_EAI_MEMORY;
+		}
+	}
+#endif
+
 	if (hints != NULL) {
 		error = z_to_nrf_addrinfo_hints(hints, &nrf_hints);
 		if (error == -EPROTONOSUPPORT) {
@@ -1013,8 +1344,7 @@ static int nrf91_socket_offload_getaddrinfo(const char *node,
 	*res = NULL;
 
 	while ((retval == 0) && (next_nrf_res != NULL)) {
-		struct zsock_addrinfo *next_z_res =
-					k_malloc(sizeof(struct zsock_addrinfo));
+		struct zsock_addrinfo *next_z_res = addrinfo_alloc();
 
 		if (next_z_res == NULL) {
 			retval = DNS_EAI_MEMORY;
@@ -1022,17 +1352,13 @@ static int nrf91_socket_offload_getaddrinfo(const char *node,
 		}
 
 		error = nrf_to_z_addrinfo(next_z_res, next_nrf_res);
-		if (error == -ENOMEM) {
-			retval = DNS_EAI_MEMORY;
-			k_free(next_z_res);
-			break;
-		} else if (error == -EPROTONOSUPPORT) {
+		if (error == -EPROTONOSUPPORT) {
 			retval = DNS_EAI_SOCKTYPE;
-			k_free(next_z_res);
+			nrf91_socket_offload_freeaddrinfo(next_z_res);
 			break;
 		} else if (error == -EAFNOSUPPORT) {
 			retval = DNS_EAI_ADDRFAMILY;
-			k_free(next_z_res);
+			nrf91_socket_offload_freeaddrinfo(next_z_res);
 			break;
 		}
 
@@ -1052,6 +1378,12 @@ static int nrf91_socket_offload_getaddrinfo(const char *node,
 	}
 	nrf_freeaddrinfo(nrf_res);
 
+#if defined(CONFIG_NRF91_SOCKET_DNS_CACHE)
+	if ((retval == 0) && cacheable) {
+		dns_cache_put(node, service, hints, *res);
+	}
+#endif
+
 	return retval;
 }
 
@@ -9,10 +9,158 @@
 
 LOG_MODULE_REGISTER(bt_conn_ctx, CONFIG_BT_CONN_CTX_LOG_LEVEL);
 
-static void bt_conn_ctx_mem_free(struct k_mem_slab *mem_slab, void **data)
+/* The reference count holds the number of users in the upper bits
+ * and whether the context is allocated in the lowest bit.
+ */
+#define REF_LIVE BIT(0)
+#define REF_ONE  BIT(1)
+
+static void bt_conn_ctx_mem_free(struct k_mem_slab *mem_slab,
+				 struct bt_conn_ctx *ctx)
+{
+	void *data = ctx->data;
+
+	ctx->conn = NULL;
+	ctx->data = NULL;
+	k_mem_slab_free(mem_slab, &data);
+}
+
+static bool bt_conn_ctx_ref(struct bt_conn_ctx *ctx)
+{
+	atomic_val_t ref;
+
+	do {
+		ref = atomic_get(&ctx->ref);
+		if (!(ref & REF_LIVE)) {
+			return false;
+		}
+	} while (!atomic_cas(&ctx->ref, ref, ref + REF_ONE));
+
+	return true;
+}
+
+static void bt_conn_ctx_unref(struct bt_conn_ctx_lib *ctx_lib,
+			      struct bt_conn_ctx *ctx)
+{
+	/* The last user of a freed context releases its memory. */
+	if (atomic_sub(&ctx->ref, REF_ONE) == REF_ONE) {
+		bt_conn_ctx_mem_free(ctx_lib->mem_slab, ctx);
+	}
+}
+
+static bool bt_conn_ctx_ref_conn(struct bt_conn_ctx_lib *ctx_lib,
+				 struct bt_conn_ctx *ctx, struct bt_conn *conn)
+{
+	if (!bt_conn_ctx_ref(ctx)) {
+		return false;
+	}
+
+	if (ctx->conn != conn) {
+		bt_conn_ctx_unref(ctx_lib, ctx);
+		return false;
+	}
+
+	return true;
+}
+
+static struct bt_conn_ctx *bt_conn_ctx_find(struct bt_conn_ctx_lib *ctx_lib,
+					    struct bt_conn *conn)
+{
+	uint8_t index = bt_conn_index(conn);
+
+	if (bt_conn_ctx_ref_conn(ctx_lib, &ctx_lib->ctx[index], conn)) {
+		return &ctx_lib->ctx[index];
+	}
+
+	/* The context is in another slot if the slot of its index was
+	 * still in use when the context was allocated.
+	 */
+	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+		struct bt_conn_ctx *ctx = &ctx_lib->ctx[i];
+
+		if ((i != index) && bt_conn_ctx_ref_conn(ctx_lib, ctx, conn)) {
+			return ctx;
+		}
+	}
+
+	return NULL;
+}
+
+static bool bt_conn_ctx_lock(struct bt_conn_ctx_lib *ctx_lib,
+			     struct bt_conn_ctx *ctx)
+{
+	k_mutex_lock(&ctx->lock, K_FOREVER);
+
+	/* The context may have been freed while waiting for the lock. */
+	if (!(atomic_get(&ctx->ref) & REF_LIVE)) {
+		k_mutex_unlock(&ctx->lock);
+		bt_conn_ctx_unref(ctx_lib, ctx);
+
+		return false;
+	}
+
+	return true;
+}
+
+static void bt_conn_ctx_unlock(struct bt_conn_ctx_lib *ctx_lib,
+			       struct bt_conn_ctx *ctx)
+{
+	/* Unlock before dropping the reference, as an unused context
+	 * can be allocated again.
+	 */
+	k_mutex_unlock(&ctx->lock);
+	bt_conn_ctx_unref(ctx_lib, ctx);
+}
+
+static int bt_conn_ctx_kill(struct bt_conn_ctx_lib *ctx_lib,
+			    struct bt_conn_ctx *ctx)
+{
+	atomic_val_t ref = atomic_and(&ctx->ref, ~REF_LIVE);
+
+	if (!(ref & REF_LIVE)) {
+		return -EINVAL;
+	}
+
+	/* Without users, the memory is released right away. */
+	if (ref == REF_LIVE) {
+		bt_conn_ctx_mem_free(ctx_lib->mem_slab, ctx);
+	}
+
+	return 0;
+}
+
+static size_t bt_conn_ctx_block_index(struct bt_conn_ctx_lib *ctx_lib,
+				      const void *data)
+{
+	const struct k_mem_slab *mem_slab = ctx_lib->mem_slab;
+	size_t offset = (const char *)data - mem_slab->buffer;
+
+	__ASSERT_NO_MSG((offset % mem_slab->block_size) == 0);
+
+	return offset / mem_slab->block_size;
+}
+
+static struct bt_conn_ctx *bt_conn_ctx_slot_get(struct bt_conn_ctx_lib *ctx_lib,
+						uint8_t index)
 {
-	k_mem_slab_free(mem_slab, data);
-	*data = NULL;
+	struct bt_conn_ctx *ctx = &ctx_lib->ctx[index];
+
+	/* A slot is free when nobody holds its context. */
+	if (!atomic_get(&ctx->ref) && !ctx->data) {
+		return ctx;
+	}
+
+	LOG_DBG("Context for index %u is busy", index);
+
+	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+		ctx = &ctx_lib->ctx[i];
+
+		if (!atomic_get(&ctx->ref) && !ctx->data) {
+			return ctx;
+		}
+	}
+
+	return NULL;
 }
 
 void *bt_conn_ctx_alloc(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
@@ -20,38 +168,49 @@ void *bt_conn_ctx_alloc(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
 	__ASSERT_NO_MSG(conn != NULL);
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 
-	int err = -ENOMEM;
+	uint8_t index = bt_conn_index(conn);
 	struct bt_conn_ctx *ctx;
+	void *data = NULL;
+	int err;
 
 	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
 
-	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
-		ctx = &ctx_lib->ctx[i];
+	/* A context of a previous connection may still be in use. */
+	ctx = bt_conn_ctx_slot_get(ctx_lib, index);
+	if (!ctx) {
+		LOG_WRN("No free context for index %u", index);
+		k_mutex_unlock(ctx_lib->mutex);
+
+		return NULL;
+	}
 
-		if (!ctx->conn && !ctx->data) {
-			err = k_mem_slab_alloc(ctx_lib->mem_slab,
-					       &ctx->data,
-					       K_NO_WAIT);
-			if (!err) {
-				ctx->conn = conn;
+	err = k_mem_slab_alloc(ctx_lib->mem_slab, &data, K_NO_WAIT);
+	if (err) {
+		LOG_WRN("Memory can not be allocated");
+		k_mutex_unlock(ctx_lib->mutex);
 
-				LOG_DBG("The memory for the connection context "
-					"has been allocated, conn %p, index: %u",
-					conn, i);
+		return NULL;
+	}
 
-				return ctx->data;
+	ctx->conn = conn;
+	ctx->data = data;
+	ctx_lib->block_ctx[bt_conn_ctx_block_index(ctx_lib, data)] =
+		ctx - ctx_lib->ctx;
 
-			} else {
-				break;
-			}
+	/* Nobody waits for the lock of an unused context. */
+	k_mutex_init(&ctx->lock);
+	k_mutex_lock(&ctx->lock, K_FOREVER);
 
-		}
-	}
+	/* The caller holds a reference until bt_conn_ctx_release. */
+	atomic_set(&ctx->ref, REF_LIVE | REF_ONE);
+
+	LOG_DBG("The memory for the connection context "
+		"has been allocated, conn %p, index: %u",
+		conn, index);
 
-	LOG_WRN("Memory can not be allocated");
 	k_mutex_unlock(ctx_lib->mutex);
 
-	return NULL;
+	return data;
 }
 
 int bt_conn_ctx_free(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
@@ -59,30 +218,29 @@ int bt_conn_ctx_free(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
 	__ASSERT_NO_MSG(conn != NULL);
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 
-	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
-
-	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
-		struct bt_conn_ctx *ctx = &ctx_lib->ctx[i];
+	struct bt_conn_ctx *ctx;
+	int err = -EINVAL;
 
-		if (ctx->conn == conn) {
-			bt_conn_ctx_mem_free(ctx_lib->mem_slab, &ctx->data);
-			ctx->conn = NULL;
-			ctx->data = NULL;
+	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
 
-			LOG_DBG("The context memory for the connection "
-				"has been released, conn %p index %u",
-				conn, i);
+	ctx = bt_conn_ctx_find(ctx_lib, conn);
+	if (ctx) {
+		err = bt_conn_ctx_kill(ctx_lib, ctx);
+		bt_conn_ctx_unref(ctx_lib, ctx);
+	}
 
-			k_mutex_unlock(ctx_lib->mutex);
+	k_mutex_unlock(ctx_lib->mutex);
 
-			return 0;
-		}
+	if (err) {
+		LOG_WRN("There is no allocated memory for this connection");
+		return err;
 	}
 
-	LOG_WRN("There is no allocated memory for this connection");
-	k_mutex_unlock(ctx_lib->mutex);
+	LOG_DBG("The context memory for the connection "
+		"has been released, conn %p index %u",
+		conn, bt_conn_index(conn));
 
-	return  -EINVAL;
+	return 0;
 }
 
 void bt_conn_ctx_free_all(struct bt_conn_ctx_lib *ctx_lib)
@@ -92,13 +250,7 @@ void bt_conn_ctx_free_all(struct bt_conn_ctx_lib *ctx_lib)
 	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
 
 	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
-		struct bt_conn_ctx *ctx = &ctx_lib->ctx[i];
-
-		if (ctx->data != NULL) {
-			k_mem_slab_free(ctx_lib->mem_slab, &ctx->data);
-			ctx->conn = NULL;
-			ctx->data = NULL;
-		}
+		(void)bt_conn_ctx_kill(ctx_lib, &ctx_lib->ctx[i]);
 	}
 
 	k_mutex_unlock(ctx_lib->mutex);
@@ -111,23 +263,17 @@ void *bt_conn_ctx_get(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
 	__ASSERT_NO_MSG(conn != NULL);
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 
-	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
-
-	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
-		struct bt_conn_ctx *ctx = &ctx_lib->ctx[i];
+	struct bt_conn_ctx *ctx = bt_conn_ctx_find(ctx_lib, conn);
 
-		if (ctx->conn == conn) {
-			LOG_DBG("Memory block found for the connection");
+	if (!ctx || !bt_conn_ctx_lock(ctx_lib, ctx)) {
+		LOG_WRN("No memory block for connection");
 
-			return ctx->data;
-		}
+		return NULL;
 	}
 
-	LOG_WRN("No memory block for connection");
-
-	k_mutex_unlock(ctx_lib->mutex);
+	LOG_DBG("Memory block found for the connection");
 
-	return NULL;
+	return ctx->data;
 }
 
 const struct bt_conn_ctx *bt_conn_ctx_get_by_id(struct bt_conn_ctx_lib *ctx_lib, uint8_t id)
@@ -135,17 +281,13 @@ const struct bt_conn_ctx *bt_conn_ctx_get_by_id(struct bt_conn_ctx_lib *ctx_lib,
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 	__ASSERT_NO_MSG(id < bt_conn_ctx_count(ctx_lib));
 
-	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
-
 	struct bt_conn_ctx *ctx = &ctx_lib->ctx[id];
 
-	if (ctx_lib->ctx[id].conn != NULL) {
-		return ctx;
+	if (!bt_conn_ctx_ref(ctx) || !bt_conn_ctx_lock(ctx_lib, ctx)) {
+		return NULL;
 	}
 
-	k_mutex_unlock(ctx_lib->mutex);
-
-	return NULL;
+	return ctx;
 }
 
 void bt_conn_ctx_release(struct bt_conn_ctx_lib *ctx_lib, void *ctx_data)
@@ -153,15 +295,35 @@ void bt_conn_ctx_release(struct bt_conn_ctx_lib *ctx_lib, void *ctx_data)
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 	__ASSERT_NO_MSG(ctx_data != NULL);
 
+	size_t block = bt_conn_ctx_block_index(ctx_lib, ctx_data);
+	struct bt_conn_ctx *ctx = &ctx_lib->ctx[ctx_lib->block_ctx[block]];
+
+	__ASSERT_NO_MSG(ctx->data == ctx_data);
+
+	bt_conn_ctx_unlock(ctx_lib, ctx);
+}
+
+size_t bt_conn_ctx_foreach(struct bt_conn_ctx_lib *ctx_lib,
+			   bt_conn_ctx_cb_t func, void *user_data)
+{
+	__ASSERT_NO_MSG(ctx_lib != NULL);
+	__ASSERT_NO_MSG(func != NULL);
+
+	size_t count = 0;
+
 	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
 		struct bt_conn_ctx *ctx = &ctx_lib->ctx[i];
 
-		if (ctx->data == ctx_data) {
-			k_mutex_unlock(ctx_lib->mutex);
-
-			return;
+		/* The reference only keeps the memory of the context. */
+		if (!bt_conn_ctx_ref(ctx)) {
+			continue;
 		}
+
+		func(ctx, user_data);
+		count++;
+
+		bt_conn_ctx_unref(ctx_lib, ctx);
 	}
 
-	__ASSERT_NO_MSG(false);
+	return count;
 }
@@ -45,18 +45,67 @@ enum entry_tag {
 	ENTRY_TAG_SEQ = 's',
 };
 
+/** Internal device state, not exposed in the device structure. */
+struct device_state {
+	/** Next device in the same hash bucket, index + 1. */
+	uint16_t next;
+	/** Signature of the last telegram that failed authentication. */
+	uint8_t fail_sig[SIGNATURE_LEN];
+	/** Sequence number of the last telegram that failed authentication. */
+	uint32_t fail_seq;
+};
+
 static struct bt_enocean_device devices[CONFIG_BT_ENOCEAN_DEVICES_MAX];
+static struct device_state states[CONFIG_BT_ENOCEAN_DEVICES_MAX];
+/* Active devices hashed on their address, index + 1. */
+static uint16_t buckets[CONFIG_BT_ENOCEAN_DEVICES_MAX];
 static const struct bt_enocean_callbacks *cb;
 static struct k_delayed_work work;
 static bool commissioning;
 
+static uint16_t *bucket_get(const bt_addr_le_t *addr)
+{
+	/* EnOcean devices use random static addresses: */
+	return &buckets[sys_get_le32(addr->a.val) % ARRAY_SIZE(buckets)];
+}
+
+static void device_link(struct bt_enocean_device *dev)
+{
+	uint16_t *bucket = bucket_get(&dev->addr);
+	int index = dev - &devices[0];
+
+	states[index].next = *bucket;
+	*bucket = index + 1;
+}
+
+static void device_unlink(struct bt_enocean_device *dev)
+{
+	uint16_t *next = bucket_get(&dev->addr);
+	int index = dev - &devices[0];
+
+	while (*next) {
+		if (*next == index + 1) {
+			*next = states[index].next;
+			states[index].next = 0;
+			return;
+		}
+
+		next = &states[*next - 1].next;
+	}
+}
+
 static struct bt_enocean_device *device_find(const bt_addr_le_t *addr)
 {
-	for (int i = 0; i < ARRAY_SIZE(devices); ++i) {
-		if ((devices[i].flags & FLAG_ACTIVE) &&
-		    !bt_addr_le_cmp(addr, &devices[i].addr)) {
-			return &devices[i];
+	uint16_t next = *bucket_get(addr);
+
+	while (next) {
+		struct bt_enocean_device *dev = &devices[next - 1];
+
+		if (!bt_addr_le_cmp(addr, &dev->addr)) {
+			return dev;
 		}
+
+		next = states[next - 1].next;
 	}
 
 	BT_DBG("Unknown device %s", bt_addr_le_str(addr));
@@ -72,6 +121,8 @@ static struct bt_enocean_device *device_alloc(const bt_addr_le_t *addr,
 			devices[i].seq = seq;
 			memcpy(devices[i].key, key, sizeof(devices[i].key));
 			devices[i].flags = 0;
+			states[i].fail_seq = 0;
+			memset(states[i].fail_sig, 0, SIGNATURE_LEN);
 			return &devices[i];
 		}
 	}
@@ -123,12 +174,29 @@ static int store_new_dev(const struct bt_enocean_device *dev)
 	return settings_save_one(tag, &dev->seq, 4);
 }
 
+/* Telegrams are repeated several times. Skip the repetitions of a telegram
+ * that failed authentication instead of spending a decryption on each.
+ */
+static bool auth_failed(const struct bt_enocean_device *dev, uint32_t seq,
+			const uint8_t *signature)
+{
+	const struct device_state *state = &states[dev - &devices[0]];
+
+	return (seq == state->fail_seq) &&
+	       !memcmp(signature, state->fail_sig, SIGNATURE_LEN);
+}
+
 static int auth(const struct bt_enocean_device *dev, uint32_t seq,
 		const uint8_t *signature, const uint8_t *payload, uint8_t len)
 {
+	struct device_state *state = &states[dev - &devices[0]];
 	struct nonce nonce;
 	int err;
 
+	if (auth_failed(dev, seq, signature)) {
+		return -EBADMSG;
+	}
+
 	memcpy(nonce.addr, dev->addr.a.val, sizeof(nonce.addr));
 	nonce.seq = seq;
 	memset(nonce.padding, 0, sizeof(nonce.padding));
@@ -136,6 +204,8 @@ static int auth(const struct bt_enocean_device *dev, uint32_t seq,
 	err = bt_ccm_decrypt(dev->key, (uint8_t *)&nonce, signature, 0, payload,
 			     len, NULL, SIGNATURE_LEN);
 	if (err) {
+		state->fail_seq = seq;
+		memcpy(state->fail_sig, signature, SIGNATURE_LEN);
 		return err;
 	}
 
@@ -374,6 +444,11 @@ static void adv_recv(const struct bt_le_scan_recv_info *info,
 		return;
 	}
 
+	/* Only commissioned devices are of interest outside commissioning. */
+	if (!commissioning && !device_find(info->addr)) {
+		return;
+	}
+
 	uint8_t *payload = buf->data;
 	uint8_t len = net_buf_simple_pull_u8(buf);
 	uint8_t type = net_buf_simple_pull_u8(buf);
@@ -489,9 +564,14 @@ static int settings_set(const char *key, size_t len, settings_read_cb read_cb,
 			return -EINVAL;
 		}
 
+		if (dev->flags & FLAG_ACTIVE) {
+			device_unlink(dev);
+		}
+
 		bt_addr_le_copy(&dev->addr, &entry.addr);
 		memcpy(dev->key, entry.key, sizeof(dev->key));
 		dev->flags |= FLAG_ACTIVE;
+		device_link(dev);
 
 		BT_DBG("Loaded %s", bt_addr_le_str(&dev->addr));
 		return 0;
@@ -572,6 +652,7 @@ int bt_enocean_commission(const bt_addr_le_t *addr, const uint8_t key[16],
 	}
 
 	dev->flags |= FLAG_ACTIVE;
+	device_link(dev);
 
 	if (cb->commissioned) {
 		cb->commissioned(dev);
@@ -605,6 +686,10 @@ void bt_enocean_decommission(struct bt_enocean_device *dev)
 		settings_delete(name);
 	}
 
+	if (dev->flags & FLAG_ACTIVE) {
+		device_unlink(dev);
+	}
+
 	dev->flags = 0;
 }
 
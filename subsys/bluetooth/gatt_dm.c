@@ -8,7 +8,9 @@
 #include <zephyr.h>
 #include <logging/log.h>
 
+#include <bluetooth/conn.h>
 #include <bluetooth/gatt_dm.h>
+#include <net/buf.h>
 
 LOG_MODULE_REGISTER(bt_gatt_dm, CONFIG_BT_GATT_DM_LOG_LEVEL);
 
@@ -18,6 +20,8 @@ LOG_MODULE_REGISTER(bt_gatt_dm, CONFIG_BT_GATT_DM_LOG_LEVEL);
 
 #define DATA_ALIGN 4U
 
+#define DB_HASH_LEN 16
+
 /* They are placed in data_chunk without padding, so they must be aligned */
 BUILD_ASSERT(sizeof(struct bt_gatt_service_val) % DATA_ALIGN == 0);
 BUILD_ASSERT(sizeof(struct bt_gatt_chrc) % DATA_ALIGN == 0);
@@ -26,6 +30,7 @@ BUILD_ASSERT(sizeof(struct bt_gatt_chrc) % DATA_ALIGN == 0);
 enum {
 	STATE_ATTRS_LOCKED,
 	STATE_ATTRS_RELEASE_PENDING,
+	STATE_DB_HASH_VALID,
 	STATE_NUM
 };
 
@@ -58,12 +63,29 @@ struct bt_gatt_dm {
 	/* The used length of the current chunk */
 	size_t cur_chunk_len;
 
+	/* Caller-provided memory for user data, used instead of chunks */
+	uint8_t *arena;
+	/* Size of the caller-provided memory */
+	size_t arena_size;
+	/* The used length of the caller-provided memory */
+	size_t arena_used;
+
 	/* The pointer to callback structure */
 	const struct bt_gatt_dm_cb *callback;
+
+#if defined(CONFIG_BT_GATT_DM_CACHE)
+	/* Parameters for reading the peer database hash */
+	struct bt_gatt_read_params hash_read_params;
+	/* The peer database hash, valid if STATE_DB_HASH_VALID is set */
+	uint8_t db_hash[DB_HASH_LEN];
+	/* The start handle of the current discovery */
+	uint16_t start_handle;
+	/* The service UUID of the current discovery */
+	const struct bt_uuid *svc_uuid;
+#endif
 };
 
-/* Currently only one instance is supported */
-static struct bt_gatt_dm bt_gatt_dm_inst;
+static struct bt_gatt_dm bt_gatt_dm_inst[CONFIG_BT_GATT_DM_MAX_INSTANCES];
 
 /* Returns pointer to newly allocated space in a dm->data_chunk */
 static void *user_data_alloc(struct bt_gatt_dm *dm,
@@ -77,6 +99,17 @@ static void *user_data_alloc(struct bt_gatt_dm *dm,
 	 */
 	len = (len + DATA_ALIGN - 1) & ~(DATA_ALIGN - 1);
 
+	if (dm->arena) {
+		if (dm->arena_used + len > dm->arena_size) {
+			return NULL;
+		}
+
+		user_data_loc = &dm->arena[dm->arena_used];
+		dm->arena_used += len;
+
+		return user_data_loc;
+	}
+
 	__ASSERT_NO_MSG(len <= CHUNK_DATA_SIZE);
 
 	if (sys_slist_is_empty(&dm->chunk_list) ||
@@ -122,6 +155,7 @@ static void svc_attr_memory_release(struct bt_gatt_dm *dm)
 	}
 
 	dm->cur_chunk_len = 0;
+	dm->arena_used = 0;
 }
 
 /* Returns size of UUID structure with padding for memory alignment */
@@ -198,6 +232,10 @@ static struct bt_uuid *uuid_store(struct bt_gatt_dm *dm,
 	size_t size = get_uuid_size(uuid);
 	void *buffer = user_data_alloc(dm, size);
 
+	if (!buffer) {
+		return NULL;
+	}
+
 	memcpy(buffer, uuid, size);
 
 	return (struct bt_uuid *)buffer;
@@ -231,36 +269,454 @@ static struct bt_gatt_dm_attr *attr_find_by_handle(
 	return NULL;
 }
 
-static void discovery_complete(struct bt_gatt_dm *dm)
+#if defined(CONFIG_BT_GATT_DM_CACHE)
+
+union uuid_any {
+	struct bt_uuid uuid;
+	struct bt_uuid_16 u16;
+	struct bt_uuid_32 u32;
+	struct bt_uuid_128 u128;
+};
+
+/* One cached discovery result.
+ * The attributes are stored serialized, as the discovery data
+ * is not contiguous in memory.
+ */
+struct cache_entry {
+	/* Peer address, as returned by bt_conn_get_dst() */
+	bt_addr_le_t addr;
+	/* Peer database hash at the time of discovery */
+	uint8_t db_hash[DB_HASH_LEN];
+	/* The start handle of the discovery */
+	uint16_t start_handle;
+	/* The service UUID of the discovery, valid if has_svc_uuid is set */
+	union uuid_any svc_uuid;
+	bool has_svc_uuid;
+	/* Value of the use counter on last access */
+	uint32_t last_used;
+	/* Length of the serialized attributes, 0 if the entry is free */
+	uint16_t data_len;
+	/* Serialized attributes */
+	uint8_t data[CONFIG_BT_GATT_DM_CACHE_DATA_SIZE];
+};
+
+static struct cache_entry cache[CONFIG_BT_GATT_DM_CACHE_SIZE];
+static uint32_t cache_use_cnt;
+static K_MUTEX_DEFINE(cache_lock);
+
+static void cache_buf_init(struct net_buf_simple *buf, uint8_t *data,
+			   uint16_t len)
+{
+	buf->__buf = data;
+	buf->data = data;
+	buf->len = len;
+	buf->size = CONFIG_BT_GATT_DM_CACHE_DATA_SIZE;
+}
+
+static int cache_uuid_put(struct net_buf_simple *buf,
+			  const struct bt_uuid *uuid)
+{
+	size_t size = get_uuid_size(uuid);
+
+	if (!size || (net_buf_simple_tailroom(buf) < size + sizeof(uint8_t))) {
+		return -ENOMEM;
+	}
+
+	net_buf_simple_add_u8(buf, size);
+	net_buf_simple_add_mem(buf, uuid, size);
+
+	return 0;
+}
+
+static void cache_uuid_pull(struct net_buf_simple *buf, union uuid_any *uuid)
+{
+	uint8_t size = net_buf_simple_pull_u8(buf);
+
+	__ASSERT_NO_MSG(size <= sizeof(*uuid));
+	memcpy(uuid, net_buf_simple_pull_mem(buf, size), size);
+}
+
+static int cache_attr_put(struct net_buf_simple *buf,
+			  const struct bt_gatt_dm_attr *attr)
+{
+	const struct bt_gatt_service_val *service_val =
+		bt_gatt_dm_attr_service_val(attr);
+	const struct bt_gatt_chrc *chrc = bt_gatt_dm_attr_chrc_val(attr);
+	int err;
+
+	if (net_buf_simple_tailroom(buf) < sizeof(uint16_t) + sizeof(uint8_t)) {
+		return -ENOMEM;
+	}
+
+	net_buf_simple_add_le16(buf, attr->handle);
+	net_buf_simple_add_u8(buf, attr->perm);
+
+	err = cache_uuid_put(buf, attr->uuid);
+	if (err) {
+		return err;
+	}
+
+	if (service_val) {
+		if (net_buf_simple_tailroom(buf) < sizeof(uint16_t)) {
+			return -ENOMEM;
+		}
+
+		net_buf_simple_add_le16(buf, service_val->end_handle);
+
+		return cache_uuid_put(buf, service_val->uuid);
+	}
+
+	if (chrc) {
+		if (net_buf_simple_tailroom(buf) <
+		    sizeof(uint16_t) + sizeof(uint8_t)) {
+			return -ENOMEM;
+		}
+
+		net_buf_simple_add_le16(buf, chrc->value_handle);
+		net_buf_simple_add_u8(buf, chrc->properties);
+
+		return cache_uuid_put(buf, chrc->uuid);
+	}
+
+	return 0;
+}
+
+static int cache_attr_restore(struct bt_gatt_dm *dm,
+			      struct net_buf_simple *buf)
+{
+	struct bt_gatt_attr attr = {0};
+	struct bt_gatt_dm_attr *cur_attr;
+	union uuid_any uuid;
+	union uuid_any val_uuid;
+
+	attr.handle = net_buf_simple_pull_le16(buf);
+	attr.perm = net_buf_simple_pull_u8(buf);
+	cache_uuid_pull(buf, &uuid);
+	attr.uuid = &uuid.uuid;
+
+	if ((bt_uuid_cmp(attr.uuid, BT_UUID_GATT_PRIMARY) == 0) ||
+	    (bt_uuid_cmp(attr.uuid, BT_UUID_GATT_SECONDARY) == 0)) {
+		struct bt_gatt_service_val *service_val;
+
+		cur_attr = attr_store(dm, &attr, sizeof(*service_val));
+		if (!cur_attr) {
+			return -ENOMEM;
+		}
+
+		service_val = bt_gatt_dm_attr_service_val(cur_attr);
+		service_val->end_handle = net_buf_simple_pull_le16(buf);
+		cache_uuid_pull(buf, &val_uuid);
+		service_val->uuid = uuid_store(dm, &val_uuid.uuid);
+		if (!service_val->uuid) {
+			return -ENOMEM;
+		}
+	} else if (bt_uuid_cmp(attr.uuid, BT_UUID_GATT_CHRC) == 0) {
+		struct bt_gatt_chrc *chrc;
+
+		cur_attr = attr_store(dm, &attr, sizeof(*chrc));
+		if (!cur_attr) {
+			return -ENOMEM;
+		}
+
+		chrc = bt_gatt_dm_attr_chrc_val(cur_attr);
+		chrc->value_handle = net_buf_simple_pull_le16(buf);
+		chrc->properties = net_buf_simple_pull_u8(buf);
+		cache_uuid_pull(buf, &val_uuid);
+		chrc->uuid = uuid_store(dm, &val_uuid.uuid);
+		if (!chrc->uuid) {
+			return -ENOMEM;
+		}
+	} else {
+		if (!attr_store(dm, &attr, 0)) {
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+static struct cache_entry *cache_find(const struct bt_gatt_dm *dm)
+{
+	const bt_addr_le_t *addr = bt_conn_get_dst(dm->conn);
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		struct cache_entry *entry = &cache[i];
+
+		if (!entry->data_len ||
+		    (entry->start_handle != dm->start_handle) ||
+		    bt_addr_le_cmp(&entry->addr, addr) ||
+		    memcmp(entry->db_hash, dm->db_hash, DB_HASH_LEN)) {
+			continue;
+		}
+
+		if (!dm->svc_uuid && !entry->has_svc_uuid) {
+			return entry;
+		}
+
+		if (dm->svc_uuid && entry->has_svc_uuid &&
+		    !bt_uuid_cmp(&entry->svc_uuid.uuid, dm->svc_uuid)) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+static struct cache_entry *cache_entry_alloc(void)
+{
+	struct cache_entry *victim = &cache[0];
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (!cache[i].data_len) {
+			return &cache[i];
+		}
+
+		if (cache[i].last_used < victim->last_used) {
+			victim = &cache[i];
+		}
+	}
+
+	return victim;
+}
+
+static void cache_store(struct bt_gatt_dm *dm)
+{
+	struct cache_entry *entry;
+	struct net_buf_simple buf;
+	int err = 0;
+
+	if (!atomic_test_bit(dm->state_flags, STATE_DB_HASH_VALID)) {
+		return;
+	}
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	entry = cache_find(dm);
+	if (!entry) {
+		entry = cache_entry_alloc();
+	}
+
+	cache_buf_init(&buf, entry->data, 0);
+	for (size_t i = 0; (i < dm->cur_attr_id) && !err; i++) {
+		err = cache_attr_put(&buf, &dm->attrs[i]);
+	}
+
+	if (err) {
+		LOG_DBG("Discovery data does not fit in the cache");
+		entry->data_len = 0;
+	} else {
+		bt_addr_le_copy(&entry->addr, bt_conn_get_dst(dm->conn));
+		memcpy(entry->db_hash, dm->db_hash, DB_HASH_LEN);
+		entry->start_handle = dm->start_handle;
+		entry->has_svc_uuid = (dm->svc_uuid != NULL);
+		if (dm->svc_uuid) {
+			memcpy(&entry->svc_uuid, dm->svc_uuid,
+			       get_uuid_size(dm->svc_uuid));
+		}
+		entry->last_used = ++cache_use_cnt;
+		entry->data_len = buf.len;
+	}
+
+	k_mutex_unlock(&cache_lock);
+}
+
+static int cache_restore(struct bt_gatt_dm *dm)
+{
+	struct cache_entry *entry;
+	struct net_buf_simple buf;
+	int err = 0;
+
+	/* The discovery parameters change as discovery goes on */
+	dm->start_handle = dm->discover_params.start_handle;
+	dm->svc_uuid = dm->discover_params.uuid;
+
+	if (!atomic_test_bit(dm->state_flags, STATE_DB_HASH_VALID)) {
+		return -ENOENT;
+	}
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	entry = cache_find(dm);
+	if (entry) {
+		entry->last_used = ++cache_use_cnt;
+
+		cache_buf_init(&buf, entry->data, entry->data_len);
+		while (buf.len && !err) {
+			err = cache_attr_restore(dm, &buf);
+		}
+	}
+
+	k_mutex_unlock(&cache_lock);
+
+	if (!entry) {
+		return -ENOENT;
+	}
+
+	if (err) {
+		return err;
+	}
+
+	LOG_DBG("Discovery data restored from cache");
+
+	/* Set up the state bt_gatt_dm_continue expects */
+	dm->discover_params.end_handle =
+		bt_gatt_dm_attr_service_val(&dm->attrs[0])->end_handle;
+
+	return 0;
+}
+
+void bt_gatt_dm_cache_clear(const bt_addr_le_t *addr)
+{
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (!addr || !bt_addr_le_cmp(&cache[i].addr, addr)) {
+			cache[i].data_len = 0;
+		}
+	}
+
+	k_mutex_unlock(&cache_lock);
+}
+
+#else
+
+static void cache_store(struct bt_gatt_dm *dm)
+{
+}
+
+static int cache_restore(struct bt_gatt_dm *dm)
+{
+	return -ENOENT;
+}
+
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
+static void discovery_complete_notify(struct bt_gatt_dm *dm)
 {
-	LOG_DBG("Discovery complete.");
 	atomic_set_bit(dm->state_flags, STATE_ATTRS_RELEASE_PENDING);
 	if (dm->callback->completed) {
 		dm->callback->completed(dm, dm->context);
 	}
 }
 
+static void discovery_complete(struct bt_gatt_dm *dm)
+{
+	LOG_DBG("Discovery complete.");
+	cache_store(dm);
+	discovery_complete_notify(dm);
+}
+
 static void discovery_complete_not_found(struct bt_gatt_dm *dm)
 {
+	struct bt_conn *conn = dm->conn;
+
 	LOG_DBG("Discover complete. No service found.");
 
 	svc_attr_memory_release(dm);
+	/* The instance may be taken over by any connection from now on */
+	dm->conn = NULL;
 	atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
 
 	if (dm->callback->service_not_found) {
-		dm->callback->service_not_found(dm->conn, dm->context);
+		dm->callback->service_not_found(conn, dm->context);
 	}
 }
 
 static void discovery_complete_error(struct bt_gatt_dm *dm, int err)
 {
+	struct bt_conn *conn = dm->conn;
+
 	svc_attr_memory_release(dm);
+	dm->conn = NULL;
 	atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
 	if (dm->callback->error_found) {
-		dm->callback->error_found(dm->conn, err, dm->context);
+		dm->callback->error_found(conn, err, dm->context);
+	}
+}
+
+/* Start discovery from the current discovery parameters,
+ * or complete it at once from the cache.
+ */
+static int discovery_begin(struct bt_gatt_dm *dm)
+{
+	int err;
+
+	err = cache_restore(dm);
+	if (!err) {
+		discovery_complete_notify(dm);
+		return 0;
+	}
+
+	if (err != -ENOENT) {
+		return err;
+	}
+
+	err = bt_gatt_discover(dm->conn, &dm->discover_params);
+	if (err) {
+		LOG_ERR("Discover failed, error: %d.", err);
+	}
+
+	return err;
+}
+
+#if defined(CONFIG_BT_GATT_DM_CACHE)
+
+/* The read uses the UUID after db_hash_read returns */
+static struct bt_uuid const * const uuid_db_hash = BT_UUID_GATT_DB_HASH;
+
+static uint8_t db_hash_read_cb(struct bt_conn *conn, uint8_t err,
+			       struct bt_gatt_read_params *params,
+			       const void *data, uint16_t length)
+{
+	struct bt_gatt_dm *dm = CONTAINER_OF(params, struct bt_gatt_dm,
+					     hash_read_params);
+	int ret;
+
+	if (!err && data && (length == DB_HASH_LEN)) {
+		memcpy(dm->db_hash, data, DB_HASH_LEN);
+		atomic_set_bit(dm->state_flags, STATE_DB_HASH_VALID);
+	} else {
+		LOG_DBG("Database hash not available, err: %u", err);
+	}
+
+	ret = discovery_begin(dm);
+	if (ret) {
+		discovery_complete_error(dm, ret);
+	}
+
+	return BT_GATT_ITER_STOP;
+}
+
+static int db_hash_read(struct bt_gatt_dm *dm)
+{
+	atomic_clear_bit(dm->state_flags, STATE_DB_HASH_VALID);
+
+	/* The cache is keyed by the peer address. A random private
+	 * address that was not resolved changes over time, so the data
+	 * of such a peer could never be found again.
+	 */
+	if (bt_addr_le_is_rpa(bt_conn_get_dst(dm->conn))) {
+		return -ENOTSUP;
 	}
+
+	dm->hash_read_params.func = db_hash_read_cb;
+	dm->hash_read_params.handle_count = 0;
+	dm->hash_read_params.by_uuid.start_handle = 0x0001;
+	dm->hash_read_params.by_uuid.end_handle = 0xffff;
+	dm->hash_read_params.by_uuid.uuid = uuid_db_hash;
+
+	return bt_gatt_read(dm->conn, &dm->hash_read_params);
 }
 
+#else
+
+static int db_hash_read(struct bt_gatt_dm *dm)
+{
+	return -ENOTSUP;
+}
+
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 static uint8_t discovery_process_service(struct bt_gatt_dm *dm,
 				      const struct bt_gatt_attr *attr,
 				      struct bt_gatt_discover_params *params)
@@ -406,30 +862,29 @@ static uint8_t discovery_callback(struct bt_conn *conn,
 			       const struct bt_gatt_attr *attr,
 			       struct bt_gatt_discover_params *params)
 {
+	struct bt_gatt_dm *dm = CONTAINER_OF(params, struct bt_gatt_dm,
+					     discover_params);
+
 	if (!attr) {
 		LOG_DBG("NULL attribute");
 	} else {
 		LOG_DBG("Attr: handle %u", attr->handle);
 	}
 
-	if (conn != bt_gatt_dm_inst.conn) {
+	if (conn != dm->conn) {
 		LOG_ERR("Unexpected conn object. Aborting.");
-		discovery_complete_error(&bt_gatt_dm_inst, -EFAULT);
+		discovery_complete_error(dm, -EFAULT);
 		return BT_GATT_ITER_STOP;
 	}
 
 	switch (params->type) {
 	case BT_GATT_DISCOVER_PRIMARY:
 	case BT_GATT_DISCOVER_SECONDARY:
-		return discovery_process_service(&bt_gatt_dm_inst,
-						 attr, params);
+		return discovery_process_service(dm, attr, params);
 	case BT_GATT_DISCOVER_ATTRIBUTE:
-		return discovery_process_attribute(&bt_gatt_dm_inst,
-						   attr, params);
+		return discovery_process_attribute(dm, attr, params);
 	case BT_GATT_DISCOVER_CHARACTERISTIC:
-		return discovery_process_characteristic(&bt_gatt_dm_inst,
-							attr,
-							params);
+		return discovery_process_characteristic(dm, attr, params);
 	default:
 		/* This should not be possible */
 		__ASSERT(false, "Unknown param type.");
@@ -568,10 +1023,41 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_next(
 	return curr;
 }
 
-int bt_gatt_dm_start(struct bt_conn *conn,
-		     const struct bt_uuid *svc_uuid,
-		     const struct bt_gatt_dm_cb *cb,
-		     void *context)
+static struct bt_gatt_dm *dm_alloc(struct bt_conn *conn)
+{
+	/* Prefer the instance used last for the same connection,
+	 * then an unused one, then any released one.
+	 * This keeps the state for bt_gatt_dm_continue available
+	 * as long as there are enough instances.
+	 */
+	for (int pass = 0; pass < 3; pass++) {
+		for (size_t i = 0; i < ARRAY_SIZE(bt_gatt_dm_inst); i++) {
+			struct bt_gatt_dm *dm = &bt_gatt_dm_inst[i];
+
+			if ((pass == 0) && (dm->conn != conn)) {
+				continue;
+			}
+
+			if ((pass == 1) && dm->conn) {
+				continue;
+			}
+
+			if (!atomic_test_and_set_bit(dm->state_flags,
+						     STATE_ATTRS_LOCKED)) {
+				return dm;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static int dm_start(struct bt_conn *conn,
+		    const struct bt_uuid *svc_uuid,
+		    const struct bt_gatt_dm_cb *cb,
+		    void *context,
+		    void *arena,
+		    size_t arena_size)
 {
 	int err;
 	struct bt_gatt_dm *dm;
@@ -586,9 +1072,8 @@ int bt_gatt_dm_start(struct bt_conn *conn,
 		return -EINVAL;
 	}
 
-	dm = &bt_gatt_dm_inst;
-
-	if (atomic_test_and_set_bit(dm->state_flags, STATE_ATTRS_LOCKED)) {
+	dm = dm_alloc(conn);
+	if (!dm) {
 		return -EALREADY;
 	}
 
@@ -598,22 +1083,60 @@ int bt_gatt_dm_start(struct bt_conn *conn,
 	dm->cur_attr_id = 0;
 	sys_slist_init(&dm->chunk_list);
 	dm->cur_chunk_len = 0;
-
-	dm->discover_params.uuid = svc_uuid ? uuid_store(dm, svc_uuid) : NULL;
+	dm->arena = arena;
+	dm->arena_size = arena_size;
+	dm->arena_used = 0;
+
+	dm->discover_params.uuid = NULL;
+	if (svc_uuid) {
+		dm->discover_params.uuid = uuid_store(dm, svc_uuid);
+		if (!dm->discover_params.uuid) {
+			atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
+			return -ENOMEM;
+		}
+	}
 	dm->discover_params.func = discovery_callback;
 	dm->discover_params.start_handle = 0x0001;
 	dm->discover_params.end_handle = 0xffff;
 	dm->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
 
-	err = bt_gatt_discover(conn, &dm->discover_params);
+	err = db_hash_read(dm);
 	if (err) {
-		LOG_ERR("Discover failed, error: %d.", err);
+		/* Discover without the cache */
+		err = discovery_begin(dm);
+	}
+
+	if (err) {
+		svc_attr_memory_release(dm);
 		atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
 	}
 
 	return err;
 }
 
+int bt_gatt_dm_start(struct bt_conn *conn,
+		     const struct bt_uuid *svc_uuid,
+		     const struct bt_gatt_dm_cb *cb,
+		     void *context)
+{
+	return dm_start(conn, svc_uuid, cb, context, NULL, 0);
+}
+
+int bt_gatt_dm_start_arena(struct bt_conn *conn,
+			   const struct bt_uuid *svc_uuid,
+			   const struct bt_gatt_dm_cb *cb,
+			   void *context,
+			   void *arena,
+			   size_t arena_size)
+{
+	if (!arena || !arena_size ||
+	    ((uintptr_t)arena % DATA_ALIGN)) {
+		return -EINVAL;
+	}
+
+	return dm_start(conn, svc_uuid, cb, context, arena, arena_size);
+}
+
 int bt_gatt_dm_continue(struct bt_gatt_dm *dm, void *context)
 {
 	int err;
@@ -646,9 +1169,9 @@ int bt_gatt_dm_continue(struct bt_gatt_dm *dm, void *context)
 	dm->discover_params.end_handle = 0xffff;
 	dm->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
 
-	err = bt_gatt_discover(dm->conn, &dm->discover_params);
+	err = discovery_begin(dm);
 	if (err) {
-		LOG_ERR("Discover failed, error: %d.", err);
+		svc_attr_memory_release(dm);
 		atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
 	}
 
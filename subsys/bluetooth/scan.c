@@ -6,6 +6,7 @@
 
 #include <zephyr.h>
 #include <sys/byteorder.h>
+#include <stdlib.h>
 #include <string.h>
 #include <bluetooth/scan.h>
 
@@ -18,6 +19,45 @@ LOG_MODULE_REGISTER(nrf_bt_scan, CONFIG_BT_SCAN_LOG_LEVEL);
 	BT_SCAN_SHORT_NAME_FILTER | BT_SCAN_APPEARANCE_FILTER | \
 	BT_SCAN_UUID_FILTER | BT_SCAN_MANUFACTURER_DATA_FILTER)
 
+/* Open addressing table with at most half of the slots used. */
+#define ADDR_HASH_SIZE (2 * CONFIG_BT_SCAN_ADDRESS_CNT + 1)
+
+/* Worst case: no common prefixes, plus the root node. */
+#define NAME_TRIE_SIZE \
+	(CONFIG_BT_SCAN_NAME_CNT * CONFIG_BT_SCAN_NAME_MAX_LEN + 1)
+#define SHORT_NAME_TRIE_SIZE \
+	(CONFIG_BT_SCAN_SHORT_NAME_CNT * CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN + 1)
+
+/* Filter sets are tracked as bit masks. */
+BUILD_ASSERT(CONFIG_BT_SCAN_NAME_CNT <= 32);
+BUILD_ASSERT(CONFIG_BT_SCAN_SHORT_NAME_CNT <= 32);
+BUILD_ASSERT(CONFIG_BT_SCAN_UUID_CNT <= 32);
+/* Address hash slots store the filter index plus one. */
+BUILD_ASSERT(CONFIG_BT_SCAN_ADDRESS_CNT < UINT8_MAX);
+BUILD_ASSERT(NAME_TRIE_SIZE <= UINT16_MAX);
+BUILD_ASSERT(SHORT_NAME_TRIE_SIZE <= UINT16_MAX);
+
+/* Bluetooth Base UUID in little-endian order, without the 32-bit value. */
+static const uint8_t base_uuid_le[BT_SCAN_UUID_128_SIZE - sizeof(uint32_t)] = {
+	0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00
+};
+
+/* Filter type checked for each advertising data type.
+ * Advertising data of other types is skipped without further processing.
+ */
+static const uint8_t ad_type_filter[UINT8_MAX + 1] = {
+	[BT_DATA_NAME_COMPLETE] = BT_SCAN_NAME_FILTER,
+	[BT_DATA_NAME_SHORTENED] = BT_SCAN_SHORT_NAME_FILTER,
+	[BT_DATA_GAP_APPEARANCE] = BT_SCAN_APPEARANCE_FILTER,
+	[BT_DATA_UUID16_SOME] = BT_SCAN_UUID_FILTER,
+	[BT_DATA_UUID16_ALL] = BT_SCAN_UUID_FILTER,
+	[BT_DATA_UUID32_SOME] = BT_SCAN_UUID_FILTER,
+	[BT_DATA_UUID32_ALL] = BT_SCAN_UUID_FILTER,
+	[BT_DATA_UUID128_SOME] = BT_SCAN_UUID_FILTER,
+	[BT_DATA_UUID128_ALL] = BT_SCAN_UUID_FILTER,
+	[BT_DATA_MANUFACTURER_DATA] = BT_SCAN_MANUFACTURER_DATA_FILTER,
+};
+
 /* Scan filter add mutex. */
 K_MUTEX_DEFINE(scan_add_mutex);
 
@@ -28,6 +68,9 @@ struct bt_scan_control {
 	/* Number of active filters. */
 	uint8_t filter_cnt;
 
+	/* Active filter types, as a filter mode mask. */
+	uint8_t filter_mode;
+
 	/* Number of matched filters. */
 	uint8_t filter_match_cnt;
 
@@ -47,13 +90,40 @@ struct bt_scan_control {
 	struct bt_scan_filter_match filter_status;
 };
 
+/* Prefix tree node for name filters.
+ * An advertised name matches the filters in the subtree of the node
+ * reached by walking its characters from the root.
+ */
+struct bt_scan_trie_node {
+	/* Filters with a name in the subtree of this node, one bit each. */
+	uint32_t mask;
+
+	/* Index of the first child node, 0 if none. */
+	uint16_t child;
+
+	/* Index of the next sibling node, 0 if none. */
+	uint16_t sibling;
+
+	/* Character leading to this node. */
+	char ch;
+};
+
 /* Name filter structure.
  */
 struct bt_scan_name_filter {
 	/* Names that the main application will scan for,
 	 * and that will be advertised by the peripherals.
 	 */
-	char target_name[CONFIG_BT_SCAN_NAME_CNT][CONFIG_BT_SCAN_NAME_MAX_LEN];
+	char target_name[CONFIG_BT_SCAN_NAME_CNT][CONFIG_BT_SCAN_NAME_MAX_LEN + 1];
+
+	/* Prefix tree of the names, node 0 is the root. */
+	struct bt_scan_trie_node trie[NAME_TRIE_SIZE];
+
+	/* Number of used prefix tree nodes. */
+	uint16_t trie_cnt;
+
+	/* Number of matches for each filter. */
+	uint32_t hits[CONFIG_BT_SCAN_NAME_CNT];
 
 	/* Name filter counter. */
 	uint8_t cnt;
@@ -70,12 +140,21 @@ struct bt_scan_short_name_filter {
 		/* Short names that the main application will scan for,
 		 * and that will be advertised by the peripherals.
 		 */
-		char target_name[CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN];
+		char target_name[CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN + 1];
 
 		/* Minimum length of the short name. */
 		uint8_t min_len;
 	} name[CONFIG_BT_SCAN_SHORT_NAME_CNT];
 
+	/* Prefix tree of the names, node 0 is the root. */
+	struct bt_scan_trie_node trie[SHORT_NAME_TRIE_SIZE];
+
+	/* Number of used prefix tree nodes. */
+	uint16_t trie_cnt;
+
+	/* Number of matches for each filter. */
+	uint32_t hits[CONFIG_BT_SCAN_SHORT_NAME_CNT];
+
 	/* Short name filter counter. */
 	uint8_t cnt;
 
@@ -89,6 +168,12 @@ struct bt_scan_addr_filter {
 	/* Addresses advertised by the peripherals. */
 	bt_addr_le_t target_addr[CONFIG_BT_SCAN_ADDRESS_CNT];
 
+	/* Hash table of the addresses, holding filter index plus one. */
+	uint8_t hash[ADDR_HASH_SIZE];
+
+	/* Number of matches for each filter. */
+	uint32_t hits[CONFIG_BT_SCAN_ADDRESS_CNT];
+
 	/* Address filter counter. */
 	uint8_t cnt;
 
@@ -110,6 +195,15 @@ struct bt_scan_uuid {
 		/* 128-bit UUID. */
 		struct bt_uuid_128 uuid_128;
 	} uuid_data;
+
+	/* Little-endian 128-bit form of the UUID. */
+	uint8_t val_128[BT_SCAN_UUID_128_SIZE];
+
+	/* 32-bit value if the UUID is based on the Bluetooth Base UUID. */
+	uint32_t val_32;
+
+	/* Indicates whether the UUID is based on the Bluetooth Base UUID. */
+	bool base;
 };
 
 /* UUIDs filter structure.
@@ -120,6 +214,9 @@ struct bt_scan_uuid_filter {
 	 */
 	struct bt_scan_uuid uuid[CONFIG_BT_SCAN_UUID_CNT];
 
+	/* Number of matches for each filter. */
+	uint32_t hits[CONFIG_BT_SCAN_UUID_CNT];
+
 	/* UUID filter counter. */
 	uint8_t cnt;
 
@@ -133,6 +230,9 @@ struct bt_scan_appearance_filter {
 	 */
 	uint16_t appearance[CONFIG_BT_SCAN_APPEARANCE_CNT];
 
+	/* Number of matches for each filter. */
+	uint32_t hits[CONFIG_BT_SCAN_APPEARANCE_CNT];
+
 	/* Appearance filter counter. */
 	uint8_t cnt;
 
@@ -155,6 +255,9 @@ struct bt_scan_manufacturer_data_filter {
 		uint8_t data_len;
 	} manufacturer_data[CONFIG_BT_SCAN_MANUFACTURER_DATA_CNT];
 
+	/* Number of matches for each filter. */
+	uint32_t hits[CONFIG_BT_SCAN_MANUFACTURER_DATA_CNT];
+
 	/* Name filter counter. */
 	uint8_t cnt;
 
@@ -223,6 +326,53 @@ static struct bt_scan {
 
 } bt_scan;
 
+#if CONFIG_BT_SCAN_DUPLICATE_FILTER
+/* Last report passed on for a device and advertising type. */
+struct bt_scan_dup_entry {
+	/* Node in the list of devices, most recently seen first. */
+	sys_dnode_t node;
+
+	/* Device address. */
+	bt_addr_le_t addr;
+
+	/* Hash of the advertising data. */
+	uint32_t data_hash;
+
+	/* Uptime of the report, in milliseconds. */
+	uint32_t timestamp;
+
+	/* Next entry in the same hash bucket, index plus one. */
+	uint8_t next;
+
+	/* Advertising type. */
+	uint8_t adv_type;
+
+	/* RSSI of the report. */
+	int8_t rssi;
+};
+
+/* Duplicate report cache. */
+static struct {
+	struct bt_scan_dup_entry entry[CONFIG_BT_SCAN_DUPLICATE_CACHE_SIZE];
+
+	/* First entry of each hash bucket, index plus one. */
+	uint8_t bucket[CONFIG_BT_SCAN_DUPLICATE_CACHE_SIZE];
+
+	/* Used entries, most recently seen first. */
+	sys_dlist_t lru;
+
+	/* Number of used entries. */
+	uint8_t cnt;
+
+	uint32_t ttl;
+	uint8_t rssi_threshold;
+
+	struct bt_scan_duplicate_stats stats;
+
+	struct k_spinlock lock;
+} dup_cache;
+#endif /* CONFIG_BT_SCAN_DUPLICATE_FILTER */
+
 static sys_slist_t callback_list;
 
 void bt_scan_cb_register(struct bt_scan_cb *cb)
@@ -283,6 +433,165 @@ static void notify_connecting_error(struct bt_scan_device_info *device_info)
 	}
 }
 
+#if CONFIG_BT_SCAN_DUPLICATE_FILTER
+static size_t dup_bucket_get(const bt_addr_le_t *addr, uint8_t adv_type)
+{
+	return (sys_get_le32(addr->a.val) ^ addr->type ^ adv_type) %
+	       ARRAY_SIZE(dup_cache.bucket);
+}
+
+static uint32_t adv_data_hash(const struct net_buf_simple *ad)
+{
+	/* FNV-1a */
+	uint32_t hash = 2166136261U;
+
+	for (size_t i = 0; i < ad->len; i++) {
+		hash = (hash ^ ad->data[i]) * 16777619U;
+	}
+
+	return hash;
+}
+
+static struct bt_scan_dup_entry *dup_entry_find(const bt_addr_le_t *addr,
+						uint8_t adv_type)
+{
+	uint8_t idx = dup_cache.bucket[dup_bucket_get(addr, adv_type)];
+
+	while (idx) {
+		struct bt_scan_dup_entry *entry = &dup_cache.entry[idx - 1];
+
+		if ((entry->adv_type == adv_type) &&
+		    !bt_addr_le_cmp(&entry->addr, addr)) {
+			return entry;
+		}
+
+		idx = entry->next;
+	}
+
+	return NULL;
+}
+
+static void dup_entry_unlink(struct bt_scan_dup_entry *entry)
+{
+	uint8_t *idx = &dup_cache.bucket[dup_bucket_get(&entry->addr,
+							entry->adv_type)];
+
+	while (&dup_cache.entry[*idx - 1] != entry) {
+		idx = &dup_cache.entry[*idx - 1].next;
+	}
+
+	*idx = entry->next;
+}
+
+static struct bt_scan_dup_entry *dup_entry_alloc(const bt_addr_le_t *addr,
+						 uint8_t adv_type)
+{
+	struct bt_scan_dup_entry *entry;
+	uint8_t *bucket;
+
+	if (dup_cache.cnt < ARRAY_SIZE(dup_cache.entry)) {
+		entry = &dup_cache.entry[dup_cache.cnt];
+		dup_cache.cnt++;
+	} else {
+		/* Replace the device that has not been seen for longest. */
+		entry = CONTAINER_OF(sys_dlist_peek_tail(&dup_cache.lru),
+				     struct bt_scan_dup_entry, node);
+		sys_dlist_remove(&entry->node);
+		dup_entry_unlink(entry);
+		dup_cache.stats.evicted++;
+	}
+
+	bt_addr_le_copy(&entry->addr, addr);
+	entry->adv_type = adv_type;
+
+	bucket = &dup_cache.bucket[dup_bucket_get(addr, adv_type)];
+	entry->next = *bucket;
+	*bucket = (entry - dup_cache.entry) + 1;
+
+	return entry;
+}
+
+static bool dup_report_check(const bt_addr_le_t *addr, int8_t rssi,
+			     uint8_t adv_type, const struct net_buf_simple *ad)
+{
+	uint32_t data_hash = adv_data_hash(ad);
+	uint32_t now = k_uptime_get_32();
+	struct bt_scan_dup_entry *entry;
+	bool duplicate = false;
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&dup_cache.lock);
+
+	entry = dup_entry_find(addr, adv_type);
+	if (entry) {
+		int rssi_diff = rssi - entry->rssi;
+
+		duplicate = (entry->data_hash == data_hash) &&
+			    (!dup_cache.rssi_threshold ||
+			     (abs(rssi_diff) < dup_cache.rssi_threshold)) &&
+			    (!dup_cache.ttl ||
+			     ((now - entry->timestamp) < dup_cache.ttl));
+
+		sys_dlist_remove(&entry->node);
+	} else {
+		entry = dup_entry_alloc(addr, adv_type);
+	}
+
+	sys_dlist_prepend(&dup_cache.lru, &entry->node);
+
+	if (duplicate) {
+		dup_cache.stats.suppressed++;
+	} else {
+		entry->data_hash = data_hash;
+		entry->rssi = rssi;
+		entry->timestamp = now;
+		dup_cache.stats.passed++;
+	}
+
+	k_spin_unlock(&dup_cache.lock, key);
+
+	return duplicate;
+}
+
+void bt_scan_duplicate_filter_set(uint32_t ttl_ms, uint8_t rssi_threshold)
+{
+	k_spinlock_key_t key = k_spin_lock(&dup_cache.lock);
+
+	dup_cache.ttl = ttl_ms;
+	dup_cache.rssi_threshold = rssi_threshold;
+
+	k_spin_unlock(&dup_cache.lock, key);
+}
+
+void bt_scan_duplicate_cache_clear(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&dup_cache.lock);
+
+	sys_dlist_init(&dup_cache.lru);
+	memset(dup_cache.bucket, 0, sizeof(dup_cache.bucket));
+	dup_cache.cnt = 0;
+
+	k_spin_unlock(&dup_cache.lock, key);
+}
+
+void bt_scan_duplicate_stats_get(struct bt_scan_duplicate_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&dup_cache.lock);
+
+	*stats = dup_cache.stats;
+
+	k_spin_unlock(&dup_cache.lock, key);
+}
+
+static void dup_cache_init(void)
+{
+	bt_scan_duplicate_cache_clear();
+	bt_scan_duplicate_filter_set(CONFIG_BT_SCAN_DUPLICATE_TTL,
+				     CONFIG_BT_SCAN_DUPLICATE_RSSI_THRESHOLD);
+	memset(&dup_cache.stats, 0, sizeof(dup_cache.stats));
+}
+#endif /* CONFIG_BT_SCAN_DUPLICATE_FILTER */
+
 static void scan_connect_with_target(struct bt_scan_control *control,
 				     const bt_addr_le_t *addr)
 {
@@ -316,22 +625,54 @@ static void scan_connect_with_target(struct bt_scan_control *control,
 	}
 }
 
+static size_t addr_hash_slot(const bt_addr_le_t *addr)
+{
+	/* Device addresses are random enough to be used as the hash. */
+	return (sys_get_le32(addr->a.val) ^ addr->type) % ADDR_HASH_SIZE;
+}
+
+/* Returns the hash slot holding the address,
+ * or the empty slot where it is to be inserted.
+ */
+static uint8_t *addr_hash_find(const bt_addr_le_t *addr)
+{
+	struct bt_scan_addr_filter *addr_filter = &bt_scan.scan_filters.addr;
+	size_t slot = addr_hash_slot(addr);
+
+	while (addr_filter->hash[slot]) {
+		uint8_t idx = addr_filter->hash[slot] - 1;
+
+		if (bt_addr_le_cmp(addr, &addr_filter->target_addr[idx]) == 0) {
+			break;
+		}
+
+		slot = (slot + 1) % ADDR_HASH_SIZE;
+	}
+
+	return &addr_filter->hash[slot];
+}
+
 static bool adv_addr_compare(const bt_addr_le_t *target_addr,
 			     struct bt_scan_control *control)
 {
-	const bt_addr_le_t *addr =
-			bt_scan.scan_filters.addr.target_addr;
-	uint8_t counter = bt_scan.scan_filters.addr.cnt;
+	struct bt_scan_addr_filter *addr_filter = &bt_scan.scan_filters.addr;
+	uint8_t *slot;
+	uint8_t idx;
 
-	for (size_t i = 0; i < counter; i++) {
-		if (bt_addr_le_cmp(target_addr, &addr[i]) == 0) {
-			control->filter_status.addr.addr = &addr[i];
+	if (!addr_filter->cnt) {
+		return false;
+	}
 
-			return true;
-		}
+	slot = addr_hash_find(target_addr);
+	if (!*slot) {
+		return false;
 	}
 
-	return false;
+	idx = *slot - 1;
+	addr_filter->hits[idx]++;
+	control->filter_status.addr.addr = &addr_filter->target_addr[idx];
+
+	return true;
 }
 
 static bool is_addr_filter_enabled(void)
@@ -359,6 +700,7 @@ static int scan_addr_filter_add(const bt_addr_le_t *target_addr)
 	bt_addr_le_t *addr_filter =
 			bt_scan.scan_filters.addr.target_addr;
 	uint8_t counter = bt_scan.scan_filters.addr.cnt;
+	uint8_t *slot;
 
 	/* If no memory for filter. */
 	if (counter >= CONFIG_BT_SCAN_ADDRESS_CNT) {
@@ -366,14 +708,15 @@ static int scan_addr_filter_add(const bt_addr_le_t *target_addr)
 	}
 
 	/* Check for duplicated filter. */
-	for (size_t i = 0; i < counter; i++) {
-		if (bt_addr_le_cmp(target_addr, &addr_filter[i]) == 0) {
-			return 0;
-		}
+	slot = addr_hash_find(target_addr);
+	if (*slot) {
+		return 0;
 	}
 
 	/* Add target address to filter. */
 	bt_addr_le_copy(&addr_filter[counter], target_addr);
+	bt_scan.scan_filters.addr.hits[counter] = 0;
+	*slot = counter + 1;
 
 	LOG_DBG("Filter set on address type %i",
 		addr_filter[counter].type);
@@ -388,36 +731,130 @@ static int scan_addr_filter_add(const bt_addr_le_t *target_addr)
 	return 0;
 }
 
-static bool adv_name_cmp(const uint8_t *data,
-			 uint8_t data_len,
-			 const char *target_name)
+static int trie_insert(struct bt_scan_trie_node *trie, uint16_t *trie_cnt,
+		       size_t trie_size, const char *name, uint8_t idx)
+{
+	uint16_t node = 0;
+	uint16_t cnt = *trie_cnt;
+
+	if (cnt == 0) {
+		/* Root node. */
+		memset(&trie[0], 0, sizeof(trie[0]));
+		cnt = 1;
+	}
+
+	/* Check the space first, so that a failed insert leaves no trace. */
+	for (const char *c = name; *c; c++) {
+		uint16_t child = trie[node].child;
+
+		while (child && (trie[child].ch != *c)) {
+			child = trie[child].sibling;
+		}
+
+		if (!child) {
+			if (cnt + strlen(c) > trie_size) {
+				return -ENOMEM;
+			}
+
+			break;
+		}
+
+		node = child;
+	}
+
+	node = 0;
+	trie[node].mask |= BIT(idx);
+
+	for (const char *c = name; *c; c++) {
+		uint16_t child = trie[node].child;
+
+		while (child && (trie[child].ch != *c)) {
+			child = trie[child].sibling;
+		}
+
+		if (!child) {
+			child = cnt++;
+			trie[child].ch = *c;
+			trie[child].mask = 0;
+			trie[child].child = 0;
+			trie[child].sibling = trie[node].child;
+			trie[node].child = child;
+		}
+
+		node = child;
+		trie[node].mask |= BIT(idx);
+	}
+
+	*trie_cnt = cnt;
+
+	return 0;
+}
+
+/* Returns the filters with a name starting with the advertised data. */
+static uint32_t trie_match(const struct bt_scan_trie_node *trie,
+			   uint16_t trie_cnt,
+			   const uint8_t *data, uint8_t data_len)
 {
-	return strncmp(target_name, data, data_len) == 0;
+	uint16_t node = 0;
+
+	if (trie_cnt == 0) {
+		return 0;
+	}
+
+	for (size_t i = 0; i < data_len; i++) {
+		uint16_t child = trie[node].child;
+
+		if (data[i] == '\0') {
+			/* The name ends at the NUL, as with strncmp().
+			 * Only the filters with a name ending here match.
+			 */
+			uint32_t mask = trie[node].mask;
+
+			while (child) {
+				mask &= ~trie[child].mask;
+				child = trie[child].sibling;
+			}
+
+			return mask;
+		}
+
+		while (child && (trie[child].ch != (char)data[i])) {
+			child = trie[child].sibling;
+		}
+
+		if (!child) {
+			return 0;
+		}
+
+		node = child;
+	}
+
+	return trie[node].mask;
 }
 
 static bool adv_name_compare(const struct bt_data *data,
 			     struct bt_scan_control *control)
 {
-	struct bt_scan_name_filter const *name_filter =
+	struct bt_scan_name_filter *name_filter =
 			&bt_scan.scan_filters.name;
-	uint8_t counter = bt_scan.scan_filters.name.cnt;
 	uint8_t data_len = data->data_len;
+	uint32_t mask;
+	uint8_t idx;
 
-	/* Compare the name found with the name filter. */
-	for (size_t i = 0; i < counter; i++) {
-		if (adv_name_cmp(data->data,
-				 data_len,
-				 name_filter->target_name[i])) {
+	mask = trie_match(name_filter->trie, name_filter->trie_cnt,
+			  data->data, data_len);
+	if (!mask) {
+		return false;
+	}
 
-			control->filter_status.name.name =
-				name_filter->target_name[i];
-			control->filter_status.name.len = data_len;
+	/* The filter added first takes precedence. */
+	idx = find_lsb_set(mask) - 1;
+	name_filter->hits[idx]++;
 
-			return true;
-		}
-	}
+	control->filter_status.name.name = name_filter->target_name[idx];
+	control->filter_status.name.len = data_len;
 
-	return false;
+	return true;
 }
 
 static bool is_name_filter_enabled(void)
@@ -443,6 +880,7 @@ static int scan_name_filter_add(const char *name)
 {
 	uint8_t counter = bt_scan.scan_filters.name.cnt;
 	size_t name_len;
+	int err;
 
 	/* If no memory for filter. */
 	if (counter >= CONFIG_BT_SCAN_NAME_CNT) {
@@ -464,8 +902,18 @@ static int scan_name_filter_add(const char *name)
 	}
 
 	/* Add name to filter. */
+	err = trie_insert(bt_scan.scan_filters.name.trie,
+			  &bt_scan.scan_filters.name.trie_cnt,
+			  ARRAY_SIZE(bt_scan.scan_filters.name.trie),
+			  name, counter);
+	if (err) {
+		return err;
+	}
+
 	memcpy(bt_scan.scan_filters.name.target_name[counter],
 	       name, name_len);
+	bt_scan.scan_filters.name.target_name[counter][name_len] = '\0';
+	bt_scan.scan_filters.name.hits[counter] = 0;
 
 	bt_scan.scan_filters.name.cnt++;
 
@@ -474,40 +922,32 @@ static int scan_name_filter_add(const char *name)
 	return 0;
 }
 
-static bool adv_short_name_cmp(const uint8_t *data,
-			       uint8_t data_len,
-			       const char *target_name,
-			       uint8_t short_name_min_len)
-{
-	if ((data_len >= short_name_min_len) &&
-	    (strncmp(target_name, data, data_len) == 0)) {
-		return true;
-	}
-
-	return false;
-}
-
 static bool adv_short_name_compare(const struct bt_data *data,
 				   struct bt_scan_control *control)
 {
-	const struct bt_scan_short_name_filter *name_filter =
+	struct bt_scan_short_name_filter *name_filter =
 			&bt_scan.scan_filters.short_name;
-	uint8_t counter = bt_scan.scan_filters.short_name.cnt;
 	uint8_t data_len = data->data_len;
+	uint32_t mask;
 
-	/* Compare the name found with the name filters. */
-	for (size_t i = 0; i < counter; i++) {
-		if (adv_short_name_cmp(data->data,
-				       data_len,
-				       name_filter->name[i].target_name,
-				       name_filter->name[i].min_len)) {
+	mask = trie_match(name_filter->trie, name_filter->trie_cnt,
+			  data->data, data_len);
+
+	/* The filter added first takes precedence. */
+	while (mask) {
+		uint8_t idx = find_lsb_set(mask) - 1;
+
+		if (data_len >= name_filter->name[idx].min_len) {
+			name_filter->hits[idx]++;
 
 			control->filter_status.short_name.name =
-				name_filter->name[i].target_name;
+				name_filter->name[idx].target_name;
 			control->filter_status.short_name.len = data_len;
 
 			return true;
 		}
+
+		mask &= ~BIT(idx);
 	}
 
 	return false;
@@ -539,6 +979,7 @@ static int scan_short_name_filter_add(const struct bt_scan_short_name *short_nam
 	struct bt_scan_short_name_filter *short_name_filter =
 		    &bt_scan.scan_filters.short_name;
 	uint8_t name_len;
+	int err;
 
 	/* If no memory for filter. */
 	if (counter >= CONFIG_BT_SCAN_SHORT_NAME_CNT) {
@@ -562,10 +1003,20 @@ static int scan_short_name_filter_add(const struct bt_scan_short_name *short_nam
 	}
 
 	/* Add name to the filter. */
+	err = trie_insert(short_name_filter->trie,
+			  &short_name_filter->trie_cnt,
+			  ARRAY_SIZE(short_name_filter->trie),
+			  short_name->name, counter);
+	if (err) {
+		return err;
+	}
+
 	short_name_filter->name[counter].min_len = short_name->min_len;
 	memcpy(short_name_filter->name[counter].target_name,
 	       short_name->name,
 	       name_len);
+	short_name_filter->name[counter].target_name[name_len] = '\0';
+	short_name_filter->hits[counter] = 0;
 
 	bt_scan.scan_filters.short_name.cnt++;
 
@@ -574,11 +1025,14 @@ static int scan_short_name_filter_add(const struct bt_scan_short_name *short_nam
 	return 0;
 }
 
-static bool find_uuid(const uint8_t *data,
-		      uint8_t data_len,
-		      uint8_t uuid_type,
-		      const struct bt_scan_uuid *target_uuid)
+/* Returns the filters found in the advertised UUID list, one bit each. */
+static uint32_t find_uuids(const uint8_t *data,
+			   uint8_t data_len,
+			   uint8_t uuid_type)
 {
+	const struct bt_scan_uuid *target_uuid = bt_scan.scan_filters.uuid.uuid;
+	const uint8_t counter = bt_scan.scan_filters.uuid.cnt;
+	uint32_t found = 0;
 	uint8_t uuid_len;
 
 	switch (uuid_type) {
@@ -595,53 +1049,63 @@ static bool find_uuid(const uint8_t *data,
 		break;
 
 	default:
-		return false;
+		return 0;
 	}
 
-	for (size_t i = 0; i < data_len; i += uuid_len) {
-		struct bt_uuid_128 uuid;
+	for (size_t i = 0; i + uuid_len <= data_len; i += uuid_len) {
+		uint32_t val_32 = 0;
 
-		if (!bt_uuid_create(&uuid.uuid, &data[i], uuid_len)) {
-			return false;
+		if (uuid_type == BT_UUID_TYPE_16) {
+			val_32 = sys_get_le16(&data[i]);
+		} else if (uuid_type == BT_UUID_TYPE_32) {
+			val_32 = sys_get_le32(&data[i]);
 		}
 
-		if (bt_uuid_cmp(&uuid.uuid, target_uuid->uuid) == 0) {
-			return true;
+		for (size_t j = 0; j < counter; j++) {
+			if (uuid_type == BT_UUID_TYPE_128) {
+				if (!memcmp(&data[i], target_uuid[j].val_128,
+					    BT_SCAN_UUID_128_SIZE)) {
+					found |= BIT(j);
+				}
+			} else if (target_uuid[j].base &&
+				   (target_uuid[j].val_32 == val_32)) {
+				found |= BIT(j);
+			}
 		}
 	}
 
-	return false;
+	return found;
 }
 
 static bool adv_uuid_compare(const struct bt_data *data, uint8_t uuid_type,
 			     struct bt_scan_control *control)
 {
-	const struct bt_scan_uuid_filter *uuid_filter =
+	struct bt_scan_uuid_filter *uuid_filter =
 			&bt_scan.scan_filters.uuid;
 	const bool all_filters_mode = bt_scan.scan_filters.all_mode;
 	const uint8_t counter = bt_scan.scan_filters.uuid.cnt;
-	uint8_t data_len = data->data_len;
 	uint8_t uuid_match_cnt = 0;
+	uint32_t found;
 
-	for (size_t i = 0; i < counter; i++) {
+	found = find_uuids(data->data, data->data_len, uuid_type);
 
-		if (find_uuid(data->data, data_len, uuid_type,
-			      &uuid_filter->uuid[i])) {
+	if (all_filters_mode) {
+		/* Report the UUIDs found until the first one missing. */
+		while ((uuid_match_cnt < counter) &&
+		       (found & BIT(uuid_match_cnt))) {
 			control->filter_status.uuid.uuid[uuid_match_cnt] =
-				uuid_filter->uuid[i].uuid;
-
+				uuid_filter->uuid[uuid_match_cnt].uuid;
 			uuid_match_cnt++;
-
-			/* In the normal filter mode,
-			 * only one UUID is needed to match.
-			 */
-			if (!all_filters_mode) {
-				break;
-			}
-
-		} else if (all_filters_mode) {
-			break;
 		}
+	} else if (found) {
+		/* In the normal filter mode,
+		 * only one UUID is needed to match.
+		 */
+		uint8_t idx = find_lsb_set(found) - 1;
+
+		control->filter_status.uuid.uuid[0] = uuid_filter->uuid[idx].uuid;
+		uuid_match_cnt = 1;
+		found = BIT(idx);
 	}
 
 	control->filter_status.uuid.count = uuid_match_cnt;
@@ -651,6 +1115,12 @@ static bool adv_uuid_compare(const struct bt_data *data, uint8_t uuid_type,
 	 */
 	if ((all_filters_mode && (uuid_match_cnt == counter)) ||
 	    ((!all_filters_mode) && (uuid_match_cnt > 0))) {
+		for (size_t i = 0; i < counter; i++) {
+			if (found & BIT(i)) {
+				uuid_filter->hits[i]++;
+			}
+		}
+
 		return true;
 	}
 
@@ -705,6 +1175,7 @@ static int scan_uuid_filter_add(struct bt_uuid *uuid)
 		uuid_filter[counter].uuid_data.uuid_16 = *uuid_16;
 		uuid_filter[counter].uuid =
 				(struct bt_uuid *)&uuid_filter[counter].uuid_data.uuid_16;
+		uuid_filter[counter].val_32 = uuid_16->val;
 		break;
 
 	case BT_UUID_TYPE_32:
@@ -713,6 +1184,7 @@ static int scan_uuid_filter_add(struct bt_uuid *uuid)
 		uuid_filter[counter].uuid_data.uuid_32 = *uuid_32;
 		uuid_filter[counter].uuid =
 				(struct bt_uuid *)&uuid_filter[counter].uuid_data.uuid_32;
+		uuid_filter[counter].val_32 = uuid_32->val;
 		break;
 
 	case BT_UUID_TYPE_128:
@@ -727,6 +1199,25 @@ static int scan_uuid_filter_add(struct bt_uuid *uuid)
 		return -EINVAL;
 	}
 
+	/* Keep the UUID in the form used in the advertising data. */
+	if (uuid->type == BT_UUID_TYPE_128) {
+		const uint8_t *val = uuid_filter[counter].uuid_data.uuid_128.val;
+
+		memcpy(uuid_filter[counter].val_128, val,
+		       BT_SCAN_UUID_128_SIZE);
+		uuid_filter[counter].base =
+			!memcmp(val, base_uuid_le, sizeof(base_uuid_le));
+		uuid_filter[counter].val_32 =
+			sys_get_le32(&val[sizeof(base_uuid_le)]);
+	} else {
+		uuid_filter[counter].base = true;
+		memcpy(uuid_filter[counter].val_128, base_uuid_le,
+		       sizeof(base_uuid_le));
+		sys_put_le32(uuid_filter[counter].val_32,
+			     &uuid_filter[counter].val_128[sizeof(base_uuid_le)]);
+	}
+
+	bt_scan.scan_filters.uuid.hits[counter] = 0;
 	bt_scan.scan_filters.uuid.cnt++;
 	LOG_DBG("Added filter on UUID type %x", uuid->type);
 
@@ -754,7 +1245,7 @@ static bool find_appearance(const uint8_t *data,
 static bool adv_appearance_compare(const struct bt_data *data,
 				   struct bt_scan_control *control)
 {
-	const struct bt_scan_appearance_filter *appearance_filter =
+	struct bt_scan_appearance_filter *appearance_filter =
 			&bt_scan.scan_filters.appearance;
 	const uint8_t counter =
 			bt_scan.scan_filters.appearance.cnt;
@@ -768,6 +1259,7 @@ static bool adv_appearance_compare(const struct bt_data *data,
 				    data_len,
 				    &appearance_filter->appearance[i])) {
 
+			appearance_filter->hits[i]++;
 			control->filter_status.appearance.appearance =
 					&appearance_filter->appearance[i];
 
@@ -816,6 +1308,7 @@ static int scan_appearance_filter_add(uint16_t appearance)
 
 	/* Add appearance to the filter. */
 	appearance_filter[counter] = appearance;
+	bt_scan.scan_filters.appearance.hits[counter] = 0;
 	bt_scan.scan_filters.appearance.cnt++;
 
 	LOG_DBG("Added filter on appearance %x", appearance);
@@ -842,7 +1335,7 @@ static bool adv_manufacturer_data_cmp(const uint8_t *data,
 static bool adv_manufacturer_data_compare(const struct bt_data *data,
 					  struct bt_scan_control *control)
 {
-	const struct bt_scan_manufacturer_data_filter *md_filter =
+	struct bt_scan_manufacturer_data_filter *md_filter =
 		&bt_scan.scan_filters.manufacturer_data;
 	uint8_t counter = bt_scan.scan_filters.manufacturer_data.cnt;
 
@@ -853,6 +1346,7 @@ static bool adv_manufacturer_data_compare(const struct bt_data *data,
 				md_filter->manufacturer_data[i].data,
 				md_filter->manufacturer_data[i].data_len)) {
 
+			md_filter->hits[i]++;
 			control->filter_status.manufacturer_data.data =
 				md_filter->manufacturer_data[i].data;
 			control->filter_status.manufacturer_data.len =
@@ -917,6 +1411,7 @@ static int scan_manufacturer_data_filter_add(const struct bt_scan_manufacturer_d
 			manufacturer_data->data, manufacturer_data->data_len);
 	md_filter->manufacturer_data[counter].data_len =
 		manufacturer_data->data_len;
+	md_filter->hits[counter] = 0;
 
 	bt_scan.scan_filters.manufacturer_data.cnt++;
 
@@ -1011,14 +1506,17 @@ void bt_scan_filter_remove_all(void)
 	struct bt_scan_name_filter *name_filter =
 			&bt_scan.scan_filters.name;
 	name_filter->cnt = 0;
+	name_filter->trie_cnt = 0;
 
 	struct bt_scan_short_name_filter *short_name_filter =
 			&bt_scan.scan_filters.short_name;
 	short_name_filter->cnt = 0;
+	short_name_filter->trie_cnt = 0;
 
 	struct bt_scan_addr_filter *addr_filter =
 			&bt_scan.scan_filters.addr;
 	addr_filter->cnt = 0;
+	memset(addr_filter->hash, 0, sizeof(addr_filter->hash));
 
 	struct bt_scan_uuid_filter *uuid_filter =
 			&bt_scan.scan_filters.uuid;
@@ -1114,6 +1612,58 @@ int bt_scan_filter_get(struct bt_filter_status *status)
 	return 0;
 }
 
+int bt_scan_filter_hits_get(enum bt_scan_filter_type type, uint32_t *hits,
+			    size_t *count)
+{
+	struct bt_scan_filters *filters = &bt_scan.scan_filters;
+	const uint32_t *filter_hits;
+	uint8_t filter_cnt;
+
+	if (!hits || !count) {
+		return -EINVAL;
+	}
+
+	switch (type) {
+	case BT_SCAN_FILTER_TYPE_NAME:
+		filter_hits = filters->name.hits;
+		filter_cnt = filters->name.cnt;
+		break;
+
+	case BT_SCAN_FILTER_TYPE_SHORT_NAME:
+		filter_hits = filters->short_name.hits;
+		filter_cnt = filters->short_name.cnt;
+		break;
+
+	case BT_SCAN_FILTER_TYPE_ADDR:
+		filter_hits = filters->addr.hits;
+		filter_cnt = filters->addr.cnt;
+		break;
+
+	case BT_SCAN_FILTER_TYPE_UUID:
+		filter_hits = filters->uuid.hits;
+		filter_cnt = filters->uuid.cnt;
+		break;
+
+	case BT_SCAN_FILTER_TYPE_APPEARANCE:
+		filter_hits = filters->appearance.hits;
+		filter_cnt = filters->appearance.cnt;
+		break;
+
+	case BT_SCAN_FILTER_TYPE_MANUFACTURER_DATA:
+		filter_hits = filters->manufacturer_data.hits;
+		filter_cnt = filters->manufacturer_data.cnt;
+		break;
+
+	default:
+		return -EINVAL;
+	}
+
+	*count = MIN(*count, filter_cnt);
+	memcpy(hits, filter_hits, *count * sizeof(*hits));
+
+	return 0;
+}
+
 int bt_scan_stop(void)
 {
 	return bt_le_scan_stop();
@@ -1124,6 +1674,10 @@ void bt_scan_init(const struct bt_scan_init_param *init)
 	/* Disable all scanning filters. */
 	memset(&bt_scan.scan_filters, 0, sizeof(bt_scan.scan_filters));
 
+#if CONFIG_BT_SCAN_DUPLICATE_FILTER
+	dup_cache_init();
+#endif /* CONFIG_BT_SCAN_DUPLICATE_FILTER */
+
 	/* If the pointer to the initialization structure exist,
 	 * use it to scan the configuration.
 	 */
@@ -1160,37 +1714,42 @@ void bt_scan_update_init_conn_params(struct bt_le_conn_param *new_conn_param)
 static void check_enabled_filters(struct bt_scan_control *control)
 {
 	control->filter_cnt = 0;
+	control->filter_mode = 0;
 
 	if (is_addr_filter_enabled()) {
 		control->filter_cnt++;
+		control->filter_mode |= BT_SCAN_ADDR_FILTER;
 	}
 
 	if (is_name_filter_enabled()) {
 		control->filter_cnt++;
+		control->filter_mode |= BT_SCAN_NAME_FILTER;
 	}
 
 	if (is_short_name_filter_enabled()) {
 		control->filter_cnt++;
+		control->filter_mode |= BT_SCAN_SHORT_NAME_FILTER;
 	}
 
 	if (is_uuid_filter_enabled()) {
 		control->filter_cnt++;
+		control->filter_mode |= BT_SCAN_UUID_FILTER;
 	}
 
 	if (is_appearance_filter_enabled()) {
 		control->filter_cnt++;
+		control->filter_mode |= BT_SCAN_APPEARANCE_FILTER;
 	}
 
 	if (is_manufacturer_data_filter_enabled()) {
 		control->filter_cnt++;
+		control->filter_mode |= BT_SCAN_MANUFACTURER_DATA_FILTER;
 	}
 }
 
-static bool adv_data_found(struct bt_data *data, void *user_data)
+static void adv_data_found(const struct bt_data *data,
+			   struct bt_scan_control *scan_control)
 {
-	struct bt_scan_control *scan_control =
-			(struct bt_scan_control *)user_data;
-
 	switch (data->type) {
 	case BT_DATA_NAME_COMPLETE:
 		/* Check the name filter. */
@@ -1232,8 +1791,42 @@ static bool adv_data_found(struct bt_data *data, void *user_data)
 	default:
 		break;
 	}
+}
 
-	return true;
+/* Walks the advertising data once, passing to the filters only
+ * the data types that an enabled filter is interested in.
+ */
+static void adv_data_parse(const struct net_buf_simple *ad,
+			   struct bt_scan_control *control)
+{
+	const uint8_t *p = ad->data;
+	size_t len = ad->len;
+
+	while (len > 1) {
+		struct bt_data data;
+		uint8_t field_len = p[0];
+
+		/* Check for early termination. */
+		if (field_len == 0) {
+			return;
+		}
+
+		if (field_len > len - 1) {
+			LOG_WRN("Malformed advertising data");
+			return;
+		}
+
+		if (ad_type_filter[p[1]] & control->filter_mode) {
+			data.type = p[1];
+			data.data_len = field_len - 1;
+			data.data = &p[2];
+
+			adv_data_found(&data, control);
+		}
+
+		p += field_len + 1;
+		len -= field_len + 1;
+	}
 }
 
 static void filter_state_check(struct bt_scan_control *control,
@@ -1261,11 +1854,26 @@ static void filter_state_check(struct bt_scan_control *control,
 	}
 }
 
+static bool is_connectable(uint8_t adv_type)
+{
+	return (adv_type == BT_GAP_ADV_TYPE_ADV_IND) ||
+	       (adv_type == BT_GAP_ADV_TYPE_ADV_DIRECT_IND);
+}
+
 static void scan_device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
 			      struct net_buf_simple *ad)
 {
 	struct bt_scan_control scan_control;
-	struct net_buf_simple_state state;
+
+#if CONFIG_BT_SCAN_DUPLICATE_FILTER
+	/* When connecting automatically, connectable reports are never
+	 * suppressed, so that a failed connection attempt can be retried.
+	 */
+	if (!(bt_scan.connect_if_match && is_connectable(type)) &&
+	    dup_report_check(addr, rssi, type, ad)) {
+		return;
+	}
+#endif /* CONFIG_BT_SCAN_DUPLICATE_FILTER */
 
 	memset(&scan_control, 0, sizeof(scan_control));
 
@@ -1274,20 +1882,17 @@ static void scan_device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t typ
 	check_enabled_filters(&scan_control);
 
 	/* Check id device is connectable. */
-	if (type == BT_GAP_ADV_TYPE_ADV_IND ||
-	    type ==  BT_GAP_ADV_TYPE_ADV_DIRECT_IND) {
-		scan_control.connectable = true;
-	}
+	scan_control.connectable = is_connectable(type);
 
 	/* Check the address filter. */
 	check_addr(&scan_control, addr);
 
-	/* Save advertising buffer state to transfer it
-	 * data to application if futher processing is needed.
+	/* The advertising data is only read, so the buffer state
+	 * is left untouched for the application.
 	 */
-	net_buf_simple_save(ad, &state);
-	bt_data_parse(ad, adv_data_found, (void *)&scan_control);
-	net_buf_simple_restore(ad, &state);
+	if (scan_control.filter_mode & ~BT_SCAN_ADDR_FILTER) {
+		adv_data_parse(ad, &scan_control);
+	}
 
 	scan_control.device_info.addr = addr;
 	scan_control.device_info.conn_param = &bt_scan.conn_param;
@@ -1317,6 +1922,11 @@ int bt_scan_start(enum bt_scan_type scan_type)
 		return -EINVAL;
 	}
 
+#if CONFIG_BT_SCAN_DUPLICATE_FILTER
+	/* Report every device again, as the controller does. */
+	bt_scan_duplicate_cache_clear();
+#endif /* CONFIG_BT_SCAN_DUPLICATE_FILTER */
+
 	/* Start the scanning. */
 	int err = bt_le_scan_start(&bt_scan.scan_param, scan_device_found);
 
@@ -458,6 +458,15 @@ static void hids_input_report_ccc_changed(struct bt_gatt_attr const *attr,
 	struct bt_gatt_hids_inp_rep *inp_rep =
 	    CONTAINER_OF((struct _bt_gatt_ccc *)attr->user_data,
 			 struct bt_gatt_hids_inp_rep, ccc);
+	struct bt_gatt_hids_inp_rep_group *inp_rep_group =
+	    CONTAINER_OF(inp_rep - inp_rep->idx,
+			 struct bt_gatt_hids_inp_rep_group, reports);
+	struct bt_gatt_hids *hids_obj =
+	    CONTAINER_OF(inp_rep_group, struct bt_gatt_hids, inp_rep_group);
+
+	/* The value is the highest one set by any of the connected peers. */
+	atomic_set_bit_to(hids_obj->inp_rep_notif, inp_rep->idx,
+			  value == BT_GATT_CCC_NOTIFY);
 
 	if (value == BT_GATT_CCC_NOTIFY) {
 		LOG_DBG("Notification has been turned on");
@@ -1009,49 +1018,78 @@ static void store_input_report(struct bt_gatt_hids_inp_rep *hids_inp_rep,
 
 	const uint8_t *rep_mask = hids_inp_rep->rep_mask;
 
-	for (size_t i = 0; i < len; i++) {
-		if ((rep_mask[i / 8] & BIT(i % 8)) != 0) {
-			rep_data[i] = rep[i];
+	/* Every mask byte covers eight bytes of the report. Fully set and
+	 * fully cleared mask bytes are handled without bit tests.
+	 */
+	for (size_t i = 0; i < len; i += 8) {
+		uint8_t mask = rep_mask[i / 8];
+		size_t chunk = MIN(len - i, 8);
+
+		if (mask == UINT8_MAX) {
+			memcpy(&rep_data[i], &rep[i], chunk);
+			continue;
+		}
+
+		while (mask) {
+			size_t pos = find_lsb_set(mask) - 1;
+
+			if (pos >= chunk) {
+				break;
+			}
+
+			rep_data[i + pos] = rep[i + pos];
+			mask &= mask - 1;
 		}
 	}
 }
 
+struct inp_rep_store_params {
+	struct bt_gatt_hids_inp_rep *hids_inp_rep;
+	struct bt_gatt_attr *rep_attr;
+	uint8_t const *rep;
+	uint8_t len;
+	bool stored;
+};
+
+static void inp_rep_store(const struct bt_conn_ctx *ctx, void *user_data)
+{
+	struct inp_rep_store_params *params = user_data;
+	struct bt_gatt_hids_conn_data *conn_data = ctx->data;
+
+	if (!bt_gatt_is_subscribed(ctx->conn, params->rep_attr,
+				   BT_GATT_CCC_NOTIFY)) {
+		return;
+	}
+
+	store_input_report(params->hids_inp_rep,
+			   conn_data->inp_rep_ctx +
+			   params->hids_inp_rep->offset,
+			   params->rep, params->len);
+	params->stored = true;
+}
+
 static int inp_rep_notify_all(struct bt_gatt_hids *hids_obj,
 			      struct bt_gatt_hids_inp_rep *hids_inp_rep,
 			      uint8_t const *rep, uint8_t len,
 			      bt_gatt_complete_func_t cb)
 {
-	struct bt_gatt_hids_conn_data *conn_data;
-	uint8_t *rep_data = NULL;
 	struct bt_gatt_attr *rep_attr =
 		&hids_obj->gp.svc.attrs[hids_inp_rep->att_ind];
-
-	const size_t contexts =
-	    bt_conn_ctx_count(hids_obj->conn_ctx);
-
-	for (size_t i = 0; i < contexts; i++) {
-		const struct bt_conn_ctx *ctx =
-			bt_conn_ctx_get_by_id(hids_obj->conn_ctx, i);
-
-		if (ctx) {
-			bool notification_enabled = bt_gatt_is_subscribed(
-				ctx->conn, rep_attr, BT_GATT_CCC_NOTIFY);
-
-			if (notification_enabled) {
-				conn_data = ctx->data;
-				rep_data = conn_data->inp_rep_ctx +
-					   hids_inp_rep->offset;
-
-				store_input_report(hids_inp_rep, rep_data, rep,
-						   len);
-			}
-
-			bt_conn_ctx_release(hids_obj->conn_ctx,
-					    (void *)ctx->data);
-		}
+	struct inp_rep_store_params store_params = {
+		.hids_inp_rep = hids_inp_rep,
+		.rep_attr = rep_attr,
+		.rep = rep,
+		.len = len,
+	};
+
+	if (!atomic_test_bit(hids_obj->inp_rep_notif, hids_inp_rep->idx)) {
+		/* No peer has enabled notification of this report. */
+		return -ENODATA;
 	}
 
-	if (rep_data != NULL) {
+	bt_conn_ctx_foreach(hids_obj->conn_ctx, inp_rep_store, &store_params);
+
+	if (store_params.stored) {
 		struct bt_gatt_notify_params params = {0};
 
 		params.attr = rep_attr;
@@ -1114,6 +1152,127 @@ int bt_gatt_hids_inp_rep_send(struct bt_gatt_hids *hids_obj,
 	return err;
 }
 
+static void inp_rep_batch_store(struct bt_gatt_hids *hids_obj,
+				struct bt_conn *conn,
+				struct bt_gatt_hids_conn_data *conn_data,
+				const struct bt_gatt_hids_inp_rep_data *reps,
+				size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		struct bt_gatt_hids_inp_rep *hids_inp_rep =
+		    &hids_obj->inp_rep_group.reports[reps[i].rep_index];
+		struct bt_gatt_attr *rep_attr =
+		    &hids_obj->gp.svc.attrs[hids_inp_rep->att_ind];
+
+		if (!atomic_test_bit(hids_obj->inp_rep_notif,
+				     hids_inp_rep->idx) ||
+		    !bt_gatt_is_subscribed(conn, rep_attr,
+					   BT_GATT_CCC_NOTIFY)) {
+			continue;
+		}
+
+		store_input_report(hids_inp_rep,
+				   conn_data->inp_rep_ctx + hids_inp_rep->offset,
+				   reps[i].data, reps[i].len);
+	}
+}
+
+struct inp_rep_batch_store_params {
+	struct bt_gatt_hids *hids_obj;
+	const struct bt_gatt_hids_inp_rep_data *reps;
+	size_t count;
+};
+
+static void inp_rep_batch_store_ctx(const struct bt_conn_ctx *ctx,
+				    void *user_data)
+{
+	struct inp_rep_batch_store_params *params = user_data;
+
+	inp_rep_batch_store(params->hids_obj, ctx->conn, ctx->data,
+			    params->reps, params->count);
+}
+
+int bt_gatt_hids_inp_rep_batch_send(struct bt_gatt_hids *hids_obj,
+				    struct bt_conn *conn,
+				    const struct bt_gatt_hids_inp_rep_data *reps,
+				    size_t count, bt_gatt_complete_func_t cb,
+				    size_t *done)
+{
+	struct bt_gatt_hids_conn_data *conn_data;
+	int sent = 0;
+	int err = 0;
+	size_t i;
+
+	if (done) {
+		*done = 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		if ((reps[i].rep_index >= hids_obj->inp_rep_group.cnt) ||
+		    (hids_obj->inp_rep_group.reports[reps[i].rep_index].size !=
+		     reps[i].len)) {
+			return -EINVAL;
+		}
+	}
+
+	/* Update the stored reports with a single pass over the
+	 * connection contexts.
+	 */
+	if (conn) {
+		conn_data = bt_conn_ctx_get(hids_obj->conn_ctx, conn);
+		if (!conn_data) {
+			LOG_WRN("The context was not found");
+			return -EINVAL;
+		}
+
+		inp_rep_batch_store(hids_obj, conn, conn_data, reps, count);
+		bt_conn_ctx_release(hids_obj->conn_ctx, (void *)conn_data);
+	} else {
+		struct inp_rep_batch_store_params store_params = {
+			.hids_obj = hids_obj,
+			.reps = reps,
+			.count = count,
+		};
+
+		bt_conn_ctx_foreach(hids_obj->conn_ctx,
+				    inp_rep_batch_store_ctx, &store_params);
+	}
+
+	for (i = 0; i < count; i++) {
+		struct bt_gatt_hids_inp_rep *hids_inp_rep =
+		    &hids_obj->inp_rep_group.reports[reps[i].rep_index];
+		struct bt_gatt_attr *rep_attr =
+		    &hids_obj->gp.svc.attrs[hids_inp_rep->att_ind];
+
+		if (!atomic_test_bit(hids_obj->inp_rep_notif,
+				     hids_inp_rep->idx) ||
+		    (conn && !bt_gatt_is_subscribed(conn, rep_attr,
+						    BT_GATT_CCC_NOTIFY))) {
+			continue;
+		}
+
+		struct bt_gatt_notify_params params = {0};
+
+		params.attr = rep_attr;
+		params.data = reps[i].data;
+		params.len = hids_inp_rep->size;
+		params.func = cb;
+
+		err = bt_gatt_notify_cb(conn, &params);
+		if (err) {
+			break;
+		}
+
+		sent++;
+	}
+
+	if (done) {
+		*done = i;
+	}
+
+	return err ? err : sent;
+}
+
 static int boot_mouse_inp_report_notify_all(
 	struct bt_gatt_hids *hids_obj, const uint8_t *buttons,
 	struct bt_gatt_hids_boot_mouse_inp_rep *boot_mouse_inp_rep,
@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
  */
 
+#include <zephyr.h>
+#include <sys/ring_buffer.h>
 #include <bluetooth/conn.h>
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt.h>
@@ -67,6 +69,227 @@ int bt_gatt_nus_init(struct bt_gatt_nus_cb *callbacks)
 	return 0;
 }
 
+#if defined(CONFIG_BT_GATT_NUS_STREAM)
+
+/* Largest payload of a notification */
+#define STREAM_CHUNK_MAX (CONFIG_BT_L2CAP_TX_MTU - 3)
+
+static void stream_send_work_handler(struct k_work *work);
+
+RING_BUF_DECLARE(stream_tx_buf, CONFIG_BT_GATT_NUS_STREAM_BUF_SIZE);
+static K_WORK_DEFINE(stream_send_work, stream_send_work_handler);
+static struct k_spinlock stream_lock;
+static struct bt_conn *stream_conn;
+static atomic_t stream_in_flight;
+/* Incremented on every start and stop, so that notifications of a previous
+ * stream are not counted in the current one.
+ */
+static uint32_t stream_gen;
+
+static void stream_in_flight_dec(uint32_t gen)
+{
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&stream_lock);
+	if (gen == stream_gen) {
+		atomic_dec(&stream_in_flight);
+	}
+	k_spin_unlock(&stream_lock, key);
+}
+
+static void on_stream_sent(struct bt_conn *conn, void *user_data)
+{
+	stream_in_flight_dec(POINTER_TO_UINT(user_data));
+	k_work_submit(&stream_send_work);
+
+	on_sent(conn, NULL);
+}
+
+static int stream_notify(struct bt_conn *conn, uint32_t gen,
+			 const uint8_t *data, uint16_t len)
+{
+	struct bt_gatt_notify_params params = {0};
+	k_spinlock_key_t key;
+	int err;
+
+	params.attr = &nus_svc.attrs[2];
+	params.data = data;
+	params.len = len;
+	params.func = on_stream_sent;
+	params.user_data = UINT_TO_POINTER(gen);
+
+	key = k_spin_lock(&stream_lock);
+	if (gen != stream_gen) {
+		/* Stream was stopped while the data was being sent. */
+		k_spin_unlock(&stream_lock, key);
+		return -ENOTCONN;
+	}
+	atomic_inc(&stream_in_flight);
+	k_spin_unlock(&stream_lock, key);
+
+	/* Data is copied to the stack buffer before the call returns. */
+	err = bt_gatt_notify_cb(conn, &params);
+	if (err) {
+		stream_in_flight_dec(gen);
+	}
+
+	return err;
+}
+
+static void stream_send_work_handler(struct k_work *work)
+{
+	static uint8_t chunk_buf[STREAM_CHUNK_MAX];
+	struct bt_conn *conn;
+	k_spinlock_key_t key;
+	uint32_t chunk_max;
+	uint32_t queued;
+	uint32_t gen;
+	uint32_t len;
+	uint8_t *data;
+	bool claimed;
+	int err;
+
+	ARG_UNUSED(work);
+
+	key = k_spin_lock(&stream_lock);
+	conn = stream_conn ? bt_conn_ref(stream_conn) : NULL;
+	gen = stream_gen;
+	k_spin_unlock(&stream_lock, key);
+
+	if (!conn) {
+		return;
+	}
+
+	if (!bt_gatt_is_subscribed(conn, &nus_svc.attrs[2],
+				   BT_GATT_CCC_NOTIFY)) {
+		/* Peer has not enabled notifications: drop the data. */
+		key = k_spin_lock(&stream_lock);
+		ring_buf_reset(&stream_tx_buf);
+		k_spin_unlock(&stream_lock, key);
+		bt_conn_unref(conn);
+		return;
+	}
+
+	chunk_max = MIN(bt_gatt_nus_max_send(conn), STREAM_CHUNK_MAX);
+
+	while (atomic_get(&stream_in_flight) <
+	       CONFIG_BT_GATT_NUS_STREAM_TX_MAX) {
+		key = k_spin_lock(&stream_lock);
+		queued = ring_buf_capacity_get(&stream_tx_buf) -
+			 ring_buf_space_get(&stream_tx_buf);
+		k_spin_unlock(&stream_lock, key);
+
+		/* Send partially filled notifications only if the link is
+		 * idle. Otherwise, let more data be packed in.
+		 */
+		if ((queued == 0) ||
+		    ((queued < chunk_max) && atomic_get(&stream_in_flight))) {
+			break;
+		}
+
+		len = MIN(queued, chunk_max);
+
+		key = k_spin_lock(&stream_lock);
+		claimed = (ring_buf_get_claim(&stream_tx_buf, &data, len) == len);
+		if (!claimed) {
+			/* Data wraps around the end of the ring. */
+			ring_buf_get_finish(&stream_tx_buf, 0);
+			len = ring_buf_get(&stream_tx_buf, chunk_buf, len);
+			data = chunk_buf;
+		}
+		k_spin_unlock(&stream_lock, key);
+
+		/* Claimed data is not overwritten until it is released. */
+		err = stream_notify(conn, gen, data, len);
+
+		if (claimed) {
+			key = k_spin_lock(&stream_lock);
+			ring_buf_get_finish(&stream_tx_buf, len);
+			k_spin_unlock(&stream_lock, key);
+		}
+
+		if (err) {
+			LOG_WRN("Stream notification failed: %d", err);
+			break;
+		}
+	}
+
+	bt_conn_unref(conn);
+}
+
+int bt_gatt_nus_stream_start(struct bt_conn *conn)
+{
+	k_spinlock_key_t key;
+
+	if (!conn) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&stream_lock);
+
+	if (stream_conn) {
+		k_spin_unlock(&stream_lock, key);
+		return -EALREADY;
+	}
+
+	stream_conn = bt_conn_ref(conn);
+	ring_buf_reset(&stream_tx_buf);
+	atomic_set(&stream_in_flight, 0);
+	stream_gen++;
+
+	k_spin_unlock(&stream_lock, key);
+
+	return 0;
+}
+
+void bt_gatt_nus_stream_stop(void)
+{
+	struct bt_conn *conn;
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&stream_lock);
+	conn = stream_conn;
+	stream_conn = NULL;
+	ring_buf_reset(&stream_tx_buf);
+	atomic_set(&stream_in_flight, 0);
+	stream_gen++;
+	k_spin_unlock(&stream_lock, key);
+
+	if (conn) {
+		bt_conn_unref(conn);
+	}
+}
+
+uint32_t bt_gatt_nus_stream_write(const uint8_t *data, uint32_t len)
+{
+	k_spinlock_key_t key;
+	uint32_t written;
+
+	key = k_spin_lock(&stream_lock);
+	written = stream_conn ? ring_buf_put(&stream_tx_buf, data, len) : 0;
+	k_spin_unlock(&stream_lock, key);
+
+	if (written) {
+		k_work_submit(&stream_send_work);
+	}
+
+	return written;
+}
+
+uint32_t bt_gatt_nus_stream_space_get(void)
+{
+	k_spinlock_key_t key;
+	uint32_t space;
+
+	key = k_spin_lock(&stream_lock);
+	space = ring_buf_space_get(&stream_tx_buf);
+	k_spin_unlock(&stream_lock, key);
+
+	return space;
+}
+
+#endif /* CONFIG_BT_GATT_NUS_STREAM */
+
 int bt_gatt_nus_send(struct bt_conn *conn, const uint8_t *data, uint16_t len)
 {
 	struct bt_gatt_notify_params params = {0};
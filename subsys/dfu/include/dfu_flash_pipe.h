@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/** @file dfu_flash_pipe.h
+ *
+ * @defgroup dfu_flash_pipe DFU flash write pipeline
+ * @{
+ * @brief Page-aligned flash writes with background erase-ahead.
+ *
+ * Data is collected into a page-sized buffer and programmed one full page
+ * at a time. Pages ahead of the write position are made blank by a work
+ * item that runs when no data has been written for a while, so that the
+ * write path normally does not have to wait for a page erase. Pages that
+ * are already blank are not erased.
+ */
+
+#ifndef DFU_FLASH_PIPE_H__
+#define DFU_FLASH_PIPE_H__
+
+#include <stddef.h>
+#include <zephyr/types.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Flash operation counters. */
+struct dfu_flash_pipe_stats {
+	/** Number of pages programmed. */
+	uint32_t pages_programmed;
+	/** Number of pages erased by the background work item. */
+	uint32_t pages_erased;
+	/** Number of pages erased in the write path. */
+	uint32_t pages_erased_inline;
+	/** Number of pages found blank, which were not erased. */
+	uint32_t pages_skipped;
+};
+
+/**
+ * @brief Open a flash area for writing.
+ *
+ * @param[in] area_id Flash area to write to.
+ * @param[in] size    Number of bytes that will be written.
+ * @param[in] offset  Offset to continue writing at. It is rounded down to
+ *                    the page size.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If CONFIG_DFU_TARGET_MCUBOOT_PAGE_SIZE is not a multiple
+ *                 of the page size of the flash device.
+ * @return Other negative errno otherwise.
+ */
+int dfu_flash_pipe_open(uint8_t area_id, size_t size, size_t offset);
+
+/**
+ * @brief Write data at the current offset.
+ *
+ * Full pages are programmed before the function returns. The remaining data
+ * is kept until more data is written or @ref dfu_flash_pipe_flush is called.
+ *
+ * @param[in] buf Data to write.
+ * @param[in] len Length of the data.
+ *
+ * @retval 0 If successful.
+ * @retval -EFBIG If the data does not fit in the size given when opening.
+ * @return Other negative errno if the flash operation failed.
+ */
+int dfu_flash_pipe_write(const uint8_t *buf, size_t len);
+
+/**
+ * @brief Program the partially filled page, padded with the erased value.
+ *
+ * @retval 0 If successful, negative errno otherwise.
+ */
+int dfu_flash_pipe_flush(void);
+
+/**
+ * @brief Make the page at the given offset blank.
+ *
+ * Used for pages outside the written data, such as the MCUboot image
+ * trailer.
+ *
+ * @param[in] off Offset of the page in the flash area.
+ *
+ * @retval 0 If successful, negative errno otherwise.
+ */
+int dfu_flash_pipe_prepare(off_t off);
+
+/**
+ * @brief Get the number of bytes written, including buffered data.
+ *
+ * @return Offset of the next write.
+ */
+size_t dfu_flash_pipe_offset(void);
+
+/**
+ * @brief Get the number of bytes that have been programmed to flash.
+ *
+ * This is the offset that writing can resume at after a reset.
+ *
+ * @return Number of programmed bytes.
+ */
+size_t dfu_flash_pipe_programmed(void);
+
+/**
+ * @brief Close the flash area. Buffered data is discarded.
+ */
+void dfu_flash_pipe_close(void);
+
+/**
+ * @brief Get the flash operation counters since the flash area was opened.
+ *
+ * @param[out] stats Counters.
+ */
+void dfu_flash_pipe_stats_get(struct dfu_flash_pipe_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DFU_FLASH_PIPE_H__ */
+
+/**@} */
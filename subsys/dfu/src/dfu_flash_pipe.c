@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <drivers/flash.h>
+#include <storage/flash_map.h>
+#include <logging/log.h>
+
+#include "dfu_flash_pipe.h"
+
+LOG_MODULE_REGISTER(dfu_flash_pipe, CONFIG_DFU_TARGET_LOG_LEVEL);
+
+#define PAGE_SIZE CONFIG_DFU_TARGET_MCUBOOT_PAGE_SIZE
+#define READ_CHUNK_SIZE 256
+#define ERASE_DELAY K_MSEC(CONFIG_DFU_TARGET_MCUBOOT_ERASE_AHEAD_DELAY)
+
+BUILD_ASSERT(PAGE_SIZE % READ_CHUNK_SIZE == 0,
+	     "Page size must be a multiple of the read chunk size");
+
+static struct {
+	const struct flash_area *fa;
+	/* End of the area that will be written, page aligned. */
+	size_t end;
+	/* Pages below this offset have been programmed. */
+	size_t programmed;
+	/* Pages below this offset are programmed or blank. */
+	size_t erased;
+	size_t buf_len;
+	uint8_t buf[PAGE_SIZE];
+	struct dfu_flash_pipe_stats stats;
+} pipe;
+
+/* Protects the flash area and the offsets, which are shared with the
+ * erase-ahead work item.
+ */
+static K_MUTEX_DEFINE(lock);
+static struct k_delayed_work erase_work;
+static bool erase_work_initialized;
+
+static bool page_is_blank(off_t off)
+{
+	static uint32_t chunk[READ_CHUNK_SIZE / sizeof(uint32_t)];
+	uint32_t blank = 0x01010101U * flash_area_erased_val(pipe.fa);
+	int err;
+
+	for (size_t i = 0; i < PAGE_SIZE; i += READ_CHUNK_SIZE) {
+		err = flash_area_read(pipe.fa, off + i, chunk, sizeof(chunk));
+		if (err) {
+			LOG_ERR("Cannot read flash (err %d)", err);
+			return false;
+		}
+
+		for (size_t j = 0; j < ARRAY_SIZE(chunk); j++) {
+			if (chunk[j] != blank) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/* Make the page blank. Reading the page takes a fraction of the time an
+ * erase takes, so pages that are already blank are checked for first.
+ * Must be called with the lock held.
+ */
+static int page_prepare(off_t off, bool in_write_path)
+{
+	int err;
+
+	if (page_is_blank(off)) {
+		pipe.stats.pages_skipped++;
+		return 0;
+	}
+
+	err = flash_area_erase(pipe.fa, off, PAGE_SIZE);
+	if (err) {
+		LOG_ERR("Cannot erase page at 0x%x (err %d)", (uint32_t)off,
+			err);
+		return err;
+	}
+
+	if (in_write_path) {
+		pipe.stats.pages_erased_inline++;
+	} else {
+		pipe.stats.pages_erased++;
+	}
+
+	return 0;
+}
+
+static size_t erase_limit(void)
+{
+	return MIN(pipe.end, pipe.programmed +
+		   CONFIG_DFU_TARGET_MCUBOOT_ERASE_AHEAD_PAGES * PAGE_SIZE);
+}
+
+/* During a page erase the CPU stalls for tens of milliseconds. The work item
+ * is delayed by each write, so that pages are erased when the download is
+ * waiting for data, one page per run.
+ */
+static void erase_work_handler(struct k_work *work)
+{
+	bool more;
+	int err;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if (!pipe.fa || pipe.erased >= erase_limit()) {
+		k_mutex_unlock(&lock);
+		return;
+	}
+
+	err = page_prepare(pipe.erased, false);
+	if (err) {
+		/* Retried by the write path, which reports the error. */
+		k_mutex_unlock(&lock);
+		return;
+	}
+
+	pipe.erased += PAGE_SIZE;
+	more = pipe.erased < erase_limit();
+
+	k_mutex_unlock(&lock);
+
+	if (more) {
+		k_delayed_work_submit(&erase_work, K_NO_WAIT);
+	}
+}
+
+static int page_program(void)
+{
+	int err = 0;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if (pipe.erased <= pipe.programmed) {
+		/* The erase-ahead has not reached this page yet. */
+		err = page_prepare(pipe.programmed, true);
+		if (err) {
+			goto unlock;
+		}
+
+		pipe.erased = pipe.programmed + PAGE_SIZE;
+	}
+
+	err = flash_area_write(pipe.fa, pipe.programmed, pipe.buf, PAGE_SIZE);
+	if (err) {
+		LOG_ERR("Cannot write page at 0x%x (err %d)",
+			(uint32_t)pipe.programmed, err);
+		goto unlock;
+	}
+
+	pipe.programmed += PAGE_SIZE;
+	pipe.buf_len = 0;
+	pipe.stats.pages_programmed++;
+
+unlock:
+	k_mutex_unlock(&lock);
+
+	return err;
+}
+
+/* Pages are erased PAGE_SIZE bytes at a time, so it must be made of whole
+ * pages of the flash device.
+ */
+static int page_size_check(const struct flash_area *fa)
+{
+	struct flash_pages_info info;
+	struct device *dev;
+	int err;
+
+	dev = device_get_binding(fa->fa_dev_name);
+	if (!dev) {
+		LOG_ERR("Cannot get flash device %s", fa->fa_dev_name);
+		return -ENODEV;
+	}
+
+	err = flash_get_page_info_by_offs(dev, fa->fa_off, &info);
+	if (err) {
+		LOG_ERR("Cannot get flash page info (err %d)", err);
+		return err;
+	}
+
+	if (PAGE_SIZE % info.size) {
+		LOG_ERR("Page size %d is not a multiple of flash page size %zu",
+			PAGE_SIZE, info.size);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int dfu_flash_pipe_open(uint8_t area_id, size_t size, size_t offset)
+{
+	const struct flash_area *fa;
+	int err;
+
+	if (!erase_work_initialized) {
+		k_delayed_work_init(&erase_work, erase_work_handler);
+		erase_work_initialized = true;
+	}
+
+	dfu_flash_pipe_close();
+
+	err = flash_area_open(area_id, &fa);
+	if (err) {
+		LOG_ERR("Cannot open flash area %u (err %d)", area_id, err);
+		return err;
+	}
+
+	err = page_size_check(fa);
+	if (err) {
+		flash_area_close(fa);
+		return err;
+	}
+
+	size = ROUND_UP(size, PAGE_SIZE);
+	offset = ROUND_DOWN(offset, PAGE_SIZE);
+
+	if (size > fa->fa_size || offset > size) {
+		LOG_ERR("Write of %zu bytes at %zu outside area of %zu bytes",
+			size, offset, (size_t)fa->fa_size);
+		flash_area_close(fa);
+		return -EFBIG;
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+	pipe.fa = fa;
+	pipe.end = size;
+	pipe.programmed = offset;
+	pipe.erased = offset;
+	pipe.buf_len = 0;
+	memset(&pipe.stats, 0, sizeof(pipe.stats));
+	k_mutex_unlock(&lock);
+
+	k_delayed_work_submit(&erase_work, K_NO_WAIT);
+
+	return 0;
+}
+
+int dfu_flash_pipe_write(const uint8_t *buf, size_t len)
+{
+	size_t n;
+	int err;
+
+	if (!pipe.fa) {
+		return -EACCES;
+	}
+
+	if (len > pipe.end - dfu_flash_pipe_offset()) {
+		return -EFBIG;
+	}
+
+	while (len) {
+		n = MIN(len, PAGE_SIZE - pipe.buf_len);
+		memcpy(pipe.buf + pipe.buf_len, buf, n);
+		pipe.buf_len += n;
+		buf += n;
+		len -= n;
+
+		if (pipe.buf_len == PAGE_SIZE) {
+			err = page_program();
+			if (err) {
+				return err;
+			}
+		}
+	}
+
+	k_delayed_work_submit(&erase_work, ERASE_DELAY);
+
+	return 0;
+}
+
+int dfu_flash_pipe_flush(void)
+{
+	if (!pipe.fa) {
+		return -EACCES;
+	}
+
+	if (pipe.buf_len == 0) {
+		return 0;
+	}
+
+	memset(pipe.buf + pipe.buf_len, flash_area_erased_val(pipe.fa),
+	       PAGE_SIZE - pipe.buf_len);
+
+	return page_program();
+}
+
+int dfu_flash_pipe_prepare(off_t off)
+{
+	int err = 0;
+
+	if (!pipe.fa) {
+		return -EACCES;
+	}
+
+	if (off < 0 || off % PAGE_SIZE ||
+	    (size_t)off + PAGE_SIZE > pipe.fa->fa_size) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if ((size_t)off < pipe.programmed) {
+		err = -EINVAL;
+	} else if ((size_t)off >= pipe.erased) {
+		err = page_prepare(off, true);
+	}
+
+	k_mutex_unlock(&lock);
+
+	return err;
+}
+
+size_t dfu_flash_pipe_offset(void)
+{
+	return pipe.programmed + pipe.buf_len;
+}
+
+size_t dfu_flash_pipe_programmed(void)
+{
+	return pipe.programmed;
+}
+
+void dfu_flash_pipe_close(void)
+{
+	if (erase_work_initialized) {
+		(void)k_delayed_work_cancel(&erase_work);
+	}
+
+	/* Waits for an erase that is in progress. */
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if (pipe.fa) {
+		flash_area_close(pipe.fa);
+		pipe.fa = NULL;
+	}
+
+	pipe.end = 0;
+	pipe.programmed = 0;
+	pipe.erased = 0;
+	pipe.buf_len = 0;
+
+	k_mutex_unlock(&lock);
+}
+
+void dfu_flash_pipe_stats_get(struct dfu_flash_pipe_stats *stats)
+{
+	k_mutex_lock(&lock, K_FOREVER);
+	*stats = pipe.stats;
+	k_mutex_unlock(&lock);
+}
@@ -25,12 +25,16 @@
 #include <dfu/flash_img.h>
 #include <settings/settings.h>
 
+#include "dfu_flash_pipe.h"
+
 LOG_MODULE_REGISTER(dfu_target_mcuboot, CONFIG_DFU_TARGET_LOG_LEVEL);
 
 #define MAX_FILE_SEARCH_LEN 500
 #define MCUBOOT_HEADER_MAGIC 0x96f3b83d
 
 static struct flash_img_context flash_img;
+/* Write progress restored from settings. */
+static size_t stored_offset;
 
 int dfu_ctx_mcuboot_set_b1_file(const char *file, bool s0_active,
 				const char **update)
@@ -69,6 +73,16 @@ int dfu_ctx_mcuboot_set_b1_file(const char *file, bool s0_active,
 
 #define MODULE "dfu"
 #define FILE_FLASH_IMG "mcuboot/flash_img"
+
+static size_t bytes_written(void)
+{
+	if (IS_ENABLED(CONFIG_DFU_TARGET_MCUBOOT_ERASE_AHEAD)) {
+		return dfu_flash_pipe_offset();
+	}
+
+	return flash_img_bytes_written(&flash_img);
+}
+
 /**
  * @brief Store the information stored in the flash_img instance so that it can
  *	  be restored from flash in case of a power failure, reboot etc.
@@ -77,9 +91,15 @@ static int store_flash_img_context(void)
 {
 	if (IS_ENABLED(CONFIG_DFU_TARGET_MCUBOOT_SAVE_PROGRESS)) {
 		char key[] = MODULE "/" FILE_FLASH_IMG;
-		size_t bytes_written = flash_img_bytes_written(&flash_img);
-		int err = settings_save_one(key, &bytes_written,
-					    sizeof(bytes_written));
+		size_t progress = bytes_written();
+		int err;
+
+		if (IS_ENABLED(CONFIG_DFU_TARGET_MCUBOOT_ERASE_AHEAD)) {
+			/* Only data that is in flash survives a reset. */
+			progress = dfu_flash_pipe_programmed();
+		}
+
+		err = settings_save_one(key, &progress, sizeof(progress));
 
 		if (err) {
 			LOG_ERR("Problem storing offset (err %d)", err);
@@ -99,11 +119,10 @@ static int settings_set(const char *key, size_t len_rd,
 			settings_read_cb read_cb, void *cb_arg)
 {
 	if (!strcmp(key, FILE_FLASH_IMG)) {
-		size_t bytes_written = flash_img_bytes_written(&flash_img);
-		ssize_t len = read_cb(cb_arg, &bytes_written,
-				      sizeof(bytes_written));
+		ssize_t len = read_cb(cb_arg, &stored_offset,
+				      sizeof(stored_offset));
 
-		if (len != sizeof(bytes_written)) {
+		if (len != sizeof(stored_offset)) {
 			LOG_ERR("Can't read flash_img from storage");
 			return len;
 		}
@@ -121,11 +140,14 @@ bool dfu_target_mcuboot_identify(const void *const buf)
 int dfu_target_mcuboot_init(size_t file_size, dfu_target_callback_t cb)
 {
 	ARG_UNUSED(cb);
-	int err = flash_img_init(&flash_img);
+	int err;
 
-	if (err != 0) {
-		LOG_ERR("flash_img_init error %d", err);
-		return err;
+	if (!IS_ENABLED(CONFIG_DFU_TARGET_MCUBOOT_ERASE_AHEAD)) {
+		err = flash_img_init(&flash_img);
+		if (err != 0) {
+			LOG_ERR("flash_img_init error %d", err);
+			return err;
+		}
 	}
 
 	if (file_size > PM_MCUBOOT_SECONDARY_SIZE) {
@@ -160,22 +182,41 @@ int dfu_target_mcuboot_init(size_t file_size, dfu_target_callback_t cb)
 		}
 	}
 
+	if (IS_ENABLED(CONFIG_DFU_TARGET_MCUBOOT_ERASE_AHEAD)) {
+		err = dfu_flash_pipe_open(PM_MCUBOOT_SECONDARY_ID, file_size,
+					  stored_offset);
+		if (err != 0) {
+			LOG_ERR("dfu_flash_pipe_open error %d", err);
+			return err;
+		}
+	}
+
 	return 0;
 }
 
 int dfu_target_mcuboot_offset_get(size_t *out)
 {
-	*out = flash_img_bytes_written(&flash_img);
+	*out = bytes_written();
 	return 0;
 }
 
 int dfu_target_mcuboot_write(const void *const buf, size_t len)
 {
-	int err = flash_img_buffered_write(&flash_img, (uint8_t *)buf, len, false);
+	int err;
 
-	if (err != 0) {
-		LOG_ERR("flash_img_buffered_write error %d", err);
-		return err;
+	if (IS_ENABLED(CONFIG_DFU_TARGET_MCUBOOT_ERASE_AHEAD)) {
+		err = dfu_flash_pipe_write(buf, len);
+		if (err != 0) {
+			LOG_ERR("dfu_flash_pipe_write error %d", err);
+			return err;
+		}
+	} else {
+		err = flash_img_buffered_write(&flash_img, (uint8_t *)buf, len,
+					       false);
+		if (err != 0) {
+			LOG_ERR("flash_img_buffered_write error %d", err);
+			return err;
+		}
 	}
 
 	err = store_flash_img_context();
@@ -191,26 +232,64 @@ int dfu_target_mcuboot_write(const void *const buf, size_t len)
 
 static void reset_flash_context(void)
 {
-	/* Need to set bytes_written to 0 */
-	int err = flash_img_init(&flash_img);
+	int err;
+
+	stored_offset = 0;
 
-	if (err) {
-		LOG_ERR("Unable to re-initialize flash_img");
+	if (IS_ENABLED(CONFIG_DFU_TARGET_MCUBOOT_ERASE_AHEAD)) {
+		dfu_flash_pipe_close();
+	} else {
+		/* Need to set bytes_written to 0 */
+		err = flash_img_init(&flash_img);
+		if (err) {
+			LOG_ERR("Unable to re-initialize flash_img");
+		}
 	}
+
 	err = store_flash_img_context();
 	if (err != 0) {
 		LOG_ERR("Unable to reset write progress: %d", err);
 	}
 }
 
+static int flush(void)
+{
+	int err;
+
+	if (!IS_ENABLED(CONFIG_DFU_TARGET_MCUBOOT_ERASE_AHEAD)) {
+		err = flash_img_buffered_write(&flash_img, NULL, 0, true);
+		if (err != 0) {
+			LOG_ERR("flash_img_buffered_write error %d", err);
+		}
+
+		return err;
+	}
+
+	err = dfu_flash_pipe_flush();
+	if (err != 0) {
+		LOG_ERR("dfu_flash_pipe_flush error %d", err);
+		return err;
+	}
+
+	/* The last page holds the image trailer written by
+	 * boot_request_upgrade().
+	 */
+	err = dfu_flash_pipe_prepare(PM_MCUBOOT_SECONDARY_SIZE -
+				     CONFIG_DFU_TARGET_MCUBOOT_PAGE_SIZE);
+	if (err != 0) {
+		LOG_ERR("Cannot erase image trailer (err %d)", err);
+	}
+
+	return err;
+}
+
 int dfu_target_mcuboot_done(bool successful)
 {
 	int err = 0;
 
 	if (successful) {
-		err = flash_img_buffered_write(&flash_img, NULL, 0, true);
+		err = flush();
 		if (err != 0) {
-			LOG_ERR("flash_img_buffered_write error %d", err);
 			reset_flash_context();
 			return err;
 		}
@@ -27,6 +27,13 @@
 /* Minimum retransmit time */
 #define RETRANSMIT_DELAY_MIN 435
 
+/* Radio ramp-up time. Burst mode uses the fast ramp-up. */
+#ifdef CONFIG_ESB_TX_BURST
+#define RADIO_RAMP_UP_TIME_US 40
+#else
+#define RADIO_RAMP_UP_TIME_US 130
+#endif
+
 /* Interrupt flags */
 /* Interrupt mask value for TX success. */
 #define INT_TX_SUCCESS_MSK 0x01
@@ -137,8 +144,22 @@ struct payload_rx_fifo {
 	uint32_t back;	/* Back of the queue (last in). */
 	uint32_t front;	/* Front of queue (first out). */
 	uint32_t count;	/* Number of elements in the queue. */
+	bool claimed;	/* Front of the queue lent to the application. */
 };
 
+/* The radio writes received packets directly into the RX FIFO. The S0 or
+ * length field and the S1 field are written to the two bytes in front of the
+ * data field, which hold the noack and pid fields. These fields are filled in
+ * when the packet is pushed to the FIFO.
+ */
+#define RX_HEADER_SIZE 2
+
+BUILD_ASSERT(offsetof(struct esb_payload, noack) + 1 ==
+	     offsetof(struct esb_payload, pid) &&
+	     offsetof(struct esb_payload, pid) + 1 ==
+	     offsetof(struct esb_payload, data),
+	     "Radio header does not fit in front of the payload data");
+
 /* Enhanced ShockBurst address.
  *
  * Enhanced ShockBurst addresses consist of a base address and a prefix
@@ -182,7 +203,19 @@ static struct esb_payload *current_payload;
 static struct payload_tx_fifo tx_fifo;
 static struct payload_rx_fifo rx_fifo;
 static uint8_t tx_payload_buffer[CONFIG_ESB_MAX_PAYLOAD_LENGTH + 2];
+/* Buffer that the radio transmits the current payload from. */
+static uint8_t *tx_buf = tx_payload_buffer;
+#ifdef CONFIG_ESB_TX_BURST
+/* Buffer for the next payload of a burst. */
+static uint8_t tx_burst_buffer[CONFIG_ESB_MAX_PAYLOAD_LENGTH + 2];
+static uint8_t *tx_next_buf = tx_burst_buffer;
+/* Payload prepared in tx_next_buf, or NULL. */
+static struct esb_payload *tx_next_payload;
+#endif
+/* Used by the radio when the RX FIFO is full. */
 static uint8_t rx_payload_buffer[CONFIG_ESB_MAX_PAYLOAD_LENGTH + 2];
+/* Buffer that the radio receives the next packet in. */
+static uint8_t *rx_buf = rx_payload_buffer;
 
 /* Run time variables */
 static uint8_t pids[CONFIG_ESB_PIPE_COUNT];
@@ -432,11 +465,21 @@ static bool update_radio_crc(void)
 	return true;
 }
 
+static void update_radio_ramp_up(void)
+{
+#ifdef CONFIG_ESB_TX_BURST
+	NRF_RADIO->MODECNF0 =
+		(NRF_RADIO->MODECNF0 & ~RADIO_MODECNF0_RU_Msk) |
+		RADIO_MODECNF0_RU_Fast << RADIO_MODECNF0_RU_Pos;
+#endif
+}
+
 static bool update_radio_parameters(void)
 {
 	bool params_valid = true;
 
 	update_radio_tx_power();
+	update_radio_ramp_up();
 	params_valid &= update_radio_bitrate();
 	params_valid &= update_radio_protocol();
 	params_valid &= update_radio_crc();
@@ -447,6 +490,87 @@ static bool update_radio_parameters(void)
 	return params_valid;
 }
 
+/*  Write the radio header and the data of a payload to a TX buffer. */
+static void tx_buf_fill(uint8_t *buf, const struct esb_payload *payload)
+{
+	if (esb_cfg.protocol == ESB_PROTOCOL_ESB) {
+		buf[0] = payload->pid;
+		buf[1] = 0;
+	} else {
+		buf[0] = payload->length;
+		buf[1] = payload->pid << 1;
+		buf[1] |= payload->noack ? 0x00 : 0x01;
+	}
+
+	memcpy(&buf[2], payload->data, payload->length);
+}
+
+/*  Prepare the payload that follows the current one in the TX FIFO, so that
+ *  it can be sent as soon as the current one is acknowledged.
+ */
+static void tx_burst_prepare(void)
+{
+#ifdef CONFIG_ESB_TX_BURST
+	uint32_t next = tx_fifo.front + 1;
+
+	if (tx_fifo.count < 2 || esb_cfg.tx_mode == ESB_TXMODE_MANUAL) {
+		return;
+	}
+
+	if (next >= CONFIG_ESB_TX_FIFO_SIZE) {
+		next = 0;
+	}
+
+	tx_buf_fill(tx_next_buf, tx_fifo.payload[next]);
+	tx_next_payload = tx_fifo.payload[next];
+#endif
+}
+
+/*  Check if tx_burst_prepare() prepared the payload at the front of the TX
+ *  FIFO.
+ */
+static bool tx_burst_ready(void)
+{
+#ifdef CONFIG_ESB_TX_BURST
+	return tx_next_payload != NULL && tx_fifo.count > 0 &&
+	       tx_next_payload == tx_fifo.payload[tx_fifo.front];
+#else
+	return false;
+#endif
+}
+
+/*  Use the buffer prepared by tx_burst_prepare() for the payload at the front
+ *  of the TX FIFO.
+ *
+ *  @retval true   The buffer was prepared and is now the current one.
+ *  @retval false  The payload must be written to the current buffer.
+ */
+static bool tx_burst_take(void)
+{
+#ifdef CONFIG_ESB_TX_BURST
+	uint8_t *buf = tx_buf;
+
+	if (!tx_burst_ready()) {
+		return false;
+	}
+
+	tx_buf = tx_next_buf;
+	tx_next_buf = buf;
+	tx_next_payload = NULL;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+static void tx_burst_cancel(void)
+{
+#ifdef CONFIG_ESB_TX_BURST
+	tx_next_payload = NULL;
+#endif
+}
+
 static void reset_fifos(void)
 {
 	tx_fifo.back = 0;
@@ -456,6 +580,11 @@ static void reset_fifos(void)
 	rx_fifo.back = 0;
 	rx_fifo.front = 0;
 	rx_fifo.count = 0;
+	rx_fifo.claimed = false;
+
+	rx_buf = rx_payload_buffer;
+
+	tx_burst_cancel();
 }
 
 static void initialize_fifos(void)
@@ -490,11 +619,37 @@ static void tx_fifo_remove_last(void)
 	irq_unlock(key);
 }
 
-/*  Function to push the content of the rx_buffer to the RX FIFO.
+static uint8_t *rx_fifo_buf(struct esb_payload *payload)
+{
+	return (uint8_t *)payload + offsetof(struct esb_payload, data) -
+	       RX_HEADER_SIZE;
+}
+
+/*  Select the buffer for the next received packet.
  *
- *  The module will point the register NRF_RADIO->PACKETPTR to a buffer for
- *  receiving packets. After receiving a packet the module will call this
- *  function to copy the received data to the RX FIFO.
+ *  The radio receives into the back of the RX FIFO, so that received packets
+ *  are not copied. When the RX FIFO is full, the packet is received in
+ *  rx_payload_buffer and dropped.
+ *
+ *  @return Buffer to point the register NRF_RADIO->PACKETPTR to.
+ */
+static uint8_t *rx_buf_select(void)
+{
+	if (rx_fifo.count < CONFIG_ESB_RX_FIFO_SIZE) {
+		rx_buf = rx_fifo_buf(rx_fifo.payload[rx_fifo.back]);
+	} else {
+		rx_buf = rx_payload_buffer;
+	}
+
+	return rx_buf;
+}
+
+/*  Function to push the packet received by the radio to the RX FIFO.
+ *
+ *  The module will point the register NRF_RADIO->PACKETPTR to the back of the
+ *  RX FIFO for receiving packets, see rx_buf_select(). After receiving a
+ *  packet the module will call this function to fill in the other fields of
+ *  the payload and add it to the RX FIFO.
  *
  *  @param  pipe Pipe number to set for the packet.
  *  @param  pid  Packet ID.
@@ -504,29 +659,32 @@ static void tx_fifo_remove_last(void)
  */
 static bool rx_fifo_push_rfbuf(uint8_t pipe, uint8_t pid)
 {
-	if (rx_fifo.count >= CONFIG_ESB_RX_FIFO_SIZE) {
+	struct esb_payload *payload = rx_fifo.payload[rx_fifo.back];
+	uint8_t length = rx_buf[0];
+	uint8_t s1 = rx_buf[1];
+
+	if (rx_fifo.count >= CONFIG_ESB_RX_FIFO_SIZE ||
+	    rx_buf != rx_fifo_buf(payload)) {
+		/* The packet was received in rx_payload_buffer. */
 		return false;
 	}
 
 	if (esb_cfg.protocol == ESB_PROTOCOL_ESB_DPL) {
-		if (rx_payload_buffer[0] > CONFIG_ESB_MAX_PAYLOAD_LENGTH) {
+		if (length > CONFIG_ESB_MAX_PAYLOAD_LENGTH) {
 			return false;
 		}
-		rx_fifo.payload[rx_fifo.back]->length = rx_payload_buffer[0];
+		payload->length = length;
 	} else if (esb_cfg.mode == ESB_MODE_PTX) {
 		/* Received packet is an acknowledgment */
-		rx_fifo.payload[rx_fifo.back]->length = 0;
+		payload->length = 0;
 	} else {
-		rx_fifo.payload[rx_fifo.back]->length = esb_cfg.payload_length;
+		payload->length = esb_cfg.payload_length;
 	}
 
-	memcpy(rx_fifo.payload[rx_fifo.back]->data, &rx_payload_buffer[2],
-	       rx_fifo.payload[rx_fifo.back]->length);
-
-	rx_fifo.payload[rx_fifo.back]->pipe = pipe;
-	rx_fifo.payload[rx_fifo.back]->rssi = NRF_RADIO->RSSISAMPLE;
-	rx_fifo.payload[rx_fifo.back]->pid = pid;
-	rx_fifo.payload[rx_fifo.back]->noack = !(rx_payload_buffer[1] & 0x01);
+	payload->pipe = pipe;
+	payload->rssi = NRF_RADIO->RSSISAMPLE;
+	payload->pid = pid;
+	payload->noack = !(s1 & 0x01);
 
 	if (++rx_fifo.back >= CONFIG_ESB_RX_FIFO_SIZE) {
 		rx_fifo.back = 0;
@@ -576,14 +734,22 @@ static void start_tx_transaction(void)
 	/* Prepare the payload */
 	current_payload = tx_fifo.payload[tx_fifo.front];
 
-	switch (esb_cfg.protocol) {
-	case ESB_PROTOCOL_ESB:
+	if (!tx_burst_take()) {
+		tx_burst_cancel();
+		tx_buf_fill(tx_buf, current_payload);
+	}
+
+	if (esb_cfg.protocol == ESB_PROTOCOL_ESB) {
 		update_rf_payload_format(current_payload->length);
-		tx_payload_buffer[0] = current_payload->pid;
-		tx_payload_buffer[1] = 0;
-		memcpy(&tx_payload_buffer[2], current_payload->data,
-		       current_payload->length);
+		ack = true;
+	} else {
+		ack = !current_payload->noack || !esb_cfg.selective_auto_ack;
+	}
 
+	/* Handling ack if noack is set to false or if selective auto ack is
+	 * turned off
+	 */
+	if (ack) {
 		NRF_RADIO->SHORTS = radio_shorts_common |
 				    RADIO_SHORTS_DISABLED_RXEN_Msk;
 		NRF_RADIO->INTENSET = RADIO_INTENSET_DISABLED_Msk |
@@ -593,47 +759,18 @@ static void start_tx_transaction(void)
 		retransmits_remaining = esb_cfg.retransmit_count;
 		on_radio_disabled = on_radio_disabled_tx;
 		esb_state = ESB_STATE_PTX_TX_ACK;
-		break;
-
-	case ESB_PROTOCOL_ESB_DPL:
-		ack = !current_payload->noack || !esb_cfg.selective_auto_ack;
-		tx_payload_buffer[0] = current_payload->length;
-		tx_payload_buffer[1] = current_payload->pid << 1;
-		tx_payload_buffer[1] |= current_payload->noack ? 0x00 : 0x01;
-		memcpy(&tx_payload_buffer[2], current_payload->data,
-		       current_payload->length);
-
-		/* Handling ack if noack is set to false or if
-		 * selective auto ack is turned off
-		 */
-		if (ack) {
-			NRF_RADIO->SHORTS = radio_shorts_common |
-					    RADIO_SHORTS_DISABLED_RXEN_Msk;
-			NRF_RADIO->INTENSET = RADIO_INTENSET_DISABLED_Msk |
-					      RADIO_INTENSET_READY_Msk;
-
-			/* Configure the retransmit counter */
-			retransmits_remaining = esb_cfg.retransmit_count;
-			on_radio_disabled = on_radio_disabled_tx;
-			esb_state = ESB_STATE_PTX_TX_ACK;
-		} else {
-			NRF_RADIO->SHORTS = radio_shorts_common;
-			NRF_RADIO->INTENSET = RADIO_INTENSET_DISABLED_Msk;
-			on_radio_disabled = on_radio_disabled_tx_noack;
-			esb_state = ESB_STATE_PTX_TX;
-		}
-		break;
-
-	default:
-		/* Should not be reached */
-		break;
+	} else {
+		NRF_RADIO->SHORTS = radio_shorts_common;
+		NRF_RADIO->INTENSET = RADIO_INTENSET_DISABLED_Msk;
+		on_radio_disabled = on_radio_disabled_tx_noack;
+		esb_state = ESB_STATE_PTX_TX;
 	}
 
 	NRF_RADIO->TXADDRESS = current_payload->pipe;
 	NRF_RADIO->RXADDRESSES = 1 << current_payload->pipe;
 	NRF_RADIO->FREQUENCY = esb_addr.rf_channel;
 
-	NRF_RADIO->PACKETPTR = (uint32_t)tx_payload_buffer;
+	NRF_RADIO->PACKETPTR = (uint32_t)tx_buf;
 
 	NVIC_ClearPendingIRQ(RADIO_IRQn);
 	irq_enable(RADIO_IRQn);
@@ -671,7 +808,7 @@ static void on_radio_disabled_tx(void)
 	 * received by the time defined in wait_for_ack_timeout_us
 	 */
 	ESB_SYS_TIMER->CC[0] = wait_for_ack_timeout_us;
-	ESB_SYS_TIMER->CC[1] = esb_cfg.retransmit_delay - 130;
+	ESB_SYS_TIMER->CC[1] = esb_cfg.retransmit_delay - RADIO_RAMP_UP_TIME_US;
 	ESB_SYS_TIMER->TASKS_CLEAR = 1;
 	ESB_SYS_TIMER->EVENTS_COMPARE[0] = 0;
 	ESB_SYS_TIMER->EVENTS_COMPARE[1] = 0;
@@ -688,13 +825,19 @@ static void on_radio_disabled_tx(void)
 		update_rf_payload_format(0);
 	}
 
-	NRF_RADIO->PACKETPTR = (uint32_t)rx_payload_buffer;
+	NRF_RADIO->PACKETPTR = (uint32_t)rx_buf_select();
 	on_radio_disabled = on_radio_disabled_tx_wait_for_ack;
 	esb_state = ESB_STATE_PTX_RX_ACK;
+
+	/* Use the time until the acknowledgment to prepare the next payload. */
+	tx_burst_prepare();
 }
 
 static void on_radio_disabled_tx_wait_for_ack(void)
 {
+	uint8_t pipe;
+	bool burst;
+
 	/* This marks the completion of a TX_RX sequence (TX with ACK) */
 
 	/* Make sure the timer will not deactivate the radio if a packet is
@@ -713,18 +856,29 @@ static void on_radio_disabled_tx_wait_for_ack(void)
 				   retransmits_remaining + 1;
 
 		tx_fifo_remove_last();
+		pipe = (uint8_t)NRF_RADIO->TXADDRESS;
+
+		/* In burst mode, the next payload is ready to be sent. Start
+		 * the radio before handling the payload of the
+		 * acknowledgment, which stays in rx_buf until the radio
+		 * receives the next acknowledgment.
+		 */
+		burst = tx_burst_ready();
+		if (burst) {
+			start_tx_transaction();
+		}
 
-		if (esb_cfg.protocol != ESB_PROTOCOL_ESB &&
-		    rx_payload_buffer[0] > 0) {
-			if (rx_fifo_push_rfbuf((uint8_t)NRF_RADIO->TXADDRESS,
-					       rx_payload_buffer[1] >> 1)) {
+		if (esb_cfg.protocol != ESB_PROTOCOL_ESB && rx_buf[0] > 0) {
+			if (rx_fifo_push_rfbuf(pipe, rx_buf[1] >> 1)) {
 				interrupt_flags |=
 					INT_RX_DATA_RECEIVED_MSK;
 			}
 		}
 
-		if ((tx_fifo.count == 0) ||
-		    (esb_cfg.tx_mode == ESB_TXMODE_MANUAL)) {
+		if (burst) {
+			NVIC_SetPendingIRQ(ESB_EVT_IRQ);
+		} else if ((tx_fifo.count == 0) ||
+			   (esb_cfg.tx_mode == ESB_TXMODE_MANUAL)) {
 			esb_state = ESB_STATE_IDLE;
 			NVIC_SetPendingIRQ(ESB_EVT_IRQ);
 		} else {
@@ -751,7 +905,7 @@ static void on_radio_disabled_tx_wait_for_ack(void)
 			NRF_RADIO->SHORTS = radio_shorts_common |
 					    RADIO_SHORTS_DISABLED_RXEN_Msk;
 			update_rf_payload_format(current_payload->length);
-			NRF_RADIO->PACKETPTR = (uint32_t)tx_payload_buffer;
+			NRF_RADIO->PACKETPTR = (uint32_t)tx_buf;
 			on_radio_disabled = on_radio_disabled_tx;
 			esb_state = ESB_STATE_PTX_TX_ACK;
 			ESB_SYS_TIMER->TASKS_START = 1;
@@ -767,7 +921,7 @@ static void clear_events_restart_rx(void)
 {
 	NRF_RADIO->SHORTS = radio_shorts_common;
 	update_rf_payload_format(esb_cfg.payload_length);
-	NRF_RADIO->PACKETPTR = (uint32_t)rx_payload_buffer;
+	NRF_RADIO->PACKETPTR = (uint32_t)rx_buf_select();
 	NRF_RADIO->EVENTS_DISABLED = 0;
 	NRF_RADIO->TASKS_DISABLE = 1;
 
@@ -783,7 +937,7 @@ static void clear_events_restart_rx(void)
 }
 
 static void on_radio_disabled_rx_dpl(bool retransmit_payload,
-				     struct pipe_info *pipe_info)
+				     struct pipe_info *pipe_info, uint8_t s1)
 {
 	if (tx_fifo.count > 0 &&
 	    (tx_fifo.payload[tx_fifo.front]->pipe == NRF_RADIO->RXMATCH)) {
@@ -818,7 +972,7 @@ static void on_radio_disabled_rx_dpl(bool retransmit_payload,
 		tx_payload_buffer[0] = 0;
 	}
 
-	tx_payload_buffer[1] = rx_payload_buffer[1];
+	tx_payload_buffer[1] = s1;
 }
 
 static void on_radio_disabled_rx(void)
@@ -826,41 +980,60 @@ static void on_radio_disabled_rx(void)
 	bool retransmit_payload = false;
 	bool send_rx_event = true;
 	struct pipe_info *pipe_info;
+	uint8_t s0;
+	uint8_t s1;
 
 	if (NRF_RADIO->CRCSTATUS == 0) {
 		clear_events_restart_rx();
 		return;
 	}
 
-	if (rx_fifo.count >= CONFIG_ESB_RX_FIFO_SIZE) {
+	if (rx_buf == rx_payload_buffer) {
+		/* The RX FIFO was full when the packet was received. */
 		clear_events_restart_rx();
 		return;
 	}
 
+	/* Pushing the packet to the RX FIFO overwrites the header. */
+	s0 = rx_buf[0];
+	s1 = rx_buf[1];
+
 	pipe_info = &rx_pipe_info[NRF_RADIO->RXMATCH];
 	if (NRF_RADIO->RXCRC == pipe_info->crc &&
-	    (rx_payload_buffer[1] >> 1) == pipe_info->pid) {
+	    (s1 >> 1) == pipe_info->pid) {
 		retransmit_payload = true;
 		send_rx_event = false;
 	}
 
-	pipe_info->pid = rx_payload_buffer[1] >> 1;
+	pipe_info->pid = s1 >> 1;
 	pipe_info->crc = NRF_RADIO->RXCRC;
 
+	if (send_rx_event) {
+		/* Push the new packet to the RX buffer and trigger a received
+		 * event if the operation was successful. This is done before
+		 * the radio is started again, as it receives the next packet
+		 * at the back of the RX FIFO.
+		 */
+		if (rx_fifo_push_rfbuf(NRF_RADIO->RXMATCH, pipe_info->pid)) {
+			interrupt_flags |= INT_RX_DATA_RECEIVED_MSK;
+			NVIC_SetPendingIRQ(ESB_EVT_IRQ);
+		}
+	}
+
 	/* Check if an ack should be sent */
-	if ((esb_cfg.selective_auto_ack == false) ||
-	    ((rx_payload_buffer[1] & 0x01) == 1)) {
+	if ((esb_cfg.selective_auto_ack == false) || ((s1 & 0x01) == 1)) {
 		NRF_RADIO->SHORTS = radio_shorts_common |
 				    RADIO_SHORTS_DISABLED_RXEN_Msk;
 
 		switch (esb_cfg.protocol) {
 		case ESB_PROTOCOL_ESB_DPL:
-			on_radio_disabled_rx_dpl(retransmit_payload, pipe_info);
+			on_radio_disabled_rx_dpl(retransmit_payload, pipe_info,
+						 s1);
 			break;
 
 		case ESB_PROTOCOL_ESB:
 			update_rf_payload_format(0);
-			tx_payload_buffer[0] = rx_payload_buffer[0];
+			tx_payload_buffer[0] = s0;
 			tx_payload_buffer[1] = 0;
 			break;
 		}
@@ -873,17 +1046,6 @@ static void on_radio_disabled_rx(void)
 	} else {
 		clear_events_restart_rx();
 	}
-
-	if (send_rx_event) {
-		/* Push the new packet to the RX buffer and trigger a received
-		 * event if the operation was
-		 * successful.
-		 */
-		if (rx_fifo_push_rfbuf(NRF_RADIO->RXMATCH, pipe_info->pid)) {
-			interrupt_flags |= INT_RX_DATA_RECEIVED_MSK;
-			NVIC_SetPendingIRQ(ESB_EVT_IRQ);
-		}
-	}
 }
 
 static void on_radio_disabled_rx_ack(void)
@@ -892,7 +1054,7 @@ static void on_radio_disabled_rx_ack(void)
 			    RADIO_SHORTS_DISABLED_TXEN_Msk;
 	update_rf_payload_format(esb_cfg.payload_length);
 
-	NRF_RADIO->PACKETPTR = (uint32_t)rx_payload_buffer;
+	NRF_RADIO->PACKETPTR = (uint32_t)rx_buf_select();
 	on_radio_disabled = on_radio_disabled_rx;
 
 	esb_state = ESB_STATE_PRX;
@@ -1195,25 +1357,83 @@ int esb_read_rx_payload(struct esb_payload *payload)
 		return -EINVAL;
 	}
 
+	uint32_t key = irq_lock();
+
+	if (rx_fifo.claimed) {
+		irq_unlock(key);
+		return -EBUSY;
+	}
 	if (rx_fifo.count == 0) {
+		irq_unlock(key);
 		return -ENODATA;
 	}
 
+	const struct esb_payload *front = rx_fifo.payload[rx_fifo.front];
+
+	memcpy(payload, front, offsetof(struct esb_payload, data) +
+	       front->length);
+
+	if (++rx_fifo.front >= CONFIG_ESB_RX_FIFO_SIZE) {
+		rx_fifo.front = 0;
+	}
+
+	rx_fifo.count--;
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+int esb_claim_rx_payload(const struct esb_payload **payload)
+{
+	if (!esb_initialized) {
+		return -EACCES;
+	}
+	if (payload == NULL) {
+		return -EINVAL;
+	}
+
+	uint32_t key = irq_lock();
+
+	if (rx_fifo.claimed) {
+		irq_unlock(key);
+		return -EBUSY;
+	}
+	if (rx_fifo.count == 0) {
+		irq_unlock(key);
+		return -ENODATA;
+	}
+
+	/* The slot stays in the RX FIFO until it is released, so the radio
+	 * does not receive in it.
+	 */
+	rx_fifo.claimed = true;
+	*payload = rx_fifo.payload[rx_fifo.front];
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+int esb_release_rx_payload(const struct esb_payload *payload)
+{
+	if (!esb_initialized) {
+		return -EACCES;
+	}
+
 	uint32_t key = irq_lock();
 
-	payload->length = rx_fifo.payload[rx_fifo.front]->length;
-	payload->pipe = rx_fifo.payload[rx_fifo.front]->pipe;
-	payload->rssi = rx_fifo.payload[rx_fifo.front]->rssi;
-	payload->pid = rx_fifo.payload[rx_fifo.front]->pid;
-	payload->noack = rx_fifo.payload[rx_fifo.front]->noack;
-	memcpy(payload->data, rx_fifo.payload[rx_fifo.front]->data,
-	       payload->length);
+	if (!rx_fifo.claimed || payload != rx_fifo.payload[rx_fifo.front]) {
+		irq_unlock(key);
+		return -EINVAL;
+	}
 
 	if (++rx_fifo.front >= CONFIG_ESB_RX_FIFO_SIZE) {
 		rx_fifo.front = 0;
 	}
 
 	rx_fifo.count--;
+	rx_fifo.claimed = false;
 
 	irq_unlock(key);
 
@@ -1252,7 +1472,7 @@ int esb_start_rx(void)
 
 	NRF_RADIO->RXADDRESSES = esb_addr.rx_pipes_enabled;
 	NRF_RADIO->FREQUENCY = esb_addr.rf_channel;
-	NRF_RADIO->PACKETPTR = (uint32_t)rx_payload_buffer;
+	NRF_RADIO->PACKETPTR = (uint32_t)rx_buf_select();
 
 	NVIC_ClearPendingIRQ(RADIO_IRQn);
 	irq_enable(RADIO_IRQn);
@@ -1297,6 +1517,7 @@ int esb_flush_tx(void)
 	tx_fifo.count = 0;
 	tx_fifo.back = 0;
 	tx_fifo.front = 0;
+	tx_burst_cancel();
 
 	irq_unlock(key);
 
@@ -1318,6 +1539,7 @@ int esb_pop_tx(void)
 		tx_fifo.back = 0;
 	}
 	tx_fifo.count--;
+	tx_burst_cancel();
 
 	irq_unlock(key);
 
@@ -1332,9 +1554,14 @@ int esb_flush_rx(void)
 
 	uint32_t key = irq_lock();
 
+	if (rx_fifo.claimed) {
+		irq_unlock(key);
+		return -EBUSY;
+	}
+
+	/* The radio may be receiving at the back of the RX FIFO. */
 	rx_fifo.count = 0;
-	rx_fifo.back = 0;
-	rx_fifo.front = 0;
+	rx_fifo.front = rx_fifo.back;
 
 	memset(rx_pipe_info, 0, sizeof(rx_pipe_info));
 
@@ -9,6 +9,10 @@
 #include <net/aws_fota.h>
 #endif
 
+#if defined(CONFIG_AWS_IOT_PUBLISH_QUEUE)
+#include "aws_iot_pub_queue.h"
+#endif
+
 #if defined(CONFIG_BOARD_QEMU_X86) && !defined(CONFIG_BSD_LIBRARY)
 #include "certificates.h"
 #endif
@@ -106,6 +110,8 @@ static aws_iot_evt_handler_t module_evt_handler;
 
 static atomic_t disconnect_requested;
 static atomic_t connection_poll_active;
+static atomic_t connected;
+static atomic_t message_id;
 
 static K_SEM_DEFINE(connection_poll_sem, 0, 1);
 
@@ -571,6 +577,18 @@ static void mqtt_evt_handler(struct mqtt_client *const c,
 
 		LOG_DBG("MQTT client connected!");
 
+		atomic_set(&connected, 1);
+
+#if defined(CONFIG_AWS_IOT_PUBLISH_QUEUE)
+		/* Unacknowledged QoS 1 messages are resent after a reconnect,
+		 * followed by the messages queued while disconnected.
+		 */
+		err = aws_iot_pub_queue_drain(true);
+		if (err) {
+			LOG_ERR("aws_iot_pub_queue_drain, error: %d", err);
+		}
+#endif
+
 		aws_iot_evt.data.persistent_session =
 				   mqtt_evt->param.connack.session_present_flag;
 		aws_iot_evt.type = AWS_IOT_EVT_CONNECTED;
@@ -580,6 +598,7 @@ static void mqtt_evt_handler(struct mqtt_client *const c,
 		break;
 	case MQTT_EVT_DISCONNECT:
 		LOG_DBG("MQTT_EVT_DISCONNECT: result = %d", mqtt_evt->result);
+		atomic_set(&connected, 0);
 		aws_iot_evt.type = AWS_IOT_EVT_DISCONNECTED;
 		aws_iot_notify_event(&aws_iot_evt);
 		break;
@@ -617,6 +636,9 @@ static void mqtt_evt_handler(struct mqtt_client *const c,
 		LOG_DBG("MQTT_EVT_PUBACK: id = %d result = %d",
 			mqtt_evt->param.puback.message_id,
 			mqtt_evt->result);
+#if defined(CONFIG_AWS_IOT_PUBLISH_QUEUE)
+		(void)aws_iot_pub_queue_ack(mqtt_evt->param.puback.message_id);
+#endif
 		break;
 	case MQTT_EVT_SUBACK:
 		LOG_DBG("MQTT_EVT_SUBACK: id = %d result = %d",
@@ -842,6 +864,62 @@ int aws_iot_input(void)
 	return mqtt_input(&client);
 }
 
+/* Message IDs are used to match PUBACKs to queued messages, so they must
+ * not repeat while messages are in flight. Zero is not a valid ID.
+ */
+static uint16_t message_id_next(void)
+{
+	uint16_t id;
+
+	do {
+		id = (uint16_t)atomic_inc(&message_id) + 1;
+	} while (id == 0);
+
+	return id;
+}
+
+#if defined(CONFIG_AWS_IOT_PUBLISH_QUEUE)
+static int pub_queue_send(const struct mqtt_publish_param *param)
+{
+	return mqtt_publish(&client, param);
+}
+
+static int publish(const struct mqtt_publish_param *param)
+{
+	bool qos0 = (param->message.topic.qos == MQTT_QOS_0_AT_MOST_ONCE);
+	int err;
+
+	/* Messages already in the queue go first, to keep the order.
+	 * QoS 1 messages are always queued, so that they are kept until
+	 * their PUBACK and resent after a reconnect.
+	 */
+	if (qos0 && atomic_get(&connected) && !aws_iot_pub_queue_pending()) {
+		err = mqtt_publish(&client, param);
+		if (err != -ENOTCONN) {
+			return err;
+		}
+	}
+
+	err = aws_iot_pub_queue_add(param);
+	if ((err == -EMSGSIZE) && !qos0 && atomic_get(&connected) &&
+	    !aws_iot_pub_queue_pending()) {
+		LOG_WRN("Message does not fit in the queue, sent untracked");
+		return mqtt_publish(&client, param);
+	}
+
+	if (err) {
+		LOG_ERR("aws_iot_pub_queue_add, error: %d", err);
+		return err;
+	}
+
+	if (atomic_get(&connected)) {
+		(void)aws_iot_pub_queue_drain(false);
+	}
+
+	return 0;
+}
+#endif
+
 int aws_iot_send(const struct aws_iot_data *const tx_data)
 {
 	struct aws_iot_data tx_data_pub = {
@@ -897,14 +975,18 @@ int aws_iot_send(const struct aws_iot_data *const tx_data)
 	param.message.topic.topic.size	= tx_data_pub.topic.len;
 	param.message.payload.data	= tx_data_pub.ptr;
 	param.message.payload.len	= tx_data_pub.len;
-	param.message_id		= sys_rand32_get();
+	param.message_id		= message_id_next();
 	param.dup_flag			= 0;
 	param.retain_flag		= 0;
 
 	LOG_DBG("Publishing to topic: %s",
 		log_strdup(param.message.topic.topic.utf8));
 
+#if defined(CONFIG_AWS_IOT_PUBLISH_QUEUE)
+	return publish(&param);
+#else
 	return mqtt_publish(&client, &param);
+#endif
 }
 
 int aws_iot_disconnect(void)
@@ -997,6 +1079,15 @@ int aws_iot_init(const struct aws_iot_config *const config,
 	}
 #endif
 
+#if defined(CONFIG_AWS_IOT_PUBLISH_QUEUE)
+	err = aws_iot_pub_queue_init(pub_queue_send, message_id_next);
+	if (err) {
+		LOG_ERR("aws_iot_pub_queue_init, error: %d", err);
+		return err;
+	}
+#endif
+
+	atomic_set(&message_id, sys_rand32_get());
 	module_evt_handler = event_handler;
 
 	return err;
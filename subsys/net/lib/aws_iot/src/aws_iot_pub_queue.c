@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/slist.h>
+#include <sys/atomic.h>
+#include <net/mqtt.h>
+
+#if defined(CONFIG_AWS_IOT_PUBLISH_QUEUE_STORE)
+#include <settings/settings.h>
+#endif
+
+#include "aws_iot_pub_queue.h"
+
+#include <logging/log.h>
+
+LOG_MODULE_REGISTER(aws_iot_pub_queue, CONFIG_AWS_IOT_LOG_LEVEL);
+
+#define SETTINGS_SUBTREE "aws_iot/pq"
+/* Subtree, separator, 8 hex digits and terminator. */
+#define SETTINGS_KEY_SIZE (sizeof(SETTINGS_SUBTREE) + 9)
+
+/* Message has been handed to the broker and waits for a PUBACK. */
+#define ENTRY_SENT BIT(0)
+/* Message is used by the drain and must not be freed by others. */
+#define ENTRY_BUSY BIT(1)
+/* PUBACK arrived while the message was busy. */
+#define ENTRY_ACKED BIT(2)
+/* Message was loaded from storage and needs a new message ID. */
+#define ENTRY_RESTORED BIT(3)
+
+/* Part of an entry that is written to persistent storage. The payload is
+ * last, so that only its used part needs to be stored.
+ */
+struct pub_queue_record {
+	uint16_t message_id;
+	uint16_t topic_len;
+	uint16_t payload_len;
+	uint8_t qos;
+	char topic[CONFIG_AWS_IOT_PUBLISH_QUEUE_TOPIC_LEN];
+	uint8_t payload[CONFIG_AWS_IOT_PUBLISH_QUEUE_PAYLOAD_LEN];
+};
+
+struct pub_queue_entry {
+	sys_snode_t node;
+	uint32_t seq;
+	uint8_t flags;
+	struct pub_queue_record rec;
+};
+
+K_MEM_SLAB_DEFINE(pub_queue_slab, sizeof(struct pub_queue_entry),
+		  CONFIG_AWS_IOT_PUBLISH_QUEUE_COUNT, 4);
+
+static K_MUTEX_DEFINE(lock);
+/* Entries in the order they were added. */
+static sys_slist_t queue;
+static size_t pending;
+static uint32_t next_seq;
+static atomic_t draining;
+static aws_iot_pub_queue_send_t send_fn;
+static aws_iot_pub_queue_id_t id_fn;
+
+#if defined(CONFIG_AWS_IOT_PUBLISH_QUEUE_STORE)
+static void entry_key(char *key, const struct pub_queue_entry *entry)
+{
+	snprintf(key, SETTINGS_KEY_SIZE, SETTINGS_SUBTREE "/%08x",
+		 (unsigned int)entry->seq);
+}
+
+static void entry_store(const struct pub_queue_entry *entry)
+{
+	char key[SETTINGS_KEY_SIZE];
+	int err;
+
+	entry_key(key, entry);
+	err = settings_save_one(key, &entry->rec,
+				offsetof(struct pub_queue_record, payload) +
+				entry->rec.payload_len);
+	if (err) {
+		LOG_WRN("Could not store message %u: %d",
+			entry->rec.message_id, err);
+	}
+}
+
+static void entry_unstore(const struct pub_queue_entry *entry)
+{
+	char key[SETTINGS_KEY_SIZE];
+
+	entry_key(key, entry);
+	(void)settings_delete(key);
+}
+#else
+static void entry_store(const struct pub_queue_entry *entry) {}
+static void entry_unstore(const struct pub_queue_entry *entry) {}
+#endif /* CONFIG_AWS_IOT_PUBLISH_QUEUE_STORE */
+
+static void entry_free(struct pub_queue_entry *entry)
+{
+	sys_slist_find_and_remove(&queue, &entry->node);
+	entry_unstore(entry);
+	k_mem_slab_free(&pub_queue_slab, (void **)&entry);
+}
+
+/* Insert by sequence number. Entries are normally added in sequence order,
+ * so this only walks the list for entries loaded from storage.
+ */
+static void entry_insert(struct pub_queue_entry *entry)
+{
+	struct pub_queue_entry *tail;
+	struct pub_queue_entry *prev = NULL;
+	struct pub_queue_entry *it;
+
+	tail = SYS_SLIST_PEEK_TAIL_CONTAINER(&queue, tail, node);
+	if (!tail || tail->seq < entry->seq) {
+		sys_slist_append(&queue, &entry->node);
+		return;
+	}
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&queue, it, node) {
+		if (it->seq > entry->seq) {
+			break;
+		}
+
+		prev = it;
+	}
+
+	sys_slist_insert(&queue, prev ? &prev->node : NULL, &entry->node);
+}
+
+static void param_build(struct mqtt_publish_param *param,
+			const struct pub_queue_entry *entry)
+{
+	memset(param, 0, sizeof(*param));
+	param->message.topic.qos = entry->rec.qos;
+	param->message.topic.topic.utf8 = (const uint8_t *)entry->rec.topic;
+	param->message.topic.topic.size = entry->rec.topic_len;
+	param->message.payload.data = (uint8_t *)entry->rec.payload;
+	param->message.payload.len = entry->rec.payload_len;
+	param->message_id = entry->rec.message_id;
+	param->dup_flag = (entry->flags & ENTRY_SENT) ? 1 : 0;
+}
+
+/* Find the next entry to send, starting after prev, and mark it busy. */
+static struct pub_queue_entry *next_get(struct pub_queue_entry *prev,
+					bool resend)
+{
+	struct pub_queue_entry *entry;
+
+	entry = prev ? SYS_SLIST_PEEK_NEXT_CONTAINER(prev, node) :
+		       SYS_SLIST_PEEK_HEAD_CONTAINER(&queue, entry, node);
+
+	for (; entry; entry = SYS_SLIST_PEEK_NEXT_CONTAINER(entry, node)) {
+		if (!(entry->flags & ENTRY_SENT) || resend) {
+			entry->flags |= ENTRY_BUSY;
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+int aws_iot_pub_queue_init(aws_iot_pub_queue_send_t send,
+			   aws_iot_pub_queue_id_t next_id)
+{
+	if (!send || !next_id) {
+		return -EINVAL;
+	}
+
+	send_fn = send;
+	id_fn = next_id;
+
+	return 0;
+}
+
+int aws_iot_pub_queue_add(const struct mqtt_publish_param *param)
+{
+	const struct mqtt_topic *topic = &param->message.topic;
+	struct pub_queue_entry *entry;
+
+	if (topic->topic.size > CONFIG_AWS_IOT_PUBLISH_QUEUE_TOPIC_LEN ||
+	    param->message.payload.len >
+	    CONFIG_AWS_IOT_PUBLISH_QUEUE_PAYLOAD_LEN) {
+		return -EMSGSIZE;
+	}
+
+	if (k_mem_slab_alloc(&pub_queue_slab, (void **)&entry, K_NO_WAIT)) {
+		LOG_WRN("Publish queue full");
+		return -ENOMEM;
+	}
+
+	entry->flags = 0;
+	entry->rec.message_id = param->message_id;
+	entry->rec.qos = topic->qos;
+	entry->rec.topic_len = topic->topic.size;
+	entry->rec.payload_len = param->message.payload.len;
+	memcpy(entry->rec.topic, topic->topic.utf8, topic->topic.size);
+	memcpy(entry->rec.payload, param->message.payload.data,
+	       param->message.payload.len);
+
+	k_mutex_lock(&lock, K_FOREVER);
+	entry->seq = next_seq++;
+	k_mutex_unlock(&lock);
+
+	/* Store before the entry is visible to the drain, which may free it. */
+	entry_store(entry);
+
+	k_mutex_lock(&lock, K_FOREVER);
+	entry_insert(entry);
+	pending++;
+	k_mutex_unlock(&lock);
+
+	LOG_DBG("Queued message %u", param->message_id);
+
+	return 0;
+}
+
+/* The drain keeps the entry it last sent busy, so that it is not freed by a
+ * PUBACK while the lock is released. Release it once the drain moves on.
+ */
+static void cursor_release(struct pub_queue_entry *entry)
+{
+	entry->flags &= ~ENTRY_BUSY;
+
+	if ((entry->flags & ENTRY_ACKED) ||
+	    ((entry->flags & ENTRY_SENT) &&
+	     entry->rec.qos == MQTT_QOS_0_AT_MOST_ONCE)) {
+		entry_free(entry);
+	}
+}
+
+int aws_iot_pub_queue_drain(bool resend)
+{
+	struct mqtt_publish_param param;
+	struct pub_queue_entry *entry;
+	struct pub_queue_entry *prev = NULL;
+	int err = 0;
+
+	if (!send_fn) {
+		return -EACCES;
+	}
+
+	/* Entries added while draining are picked up by the ongoing drain. */
+	if (!atomic_cas(&draining, 0, 1)) {
+		return 0;
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	while ((entry = next_get(prev, resend)) != NULL) {
+		/* The IDs of a previous boot may collide with new ones. */
+		if (entry->flags & ENTRY_RESTORED) {
+			entry->rec.message_id = id_fn();
+			entry->flags &= ~ENTRY_RESTORED;
+		}
+
+		param_build(&param, entry);
+
+		/* The lock is not held while sending, as the send function
+		 * takes the MQTT client lock, which is also held when PUBACKs
+		 * are processed.
+		 */
+		k_mutex_unlock(&lock);
+		err = send_fn(&param);
+		k_mutex_lock(&lock, K_FOREVER);
+
+		if (prev) {
+			cursor_release(prev);
+		}
+
+		prev = entry;
+
+		if (err) {
+			LOG_DBG("Drain stopped at message %u: %d",
+				entry->rec.message_id, err);
+			break;
+		}
+
+		if (!(entry->flags & ENTRY_SENT)) {
+			entry->flags |= ENTRY_SENT;
+			pending--;
+		}
+	}
+
+	if (prev) {
+		cursor_release(prev);
+	}
+
+	/* Clear the flag before entries can be added again, so that an entry
+	 * added after the last lookup is drained by the one who added it.
+	 */
+	atomic_clear(&draining);
+	k_mutex_unlock(&lock);
+
+	return err;
+}
+
+bool aws_iot_pub_queue_ack(uint16_t message_id)
+{
+	struct pub_queue_entry *entry;
+	bool found = false;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&queue, entry, node) {
+		if (entry->rec.message_id != message_id ||
+		    entry->rec.qos == MQTT_QOS_0_AT_MOST_ONCE) {
+			continue;
+		}
+
+		if (entry->flags & ENTRY_BUSY) {
+			entry->flags |= ENTRY_ACKED;
+		} else if (entry->flags & ENTRY_SENT) {
+			entry_free(entry);
+		} else {
+			continue;
+		}
+
+		found = true;
+		break;
+	}
+
+	k_mutex_unlock(&lock);
+
+	return found;
+}
+
+size_t aws_iot_pub_queue_pending(void)
+{
+	return pending;
+}
+
+size_t aws_iot_pub_queue_count(void)
+{
+	return k_mem_slab_num_used_get(&pub_queue_slab);
+}
+
+#if defined(CONFIG_AWS_IOT_PUBLISH_QUEUE_STORE)
+static int settings_set(const char *key, size_t len, settings_read_cb read_cb,
+			void *cb_arg)
+{
+	struct pub_queue_entry *entry;
+	ssize_t size;
+
+	if (len < offsetof(struct pub_queue_record, payload) ||
+	    len > sizeof(entry->rec)) {
+		return -EINVAL;
+	}
+
+	if (k_mem_slab_alloc(&pub_queue_slab, (void **)&entry, K_NO_WAIT)) {
+		LOG_WRN("No room for stored message %s", log_strdup(key));
+		return -ENOMEM;
+	}
+
+	size = read_cb(cb_arg, &entry->rec, len);
+	if (size != len ||
+	    entry->rec.topic_len > sizeof(entry->rec.topic) ||
+	    entry->rec.payload_len !=
+	    len - offsetof(struct pub_queue_record, payload)) {
+		k_mem_slab_free(&pub_queue_slab, (void **)&entry);
+		return -EINVAL;
+	}
+
+	entry->seq = strtoul(key, NULL, 16);
+	entry->flags = ENTRY_RESTORED;
+
+	k_mutex_lock(&lock, K_FOREVER);
+	entry_insert(entry);
+	pending++;
+	if (entry->seq >= next_seq) {
+		next_seq = entry->seq + 1;
+	}
+	k_mutex_unlock(&lock);
+
+	return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(aws_iot_pub_queue, SETTINGS_SUBTREE, NULL,
+			       settings_set, NULL, NULL);
+#endif /* CONFIG_AWS_IOT_PUBLISH_QUEUE_STORE */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef AWS_IOT_PUB_QUEUE_H__
+#define AWS_IOT_PUB_QUEUE_H__
+
+#include <stdbool.h>
+#include <zephyr/types.h>
+#include <net/mqtt.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Function used by the queue to hand a message to the broker.
+ *
+ * @param param Publish parameters. Topic and payload point into the queue
+ *		and stay valid until the message is freed.
+ *
+ * @return 0 if the message was sent, otherwise a negative error code.
+ */
+typedef int (*aws_iot_pub_queue_send_t)(const struct mqtt_publish_param *param);
+
+/** @brief Function used by the queue to get a new message ID.
+ *
+ * @return Message ID that is not used by any message in flight.
+ */
+typedef uint16_t (*aws_iot_pub_queue_id_t)(void);
+
+/** @brief Initialize the publish queue.
+ *
+ * Messages restored from persistent storage are kept. They get a new
+ * message ID when they are sent for the first time after the restore.
+ *
+ * @param send Function used to send messages when the queue is drained.
+ * @param next_id Function used to get message IDs for restored messages.
+ *
+ * @return 0 on success, otherwise a negative error code.
+ */
+int aws_iot_pub_queue_init(aws_iot_pub_queue_send_t send,
+			   aws_iot_pub_queue_id_t next_id);
+
+/** @brief Copy a message into the queue.
+ *
+ * @param param Publish parameters. The message ID is kept and used to match
+ *		the PUBACK of QoS 1 messages.
+ *
+ * @retval 0 The message was queued.
+ * @retval -EMSGSIZE The topic or payload does not fit in a queue entry.
+ * @retval -ENOMEM The queue is full.
+ */
+int aws_iot_pub_queue_add(const struct mqtt_publish_param *param);
+
+/** @brief Send queued messages in the order they were added.
+ *
+ * QoS 0 messages are freed once sent. QoS 1 messages are kept until their
+ * PUBACK is received, see @ref aws_iot_pub_queue_ack.
+ *
+ * @param resend Also resend QoS 1 messages that have been sent before but
+ *		 were not acknowledged, with the DUP flag set. Used after
+ *		 the connection has been reestablished.
+ *
+ * @return 0 if all messages were sent, otherwise the error returned by the
+ *	   send function. Messages that were not sent stay in the queue.
+ */
+int aws_iot_pub_queue_drain(bool resend);
+
+/** @brief Free the QoS 1 message acknowledged by a PUBACK.
+ *
+ * @param message_id Message ID of the PUBACK.
+ *
+ * @return true if a queued message was acknowledged.
+ */
+bool aws_iot_pub_queue_ack(uint16_t message_id);
+
+/** @brief Get the number of queued messages that have not been sent yet.
+ *
+ * @return Number of unsent messages.
+ */
+size_t aws_iot_pub_queue_pending(void);
+
+/** @brief Get the number of messages in the queue, including QoS 1 messages
+ *	  waiting for a PUBACK.
+ *
+ * @return Number of queued messages.
+ */
+size_t aws_iot_pub_queue_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AWS_IOT_PUB_QUEUE_H__ */
@@ -5,6 +5,7 @@
  */
 #include <zephyr.h>
 #include <logging/log.h>
+#include <random/rand32.h>
 #include <net/coap.h>
 #include <net/coap_utils.h>
 #include <net/socket.h>
@@ -14,18 +15,60 @@ LOG_MODULE_REGISTER(coap_utils, CONFIG_COAP_UTILS_LOG_LEVEL);
 #define MAX_COAP_MSG_LEN 256
 #define COAP_VER 1
 #define COAP_TOKEN_LEN 8
-#define COAP_MAX_REPLIES 1
-#define COAP_POOL_SLEEP 500
+#define COAP_MAX_REQUESTS CONFIG_COAP_UTILS_MAX_REQUESTS
 #define COAP_OPEN_SOCKET_SLEEP 200
+#define COAP_POLL_SLEEP 500
 #if defined(CONFIG_BSD_LIBRARY)
 #define COAP_RECEIVE_STACK_SIZE 1000
 #else
 #define COAP_RECEIVE_STACK_SIZE 500
 #endif
 
+/* Transmission parameters, RFC 7252 section 4.8. */
+#define COAP_ACK_TIMEOUT_MS 2000
+#define COAP_ACK_RANDOM_PERCENT 50
+#define COAP_MAX_RETRANSMIT 4
+
+/* Observation handles hold the generation of the slot above its index. */
+#define COAP_HANDLE_INDEX_BITS 8
+#define COAP_HANDLE_INDEX_MASK (BIT(COAP_HANDLE_INDEX_BITS) - 1)
+
+BUILD_ASSERT(COAP_MAX_REQUESTS <= BIT(COAP_HANDLE_INDEX_BITS),
+	     "Too many requests for the observation handle");
+
+/* Notification freshness, RFC 7641 section 3.4. */
+#define COAP_OBSERVE_SEQ_HALF BIT(23)
+#define COAP_OBSERVE_FRESH_MS (128 * MSEC_PER_SEC)
+
+struct coap_request {
+	/* Holds the token and message ID the responses are matched by. */
+	struct coap_reply reply;
+	struct k_delayed_work retransmit_work;
+	struct sockaddr addr;
+	uint32_t sent_time;
+	uint32_t timeout;
+	uint32_t observe_time;
+	int observe_seq;
+	uint16_t len;
+	uint16_t generation;
+	uint8_t type;
+	uint8_t retries;
+	/* Retransmissions whose handler was running when they were
+	 * cancelled, and which the handler must drop.
+	 */
+	uint8_t retransmit_stale;
+	bool retransmit_pending;
+	bool used;
+	bool acked;
+	bool observe;
+	uint8_t buf[MAX_COAP_MSG_LEN];
+};
+
 const static int nfds = 1;
 static struct pollfd fds;
-static struct coap_reply replies[COAP_MAX_REPLIES];
+static struct coap_request requests[COAP_MAX_REQUESTS];
+static struct coap_utils_stats stats;
+static K_MUTEX_DEFINE(requests_lock);
 static int proto_family;
 
 static K_THREAD_STACK_DEFINE(receive_stack_area, COAP_RECEIVE_STACK_SIZE);
@@ -53,42 +96,318 @@ static void coap_close_socket(int socket)
 	(void)close(socket);
 }
 
+static int coap_send_buf(const struct sockaddr *addr, const uint8_t *buf,
+			 uint16_t len)
+{
+	int ret;
+
+	/* The receive thread may reopen the socket meanwhile. */
+	k_mutex_lock(&requests_lock, K_FOREVER);
+	ret = sendto(fds.fd, buf, len, 0, addr, sizeof(*addr));
+	k_mutex_unlock(&requests_lock);
+
+	return ret;
+}
+
+static void retransmit_submit(struct coap_request *req)
+{
+	req->retransmit_pending = true;
+	k_delayed_work_submit(&req->retransmit_work, K_MSEC(req->timeout));
+}
+
+static void retransmit_cancel(struct coap_request *req)
+{
+	if (!req->retransmit_pending) {
+		return;
+	}
+
+	req->retransmit_pending = false;
+
+	/* The handler has already started and waits for the lock. It must
+	 * not act on the next request that is stored in the slot.
+	 */
+	if (k_delayed_work_cancel(&req->retransmit_work) != 0) {
+		req->retransmit_stale++;
+	}
+}
+
+static void request_free(struct coap_request *req)
+{
+	retransmit_cancel(req);
+	req->used = false;
+}
+
+/* Free slots first. If the table is full, the oldest non-confirmable
+ * request is replaced, as its response may never come.
+ */
+static struct coap_request *request_alloc(void)
+{
+	struct coap_request *oldest = NULL;
+
+	for (size_t i = 0; i < ARRAY_SIZE(requests); i++) {
+		struct coap_request *req = &requests[i];
+
+		if (!req->used) {
+			return req;
+		}
+
+		if (req->type == COAP_TYPE_CON || req->observe) {
+			continue;
+		}
+
+		if (!oldest ||
+		    (int32_t)(req->sent_time - oldest->sent_time) < 0) {
+			oldest = req;
+		}
+	}
+
+	if (oldest) {
+		request_free(oldest);
+	}
+
+	return oldest;
+}
+
+static struct coap_request *request_find_token(const uint8_t *token,
+					       uint8_t tkl)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(requests); i++) {
+		struct coap_request *req = &requests[i];
+
+		if (req->used && req->reply.tkl == tkl &&
+		    !memcmp(req->reply.token, token, tkl)) {
+			return req;
+		}
+	}
+
+	return NULL;
+}
+
+static struct coap_request *request_find_id(uint16_t id)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(requests); i++) {
+		struct coap_request *req = &requests[i];
+
+		if (req->used && req->reply.id == id) {
+			return req;
+		}
+	}
+
+	return NULL;
+}
+
+static void request_acked(struct coap_request *req)
+{
+	if (req->type != COAP_TYPE_CON || req->acked) {
+		return;
+	}
+
+	req->acked = true;
+	retransmit_cancel(req);
+
+	/* Retransmitted requests give ambiguous round trip times. */
+	if (req->retries == 0) {
+		stats.rtt_last_ms = k_uptime_get_32() - req->sent_time;
+		stats.rtt_sum_ms += stats.rtt_last_ms;
+		stats.rtt_count++;
+	}
+}
+
+static bool observe_is_fresh(struct coap_request *req, int seq)
+{
+	uint32_t now = k_uptime_get_32();
+	bool fresh;
+
+	fresh = (req->observe_seq < 0) ||
+		(req->observe_seq < seq &&
+		 seq - req->observe_seq < COAP_OBSERVE_SEQ_HALF) ||
+		(req->observe_seq > seq &&
+		 req->observe_seq - seq > COAP_OBSERVE_SEQ_HALF) ||
+		(now - req->observe_time > COAP_OBSERVE_FRESH_MS);
+
+	if (fresh) {
+		req->observe_seq = seq;
+		req->observe_time = now;
+	}
+
+	return fresh;
+}
+
+static void retransmit_handler(struct k_work *work)
+{
+	struct coap_request *req =
+		CONTAINER_OF(work, struct coap_request, retransmit_work);
+	struct coap_reply reply;
+
+	k_mutex_lock(&requests_lock, K_FOREVER);
+
+	if (req->retransmit_stale > 0) {
+		req->retransmit_stale--;
+		k_mutex_unlock(&requests_lock);
+		return;
+	}
+
+	req->retransmit_pending = false;
+
+	if (!req->used || req->acked) {
+		k_mutex_unlock(&requests_lock);
+		return;
+	}
+
+	if (req->retries < COAP_MAX_RETRANSMIT) {
+		req->retries++;
+		req->timeout <<= 1;
+		stats.retransmissions++;
+
+		if (coap_send_buf(&req->addr, req->buf, req->len) < 0) {
+			LOG_ERR("Retransmission failed: %d", errno);
+		}
+
+		retransmit_submit(req);
+		k_mutex_unlock(&requests_lock);
+		return;
+	}
+
+	LOG_WRN("Request %u timed out", req->reply.id);
+	stats.timeouts++;
+	reply = req->reply;
+	request_free(req);
+
+	k_mutex_unlock(&requests_lock);
+
+	if (reply.reply) {
+		reply.reply(NULL, &reply, NULL);
+	}
+}
+
+static void coap_send_empty(const struct sockaddr *addr, uint8_t type,
+			    uint16_t id)
+{
+	struct coap_packet packet;
+	uint8_t buf[4];
+
+	if (coap_packet_init(&packet, buf, sizeof(buf), COAP_VER, type, 0,
+			     NULL, COAP_CODE_EMPTY, id) < 0) {
+		return;
+	}
+
+	(void)coap_send_buf(addr, packet.data, packet.offset);
+}
+
+static void coap_response_handle(const struct coap_packet *response,
+				 const struct sockaddr *from)
+{
+	uint8_t token[COAP_TOKEN_LEN];
+	uint8_t tkl = coap_header_get_token(response, token);
+	uint8_t type = coap_header_get_type(response);
+	uint16_t id = coap_header_get_id(response);
+	struct coap_request *req;
+	struct coap_reply reply;
+	int seq;
+
+	k_mutex_lock(&requests_lock, K_FOREVER);
+
+	if (type == COAP_TYPE_ACK || type == COAP_TYPE_RESET) {
+		req = request_find_id(id);
+		if (req) {
+			request_acked(req);
+		}
+
+		if (coap_header_get_code(response) == COAP_CODE_EMPTY) {
+			/* A reset cancels the request, or the observation. */
+			if (req && type == COAP_TYPE_RESET) {
+				request_free(req);
+			}
+
+			k_mutex_unlock(&requests_lock);
+			return;
+		}
+	}
+
+	req = request_find_token(token, tkl);
+	if (!req) {
+		k_mutex_unlock(&requests_lock);
+
+		/* Reject notifications of cancelled observations. */
+		if (type == COAP_TYPE_CON) {
+			coap_send_empty(from, COAP_TYPE_RESET, id);
+		}
+
+		return;
+	}
+
+	/* A separate response also acknowledges the request. */
+	request_acked(req);
+
+	if (type == COAP_TYPE_CON) {
+		coap_send_empty(from, COAP_TYPE_ACK, id);
+	}
+
+	seq = req->observe ?
+	      coap_get_option_int(response, COAP_OPTION_OBSERVE) : -ENOENT;
+
+	if (seq >= 0 && !observe_is_fresh(req, seq)) {
+		LOG_DBG("Dropping stale notification %d", seq);
+		k_mutex_unlock(&requests_lock);
+		return;
+	}
+
+	stats.responses++;
+	reply = req->reply;
+
+	/* Responses without the Observe option end the observation. */
+	if (seq < 0) {
+		request_free(req);
+	}
+
+	k_mutex_unlock(&requests_lock);
+
+	if (reply.reply) {
+		reply.reply(response, &reply, from);
+	}
+}
+
 static void coap_receive(void)
 {
 	static uint8_t buf[MAX_COAP_MSG_LEN + 1];
 	struct coap_packet response;
-	struct coap_reply *reply = NULL;
 	static struct sockaddr from_addr;
 	socklen_t from_addr_len;
+	int sock;
 	int len;
 	int ret;
 
+	/* Retransmissions are driven by delayed work, so the thread only wakes
+	 * up when data arrives.
+	 */
 	while (1) {
 		fds.revents = 0;
 
 		if (poll(&fds, nfds, -1) < 0) {
 			LOG_ERR("Error in poll:%d", errno);
 			errno = 0;
-			k_sleep(K_MSEC(COAP_POOL_SLEEP));
+			k_sleep(K_MSEC(COAP_POLL_SLEEP));
 			continue;
 		}
 
-		if (fds.revents & POLLERR) {
-			LOG_ERR("Error in poll.. waiting a moment.");
-			k_sleep(K_MSEC(COAP_POOL_SLEEP));
-			continue;
-		}
+		if (fds.revents & (POLLERR | POLLNVAL | POLLHUP)) {
+			LOG_ERR("Error in poll: %s",
+				(fds.revents & POLLNVAL) ?
+				"POLLNVAL - fd not open" :
+				(fds.revents & POLLERR) ? "POLLERR" :
+				"POLLHUP");
 
-		if (fds.revents & POLLHUP) {
-			LOG_ERR("Error in poll: POLLHUP");
-			continue;
-		}
+			/* Senders read the socket with the lock held. */
+			k_mutex_lock(&requests_lock, K_FOREVER);
+			coap_close_socket(fds.fd);
+			fds.fd = -1;
+			k_mutex_unlock(&requests_lock);
 
-		if (fds.revents & POLLNVAL) {
-			LOG_ERR("Error in poll: POLLNVAL - fd not open");
+			sock = coap_open_socket();
 
-			coap_close_socket(fds.fd);
-			fds.fd = coap_open_socket();
+			k_mutex_lock(&requests_lock, K_FOREVER);
+			fds.fd = sock;
+			k_mutex_unlock(&requests_lock);
 
 			LOG_INF("Socket has been re-open");
 
@@ -97,9 +416,11 @@ static void coap_receive(void)
 
 		if (!(fds.revents & POLLIN)) {
 			LOG_ERR("Unknown poll error");
+			k_sleep(K_MSEC(COAP_POLL_SLEEP));
 			continue;
 		}
 
+		from_addr_len = sizeof(from_addr);
 		len = recvfrom(fds.fd, buf, sizeof(buf) - 1, 0, &from_addr,
 			       &from_addr_len);
 
@@ -120,16 +441,12 @@ static void coap_receive(void)
 			continue;
 		}
 
-		reply = coap_response_received(&response, &from_addr, replies,
-					       COAP_MAX_REPLIES);
-		if (reply) {
-			coap_reply_clear(reply);
-		}
+		coap_response_handle(&response, &from_addr);
 	}
 }
 
 static int coap_init_request(enum coap_method method,
-			     enum coap_msgtype msg_type,
+			     enum coap_msgtype msg_type, bool observe,
 			     const char *const *uri_path_options, uint8_t *payload,
 			     uint16_t payload_size, struct coap_packet *request,
 			     uint8_t *buf)
@@ -145,6 +462,15 @@ static int coap_init_request(enum coap_method method,
 		goto end;
 	}
 
+	/* Options are appended in ascending order, Observe before Uri-Path. */
+	if (observe) {
+		ret = coap_append_option_int(request, COAP_OPTION_OBSERVE, 0);
+		if (ret < 0) {
+			LOG_ERR("Unable add option to request");
+			goto end;
+		}
+	}
+
 	for (opt = uri_path_options; opt && *opt; opt++) {
 		ret = coap_packet_append_option(request, COAP_OPTION_URI_PATH,
 						*opt, strlen(*opt));
@@ -173,29 +499,81 @@ end:
 	return ret;
 }
 
-static int coap_send_message(const struct sockaddr *addr,
-			     struct coap_packet *request)
+/* Builds the request in a table slot, so that it can be retransmitted and
+ * its responses matched. Returns the handle of the slot.
+ */
+static int coap_send_tracked(enum coap_method method,
+			     enum coap_msgtype msg_type, bool observe,
+			     const struct sockaddr *addr,
+			     const char *const *uri_path_options,
+			     uint8_t *payload, uint16_t payload_size,
+			     coap_reply_t reply_cb)
 {
-	return sendto(fds.fd, request->data, request->offset, 0, addr,
-		      sizeof(*addr));
-}
+	struct coap_request *req;
+	struct coap_packet request;
+	int ret;
 
-static void coap_set_response_callback(struct coap_packet *request,
-				       coap_reply_t reply_cb)
-{
-	struct coap_reply *reply;
+	k_mutex_lock(&requests_lock, K_FOREVER);
 
-	reply = &replies[0];
+	req = request_alloc();
+	if (!req) {
+		LOG_ERR("No free request slot");
+		ret = -ENOMEM;
+		goto end;
+	}
 
-	coap_reply_clear(reply);
-	coap_reply_init(reply, request);
-	reply->reply = reply_cb;
+	ret = coap_init_request(method, msg_type, observe, uri_path_options,
+				payload, payload_size, &request, req->buf);
+	if (ret < 0) {
+		goto end;
+	}
+
+	coap_reply_init(&req->reply, &request);
+	req->reply.reply = reply_cb;
+	req->addr = *addr;
+	req->len = request.offset;
+	req->type = msg_type;
+	req->observe = observe;
+	req->observe_seq = -1;
+	req->retries = 0;
+	req->acked = false;
+	req->sent_time = k_uptime_get_32();
+	req->timeout = COAP_ACK_TIMEOUT_MS +
+		       sys_rand32_get() % (COAP_ACK_TIMEOUT_MS *
+					   COAP_ACK_RANDOM_PERCENT / 100);
+
+	ret = coap_send_buf(addr, req->buf, req->len);
+	if (ret < 0) {
+		LOG_ERR("Transmission failed: %d", errno);
+		goto end;
+	}
+
+	req->used = true;
+	req->generation++;
+	stats.requests++;
+
+	if (msg_type == COAP_TYPE_CON) {
+		retransmit_submit(req);
+	}
+
+	/* A stale handle does not match the next request in the slot. */
+	ret = ((int)req->generation << COAP_HANDLE_INDEX_BITS) |
+	      (req - requests);
+
+end:
+	k_mutex_unlock(&requests_lock);
+	return ret;
 }
 
 void coap_init(int ip_family)
 {
 	proto_family = ip_family;
 
+	for (size_t i = 0; i < ARRAY_SIZE(requests); i++) {
+		k_delayed_work_init(&requests[i].retransmit_work,
+				    retransmit_handler);
+	}
+
 	fds.events = POLLIN;
 	fds.revents = 0;
 	fds.fd = coap_open_socket();
@@ -219,17 +597,21 @@ int coap_send_request(enum coap_method method, const struct sockaddr *addr,
 	struct coap_packet request;
 	uint8_t buf[MAX_COAP_MSG_LEN];
 
-	ret = coap_init_request(method, COAP_TYPE_NON_CON, uri_path_options,
-				payload, payload_size, &request, buf);
-	if (ret < 0) {
-		goto end;
+	if (reply_cb != NULL) {
+		ret = coap_send_tracked(method, COAP_TYPE_NON_CON, false, addr,
+					uri_path_options, payload,
+					payload_size, reply_cb);
+		return ret < 0 ? ret : 0;
 	}
 
-	if (reply_cb != NULL) {
-		coap_set_response_callback(&request, reply_cb);
+	ret = coap_init_request(method, COAP_TYPE_NON_CON, false,
+				uri_path_options, payload, payload_size,
+				&request, buf);
+	if (ret < 0) {
+		goto end;
 	}
 
-	ret = coap_send_message(addr, &request);
+	ret = coap_send_buf(addr, request.data, request.offset);
 	if (ret < 0) {
 		LOG_ERR("Transmission failed: %d", errno);
 		goto end;
@@ -238,3 +620,62 @@ int coap_send_request(enum coap_method method, const struct sockaddr *addr,
 end:
 	return ret;
 }
+
+int coap_send_con_request(enum coap_method method,
+			  const struct sockaddr *addr,
+			  const char *const *uri_path_options,
+			  uint8_t *payload, uint16_t payload_size,
+			  coap_reply_t reply_cb)
+{
+	int ret;
+
+	ret = coap_send_tracked(method, COAP_TYPE_CON, false, addr,
+				uri_path_options, payload, payload_size,
+				reply_cb);
+
+	return ret < 0 ? ret : 0;
+}
+
+int coap_observe(const struct sockaddr *addr,
+		 const char *const *uri_path_options, coap_reply_t reply_cb)
+{
+	if (reply_cb == NULL) {
+		return -EINVAL;
+	}
+
+	return coap_send_tracked(COAP_METHOD_GET, COAP_TYPE_CON, true, addr,
+				 uri_path_options, NULL, 0, reply_cb);
+}
+
+int coap_observe_cancel(int handle)
+{
+	struct coap_request *req;
+	size_t index = handle & COAP_HANDLE_INDEX_MASK;
+
+	if (handle < 0 || index >= ARRAY_SIZE(requests)) {
+		return -EINVAL;
+	}
+
+	req = &requests[index];
+
+	k_mutex_lock(&requests_lock, K_FOREVER);
+
+	if (!req->used || !req->observe ||
+	    req->generation != (handle >> COAP_HANDLE_INDEX_BITS)) {
+		k_mutex_unlock(&requests_lock);
+		return -ENOENT;
+	}
+
+	/* The server is told by a reset on its next notification. */
+	request_free(req);
+
+	k_mutex_unlock(&requests_lock);
+	return 0;
+}
+
+void coap_utils_stats_get(struct coap_utils_stats *stats_out)
+{
+	k_mutex_lock(&requests_lock, K_FOREVER);
+	*stats_out = stats;
+	k_mutex_unlock(&requests_lock);
+}
@@ -7,6 +7,8 @@
 #include <zephyr.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
 #include <net/socket.h>
 #include <net/tls_credentials.h>
 #include <net/ftp_client.h>
@@ -53,6 +55,17 @@ static struct data_task {
 	uint16_t length;	/* TX length */
 } data_task_param;
 
+/* Streaming transfer over a single data connection. */
+static struct ftp_stream {
+	int sock;		/* Data socket, INVALID_SOCKET if not open */
+	bool upload;
+	bool done;		/* Transfer complete reply already received */
+	size_t offset;		/* Restart offset */
+	size_t bytes;		/* Bytes transferred in this session */
+} stream = {
+	.sock = INVALID_SOCKET
+};
+
 static int parse_return_code(const uint8_t *message, int success_code)
 {
 	char code_str[6]; /* max 1xxxx*/
@@ -66,6 +79,29 @@ static int parse_return_code(const uint8_t *message, int success_code)
 	return ret;
 }
 
+/* Returns the code of the last complete reply in the message, 0 if none.
+ * Lines of a multi-line reply, such as "226-Info", are skipped.
+ */
+static int last_reply_code(const char *message)
+{
+	const char *line = message;
+	int ret = 0;
+
+	while (line) {
+		if (isdigit((int)line[0]) && isdigit((int)line[1]) &&
+		    isdigit((int)line[2]) && line[3] == ' ') {
+			ret = atoi(line);
+		}
+
+		line = strchr(line, '\n');
+		if (line) {
+			line++;
+		}
+	}
+
+	return ret;
+}
+
 static int establish_data_channel(const char *pasv_msg)
 {
 	int ret;
@@ -430,6 +466,11 @@ int ftp_close(void)
 {
 	int ret = 0;
 
+	if (stream.sock != INVALID_SOCKET) {
+		close(stream.sock);
+		stream.sock = INVALID_SOCKET;
+	}
+
 	if (client.connected) {
 		ret = do_ftp_send_ctrl(CMD_QUIT, sizeof(CMD_QUIT) - 1);
 		if (ret == 0) {
@@ -712,6 +753,233 @@ int ftp_put(const char *file, const uint8_t *data, uint16_t length)
 	return ret;
 }
 
+/* Wait for the final reply of a transfer. Only preliminary replies are
+ * skipped, so an error reply such as 451 or 552 ends the wait as well.
+ */
+static int stream_recv_complete(void)
+{
+	int ret;
+
+	do {
+		ret = do_ftp_recv_ctrl(true, FTP_CODE_226);
+		if (ret < 0 || ret == FTP_CODE_226) {
+			return ret;
+		}
+
+		ret = last_reply_code(ctrl_buf);
+	} while (ret < FTP_CODE_200);
+
+	LOG_ERR("Transfer failed: %d", ret);
+
+	return ret;
+}
+
+static int stream_open(const char *cmd, const char *file, size_t offset,
+		       bool upload)
+{
+	int ret;
+	int keepalive_time = CONFIG_FTP_CLIENT_KEEPALIVE_TIME;
+
+	if (!client.connected) {
+		return -ENOTCONN;
+	}
+
+	if (stream.sock != INVALID_SOCKET) {
+		LOG_ERR("Transfer already open");
+		return -EALREADY;
+	}
+
+	/* The keep-alive replies would interleave with the transfer replies */
+	k_timer_stop(&keepalive_timer);
+
+	/* Always set Passive mode to act as TCP client */
+	ret = do_ftp_send_ctrl(CMD_PASV, sizeof(CMD_PASV) - 1);
+	if (ret) {
+		ret = -EIO;
+		goto error;
+	}
+	ret = do_ftp_recv_ctrl(true, FTP_CODE_227);
+	if (ret != FTP_CODE_227) {
+		goto error;
+	}
+
+	ret = establish_data_channel(ctrl_buf);
+	if (ret < 0) {
+		goto error;
+	}
+	stream.sock = ret;
+
+	if (offset > 0) {
+		sprintf(ctrl_buf, CMD_REST, (unsigned int)offset);
+		ret = do_ftp_send_ctrl(ctrl_buf, strlen(ctrl_buf));
+		if (ret) {
+			ret = -EIO;
+			goto error;
+		}
+		ret = do_ftp_recv_ctrl(true, FTP_CODE_350);
+		if (ret != FTP_CODE_350) {
+			goto error;
+		}
+	}
+
+	sprintf(ctrl_buf, cmd, file);
+	ret = do_ftp_send_ctrl(ctrl_buf, strlen(ctrl_buf));
+	if (ret) {
+		ret = -EIO;
+		goto error;
+	}
+	ret = do_ftp_recv_ctrl(true, FTP_CODE_150);
+	if (ret != FTP_CODE_150 &&
+	    parse_return_code(ctrl_buf, FTP_CODE_125) != FTP_CODE_125) {
+		goto error;
+	}
+
+	/* Small downloads may complete within the same reply */
+	stream.done = (parse_return_code(ctrl_buf, FTP_CODE_226) ==
+		       FTP_CODE_226);
+	stream.upload = upload;
+	stream.offset = offset;
+	stream.bytes = 0;
+
+	return 0;
+
+error:
+	if (stream.sock != INVALID_SOCKET) {
+		close(stream.sock);
+		stream.sock = INVALID_SOCKET;
+	}
+
+	if (keepalive_time > 0) {
+		k_timer_start(&keepalive_timer, K_SECONDS(keepalive_time),
+			K_SECONDS(keepalive_time));
+	}
+
+	return ret;
+}
+
+int ftp_stream_put_open(const char *file, size_t offset)
+{
+	return stream_open(CMD_STOR, file, offset, true);
+}
+
+int ftp_stream_get_open(const char *file, size_t offset)
+{
+	return stream_open(CMD_RETR, file, offset, false);
+}
+
+int ftp_stream_write(const uint8_t *data, size_t length)
+{
+	int ret;
+	size_t offset = 0;
+
+	if (stream.sock == INVALID_SOCKET || !stream.upload) {
+		return -EBADF;
+	}
+
+	while (offset < length) {
+		ret = send(stream.sock, data + offset, length - offset, 0);
+		if (ret < 0) {
+			LOG_ERR("send(data) failed: %d", -errno);
+			return -errno;
+		}
+		offset += ret;
+		stream.bytes += ret;
+	}
+
+	return 0;
+}
+
+int ftp_stream_read(uint8_t *buf, size_t length)
+{
+	int ret;
+	struct pollfd fds[1];
+
+	if (stream.sock == INVALID_SOCKET || stream.upload) {
+		return -EBADF;
+	}
+
+	fds[0].fd = stream.sock;
+	fds[0].events = POLLIN;
+	ret = poll(fds, 1, MSEC_PER_SEC * CONFIG_FTP_CLIENT_LISTEN_TIME);
+	if (ret < 0) {
+		LOG_ERR("poll(data) failed: (%d)", -errno);
+		return -errno;
+	}
+	if (ret == 0) {
+		return -ETIMEDOUT;
+	}
+
+	ret = recv(stream.sock, buf, length, 0);
+	if (ret < 0) {
+		LOG_ERR("recv(data) failed: (%d)", -errno);
+		return -errno;
+	}
+
+	/* Zero when the server has closed the data connection */
+	stream.bytes += ret;
+	return ret;
+}
+
+size_t ftp_stream_progress(void)
+{
+	return stream.offset + stream.bytes;
+}
+
+int ftp_stream_close(void)
+{
+	int ret;
+	int keepalive_time = CONFIG_FTP_CLIENT_KEEPALIVE_TIME;
+
+	if (stream.sock == INVALID_SOCKET) {
+		return -EBADF;
+	}
+
+	/* Closing the data connection marks the end of an upload */
+	close(stream.sock);
+	stream.sock = INVALID_SOCKET;
+
+	if (stream.done) {
+		ret = FTP_CODE_226;
+	} else {
+		ret = stream_recv_complete();
+	}
+
+	LOG_DBG("Transferred %u bytes", (unsigned int)stream.bytes);
+
+	if (keepalive_time > 0) {
+		k_timer_start(&keepalive_timer, K_SECONDS(keepalive_time),
+			K_SECONDS(keepalive_time));
+	}
+
+	return ret;
+}
+
+int ftp_size(const char *file, size_t *size)
+{
+	int ret;
+	char *value;
+
+	sprintf(ctrl_buf, CMD_SIZE, file);
+	ret = do_ftp_send_ctrl(ctrl_buf, strlen(ctrl_buf));
+	if (ret == 0) {
+		ret = do_ftp_recv_ctrl(true, FTP_CODE_213);
+	}
+	if (ret != FTP_CODE_213) {
+		return ret;
+	}
+
+	/* e.g. "213 1048576" */
+	value = strstr(ctrl_buf, "213 ");
+	if (value == NULL) {
+		LOG_ERR("Invalid SIZE reply");
+		return -EIO;
+	}
+
+	*size = strtoul(value + 4, NULL, 10);
+
+	return ret;
+}
+
 int ftp_init(ftp_client_callback_t ctrl_callback,
 	ftp_client_callback_t data_callback)
 {
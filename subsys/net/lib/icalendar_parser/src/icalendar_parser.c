@@ -14,69 +14,52 @@
 
 LOG_MODULE_REGISTER(icalendar_parser, CONFIG_ICAL_PARSER_LOG_LEVEL);
 
-static size_t unfold_contentline(const char *buf, char *prop_buf)
+/* Components, in the order of ical_parser_evt_id shifted by one. */
+enum ical_component_type {
+	COMPONENT_NONE,
+	COMPONENT_VEVENT,
+	COMPONENT_VTODO,
+	COMPONENT_VJOURNAL,
+	COMPONENT_VTIMEZONE,
+	COMPONENT_VFREEBUSY,
+	/* Not supported, skipped without an event. */
+	COMPONENT_OTHER,
+};
+
+static const char *const component_names[] = {
+	[COMPONENT_VEVENT] = "VEVENT",
+	[COMPONENT_VTODO] = "VTODO",
+	[COMPONENT_VJOURNAL] = "VJOURNAL",
+	[COMPONENT_VTIMEZONE] = "VTIMEZONE",
+	[COMPONENT_VFREEBUSY] = "VFREEBUSY",
+};
+
+static uint8_t component_type(const char *name)
 {
-	size_t unfold_size = 0;
-	const char *sol = buf;
-	char *eol;
-	uint16_t total_line_len = 0, single_line_len = 0;
-
-	while (1) {
-		eol = strstr(sol, "\r\n");
-		if (!eol) {
-			return 0;
-		}
-		single_line_len = eol - sol;
-		if ((total_line_len + single_line_len)
-		    <= CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE) {
-			memcpy(prop_buf +
-			       total_line_len, sol, single_line_len);
-			total_line_len += single_line_len;
-		} else {
-			LOG_DBG("Property value overflow."
-				"Increase CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE.");
-			return 0;
-		}
-		if (!strncmp(eol, "\r\n ", strlen("\r\n "))) {
-			/* Long content line is split into multiple lines.
-			 * Copy the folded part to unfolded buffer.
-			 */
-			sol = eol + strlen("\r\n ");
-		} else {
-			/* Content line is delimited. Count parsed bytes */
-			unfold_size = eol - buf;
-			break;
+	for (size_t i = COMPONENT_VEVENT; i < ARRAY_SIZE(component_names);
+	     i++) {
+		if (!strcmp(name, component_names[i])) {
+			return i;
 		}
 	}
-	prop_buf[unfold_size] = '\0';
 
-	return unfold_size;
+	return COMPONENT_OTHER;
 }
 
-static bool parse_desc_props(const char *buf,
+static bool parse_desc_props(const char *line,
+			     size_t line_len,
 			     const char *name,
 			     size_t name_size,
 			     char *value,
 			     size_t max_value_len)
 {
 	bool ret;
-	size_t unfold_size;
-	char ical_prop_buf[CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE + 1];
-
-	unfold_size = unfold_contentline(buf, ical_prop_buf);
-	if (unfold_size <= 0) {
-		/* Property wrong format - no parameter or value. */
-		LOG_ERR("%s no value/param.", name);
-		return false;
-	}
 
-	if (ical_prop_buf[name_size] == ':') {
-		size_t value_len = unfold_size - name_size - 1;
+	if (line[name_size] == ':') {
+		size_t value_len = line_len - name_size - 1;
 
 		if (value_len <= max_value_len) {
-			memcpy(value,
-				ical_prop_buf + name_size + 1,
-				value_len);
+			memcpy(value, line + name_size + 1, value_len);
 			value[value_len] = '\0';
 			ret = true;
 		} else {
@@ -84,7 +67,7 @@ static bool parse_desc_props(const char *buf,
 			LOG_ERR("%s value overflow.", name);
 			ret = false;
 		}
-	} else if (ical_prop_buf[name_size] == ';') {
+	} else if (line[name_size] == ';') {
 		/* Does not support property parameter. */
 		LOG_ERR("%s param not supported.", name);
 		ret = false;
@@ -97,319 +80,255 @@ static bool parse_desc_props(const char *buf,
 	return ret;
 }
 
-static bool parse_datetime_props(const char *buf,
+static bool parse_datetime_props(const char *line,
+				 size_t line_len,
 				 const char *name,
 				 size_t name_size,
 				 char *value,
 				 size_t max_value_len)
 {
-	bool ret;
-	size_t unfold_size;
-	char ical_prop_buf[CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE + 1];
+	const char *dtvalue;
+	size_t value_len;
 
-	unfold_size = unfold_contentline(buf, ical_prop_buf);
-	if (unfold_size <= 0) {
-		/* Property wrong format - fail to unfold property. */
-		LOG_ERR("%s wrong format. Fail to unfold property", name);
+	if (line[name_size] != ':' && line[name_size] != ';') {
+		/* Property wrong format - no parameter or value. */
+		LOG_ERR("%s wrong format.", name);
 		return false;
 	}
 
-	if (ical_prop_buf[name_size] == ':') {
-		size_t value_len = unfold_size - name_size - 1;
+	/* Skip parameters, such as the time zone. */
+	dtvalue = strchr(line + name_size, ':');
+	if (!dtvalue) {
+		/* Property wrong format - no value. */
+		LOG_ERR("%s wrong format - no value.", name);
+		return false;
+	}
 
-		if (value_len <= max_value_len) {
-			memcpy(value,
-				ical_prop_buf + name_size + 1,
-				value_len);
-			value[value_len] = '\0';
-			ret = true;
-		} else {
-			/* Property value overflow. */
-			LOG_ERR("%s value overflow.", name);
-			ret = false;
-		}
-	} else if (ical_prop_buf[name_size] == ';') {
-		char *dtvalue;
-
-		dtvalue = strchr(ical_prop_buf, ':');
-		if (dtvalue) {
-			dtvalue = dtvalue + 1;
-			size_t value_len;
-
-			value_len = unfold_size -
-					(dtvalue - ical_prop_buf);
-			if (value_len <= max_value_len) {
-				memcpy(value, dtvalue, value_len);
-				value[value_len] = '\0';
-				ret = true;
-			} else {
-				/* Property value overflow. */
-				LOG_ERR("%s value overflow.", name);
-				ret = false;
-			}
-		} else {
-			/* Property wrong format - no value. */
-			LOG_ERR("%s wrong format - no value.", name);
-			ret = false;
-		}
-	} else {
-		/* Property wrong format - no parameter or value. */
-		LOG_ERR("%s wrong format.", name);
-		ret = false;
+	dtvalue++;
+	value_len = line_len - (dtvalue - line);
+	if (value_len > max_value_len) {
+		/* Property value overflow. */
+		LOG_ERR("%s value overflow.", name);
+		return false;
 	}
 
-	return ret;
+	memcpy(value, dtvalue, value_len);
+	value[value_len] = '\0';
+
+	return true;
 }
 
-static size_t parse_calprops(const char *buf)
+static void parse_eventprop(struct icalendar_parser *ical, const char *line,
+			    size_t line_len)
 {
-	const char *parsed = buf;
-	char *end = NULL;
-	char prop_value[CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE + 1];
-
-	parsed = strstr(parsed, "BEGIN:VCALENDAR\r\n");
-	if (parsed == NULL) {
-		return 0;
-	}
-	parsed += strlen("BEGIN:VCALENDAR\r\n");
-
-	end = strstr(parsed, "\r\nBEGIN:");
-	if (end == NULL) {
-		return 0;
-	}
-	end += strlen("\r\n");
-
-	while (parsed < end) {
-		memset(prop_value, 0, sizeof(prop_value));
-		if (!strncmp(parsed, "PRODID", 6)) {
-			if (!parse_desc_props(parsed, "PRODID", 6,
-					prop_value, sizeof(prop_value))) {
-				LOG_ERR("Wrong PRODID");
-			}
-		} else if (!strncmp(parsed, "VERSION", 7)) {
-			if (!parse_desc_props(parsed, "VERSION", 7,
-					prop_value, sizeof(prop_value))) {
-				LOG_ERR("Wrong VERSION");
-			}
+	struct ical_parser_evt *evt = &ical->evt;
+	struct ical_component *com = &evt->ical_com;
+
+	if (!strncasecmp(line, "SUMMARY", 7)) {
+		if (ical->line_overflow ||
+		    !parse_desc_props(line, line_len, "SUMMARY", 7,
+				      com->summary,
+				      CONFIG_ICAL_PARSER_SUMMARY_SIZE)) {
+			evt->error = ICAL_ERROR_SUMMARY;
+		}
+	} else if (!strncasecmp(line, "LOCATION", 8)) {
+		if (ical->line_overflow ||
+		    !parse_desc_props(line, line_len, "LOCATION", 8,
+				      com->location,
+				      CONFIG_ICAL_PARSER_LOCATION_SIZE)) {
+			evt->error = ICAL_ERROR_LOCATION;
+		}
+	} else if (!strncasecmp(line, "DESCRIPTION", 11)) {
+		if (ical->line_overflow ||
+		    !parse_desc_props(line, line_len, "DESCRIPTION", 11,
+				      com->description,
+				      CONFIG_ICAL_PARSER_DESCRIPTION_SIZE)) {
+			evt->error = ICAL_ERROR_DESCRIPTION;
+		}
+	} else if (!strncasecmp(line, "DTSTART", 7)) {
+		if (ical->line_overflow ||
+		    !parse_datetime_props(line, line_len, "DTSTART", 7,
+					  com->dtstart,
+					  CONFIG_ICAL_PARSER_DTSTART_SIZE)) {
+			evt->error = ICAL_ERROR_DTSTART;
+		}
+	} else if (!strncasecmp(line, "DTEND", 5)) {
+		if (ical->line_overflow ||
+		    !parse_datetime_props(line, line_len, "DTEND", 5,
+					  com->dtend,
+					  CONFIG_ICAL_PARSER_DTEND_SIZE)) {
+			evt->error = ICAL_ERROR_DTEND;
 		}
-		parsed = strstr(parsed, "\r\n");
-		parsed += strlen("\r\n");
 	}
-
-	return (parsed - buf);
 }
 
-static size_t parse_eventprop(const char *buf,
-			      struct ical_parser_evt *evt)
+static void component_begin(struct icalendar_parser *ical, const char *name)
 {
-	const char *parsed = buf;
-	char *com_end;
-
-	if (strncmp(buf, "BEGIN:VEVENT\r\n", strlen("BEGIN:VEVENT\r\n"))) {
-		return 0;
+	if (ical->component != COMPONENT_NONE) {
+		/* Subcomponent, such as VALARM, is skipped. */
+		ical->depth++;
+		return;
 	}
 
-	com_end = strstr(buf, "END:VEVENT\r\n");
-	if (com_end == NULL) {
-		return 0;
-	}
+	ical->component = component_type(name);
+	ical->depth = 0;
 
-	evt->id = ICAL_EVT_VEVENT;
-	evt->error = ICAL_ERROR_NONE;
-	com_end += strlen("END:VEVENT\r\n");
-	while (parsed < com_end) {
-		if (!strncasecmp(parsed, "SUMMARY", 7)) {
-			if (!parse_desc_props(
-				parsed, "SUMMARY", 7,
-				evt->ical_com.summary,
-				CONFIG_ICAL_PARSER_SUMMARY_SIZE)) {
-				evt->error = ICAL_ERROR_SUMMARY;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed, "LOCATION", 8)) {
-			if (!parse_desc_props(
-				parsed, "LOCATION", 8,
-				evt->ical_com.location,
-				CONFIG_ICAL_PARSER_LOCATION_SIZE)) {
-				evt->error = ICAL_ERROR_LOCATION;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed, "DESCRIPTION", 11)) {
-			if (!parse_desc_props(
-				parsed, "DESCRIPTION", 11,
-				evt->ical_com.description,
-				CONFIG_ICAL_PARSER_DESCRIPTION_SIZE)) {
-				evt->error = ICAL_ERROR_DESCRIPTION;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed, "DTSTART", 7)) {
-			if (!parse_datetime_props(
-				parsed, "DTSTART", 7,
-				evt->ical_com.dtstart,
-				CONFIG_ICAL_PARSER_DTSTART_SIZE)) {
-				evt->error = ICAL_ERROR_DTSTART;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed,
-					"DTEND", 5)) {
-			if (!parse_datetime_props(
-				parsed, "DTEND", 5,
-				evt->ical_com.dtend,
-				CONFIG_ICAL_PARSER_DTEND_SIZE)) {
-				evt->error = ICAL_ERROR_DTEND;
-				parsed = com_end;
-			}
-		}
-
-		/* Move parsed pointer to end of line break */
-		parsed = strstr(parsed, "\r\n") + 2;
+	if (ical->component == COMPONENT_OTHER) {
+		return;
 	}
 
-	return parsed - buf;
+	memset(&ical->evt, 0, sizeof(ical->evt));
+	ical->evt.id = ICAL_EVT_VEVENT + ical->component - COMPONENT_VEVENT;
+	ical->evt.error = (ical->component == COMPONENT_VEVENT) ?
+			  ICAL_ERROR_NONE : ICAL_ERROR_COM_NOT_SUPPORTED;
 }
 
-static size_t parse_todoprop(const char *buf,
-				struct ical_parser_evt *evt)
+/* Returns the callback result when a component is complete, 0 otherwise. */
+static int component_end(struct icalendar_parser *ical)
 {
-	const char *parsed = buf;
-	char *com_end;
+	uint8_t component = ical->component;
 
-	com_end = strstr(buf, "END:VTODO\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VTODO\r\n");
+	if (ical->depth > 0) {
+		ical->depth--;
+		return 0;
 	}
-	evt->id = ICAL_EVT_VTODO;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
 
-	return parsed - buf;
-}
+	ical->component = COMPONENT_NONE;
 
-static size_t parse_jourprop(const char *buf,
-				struct ical_parser_evt *evt)
-{
-	const char *parsed = buf;
-	char *com_end;
-
-	com_end = strstr(buf, "END:VJOURNAL\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VJOURNAL\r\n");
+	if (component == COMPONENT_OTHER) {
+		return 0;
 	}
-	evt->id = ICAL_EVT_VJOURNAL;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
 
-	return parsed - buf;
+	return ical->callback(&ical->evt);
 }
 
-static size_t parse_fbprop(const char *buf, struct ical_parser_evt *evt)
+/* Handle one unfolded content line.
+ * Reference: RFC 5545 3.1 Content Lines
+ */
+static int parse_contentline(struct icalendar_parser *ical)
 {
-	const char *parsed = buf;
-	char *com_end;
+	char *line = ical->buf;
+	size_t line_len = ical->offset;
+	int ret = 0;
+
+	line[line_len] = '\0';
 
-	com_end = strstr(buf, "END:VFREEBUSY\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VFREEBUSY\r\n");
+	/* Check begin of iCalendar object delimiter
+	 * Reference: RFC 5545 3.4 iCalendar Object
+	 */
+	if (!ical->icalobject_begin) {
+		if (!strcmp(line, "BEGIN:VCALENDAR")) {
+			LOG_DBG("Found a calendar stream");
+			ical->icalobject_begin = true;
+			ical->component = COMPONENT_NONE;
+		}
+	} else if (!strncmp(line, "BEGIN:", 6)) {
+		component_begin(ical, line + 6);
+	} else if (!strncmp(line, "END:", 4)) {
+		if (ical->component != COMPONENT_NONE) {
+			ret = component_end(ical);
+		} else if (!strcmp(line + 4, "VCALENDAR")) {
+			ical->icalobject_begin = false;
+		}
+	} else if (ical->component == COMPONENT_VEVENT && ical->depth == 0 &&
+		   ical->evt.error == ICAL_ERROR_NONE) {
+		parse_eventprop(ical, line, line_len);
 	}
-	evt->id = ICAL_EVT_VFREEBUSY;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
 
-	return parsed - buf;
+	ical->offset = 0;
+	ical->line_overflow = false;
+
+	return ret;
 }
 
-static size_t parse_tzprop(const char *buf, struct ical_parser_evt *evt)
+static void line_append(struct icalendar_parser *ical, char c)
 {
-	const char *parsed = buf;
-	char *com_end;
-
-	com_end = strstr(buf, "END:VTIMEZONE\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VTIMEZONE\r\n");
+	if (ical->offset < CONFIG_ICAL_PARSER_BUFFER_SIZE) {
+		ical->buf[ical->offset++] = c;
+	} else {
+		ical->line_overflow = true;
 	}
-	evt->id = ICAL_EVT_VTIMEZONE;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
-
-	return parsed - buf;
 }
 
-static size_t parse_component(char *buf, struct ical_parser_evt *evt)
+size_t ical_parser_parse(struct icalendar_parser *ical,
+			const char *data, size_t len)
 {
-	char *com_begin = buf;
-	size_t ret = 0;
-
-	/* Search begin of component */
-	if (!strncmp(com_begin, "BEGIN:VEVENT\r\n", 14)) {
-		ret += parse_eventprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VTODO\r\n", 13)) {
-		ret += parse_todoprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VJOURNAL\r\n", 16)) {
-		ret += parse_jourprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VFREEBUSY\r\n", 17)) {
-		ret += parse_fbprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VTIMEZONE\r\n", 17)) {
-		ret += parse_tzprop(com_begin, evt);
-	}
+	size_t i;
 
-	return ret;
-}
+	for (i = 0; i < len; i++) {
+		char c = data[i];
 
-static size_t parse_icalbody(char *buf,
-				icalendar_parser_callback_t callback)
-{
-	size_t parsed_bytes = 0, parsed_offset = 0;
+		if (ical->line_end) {
+			ical->line_end = false;
+
+			/* Long content line is split into multiple lines.
+			 * Drop the line break and the leading white space.
+			 */
+			if (c == ' ' || c == '\t') {
+				continue;
+			}
+
+			if (parse_contentline(ical)) {
+				/* Stopped by the application. */
+				return i;
+			}
+		}
+
+		if (c == '\n') {
+			/* Also accept bare line feeds as line breaks. */
+			ical->cr = false;
+			ical->line_end = true;
+			continue;
+		}
 
-	do {
-		struct ical_parser_evt evt;
+		if (ical->cr) {
+			ical->cr = false;
+			line_append(ical, '\r');
+		}
 
-		parsed_bytes = parse_component(buf + parsed_offset, &evt);
-		parsed_offset += parsed_bytes;
-		if (parsed_bytes > 0) {
-			callback(&evt);
+		if (c == '\r') {
+			ical->cr = true;
+			continue;
 		}
-	} while (parsed_bytes > 0);
 
-	return parsed_offset;
+		line_append(ical, c);
+	}
+
+	return len;
 }
 
-size_t ical_parser_parse(struct icalendar_parser *ical,
-			const char *data, size_t len)
+int ical_parser_finish(struct icalendar_parser *ical)
 {
-	size_t parsed_offset = 0;
+	bool complete;
 
-	if (CONFIG_ICAL_PARSER_BUFFER_SIZE < (ical->offset + len)) {
-		return -ENOBUFS;
+	if (ical == NULL) {
+		return -EINVAL;
 	}
 
-	memcpy(ical->buf + ical->offset, data, len);
-	ical->buf[ical->offset + len] = '\0';
-
-	/* Check begin of iCalendar object delimiter
-	 * Reference: RFC 5545 3.4 iCalendar Object
+	/* The last line may end without a line break. A carriage return
+	 * without the line feed still ends it.
 	 */
-	if (!ical->icalobject_begin) {
-		/* The body of the iCalendar object consists of
-		 * a sequence of calendar properties and
-		 * one or more calendar components.
-		 *
-		 * Reference: RFC 5545 3.6 Calendar Components
-		 */
-		parsed_offset += parse_calprops(ical->buf);
-		if (parsed_offset > 0) {
-			LOG_DBG("Found a calendar stream");
-			ical->icalobject_begin = true;
-		}
+	if (ical->line_end || ical->cr || ical->offset > 0) {
+		(void)parse_contentline(ical);
 	}
 
-	/* If we got a calendar property, start parsing calendar body. */
-	if (ical->icalobject_begin) {
-		parsed_offset += parse_icalbody(ical->buf + parsed_offset,
-						ical->callback);
-	}
+	complete = !ical->icalobject_begin;
 
-	if (parsed_offset) {
-		ical->offset = ical->offset + len - parsed_offset;
-		memcpy(ical->buf, ical->buf + parsed_offset, ical->offset);
+	/* Get ready for the next stream. */
+	ical->icalobject_begin = false;
+	ical->offset = 0;
+	ical->line_overflow = false;
+	ical->cr = false;
+	ical->line_end = false;
+	ical->component = COMPONENT_NONE;
+	ical->depth = 0;
+
+	if (!complete) {
+		LOG_WRN("Calendar stream ended before END:VCALENDAR");
+		return -ENODATA;
 	}
 
-	return parsed_offset;
+	return 0;
 }
 
 int ical_parser_init(struct icalendar_parser *ical,
@@ -422,6 +341,11 @@ int ical_parser_init(struct icalendar_parser *ical,
 	ical->callback = callback;
 	ical->icalobject_begin = false;
 	ical->offset = 0;
+	ical->line_overflow = false;
+	ical->cr = false;
+	ical->line_end = false;
+	ical->component = COMPONENT_NONE;
+	ical->depth = 0;
 
 	return 0;
 }
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NRF_CLOUD_TOPIC_ROUTER_H_
+#define NRF_CLOUD_TOPIC_ROUTER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr.h>
+
+/**@brief Topic to route, and the identifier it is routed to. */
+struct nrf_cloud_topic_route {
+	/** Topic string, not necessarily null-terminated. */
+	const char *topic;
+	/** Length of the topic string. */
+	size_t len;
+	/** Identifier returned when the topic is matched. */
+	uint32_t id;
+};
+
+/**@brief Topic routing table.
+ *
+ * The topics are kept in an open addressing hash table, so matching a topic
+ * takes a hash of the topic and a bounded number of comparisons, regardless
+ * of the number of routes.
+ */
+struct nrf_cloud_topic_router {
+	/** Routes, owned by the user. */
+	const struct nrf_cloud_topic_route *routes;
+	/** Hash table slots, holding route index plus one. */
+	uint16_t *slots;
+	/** Number of hash table slots. */
+	size_t slot_cnt;
+	/** Largest distance of a route from its hash table slot. */
+	size_t max_probe;
+};
+
+/**@brief Build a routing table.
+ *
+ * The routes must remain valid as long as the router is used.
+ *
+ * @param[out] router Router to build.
+ * @param[in] routes Routes to add.
+ * @param[in] route_cnt Number of routes.
+ * @param[in] slots Hash table storage. Twice the number of routes is
+ *                  recommended.
+ * @param[in] slot_cnt Number of elements in @p slots, must be larger than
+ *                     @p route_cnt.
+ *
+ * @retval 0 If the table was built.
+ * @retval -ENOMEM If there are not enough slots.
+ * @retval -EEXIST If a topic is added twice.
+ */
+int nrf_cloud_topic_router_init(struct nrf_cloud_topic_router *router,
+				const struct nrf_cloud_topic_route *routes,
+				size_t route_cnt, uint16_t *slots,
+				size_t slot_cnt);
+
+/**@brief Match a topic against the routing table.
+ *
+ * @param[in] router Router built by @ref nrf_cloud_topic_router_init.
+ * @param[in] topic Topic string, not necessarily null-terminated.
+ * @param[in] len Length of the topic string.
+ * @param[out] id Identifier of the matched route.
+ *
+ * @retval true If the topic matched one of the routes.
+ */
+bool nrf_cloud_topic_router_match(const struct nrf_cloud_topic_router *router,
+				  const char *topic, size_t len, uint32_t *id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NRF_CLOUD_TOPIC_ROUTER_H_ */
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include "nrf_cloud_topic_router.h"
+
+#include <string.h>
+
+static size_t topic_hash(const char *topic, size_t len)
+{
+	/* FNV-1a */
+	uint32_t hash = 2166136261U;
+
+	for (size_t i = 0; i < len; i++) {
+		hash = (hash ^ (uint8_t)topic[i]) * 16777619U;
+	}
+
+	return hash;
+}
+
+static bool route_match(const struct nrf_cloud_topic_route *route,
+			const char *topic, size_t len)
+{
+	return (route->len == len) && !memcmp(route->topic, topic, len);
+}
+
+int nrf_cloud_topic_router_init(struct nrf_cloud_topic_router *router,
+				const struct nrf_cloud_topic_route *routes,
+				size_t route_cnt, uint16_t *slots,
+				size_t slot_cnt)
+{
+	__ASSERT_NO_MSG(router != NULL);
+	__ASSERT_NO_MSG(slots != NULL);
+
+	if ((slot_cnt <= route_cnt) || (route_cnt >= UINT16_MAX)) {
+		return -ENOMEM;
+	}
+
+	router->routes = routes;
+	router->slots = slots;
+	router->slot_cnt = slot_cnt;
+	router->max_probe = 0;
+
+	memset(slots, 0, slot_cnt * sizeof(slots[0]));
+
+	for (size_t i = 0; i < route_cnt; i++) {
+		size_t slot = topic_hash(routes[i].topic, routes[i].len) %
+			      slot_cnt;
+		size_t probe = 0;
+
+		while (slots[slot]) {
+			if (route_match(&routes[slots[slot] - 1],
+					routes[i].topic, routes[i].len)) {
+				return -EEXIST;
+			}
+
+			slot = (slot + 1) % slot_cnt;
+			probe++;
+		}
+
+		slots[slot] = i + 1;
+		router->max_probe = MAX(router->max_probe, probe);
+	}
+
+	return 0;
+}
+
+bool nrf_cloud_topic_router_match(const struct nrf_cloud_topic_router *router,
+				  const char *topic, size_t len, uint32_t *id)
+{
+	__ASSERT_NO_MSG(router != NULL);
+	__ASSERT_NO_MSG(id != NULL);
+
+	if (!router->slot_cnt) {
+		return false;
+	}
+
+	size_t slot = topic_hash(topic, len) % router->slot_cnt;
+
+	/* No route is further than max_probe from its slot. */
+	for (size_t probe = 0; probe <= router->max_probe; probe++) {
+		uint16_t index = router->slots[slot];
+
+		if (!index) {
+			return false;
+		}
+
+		if (route_match(&router->routes[index - 1], topic, len)) {
+			*id = router->routes[index - 1].id;
+			return true;
+		}
+
+		slot = (slot + 1) % router->slot_cnt;
+	}
+
+	return false;
+}
@@ -6,6 +6,7 @@
 
 #include "nrf_cloud_transport.h"
 #include "nrf_cloud_mem.h"
+#include "nrf_cloud_topic_router.h"
 
 #include <zephyr.h>
 #include <stdio.h>
@@ -106,9 +107,6 @@ static bool initialized;
 #define NCT_CC_SUBSCRIBE_ID 1234
 #define NCT_DC_SUBSCRIBE_ID 8765
 
-#define NCT_RX_LIST 0
-#define NCT_TX_LIST 1
-
 /* Forward declaration of the event handler registered with MQTT. */
 static void nct_mqtt_evt_handler(struct mqtt_client *client,
 				 const struct mqtt_evt *evt);
@@ -175,6 +173,13 @@ static uint32_t const nct_cc_rx_opcode_map[] = {
 	NCT_CC_OPCODE_UPDATE_ACCEPT_RSP
 };
 
+/* Routing table of the control channel topics to their opcodes,
+ * built when the topics are populated.
+ */
+static struct nrf_cloud_topic_route nct_cc_rx_routes[ARRAY_SIZE(nct_cc_rx_list)];
+static uint16_t nct_cc_rx_slots[2 * ARRAY_SIZE(nct_cc_rx_list) + 1];
+static struct nrf_cloud_topic_router nct_cc_rx_router;
+
 /* Internal routine to reset data endpoint information. */
 static void dc_endpoint_reset(void)
 {
@@ -257,39 +262,36 @@ static uint32_t dc_send(const struct nct_dc_data *dc_data, uint8_t qos)
 	return mqtt_publish(&nct.client, &publish);
 }
 
-static bool strings_compare(const char *s1, const char *s2, uint32_t s1_len,
-			    uint32_t s2_len)
-{
-	return (strncmp(s1, s2, MIN(s1_len, s2_len))) ? false : true;
-}
-
 /* Verify if the topic is a control channel topic or not. */
-static bool control_channel_topic_match(uint32_t list_id,
-					const struct mqtt_topic *topic,
+static bool control_channel_topic_match(const struct mqtt_topic *topic,
 					enum nct_cc_opcode *opcode)
 {
-	struct mqtt_topic *topic_list;
-	uint32_t list_size;
-
-	if (list_id == NCT_RX_LIST) {
-		topic_list = (struct mqtt_topic *)nct_cc_rx_list;
-		list_size = ARRAY_SIZE(nct_cc_rx_list);
-	} else if (list_id == NCT_TX_LIST) {
-		topic_list = (struct mqtt_topic *)nct_cc_tx_list;
-		list_size = ARRAY_SIZE(nct_cc_tx_list);
-	} else {
+	uint32_t id;
+
+	if (!nrf_cloud_topic_router_match(&nct_cc_rx_router,
+					  (const char *)topic->topic.utf8,
+					  topic->topic.size, &id)) {
 		return false;
 	}
 
-	for (uint32_t index = 0; index < list_size; index++) {
-		if (strings_compare(
-			    topic->topic.utf8, topic_list[index].topic.utf8,
-			    topic->topic.size, topic_list[index].topic.size)) {
-			*opcode = nct_cc_rx_opcode_map[index];
-			return true;
-		}
+	*opcode = id;
+	return true;
+}
+
+static int nct_cc_rx_router_build(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(nct_cc_rx_list); i++) {
+		nct_cc_rx_routes[i].topic =
+			(const char *)nct_cc_rx_list[i].topic.utf8;
+		nct_cc_rx_routes[i].len = nct_cc_rx_list[i].topic.size;
+		nct_cc_rx_routes[i].id = nct_cc_rx_opcode_map[i];
 	}
-	return false;
+
+	return nrf_cloud_topic_router_init(&nct_cc_rx_router,
+					   nct_cc_rx_routes,
+					   ARRAY_SIZE(nct_cc_rx_routes),
+					   nct_cc_rx_slots,
+					   ARRAY_SIZE(nct_cc_rx_slots));
 }
 
 /* Function to get the client id */
@@ -380,7 +382,7 @@ static int nct_topics_populate(void)
 	}
 	LOG_DBG("shadow_get_topic: %s", log_strdup(shadow_get_topic));
 
-	return 0;
+	return nct_cc_rx_router_build();
 }
 
 /* Provisions root CA certificate using modem_key_mgmt API */
@@ -739,7 +741,7 @@ static void nct_mqtt_evt_handler(struct mqtt_client *const mqtt_client,
 		/* If the data arrives on one of the subscribed control channel
 		 * topic. Then we notify the same.
 		 */
-		if (control_channel_topic_match(NCT_RX_LIST, &p->message.topic,
+		if (control_channel_topic_match(&p->message.topic,
 						&cc.opcode)) {
 			cc.id = p->message_id;
 			cc.data.ptr = nct.payload_buf;
@@ -38,6 +38,61 @@ int nrf_rpc_os_init(nrf_rpc_os_work_t callback);
 
 void nrf_rpc_os_thread_pool_send(const uint8_t *data, size_t len);
 
+/** @brief Lanes of the thread pool, from the most to the least urgent. */
+enum nrf_rpc_os_lane {
+	NRF_RPC_OS_LANE_HIGH,
+	NRF_RPC_OS_LANE_NORMAL,
+	NRF_RPC_OS_LANE_LOW,
+
+	NRF_RPC_OS_LANE_COUNT
+};
+
+/** @brief Statistics of a thread pool lane. */
+struct nrf_rpc_os_lane_stats {
+	/** Number of packets waiting in the lane. */
+	uint32_t depth;
+	/** Highest number of packets that waited in the lane. */
+	uint32_t depth_max;
+	/** Number of packets taken from the lane. */
+	uint32_t packets;
+	/** Number of packets taken by threads of a more urgent lane. */
+	uint32_t stolen;
+	/** Total time that the packets waited, in microseconds. */
+	uint64_t wait_total_us;
+	/** Longest time that a packet waited, in microseconds. */
+	uint32_t wait_max_us;
+};
+
+#if defined(CONFIG_NRF_RPC_THREAD_POOL_LANES)
+
+/**
+ * @brief Assign a lane to a group.
+ *
+ * Commands and events of the group are queued in the given lane.
+ *
+ * @param group_id Identifier of the group that nRF RPC puts in the packet
+ *                 header.
+ * @param lane     Lane of the group.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If the group identifier or the lane is out of range.
+ */
+int nrf_rpc_os_lane_set(uint8_t group_id, enum nrf_rpc_os_lane lane);
+
+/**
+ * @brief Get the statistics of a lane.
+ *
+ * @param lane  Lane.
+ * @param stats Statistics since the last reset.
+ */
+void nrf_rpc_os_lane_stats_get(enum nrf_rpc_os_lane lane,
+			       struct nrf_rpc_os_lane_stats *stats);
+
+/** @brief Reset the statistics of all lanes, except the current depth. */
+void nrf_rpc_os_lane_stats_reset(void);
+
+#endif /* defined(CONFIG_NRF_RPC_THREAD_POOL_LANES) */
+
 static inline int nrf_rpc_os_event_init(struct nrf_rpc_os_event *event)
 {
 	return k_sem_init(&event->sem, 0, 1);
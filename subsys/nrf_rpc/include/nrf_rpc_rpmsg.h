@@ -36,6 +36,57 @@ static inline void nrf_rpc_tr_free_rx_buf(const uint8_t *buf)
 {
 }
 
+#if defined(CONFIG_NRF_RPC_TR_RPMSG_NOCOPY)
+
+/** @brief Transmission counters of the zero-copy transport. */
+struct nrf_rpc_tr_stats {
+	/** Number of rpmsg frames sent. */
+	uint32_t frames;
+	/** Number of packets sent. */
+	uint32_t packets;
+	/** Number of buffers freed without being sent. */
+	uint32_t dropped;
+};
+
+/**
+ * @brief Get a buffer for a packet in rpmsg shared memory.
+ *
+ * Packets allocated by several threads at the same time, or within
+ * CONFIG_NRF_RPC_TR_RPMSG_BATCH_WINDOW microseconds, share one rpmsg frame.
+ *
+ * Unlike the buffers of the copying transport, which are allocated on the
+ * stack, the buffer can not be got if the packet does not fit in the payload
+ * of an rpmsg buffer, or if the rpmsg layer fails. The caller must check for
+ * NULL, including callers of nrf_rpc_tr_alloc_tx_buf().
+ *
+ * @param len Maximum length of the packet.
+ *
+ * @return Pointer to the buffer, or NULL if the packet does not fit in an
+ *         rpmsg buffer or no rpmsg buffer can be got.
+ */
+uint8_t *nrf_rpc_tr_tx_buf_get(size_t len);
+
+/**
+ * @brief Free a buffer from @ref nrf_rpc_tr_tx_buf_get without sending it.
+ *
+ * @param buf Buffer to free.
+ */
+void nrf_rpc_tr_tx_buf_drop(uint8_t *buf);
+
+/**
+ * @brief Get the transmission counters.
+ *
+ * @param[out] stats Counters.
+ */
+void nrf_rpc_tr_stats_get(struct nrf_rpc_tr_stats *stats);
+
+#define nrf_rpc_tr_alloc_tx_buf(buf, len)				       \
+	(*(buf) = nrf_rpc_tr_tx_buf_get(len))
+
+#define nrf_rpc_tr_free_tx_buf(buf) nrf_rpc_tr_tx_buf_drop(buf)
+
+#else
+
 #define nrf_rpc_tr_alloc_tx_buf(buf, len)				       \
 	uint32_t _nrf_rpc_tr_buf_vla[(sizeof(uint32_t) - 1 + (len)) /	       \
 				     sizeof(uint32_t)];			       \
@@ -43,6 +94,8 @@ static inline void nrf_rpc_tr_free_rx_buf(const uint8_t *buf)
 
 #define nrf_rpc_tr_free_tx_buf(buf)
 
+#endif /* CONFIG_NRF_RPC_TR_RPMSG_NOCOPY */
+
 int nrf_rpc_tr_send(uint8_t *buf, size_t len);
 
 #ifdef __cplusplus
@@ -88,6 +88,28 @@ void rp_ll_endpoint_uninit(struct rp_ll_endpoint *endpoint);
 int rp_ll_send(struct rp_ll_endpoint *endpoint, const uint8_t *buf,
 	       size_t buf_len);
 
+/** @brief Gets a shared memory buffer to build a packet in.
+ *
+ * The buffer must be passed to @ref rp_ll_send_nocopy. The function waits
+ * until a buffer is available.
+ *
+ * @param endpoint endpoint to use
+ * @param size     returns the size of the buffer
+ *
+ * @return Pointer to the buffer or NULL on failure.
+ */
+uint8_t *rp_ll_tx_buf_get(struct rp_ll_endpoint *endpoint, size_t *size);
+
+/** @brief Sends a packet built in a buffer from @ref rp_ll_tx_buf_get
+ * without copying it.
+ *
+ * @param endpoint endpoint to use
+ * @param buf      buffer from @ref rp_ll_tx_buf_get
+ * @param buf_len  length of the packet in @a buf
+ */
+int rp_ll_send_nocopy(struct rp_ll_endpoint *endpoint, uint8_t *buf,
+		      size_t buf_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,6 +7,9 @@
 #define NRF_RPC_LOG_MODULE NRF_RPC_OS
 #include <nrf_rpc_log.h>
 
+#include <string.h>
+#include <spinlock.h>
+
 #include "nrf_rpc_os.h"
 
 /* Maximum number of remote thread that this implementation allows. */
@@ -19,15 +22,70 @@
 	(~(((atomic_val_t)1 << (8 * sizeof(atomic_val_t) -		       \
 				CONFIG_NRF_RPC_CMD_CTX_POOL_SIZE)) - 1))
 
+#if defined(CONFIG_NRF_RPC_THREAD_POOL_LANES)
+#define LANE_COUNT NRF_RPC_OS_LANE_COUNT
+#define LANE_QUEUE_SIZE CONFIG_NRF_RPC_THREAD_POOL_LANE_QUEUE_SIZE
+#else
+#define LANE_COUNT 1
+#define LANE_QUEUE_SIZE 2
+#endif
+
+/* Index of the destination group identifier in the nRF RPC packet header. */
+#define PACKET_GROUP_ID_IDX 4
+
 struct pool_start_msg {
 	const uint8_t *data;
 	size_t len;
+	/* Cycle count when the packet was queued. */
+	uint32_t queued;
+};
+
+struct lane {
+	struct pool_start_msg buf[LANE_QUEUE_SIZE];
+	uint8_t head;
+	uint8_t count;
+	/* Free entries in the queue. */
+	struct k_sem free;
+	struct nrf_rpc_os_lane_stats stats;
+};
+
+struct pool_thread {
+	struct k_thread thread;
+	struct k_sem wake;
+	uint8_t lane;
+	bool idle;
 };
 
 static nrf_rpc_os_work_t thread_pool_callback;
 
-static struct pool_start_msg pool_start_msg_buf[2];
-static struct k_msgq pool_start_msg;
+/* Protects the lane queues and the idle state of the pool threads. */
+static struct k_spinlock pool_lock;
+static struct lane lanes[LANE_COUNT];
+/* Number of idle threads of each lane. */
+static uint8_t idle_count[LANE_COUNT];
+
+#if defined(CONFIG_NRF_RPC_THREAD_POOL_LANES)
+static uint8_t group_lanes[CONFIG_NRF_RPC_THREAD_POOL_LANE_GROUPS] = {
+	[0 ... CONFIG_NRF_RPC_THREAD_POOL_LANE_GROUPS - 1] =
+		NRF_RPC_OS_LANE_NORMAL
+};
+
+BUILD_ASSERT(CONFIG_NRF_RPC_THREAD_POOL_HIGH_THREADS +
+	     CONFIG_NRF_RPC_THREAD_POOL_LOW_THREADS <
+	     CONFIG_NRF_RPC_THREAD_POOL_SIZE,
+	     "No thread left in the thread pool for the normal lane");
+
+/* The high and low lanes run one priority above and below the normal lane,
+ * and all of them must stay preemptible.
+ */
+BUILD_ASSERT(CONFIG_NRF_RPC_THREAD_PRIORITY > 0,
+	     "CONFIG_NRF_RPC_THREAD_PRIORITY leaves no priority for the high "
+	     "lane");
+BUILD_ASSERT(CONFIG_NRF_RPC_THREAD_PRIORITY + 1 <
+	     CONFIG_NUM_PREEMPT_PRIORITIES,
+	     "CONFIG_NRF_RPC_THREAD_PRIORITY leaves no priority for the low "
+	     "lane");
+#endif
 
 static struct k_sem context_reserved;
 static atomic_t context_mask;
@@ -40,7 +98,7 @@ static K_THREAD_STACK_ARRAY_DEFINE(pool_stacks,
 	CONFIG_NRF_RPC_THREAD_POOL_SIZE,
 	CONFIG_NRF_RPC_THREAD_STACK_SIZE);
 
-static struct k_thread pool_threads[CONFIG_NRF_RPC_THREAD_POOL_SIZE];
+static struct pool_thread pool_threads[CONFIG_NRF_RPC_THREAD_POOL_SIZE];
 
 BUILD_ASSERT(CONFIG_NRF_RPC_CMD_CTX_POOL_SIZE > 0,
 	     "CONFIG_NRF_RPC_CMD_CTX_POOL_SIZE must be greaten than zero");
@@ -49,12 +107,149 @@ BUILD_ASSERT(CONFIG_NRF_RPC_CMD_CTX_POOL_SIZE <= 8 * sizeof(atomic_val_t),
 BUILD_ASSERT(sizeof(uint32_t) == sizeof(atomic_val_t),
 	     "Only atomic_val_t is implemented that is the same as uint32_t");
 
+static uint8_t thread_lane(int index)
+{
+#if defined(CONFIG_NRF_RPC_THREAD_POOL_LANES)
+	if (index < CONFIG_NRF_RPC_THREAD_POOL_HIGH_THREADS) {
+		return NRF_RPC_OS_LANE_HIGH;
+	} else if (index >= CONFIG_NRF_RPC_THREAD_POOL_SIZE -
+			    CONFIG_NRF_RPC_THREAD_POOL_LOW_THREADS) {
+		return NRF_RPC_OS_LANE_LOW;
+	}
+
+	return NRF_RPC_OS_LANE_NORMAL;
+#else
+	return 0;
+#endif
+}
+
+static int lane_priority(uint8_t lane)
+{
+#if defined(CONFIG_NRF_RPC_THREAD_POOL_LANES)
+	return CONFIG_NRF_RPC_THREAD_PRIORITY + lane - NRF_RPC_OS_LANE_NORMAL;
+#else
+	return CONFIG_NRF_RPC_THREAD_PRIORITY;
+#endif
+}
+
+static uint8_t packet_lane(const uint8_t *data, size_t len)
+{
+#if defined(CONFIG_NRF_RPC_THREAD_POOL_LANES)
+	if (len > PACKET_GROUP_ID_IDX &&
+	    data[PACKET_GROUP_ID_IDX] < ARRAY_SIZE(group_lanes)) {
+		return group_lanes[data[PACKET_GROUP_ID_IDX]];
+	}
+
+	return NRF_RPC_OS_LANE_NORMAL;
+#else
+	return 0;
+#endif
+}
+
+/* Take the packet that the thread should run next. A thread serves its own
+ * lane first. It takes work from less urgent lanes only if another thread
+ * of its lane stays idle, so that a burst of slow work in those lanes never
+ * occupies all threads of a more urgent lane. Must be called with the pool
+ * lock held.
+ */
+static bool pool_take(struct pool_thread *thread, struct pool_start_msg *msg,
+		      uint8_t *lane_out)
+{
+	struct lane *lane;
+	uint32_t wait;
+
+	for (uint8_t i = thread->lane; i < LANE_COUNT; i++) {
+		lane = &lanes[i];
+
+		if (lane->count == 0) {
+			continue;
+		}
+
+		if (i != thread->lane) {
+			if (idle_count[thread->lane] == 0) {
+				return false;
+			}
+
+			lane->stats.stolen++;
+		}
+
+		*msg = lane->buf[lane->head];
+		lane->head = (lane->head + 1) % LANE_QUEUE_SIZE;
+		lane->count--;
+
+		wait = k_cyc_to_us_floor32(k_cycle_get_32() - msg->queued);
+		lane->stats.depth = lane->count;
+		lane->stats.packets++;
+		lane->stats.wait_total_us += wait;
+		lane->stats.wait_max_us = MAX(lane->stats.wait_max_us, wait);
+
+		*lane_out = i;
+
+		return true;
+	}
+
+	return false;
+}
+
+/* Find an idle thread that can take a packet from the lane and mark it busy.
+ * Must be called with the pool lock held.
+ */
+static struct pool_thread *pool_wake(uint8_t lane)
+{
+	struct pool_thread *thread;
+	int i;
+
+	for (i = lane; i >= 0; i--) {
+		/* Threads of more urgent lanes keep one thread idle. */
+		if (idle_count[i] > (i == lane ? 0 : 1)) {
+			break;
+		}
+	}
+
+	if (i < 0) {
+		/* Taken by the next thread that finishes its work. */
+		return NULL;
+	}
+
+	for (size_t j = 0; j < ARRAY_SIZE(pool_threads); j++) {
+		thread = &pool_threads[j];
+
+		if (thread->idle && thread->lane == i) {
+			thread->idle = false;
+			idle_count[i]--;
+			return thread;
+		}
+	}
+
+	return NULL;
+}
+
 static void thread_pool_entry(void *p1, void *p2, void *p3)
 {
+	struct pool_thread *thread = p1;
 	struct pool_start_msg msg;
+	k_spinlock_key_t key;
+	uint8_t lane;
 
 	do {
-		k_msgq_get(&pool_start_msg, &msg, K_FOREVER);
+		key = k_spin_lock(&pool_lock);
+
+		if (!pool_take(thread, &msg, &lane)) {
+			thread->idle = true;
+			idle_count[thread->lane]++;
+			k_spin_unlock(&pool_lock, key);
+
+			k_sem_take(&thread->wake, K_FOREVER);
+			continue;
+		}
+
+		k_spin_unlock(&pool_lock, key);
+		k_sem_give(&lanes[lane].free);
+
+		/* Work taken from another lane runs at the priority of that
+		 * lane.
+		 */
+		k_thread_priority_set(k_current_get(), lane_priority(lane));
 		thread_pool_callback(msg.data, msg.len);
 	} while (1);
 }
@@ -82,16 +277,29 @@ int nrf_rpc_os_init(nrf_rpc_os_work_t callback)
 
 	atomic_set(&context_mask, CONTEXT_MASK_INIT_VALUE);
 
-	k_msgq_init(&pool_start_msg, (char *)pool_start_msg_buf,
-		    sizeof(struct pool_start_msg),
-		    ARRAY_SIZE(pool_start_msg_buf));
+	for (i = 0; i < LANE_COUNT; i++) {
+		err = k_sem_init(&lanes[i].free, LANE_QUEUE_SIZE,
+				 LANE_QUEUE_SIZE);
+		if (err < 0) {
+			return err;
+		}
+	}
 
 	for (i = 0; i < CONFIG_NRF_RPC_THREAD_POOL_SIZE; i++) {
-		k_thread_create(&pool_threads[i], pool_stacks[i],
+		struct pool_thread *thread = &pool_threads[i];
+
+		thread->lane = thread_lane(i);
+
+		err = k_sem_init(&thread->wake, 0, 1);
+		if (err < 0) {
+			return err;
+		}
+
+		k_thread_create(&thread->thread, pool_stacks[i],
 			K_THREAD_STACK_SIZEOF(pool_stacks[i]),
 			thread_pool_entry,
-			NULL, NULL, NULL,
-			CONFIG_NRF_RPC_THREAD_PRIORITY, 0, K_NO_WAIT);
+			thread, NULL, NULL,
+			lane_priority(thread->lane), 0, K_NO_WAIT);
 	}
 
 	return 0;
@@ -99,13 +307,75 @@ int nrf_rpc_os_init(nrf_rpc_os_work_t callback)
 
 void nrf_rpc_os_thread_pool_send(const uint8_t *data, size_t len)
 {
-	struct pool_start_msg msg;
+	uint8_t i = packet_lane(data, len);
+	struct lane *lane = &lanes[i];
+	struct pool_thread *thread;
+	struct pool_start_msg *msg;
+	k_spinlock_key_t key;
+
+	k_sem_take(&lane->free, K_FOREVER);
+
+	key = k_spin_lock(&pool_lock);
+
+	msg = &lane->buf[(lane->head + lane->count) % LANE_QUEUE_SIZE];
+	msg->data = data;
+	msg->len = len;
+	msg->queued = k_cycle_get_32();
+	lane->count++;
+
+	lane->stats.depth = lane->count;
+	lane->stats.depth_max = MAX(lane->stats.depth_max, lane->count);
 
-	msg.data = data;
-	msg.len = len;
-	k_msgq_put(&pool_start_msg, &msg, K_FOREVER);
+	thread = pool_wake(i);
+
+	k_spin_unlock(&pool_lock, key);
+
+	if (thread) {
+		k_sem_give(&thread->wake);
+	}
+}
+
+#if defined(CONFIG_NRF_RPC_THREAD_POOL_LANES)
+
+int nrf_rpc_os_lane_set(uint8_t group_id, enum nrf_rpc_os_lane lane)
+{
+	if (group_id >= ARRAY_SIZE(group_lanes) ||
+	    lane >= NRF_RPC_OS_LANE_COUNT) {
+		return -EINVAL;
+	}
+
+	group_lanes[group_id] = lane;
+
+	return 0;
 }
 
+void nrf_rpc_os_lane_stats_get(enum nrf_rpc_os_lane lane,
+			       struct nrf_rpc_os_lane_stats *stats)
+{
+	k_spinlock_key_t key;
+
+	__ASSERT_NO_MSG(lane < NRF_RPC_OS_LANE_COUNT);
+
+	key = k_spin_lock(&pool_lock);
+	*stats = lanes[lane].stats;
+	k_spin_unlock(&pool_lock, key);
+}
+
+void nrf_rpc_os_lane_stats_reset(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&pool_lock);
+
+	for (size_t i = 0; i < ARRAY_SIZE(lanes); i++) {
+		memset(&lanes[i].stats, 0, sizeof(lanes[i].stats));
+		lanes[i].stats.depth = lanes[i].count;
+		lanes[i].stats.depth_max = lanes[i].count;
+	}
+
+	k_spin_unlock(&pool_lock, key);
+}
+
+#endif /* defined(CONFIG_NRF_RPC_THREAD_POOL_LANES) */
+
 void nrf_rpc_os_msg_set(struct nrf_rpc_os_msg *msg, const uint8_t *data,
 			size_t len)
 {
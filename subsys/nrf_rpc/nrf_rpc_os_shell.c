@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <shell/shell.h>
+
+#include "nrf_rpc_os.h"
+
+static const char * const lane_names[] = {
+	[NRF_RPC_OS_LANE_HIGH] = "high",
+	[NRF_RPC_OS_LANE_NORMAL] = "normal",
+	[NRF_RPC_OS_LANE_LOW] = "low",
+};
+
+BUILD_ASSERT(ARRAY_SIZE(lane_names) == NRF_RPC_OS_LANE_COUNT,
+	     "Lane without a name");
+
+static int show_lanes(const struct shell *shell, size_t argc, char **argv)
+{
+	struct nrf_rpc_os_lane_stats stats;
+	uint32_t wait_avg;
+
+	shell_fprintf(shell, SHELL_NORMAL,
+		      "lane    depth  max  packets  stolen  "
+		      "wait avg [us]  wait max [us]\n");
+
+	for (size_t i = 0; i < NRF_RPC_OS_LANE_COUNT; i++) {
+		nrf_rpc_os_lane_stats_get(i, &stats);
+
+		wait_avg = stats.packets ?
+			   (uint32_t)(stats.wait_total_us / stats.packets) : 0;
+
+		shell_fprintf(shell, SHELL_NORMAL,
+			      "%-6s  %5u  %3u  %7u  %6u  %13u  %13u\n",
+			      lane_names[i], stats.depth, stats.depth_max,
+			      stats.packets, stats.stolen, wait_avg,
+			      stats.wait_max_us);
+	}
+
+	return 0;
+}
+
+static int reset_lanes(const struct shell *shell, size_t argc, char **argv)
+{
+	nrf_rpc_os_lane_stats_reset();
+	shell_fprintf(shell, SHELL_NORMAL, "Lane statistics reset\n");
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_lanes,
+	SHELL_CMD_ARG(reset, NULL, "Reset lane statistics", reset_lanes, 0, 0),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_nrf_rpc,
+	SHELL_CMD_ARG(lanes, &sub_lanes, "Show thread pool lane statistics",
+		      show_lanes, 0, 0),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(nrf_rpc, &sub_nrf_rpc, "nRF RPC commands", NULL);
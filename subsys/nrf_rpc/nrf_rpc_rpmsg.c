@@ -9,6 +9,7 @@
 
 #include <zephyr.h>
 #include <errno.h>
+#include <sys/byteorder.h>
 #include <metal/sys.h>
 #include <metal/device.h>
 #include <metal/alloc.h>
@@ -38,6 +39,54 @@ static nrf_rpc_tr_receive_handler_t receive_callback;
 /* Lower level endpoint instance */
 static struct rp_ll_endpoint ll_endpoint;
 
+#if defined(CONFIG_NRF_RPC_TR_RPMSG_NOCOPY)
+
+/* Packets are sent in frames, which hold one or more entries:
+ *
+ *   | size (16 bits) | len (16 bits) | packet, padded to size bytes |
+ *
+ * An entry with zero length is left by a buffer that was not sent.
+ */
+#define ENTRY_HDR_SIZE 4
+#define ENTRY_ALIGN 4
+#define BATCH_WINDOW CONFIG_NRF_RPC_TR_RPMSG_BATCH_WINDOW
+
+struct tx_frame {
+	/* rpmsg buffer, NULL if the frame is free. */
+	uint8_t *buf;
+	size_t size;
+	/* Bytes used by entries. */
+	size_t used;
+	/* Entries that are not yet sent or dropped. */
+	uint32_t pending;
+	uint32_t packets;
+};
+
+static struct tx_frame tx_frames[CONFIG_NRF_RPC_TR_RPMSG_TX_FRAMES];
+
+/* Frame that new entries are added to. */
+static struct tx_frame *tx_frame_cur;
+
+static struct nrf_rpc_tr_stats tx_stats;
+
+/* Size of the rpmsg buffers, 0 until the first one is got. */
+static size_t tx_buf_size;
+
+/* Protects the frames. */
+static K_MUTEX_DEFINE(tx_lock);
+
+/* Serializes getting a new rpmsg buffer, which may wait for the remote to
+ * free one. Entries can be completed meanwhile.
+ */
+static K_MUTEX_DEFINE(tx_open_lock);
+
+static K_SEM_DEFINE(tx_frames_free, CONFIG_NRF_RPC_TR_RPMSG_TX_FRAMES,
+		    CONFIG_NRF_RPC_TR_RPMSG_TX_FRAMES);
+
+static struct k_delayed_work tx_flush_work;
+
+#endif /* CONFIG_NRF_RPC_TR_RPMSG_NOCOPY */
+
 /* Translates RPMsg error code to nRF RPC error code. */
 static int translate_error(int rpmsg_err)
 {
@@ -61,6 +110,263 @@ static int translate_error(int rpmsg_err)
 	return 0;
 }
 
+#if defined(CONFIG_NRF_RPC_TR_RPMSG_NOCOPY)
+
+/* Splits a received frame into packets. */
+static void frame_receive(const uint8_t *buf, size_t length)
+{
+	size_t size;
+	size_t len;
+
+	while (length >= ENTRY_HDR_SIZE) {
+		size = sys_get_le16(buf);
+		len = sys_get_le16(buf + 2);
+		buf += ENTRY_HDR_SIZE;
+		length -= ENTRY_HDR_SIZE;
+
+		if (size > length || len > size) {
+			NRF_RPC_ERR("Malformed frame");
+			return;
+		}
+
+		if (len > 0) {
+			DUMP_LIMITED_DBG(buf, len, "Received data");
+			receive_callback(buf, len);
+		}
+
+		buf += size;
+		length -= size;
+	}
+}
+
+static struct tx_frame *frame_of(const uint8_t *packet)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(tx_frames); i++) {
+		struct tx_frame *frame = &tx_frames[i];
+
+		if (frame->buf != NULL && packet >= frame->buf &&
+		    packet < frame->buf + frame->size) {
+			return frame;
+		}
+	}
+
+	return NULL;
+}
+
+/* Stops adding entries to the current frame. Returns the frame if it can be
+ * sent, otherwise it is sent when its last entry is completed.
+ * Must be called with tx_lock held.
+ */
+static struct tx_frame *frame_close(void)
+{
+	struct tx_frame *frame = tx_frame_cur;
+
+	tx_frame_cur = NULL;
+
+	return (frame != NULL && frame->pending == 0) ? frame : NULL;
+}
+
+static int frame_send(struct tx_frame *frame)
+{
+	int err;
+
+	k_mutex_lock(&tx_lock, K_FOREVER);
+	tx_stats.frames++;
+	tx_stats.packets += frame->packets;
+	k_mutex_unlock(&tx_lock);
+
+	err = rp_ll_send_nocopy(&ll_endpoint, frame->buf, frame->used);
+	if (err != 0) {
+		NRF_RPC_ERR("Frame send error %d", err);
+	}
+
+	k_mutex_lock(&tx_lock, K_FOREVER);
+	frame->buf = NULL;
+	k_mutex_unlock(&tx_lock);
+
+	k_sem_give(&tx_frames_free);
+
+	return err;
+}
+
+static void tx_flush_work_handler(struct k_work *work)
+{
+	struct tx_frame *frame;
+
+	k_mutex_lock(&tx_lock, K_FOREVER);
+	frame = frame_close();
+	k_mutex_unlock(&tx_lock);
+
+	if (frame != NULL) {
+		(void)frame_send(frame);
+	}
+}
+
+/* Must be called with tx_lock held. */
+static uint8_t *entry_reserve(struct tx_frame *frame, size_t size)
+{
+	uint8_t *hdr = frame->buf + frame->used;
+
+	sys_put_le16(size, hdr);
+	sys_put_le16(0, hdr + 2);
+
+	frame->used += ENTRY_HDR_SIZE + size;
+	frame->pending++;
+
+	return hdr + ENTRY_HDR_SIZE;
+}
+
+static int entry_complete(uint8_t *packet, size_t len)
+{
+	uint8_t *hdr = packet - ENTRY_HDR_SIZE;
+	struct tx_frame *frame;
+	bool send = false;
+	size_t size;
+
+	k_mutex_lock(&tx_lock, K_FOREVER);
+
+	frame = frame_of(packet);
+	NRF_RPC_ASSERT(frame != NULL);
+
+	size = sys_get_le16(hdr);
+	NRF_RPC_ASSERT(len <= size);
+
+	sys_put_le16(len, hdr + 2);
+
+	if (len > 0) {
+		frame->packets++;
+	} else {
+		tx_stats.dropped++;
+	}
+
+	/* Unused space after the last entry can take more entries. */
+	if (frame == tx_frame_cur &&
+	    packet + size == frame->buf + frame->used) {
+		sys_put_le16(ROUND_UP(len, ENTRY_ALIGN), hdr);
+		frame->used -= size - ROUND_UP(len, ENTRY_ALIGN);
+	}
+
+	frame->pending--;
+
+	if (frame->pending == 0 &&
+	    (frame != tx_frame_cur || BATCH_WINDOW == 0)) {
+		if (frame == tx_frame_cur) {
+			tx_frame_cur = NULL;
+		}
+
+		send = true;
+	}
+
+	k_mutex_unlock(&tx_lock);
+
+	return send ? frame_send(frame) : 0;
+}
+
+uint8_t *nrf_rpc_tr_tx_buf_get(size_t len)
+{
+	size_t size = ROUND_UP(len, ENTRY_ALIGN);
+	struct tx_frame *frame;
+	uint8_t *packet = NULL;
+	size_t buf_size;
+	uint8_t *buf;
+
+	k_mutex_lock(&tx_open_lock, K_FOREVER);
+	k_mutex_lock(&tx_lock, K_FOREVER);
+
+	frame = tx_frame_cur;
+	if (frame != NULL &&
+	    frame->size - frame->used >= ENTRY_HDR_SIZE + size) {
+		packet = entry_reserve(frame, size);
+		k_mutex_unlock(&tx_lock);
+		k_mutex_unlock(&tx_open_lock);
+
+		return packet;
+	}
+
+	/* All rpmsg buffers have the same size. */
+	if (tx_buf_size != 0 && tx_buf_size < ENTRY_HDR_SIZE + size) {
+		k_mutex_unlock(&tx_lock);
+		k_mutex_unlock(&tx_open_lock);
+		NRF_RPC_ERR("Packet of %zu bytes does not fit in %zu bytes",
+			    len, tx_buf_size - ENTRY_HDR_SIZE);
+
+		return NULL;
+	}
+
+	/* The packet does not fit in the current frame. */
+	frame = frame_close();
+	k_mutex_unlock(&tx_lock);
+
+	if (frame != NULL) {
+		(void)frame_send(frame);
+	}
+
+	k_sem_take(&tx_frames_free, K_FOREVER);
+
+	/* Frames are only taken while holding tx_open_lock. */
+	for (frame = tx_frames; frame->buf != NULL; frame++) {
+	}
+
+	buf = rp_ll_tx_buf_get(&ll_endpoint, &buf_size);
+	if (buf == NULL) {
+		NRF_RPC_ERR("No rpmsg buffer");
+		k_sem_give(&tx_frames_free);
+		k_mutex_unlock(&tx_open_lock);
+
+		return NULL;
+	}
+
+	tx_buf_size = buf_size;
+
+	if (buf_size < ENTRY_HDR_SIZE + size) {
+		NRF_RPC_ERR("Packet of %zu bytes does not fit in %zu bytes",
+			    len, buf_size - ENTRY_HDR_SIZE);
+
+		/* An rpmsg buffer can only be given back by sending it. */
+		(void)rp_ll_send_nocopy(&ll_endpoint, buf, 0);
+		k_sem_give(&tx_frames_free);
+		k_mutex_unlock(&tx_open_lock);
+
+		return NULL;
+	}
+
+	k_mutex_lock(&tx_lock, K_FOREVER);
+
+	frame->buf = buf;
+	frame->size = buf_size;
+	frame->used = 0;
+	frame->pending = 0;
+	frame->packets = 0;
+	tx_frame_cur = frame;
+	packet = entry_reserve(frame, size);
+
+	k_mutex_unlock(&tx_lock);
+
+	if (BATCH_WINDOW > 0) {
+		k_delayed_work_submit(&tx_flush_work, K_USEC(BATCH_WINDOW));
+	}
+
+	k_mutex_unlock(&tx_open_lock);
+
+	return packet;
+}
+
+void nrf_rpc_tr_tx_buf_drop(uint8_t *buf)
+{
+	if (buf != NULL) {
+		(void)entry_complete(buf, 0);
+	}
+}
+
+void nrf_rpc_tr_stats_get(struct nrf_rpc_tr_stats *stats)
+{
+	k_mutex_lock(&tx_lock, K_FOREVER);
+	*stats = tx_stats;
+	k_mutex_unlock(&tx_lock);
+}
+
+#endif /* CONFIG_NRF_RPC_TR_RPMSG_NOCOPY */
+
 /* Event callback from lower level. */
 static void ll_event_handler(struct rp_ll_endpoint *endpoint,
 			    enum rp_ll_event_type event, const uint8_t *buf,
@@ -80,9 +386,13 @@ static void ll_event_handler(struct rp_ll_endpoint *endpoint,
 
 	NRF_RPC_ASSERT(buf != NULL);
 
+#if defined(CONFIG_NRF_RPC_TR_RPMSG_NOCOPY)
+	frame_receive(buf, length);
+#else
 	DUMP_LIMITED_DBG(buf, length, "Received data");
 
 	receive_callback(buf, length);
+#endif
 }
 
 int nrf_rpc_tr_init(nrf_rpc_tr_receive_handler_t callback)
@@ -93,6 +403,10 @@ int nrf_rpc_tr_init(nrf_rpc_tr_receive_handler_t callback)
 
 	receive_callback = callback;
 
+#if defined(CONFIG_NRF_RPC_TR_RPMSG_NOCOPY)
+	k_delayed_work_init(&tx_flush_work, tx_flush_work_handler);
+#endif
+
 	err = rp_ll_init();
 	if (err != 0) {
 		goto error_exit;
@@ -123,7 +437,11 @@ int nrf_rpc_tr_send(uint8_t *buf, size_t len)
 
 	DUMP_LIMITED_DBG(buf, len, "Send data");
 
+#if defined(CONFIG_NRF_RPC_TR_RPMSG_NOCOPY)
+	err = entry_complete(buf, len);
+#else
 	err = rp_ll_send(&ll_endpoint, buf, len);
+#endif
 
 	return translate_error(err);
 }
@@ -175,6 +175,29 @@ int rp_ll_send(struct rp_ll_endpoint *endpoint, const uint8_t *buf,
 	return ret;
 }
 
+uint8_t *rp_ll_tx_buf_get(struct rp_ll_endpoint *endpoint, size_t *size)
+{
+	uint32_t len;
+	void *buf;
+
+	buf = rpmsg_get_tx_payload_buffer(&endpoint->rpmsg_ep, &len, true);
+	*size = (buf != NULL) ? len : 0;
+
+	return buf;
+}
+
+int rp_ll_send_nocopy(struct rp_ll_endpoint *endpoint, uint8_t *buf,
+		      size_t buf_len)
+{
+	int ret;
+
+	ret = rpmsg_send_nocopy(&endpoint->rpmsg_ep, buf, buf_len);
+	if (ret > 0) {
+		ret = 0;
+	}
+	return ret;
+}
+
 int rp_ll_init(void)
 {
 	int err;
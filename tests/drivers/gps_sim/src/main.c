@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <drivers/gps.h>
+
+/* Number of simulated fixes in the callback load test. */
+#define FIX_COUNT		40
+#define TEST_DURATION_MS	(FIX_COUNT * CONFIG_GPS_SIM_FIX_TIME + \
+				 CONFIG_GPS_SIM_FIX_TIME / 2)
+
+/* The simulator reports HDOP 1.0, expressed here in tenths. */
+#define SIM_HDOP		10
+#define FIXES_FILTERED		((CONFIG_GPS_PVT_QUEUE_MAX_HDOP > 0) && \
+				 (CONFIG_GPS_PVT_QUEUE_MAX_HDOP < SIM_HDOP))
+
+static struct device *gps_dev;
+static struct gps_pvt pvt_buf[CONFIG_GPS_PVT_QUEUE_SIZE];
+
+static uint32_t callback_count;
+static uint32_t ready_count;
+static uint32_t nmea_count;
+static uint32_t pvt_count;
+static uint32_t samples_read;
+static uint32_t timeout_count;
+static K_SEM_DEFINE(stopped_sem, 0, 1);
+
+static void gps_handler(struct device *dev, struct gps_event *evt)
+{
+	int read;
+
+	callback_count++;
+
+	switch (evt->type) {
+	case GPS_EVT_PVT_QUEUE_READY:
+		ready_count++;
+
+		do {
+			read = gps_pvt_read(dev, pvt_buf, ARRAY_SIZE(pvt_buf));
+			zassert_true(read >= 0, "Failed to read PVT queue");
+			samples_read += read;
+		} while (read > 0);
+		break;
+	case GPS_EVT_NMEA:
+	case GPS_EVT_NMEA_FIX:
+		nmea_count++;
+		break;
+	case GPS_EVT_PVT:
+	case GPS_EVT_PVT_FIX:
+		pvt_count++;
+		break;
+	case GPS_EVT_SEARCH_STOPPED:
+		k_sem_give(&stopped_sem);
+		break;
+	case GPS_EVT_SEARCH_TIMEOUT:
+		timeout_count++;
+		break;
+	default:
+		break;
+	}
+}
+
+static void test_init(void)
+{
+	int err;
+
+	gps_dev = device_get_binding(CONFIG_GPS_SIM_DEV_NAME);
+	zassert_not_null(gps_dev, "GPS simulator not found");
+
+	err = gps_init(gps_dev, gps_handler);
+	zassert_equal(err, 0, "Failed to initialize GPS simulator");
+}
+
+static void test_pvt_read_empty(void)
+{
+	int read = gps_pvt_read(gps_dev, pvt_buf, ARRAY_SIZE(pvt_buf));
+
+	zassert_equal(read, 0, "Queue should be empty");
+}
+
+static void test_callback_load(void)
+{
+	struct gps_config cfg = {
+		.nav_mode = GPS_NAV_MODE_CONTINUOUS,
+		.interval = 1,
+		.timeout = 0,
+	};
+	uint32_t stored = FIX_COUNT / CONFIG_GPS_PVT_QUEUE_DECIMATION;
+	uint32_t expected_ready = stored / CONFIG_GPS_PVT_QUEUE_WATERMARK;
+	int err;
+
+	err = gps_start(gps_dev, &cfg);
+	zassert_equal(err, 0, "Failed to start GPS simulator");
+
+	k_sleep(K_MSEC(TEST_DURATION_MS));
+
+	err = gps_stop(gps_dev);
+	zassert_equal(err, 0, "Failed to stop GPS simulator");
+
+	err = k_sem_take(&stopped_sem, K_SECONDS(1));
+	zassert_equal(err, 0, "GPS simulator did not stop");
+
+	TC_PRINT("%d fixes: %u callbacks (%u ready), %u samples read\n",
+		 FIX_COUNT, callback_count, ready_count, samples_read);
+
+	zassert_equal(nmea_count, 0, "NMEA events not suppressed");
+	zassert_equal(pvt_count, 0, "PVT events not suppressed");
+
+	if (FIXES_FILTERED) {
+		zassert_equal(ready_count, 0, "Fixes not filtered");
+		zassert_equal(samples_read, 0, "Fixes not filtered");
+		return;
+	}
+
+	/* Allow for one fix of scheduling jitter at either end. */
+	zassert_within(ready_count, expected_ready, 1,
+		       "Unexpected number of ready events");
+	zassert_within(samples_read,
+		       expected_ready * CONFIG_GPS_PVT_QUEUE_WATERMARK,
+		       CONFIG_GPS_PVT_QUEUE_WATERMARK,
+		       "Unexpected number of samples read");
+	zassert_true(callback_count < FIX_COUNT / 4,
+		     "Callback load not reduced");
+}
+
+static void test_single_fix(void)
+{
+	struct gps_config cfg = {
+		.nav_mode = GPS_NAV_MODE_SINGLE_FIX,
+		.interval = 10,
+		.timeout = 3,
+	};
+	uint32_t read_before = samples_read;
+	int err;
+
+	err = gps_start(gps_dev, &cfg);
+	zassert_equal(err, 0, "Failed to start GPS simulator");
+
+	err = k_sem_take(&stopped_sem, K_SECONDS(cfg.timeout + 1));
+
+	if (FIXES_FILTERED) {
+		zassert_not_equal(err, 0, "Search stopped by a filtered fix");
+		zassert_equal(timeout_count, 1, "Search did not time out");
+		zassert_equal(samples_read, read_before, "Fixes not filtered");
+
+		err = gps_stop(gps_dev);
+		zassert_equal(err, 0, "Failed to stop GPS simulator");
+
+		err = k_sem_take(&stopped_sem, K_SECONDS(1));
+		zassert_equal(err, 0, "GPS simulator did not stop");
+		return;
+	}
+
+	zassert_equal(err, 0, "Search not stopped after a fix");
+	zassert_equal(timeout_count, 0, "Search timed out");
+	zassert_true(samples_read > read_before, "Fix not read");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(gps_sim_pvt_queue,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_pvt_read_empty),
+			 ztest_unit_test(test_callback_load),
+			 ztest_unit_test(test_single_fix)
+			 );
+
+	ztest_run_test_suite(gps_sim_pvt_queue);
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <unity.h>
+#include <string.h>
+#include <zephyr.h>
+#include <net/socket.h>
+#include "mock_nrf_socket.h"
+
+/* Same as CONFIG_BSD_LIBRARY_SENDMSG_BUF_SIZE set for the library. */
+#define SENDMSG_BUF_SIZE 16
+#define SENDTO_CALLS_MAX 8
+#define TEST_SD 0
+
+struct sendto_call {
+	const void *message;
+	size_t length;
+};
+
+static struct sendto_call sendto_calls[SENDTO_CALLS_MAX];
+static size_t sendto_count;
+static size_t sendto_limit;
+static uint8_t sent_data[4 * SENDMSG_BUF_SIZE];
+static size_t sent_len;
+static int fd;
+
+static ssize_t sendto_stub(int socket, const void *message, size_t length,
+			   int flags, const void *dest_addr,
+			   nrf_socklen_t dest_len, int cmock_num_calls)
+{
+	TEST_ASSERT_EQUAL(TEST_SD, socket);
+	TEST_ASSERT_NULL(dest_addr);
+	TEST_ASSERT_LESS_THAN(SENDTO_CALLS_MAX, sendto_count);
+
+	/* Accept at most sendto_limit bytes, if it is set. */
+	if (sendto_limit && (length > sendto_limit)) {
+		length = sendto_limit;
+	}
+
+	TEST_ASSERT_LESS_OR_EQUAL(sizeof(sent_data) - sent_len, length);
+
+	sendto_calls[sendto_count].message = message;
+	sendto_calls[sendto_count].length = length;
+	sendto_count++;
+
+	memcpy(&sent_data[sent_len], message, length);
+	sent_len += length;
+
+	return length;
+}
+
+static void data_fill(uint8_t *buf, size_t len, uint8_t first)
+{
+	for (size_t i = 0; i < len; i++) {
+		buf[i] = first + i;
+	}
+}
+
+static ssize_t msg_send(struct iovec *iov, size_t iovlen)
+{
+	struct msghdr msg = {
+		.msg_iov = iov,
+		.msg_iovlen = iovlen,
+	};
+
+	return sendmsg(fd, &msg, 0);
+}
+
+void setUp(void)
+{
+	memset(sendto_calls, 0, sizeof(sendto_calls));
+	sendto_count = 0;
+	sendto_limit = 0;
+	sent_len = 0;
+
+	__wrap_nrf_socket_ExpectAndReturn(NRF_AF_INET, NRF_SOCK_DGRAM,
+					  NRF_IPPROTO_UDP, TEST_SD);
+	fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+
+	__wrap_nrf_sendto_StubWithCallback(sendto_stub);
+}
+
+void tearDown(void)
+{
+	__wrap_nrf_close_ExpectAndReturn(TEST_SD, 0);
+	TEST_ASSERT_EQUAL(0, close(fd));
+}
+
+/* Small parts are packed together and sent with a single call. */
+void test_sendmsg_small_parts_packed(void)
+{
+	uint8_t data[12];
+	struct iovec iov[] = {
+		{ .iov_base = &data[0], .iov_len = 3 },
+		{ .iov_base = &data[3], .iov_len = 0 },
+		{ .iov_base = &data[3], .iov_len = 5 },
+		{ .iov_base = &data[8], .iov_len = 4 },
+	};
+
+	data_fill(data, sizeof(data), 0);
+
+	TEST_ASSERT_EQUAL(sizeof(data), msg_send(iov, ARRAY_SIZE(iov)));
+	TEST_ASSERT_EQUAL(1, sendto_count);
+	TEST_ASSERT_EQUAL(sizeof(data), sendto_calls[0].length);
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(data, sent_data, sizeof(data));
+}
+
+/* A message filling the buffer exactly is still sent with a single call. */
+void test_sendmsg_buffer_full(void)
+{
+	uint8_t data[SENDMSG_BUF_SIZE];
+	struct iovec iov[] = {
+		{ .iov_base = &data[0], .iov_len = SENDMSG_BUF_SIZE / 2 },
+		{ .iov_base = &data[SENDMSG_BUF_SIZE / 2],
+		  .iov_len = SENDMSG_BUF_SIZE / 2 },
+	};
+
+	data_fill(data, sizeof(data), 0);
+
+	TEST_ASSERT_EQUAL(sizeof(data), msg_send(iov, ARRAY_SIZE(iov)));
+	TEST_ASSERT_EQUAL(1, sendto_count);
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(data, sent_data, sizeof(data));
+}
+
+/* The buffer is flushed when the next part does not fit into it. */
+void test_sendmsg_buffer_overflow(void)
+{
+	uint8_t data[SENDMSG_BUF_SIZE + 4];
+	struct iovec iov[] = {
+		{ .iov_base = &data[0], .iov_len = 10 },
+		{ .iov_base = &data[10], .iov_len = 10 },
+	};
+
+	data_fill(data, sizeof(data), 0);
+
+	TEST_ASSERT_EQUAL(sizeof(data), msg_send(iov, ARRAY_SIZE(iov)));
+	TEST_ASSERT_EQUAL(2, sendto_count);
+	TEST_ASSERT_EQUAL(10, sendto_calls[0].length);
+	TEST_ASSERT_EQUAL(10, sendto_calls[1].length);
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(data, sent_data, sizeof(data));
+}
+
+/* Parts larger than the buffer are sent in place, in order with the packed
+ * parts around them.
+ */
+void test_sendmsg_large_part_in_place(void)
+{
+	uint8_t data[2 * SENDMSG_BUF_SIZE + 6];
+	uint8_t *large = &data[4];
+	struct iovec iov[] = {
+		{ .iov_base = &data[0], .iov_len = 4 },
+		{ .iov_base = large, .iov_len = 2 * SENDMSG_BUF_SIZE },
+		{ .iov_base = &data[4 + 2 * SENDMSG_BUF_SIZE], .iov_len = 2 },
+	};
+
+	data_fill(data, sizeof(data), 0x10);
+
+	TEST_ASSERT_EQUAL(sizeof(data), msg_send(iov, ARRAY_SIZE(iov)));
+	TEST_ASSERT_EQUAL(3, sendto_count);
+	TEST_ASSERT_EQUAL(4, sendto_calls[0].length);
+	TEST_ASSERT_EQUAL_PTR(large, sendto_calls[1].message);
+	TEST_ASSERT_EQUAL(2 * SENDMSG_BUF_SIZE, sendto_calls[1].length);
+	TEST_ASSERT_EQUAL(2, sendto_calls[2].length);
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(data, sent_data, sizeof(data));
+}
+
+/* The rest of the buffer is sent when the modem accepts only a part of it. */
+void test_sendmsg_short_send(void)
+{
+	uint8_t data[10];
+	struct iovec iov[] = {
+		{ .iov_base = &data[0], .iov_len = 6 },
+		{ .iov_base = &data[6], .iov_len = 4 },
+	};
+
+	data_fill(data, sizeof(data), 0x20);
+	sendto_limit = 4;
+
+	TEST_ASSERT_EQUAL(sizeof(data), msg_send(iov, ARRAY_SIZE(iov)));
+	TEST_ASSERT_EQUAL(3, sendto_count);
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(data, sent_data, sizeof(data));
+}
+
+/* It is required to be added to each test. That is because unity is using
+ * different main signature (returns int) and zephyr expects main which does
+ * not return value.
+ */
+extern int unity_main(void);
+
+void main(void)
+{
+	(void)unity_main();
+}
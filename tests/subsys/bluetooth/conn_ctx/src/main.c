@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <bluetooth/conn_ctx.h>
+
+#define THREAD_COUNT 4
+#define THREAD_LOOPS 100
+#define THREAD_STACK_SIZE 1024
+#define THREAD_PRIORITY K_PRIO_PREEMPT(1)
+
+struct test_data {
+	uint32_t count;
+};
+
+BT_CONN_CTX_DEF(test, CONFIG_BT_MAX_CONN, sizeof(struct test_data));
+
+static struct bt_conn_ctx_lib *const ctx_lib = &test_ctx_lib;
+
+/* The last connection gets the index of the first one. */
+static uint8_t conn_obj[CONFIG_BT_MAX_CONN + 1];
+static const uint8_t conn_index[] = { 0, 1, 0 };
+
+#define CONN(i) ((struct bt_conn *)&conn_obj[i])
+
+static K_THREAD_STACK_ARRAY_DEFINE(thread_stacks, THREAD_COUNT,
+				   THREAD_STACK_SIZE);
+static struct k_thread threads[THREAD_COUNT];
+static K_SEM_DEFINE(done_sem, 0, THREAD_COUNT);
+static K_SEM_DEFINE(held_sem, 0, 1);
+static K_SEM_DEFINE(release_sem, 0, 1);
+static volatile bool held;
+
+/* Bluetooth stack mocks. */
+
+uint8_t bt_conn_index(struct bt_conn *conn)
+{
+	return conn_index[(uint8_t *)conn - conn_obj];
+}
+
+static void ctx_alloc(struct bt_conn *conn)
+{
+	void *data = bt_conn_ctx_alloc(ctx_lib, conn);
+
+	zassert_not_null(data, NULL);
+	memset(data, 0, sizeof(struct test_data));
+	bt_conn_ctx_release(ctx_lib, data);
+}
+
+static size_t mem_free_count(void)
+{
+	return k_mem_slab_num_free_get(ctx_lib->mem_slab);
+}
+
+static void counter_thread(void *p1, void *p2, void *p3)
+{
+	struct bt_conn *conn = p1;
+
+	for (size_t i = 0; i < THREAD_LOOPS; i++) {
+		struct test_data *data = bt_conn_ctx_get(ctx_lib, conn);
+		uint32_t count;
+
+		zassert_not_null(data, NULL);
+
+		/* Let the other threads try to get the context meanwhile. */
+		count = data->count;
+		k_yield();
+		data->count = count + 1;
+
+		bt_conn_ctx_release(ctx_lib, data);
+	}
+
+	k_sem_give(&done_sem);
+}
+
+static void holder_thread(void *p1, void *p2, void *p3)
+{
+	struct test_data *data = bt_conn_ctx_get(ctx_lib, p1);
+
+	zassert_not_null(data, NULL);
+
+	held = true;
+	k_sem_give(&held_sem);
+
+	/* A test that waits for the context is released after a while. */
+	k_sem_take(&release_sem, K_MSEC(100));
+
+	held = false;
+	bt_conn_ctx_release(ctx_lib, data);
+
+	k_sem_give(&done_sem);
+}
+
+static void thread_start(size_t i, k_thread_entry_t entry,
+			 struct bt_conn *conn)
+{
+	k_thread_create(&threads[i], thread_stacks[i],
+			K_THREAD_STACK_SIZEOF(thread_stacks[i]),
+			entry, conn, NULL, NULL,
+			THREAD_PRIORITY, 0, K_NO_WAIT);
+}
+
+static void teardown(void)
+{
+	bt_conn_ctx_free_all(ctx_lib);
+	zassert_equal(mem_free_count(), CONFIG_BT_MAX_CONN,
+		      "Context memory leaked");
+}
+
+static void test_get_release_concurrent(void)
+{
+	struct test_data *data;
+
+	ctx_alloc(CONN(0));
+	ctx_alloc(CONN(1));
+
+	/* Each connection context is updated by half of the threads. */
+	for (size_t i = 0; i < THREAD_COUNT; i++) {
+		thread_start(i, counter_thread, CONN(i % CONFIG_BT_MAX_CONN));
+	}
+
+	for (size_t i = 0; i < THREAD_COUNT; i++) {
+		zassert_equal(k_sem_take(&done_sem, K_SECONDS(1)), 0, NULL);
+	}
+
+	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+		data = bt_conn_ctx_get(ctx_lib, CONN(i));
+		zassert_not_null(data, NULL);
+		zassert_equal(data->count,
+			      THREAD_COUNT / CONFIG_BT_MAX_CONN * THREAD_LOOPS,
+			      "Update of context %zu lost", i);
+		bt_conn_ctx_release(ctx_lib, data);
+	}
+}
+
+static void test_free_while_held(void)
+{
+	struct test_data *data;
+
+	ctx_alloc(CONN(0));
+
+	data = bt_conn_ctx_get(ctx_lib, CONN(0));
+	zassert_not_null(data, NULL);
+	zassert_equal(bt_conn_ctx_free(ctx_lib, CONN(0)), 0, NULL);
+
+	/* A freed context can not be got, but its memory is kept until
+	 * its user releases it.
+	 */
+	zassert_is_null(bt_conn_ctx_get(ctx_lib, CONN(0)), NULL);
+	zassert_equal(mem_free_count(), CONFIG_BT_MAX_CONN - 1, NULL);
+
+	bt_conn_ctx_release(ctx_lib, data);
+	zassert_equal(mem_free_count(), CONFIG_BT_MAX_CONN, NULL);
+
+	zassert_equal(bt_conn_ctx_free(ctx_lib, CONN(0)), -EINVAL, NULL);
+}
+
+static void test_index_reuse(void)
+{
+	struct test_data *old_data;
+	struct test_data *new_data;
+	struct test_data *data;
+
+	ctx_alloc(CONN(0));
+
+	old_data = bt_conn_ctx_get(ctx_lib, CONN(0));
+	zassert_not_null(old_data, NULL);
+	zassert_equal(bt_conn_ctx_free(ctx_lib, CONN(0)), 0, NULL);
+
+	/* The new connection has the index of the held context. */
+	new_data = bt_conn_ctx_alloc(ctx_lib, CONN(CONFIG_BT_MAX_CONN));
+	zassert_not_null(new_data, NULL);
+	zassert_not_equal(new_data, old_data, NULL);
+	bt_conn_ctx_release(ctx_lib, new_data);
+
+	/* All slots are in use. */
+	zassert_is_null(bt_conn_ctx_alloc(ctx_lib, CONN(1)), NULL);
+
+	data = bt_conn_ctx_get(ctx_lib, CONN(CONFIG_BT_MAX_CONN));
+	zassert_equal_ptr(data, new_data, NULL);
+	bt_conn_ctx_release(ctx_lib, data);
+	zassert_is_null(bt_conn_ctx_get(ctx_lib, CONN(0)), NULL);
+
+	bt_conn_ctx_release(ctx_lib, old_data);
+
+	/* The new context is still found after the slot of its index
+	 * has been freed.
+	 */
+	data = bt_conn_ctx_get(ctx_lib, CONN(CONFIG_BT_MAX_CONN));
+	zassert_equal_ptr(data, new_data, NULL);
+	bt_conn_ctx_release(ctx_lib, data);
+
+	zassert_equal(bt_conn_ctx_free(ctx_lib, CONN(CONFIG_BT_MAX_CONN)), 0,
+		      NULL);
+}
+
+struct foreach_params {
+	struct bt_conn *conn[CONFIG_BT_MAX_CONN];
+	size_t count;
+};
+
+static void foreach_cb(const struct bt_conn_ctx *ctx, void *user_data)
+{
+	struct foreach_params *params = user_data;
+
+	zassert_true(params->count < ARRAY_SIZE(params->conn), NULL);
+	params->conn[params->count++] = ctx->conn;
+}
+
+static void test_foreach(void)
+{
+	struct foreach_params params = {0};
+
+	ctx_alloc(CONN(0));
+	ctx_alloc(CONN(1));
+
+	thread_start(0, holder_thread, CONN(0));
+	zassert_equal(k_sem_take(&held_sem, K_SECONDS(1)), 0, NULL);
+
+	/* The iteration does not wait for the user of a context. */
+	zassert_equal(bt_conn_ctx_foreach(ctx_lib, foreach_cb, &params), 2,
+		      NULL);
+	zassert_true(held, "Iteration waited for the context user");
+	zassert_equal_ptr(params.conn[0], CONN(0), NULL);
+	zassert_equal_ptr(params.conn[1], CONN(1), NULL);
+
+	k_sem_give(&release_sem);
+	zassert_equal(k_sem_take(&done_sem, K_SECONDS(1)), 0, NULL);
+
+	/* Freed contexts are skipped. */
+	zassert_equal(bt_conn_ctx_free(ctx_lib, CONN(0)), 0, NULL);
+
+	params.count = 0;
+	zassert_equal(bt_conn_ctx_foreach(ctx_lib, foreach_cb, &params), 1,
+		      NULL);
+	zassert_equal_ptr(params.conn[0], CONN(1), NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(test_conn_ctx,
+			 ztest_unit_test_setup_teardown(
+				test_get_release_concurrent,
+				unit_test_noop, teardown),
+			 ztest_unit_test_setup_teardown(test_free_while_held,
+							unit_test_noop,
+							teardown),
+			 ztest_unit_test_setup_teardown(test_index_reuse,
+							unit_test_noop,
+							teardown),
+			 ztest_unit_test_setup_teardown(test_foreach,
+							unit_test_noop,
+							teardown));
+	ztest_run_test_suite(test_conn_ctx);
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <sys/byteorder.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/crypto.h>
+#include <bluetooth/enocean.h>
+
+#define SIG_VALID 0xa5
+#define SIG_INVALID 0x5a
+
+static struct bt_le_scan_cb *scan_cb;
+static int decrypt_count;
+static int button_count;
+static struct bt_enocean_device *button_dev;
+
+/* Bluetooth stack mocks. */
+
+void bt_le_scan_cb_register(struct bt_le_scan_cb *cb)
+{
+	scan_cb = cb;
+}
+
+int bt_ccm_decrypt(const uint8_t key[16], uint8_t nonce[13],
+		   const uint8_t *enc_data, size_t len, const uint8_t *aad,
+		   size_t aad_len, uint8_t *plaintext, size_t mic_size)
+{
+	decrypt_count++;
+
+	return (enc_data[len] == SIG_VALID) ? 0 : -EBADMSG;
+}
+
+static void button_cb(struct bt_enocean_device *device,
+		      enum bt_enocean_button_action action, uint8_t changed,
+		      const uint8_t *opt_data, size_t opt_data_len)
+{
+	button_count++;
+	button_dev = device;
+}
+
+static const struct bt_enocean_callbacks callbacks = {
+	.button = button_cb,
+};
+
+static void addr_get(bt_addr_le_t *addr, uint32_t index)
+{
+	addr->type = BT_ADDR_LE_RANDOM;
+	sys_put_le32(index * 0x9e3779b9, &addr->a.val[0]);
+	sys_put_le16(0xc000 | index, &addr->a.val[4]);
+}
+
+static void switch_telegram_send(const bt_addr_le_t *addr, uint32_t seq,
+				 uint8_t sig)
+{
+	struct bt_le_scan_recv_info info = {
+		.addr = addr,
+		.rssi = -40,
+		.adv_type = BT_GAP_ADV_TYPE_ADV_NONCONN_IND,
+	};
+	struct net_buf_simple buf;
+	uint8_t data[13];
+
+	data[0] = sizeof(data) - 1;
+	data[1] = BT_DATA_MANUFACTURER_DATA;
+	sys_put_le16(0x03da, &data[2]);
+	sys_put_le32(seq, &data[4]);
+	data[8] = BIT(0) | BIT(1);
+	memset(&data[9], sig, 4);
+
+	net_buf_simple_init_with_data(&buf, data, sizeof(data));
+	scan_cb->recv(&info, &buf);
+}
+
+static void decommission(struct bt_enocean_device *dev, void *user_data)
+{
+	bt_enocean_decommission(dev);
+}
+
+static void setup(void)
+{
+	static const uint8_t key[16];
+	bt_addr_le_t addr;
+
+	for (int i = 0; i < CONFIG_BT_ENOCEAN_DEVICES_MAX; i++) {
+		addr_get(&addr, i);
+		zassert_equal(bt_enocean_commission(&addr, key, 0), 0, NULL);
+	}
+
+	decrypt_count = 0;
+	button_count = 0;
+	button_dev = NULL;
+}
+
+static void teardown(void)
+{
+	bt_enocean_foreach(decommission, NULL);
+}
+
+static void test_replay(void)
+{
+	bt_addr_le_t addr;
+
+	addr_get(&addr, 0);
+
+	/* Each telegram is transmitted several times: */
+	for (int i = 0; i < 3; i++) {
+		switch_telegram_send(&addr, 1, SIG_VALID);
+	}
+
+	zassert_equal(decrypt_count, 1, NULL);
+	zassert_equal(button_count, 1, NULL);
+
+	/* Old telegrams are dropped without authentication: */
+	switch_telegram_send(&addr, 1, SIG_VALID);
+	switch_telegram_send(&addr, 0, SIG_VALID);
+	zassert_equal(decrypt_count, 1, NULL);
+	zassert_equal(button_count, 1, NULL);
+
+	switch_telegram_send(&addr, 2, SIG_VALID);
+	zassert_equal(decrypt_count, 2, NULL);
+	zassert_equal(button_count, 2, NULL);
+}
+
+static void test_auth_failure(void)
+{
+	bt_addr_le_t addr;
+
+	addr_get(&addr, 1);
+
+	for (int i = 0; i < 3; i++) {
+		switch_telegram_send(&addr, 5, SIG_INVALID);
+	}
+
+	zassert_equal(decrypt_count, 1, NULL);
+	zassert_equal(button_count, 0, NULL);
+
+	/* A forged telegram must not block the genuine one: */
+	switch_telegram_send(&addr, 5, SIG_VALID);
+	zassert_equal(decrypt_count, 2, NULL);
+	zassert_equal(button_count, 1, NULL);
+}
+
+static void test_device_lookup(void)
+{
+	bt_addr_le_t addr;
+
+	for (int i = 0; i < CONFIG_BT_ENOCEAN_DEVICES_MAX; i++) {
+		addr_get(&addr, i);
+		switch_telegram_send(&addr, 1, SIG_VALID);
+		zassert_not_null(button_dev, NULL);
+		zassert_false(bt_addr_le_cmp(&button_dev->addr, &addr), NULL);
+
+		/* Every other device is removed: */
+		if (i % 2) {
+			bt_enocean_decommission(button_dev);
+		}
+	}
+
+	zassert_equal(button_count, CONFIG_BT_ENOCEAN_DEVICES_MAX, NULL);
+
+	for (int i = 0; i < CONFIG_BT_ENOCEAN_DEVICES_MAX; i++) {
+		button_dev = NULL;
+		addr_get(&addr, i);
+		switch_telegram_send(&addr, 2, SIG_VALID);
+
+		if (i % 2) {
+			zassert_is_null(button_dev, NULL);
+		} else {
+			zassert_not_null(button_dev, NULL);
+			zassert_false(bt_addr_le_cmp(&button_dev->addr, &addr),
+				      NULL);
+		}
+	}
+
+	/* Unknown devices are never authenticated: */
+	decrypt_count = 0;
+	addr_get(&addr, CONFIG_BT_ENOCEAN_DEVICES_MAX);
+	switch_telegram_send(&addr, 1, SIG_VALID);
+	zassert_equal(decrypt_count, 0, NULL);
+}
+
+void test_main(void)
+{
+	bt_enocean_init(&callbacks);
+
+	ztest_test_suite(test_enocean,
+			 ztest_unit_test_setup_teardown(test_replay,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_auth_failure,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_device_lookup,
+							setup, teardown));
+	ztest_run_test_suite(test_enocean);
+}
@@ -5,27 +5,75 @@
  */
 #include <stdbool.h>
 #include <inttypes.h>
+#include <bluetooth/att.h>
 #include <bluetooth/gatt.h>
 #include <bluetooth/uuid.h>
 #include <kernel.h>
 #include <ztest.h>
 #include <sys/util.h>
+#include "gatt_discover_mock.h"
 
 
+/* Number of connections the mock can run procedures on at the same time */
+#define DISCOVER_MOCK_CONN_MAX 4
+
 /* Settings of the discover mock */
-static struct bt_discover_mock {
+static struct {
 	const struct bt_gatt_attr *attr;
 	size_t len;
+	const uint8_t *db_hash;
+	atomic_t discover_cnt;
+} discover_mock_cfg;
+
+/* State of the procedures on one connection */
+static struct bt_discover_mock {
 	struct bt_conn *conn;
 	struct bt_gatt_discover_params *params;
 	struct k_delayed_work work;
-} discover_mock_data;
+	struct bt_gatt_read_params *read_params;
+	struct k_delayed_work read_work;
+} discover_mock_data[DISCOVER_MOCK_CONN_MAX];
 
 
 void bt_gatt_discover_mock_setup(const struct bt_gatt_attr *attr, size_t len)
 {
-	discover_mock_data.attr = attr;
-	discover_mock_data.len  = len;
+	discover_mock_cfg.attr = attr;
+	discover_mock_cfg.len  = len;
+	discover_mock_cfg.db_hash = NULL;
+	atomic_set(&discover_mock_cfg.discover_cnt, 0);
+
+	for (size_t i = 0; i < ARRAY_SIZE(discover_mock_data); i++) {
+		discover_mock_data[i].conn = NULL;
+	}
+}
+
+void bt_gatt_discover_mock_db_hash_set(const uint8_t *db_hash)
+{
+	discover_mock_cfg.db_hash = db_hash;
+}
+
+size_t bt_gatt_discover_mock_cnt_get(void)
+{
+	return atomic_get(&discover_mock_cfg.discover_cnt);
+}
+
+static struct bt_discover_mock *discover_mock_get(struct bt_conn *conn)
+{
+	struct bt_discover_mock *free_slot = NULL;
+
+	for (size_t i = 0; i < ARRAY_SIZE(discover_mock_data); i++) {
+		if (discover_mock_data[i].conn == conn) {
+			return &discover_mock_data[i];
+		}
+		if (!free_slot && !discover_mock_data[i].conn) {
+			free_slot = &discover_mock_data[i];
+		}
+	}
+
+	zassert_not_null(free_slot, "Too many connections used by the test");
+	free_slot->conn = conn;
+
+	return free_slot;
 }
 
 static bool bt_gatt_primary_check(const struct bt_gatt_attr *attr_cur,
@@ -46,7 +94,7 @@ static void bt_gatt_discover_work(struct k_work *work)
 	struct bt_discover_mock *mock_data =
 		CONTAINER_OF(work, struct bt_discover_mock, work);
 	const struct bt_gatt_attr *const attr_end =
-		discover_mock_data.attr + discover_mock_data.len;
+		discover_mock_cfg.attr + discover_mock_cfg.len;
 	const struct bt_gatt_attr *attr_cur;
 
 	printk("Running simulated discovery:"
@@ -55,10 +103,10 @@ static void bt_gatt_discover_work(struct k_work *work)
 	       mock_data->params->start_handle,
 	       mock_data->params->end_handle);
 
-	zassert_true(mock_data->params->start_handle < discover_mock_data.len,
+	zassert_true(mock_data->params->start_handle < discover_mock_cfg.len,
 		"Unexpected start handle: %u", mock_data->params->start_handle);
 
-	for (attr_cur = discover_mock_data.attr;
+	for (attr_cur = discover_mock_cfg.attr;
 	     attr_cur < attr_end;
 	     ++attr_cur) {
 		if (attr_cur->handle > mock_data->params->end_handle) {
@@ -122,11 +170,53 @@ static void bt_gatt_discover_work(struct k_work *work)
 int bt_gatt_discover(struct bt_conn *conn,
 		     struct bt_gatt_discover_params *params)
 {
+	struct bt_discover_mock *mock_data = discover_mock_get(conn);
+
+	printk("Running %s mock\n", __func__);
+	atomic_inc(&discover_mock_cfg.discover_cnt);
+	mock_data->params = params;
+
+	k_delayed_work_init(&(mock_data->work), bt_gatt_discover_work);
+	k_delayed_work_submit(&(mock_data->work), K_MSEC(5));
+	return 0;
+}
+
+static void bt_gatt_read_work(struct k_work *work)
+{
+	struct bt_discover_mock *mock_data =
+		CONTAINER_OF(work, struct bt_discover_mock, read_work);
+	struct bt_gatt_read_params *params = mock_data->read_params;
+
+	zassert_equal(0, params->handle_count, "Only read by UUID is mocked");
+	zassert_true(!bt_uuid_cmp(BT_UUID_GATT_DB_HASH, params->by_uuid.uuid),
+		     "Only the database hash read is mocked");
+
+	if (!discover_mock_cfg.db_hash) {
+		(void)params->func(mock_data->conn,
+				   BT_ATT_ERR_ATTRIBUTE_NOT_FOUND,
+				   params, NULL, 0);
+		return;
+	}
+
+	if (BT_GATT_ITER_STOP ==
+		params->func(mock_data->conn, 0, params,
+			     discover_mock_cfg.db_hash,
+			     BT_GATT_DISCOVER_MOCK_DB_HASH_LEN)) {
+		return;
+	}
+	(void)params->func(mock_data->conn, 0, params, NULL, 0);
+}
+
+/* Mocked version of the bt_gatt_read, for the database hash only */
+/* Call the bt_gatt_discover_mock_db_hash_set function to set the hash */
+int bt_gatt_read(struct bt_conn *conn, struct bt_gatt_read_params *params)
+{
+	struct bt_discover_mock *mock_data = discover_mock_get(conn);
+
 	printk("Running %s mock\n", __func__);
-	discover_mock_data.conn = conn;
-	discover_mock_data.params = params;
+	mock_data->read_params = params;
 
-	k_delayed_work_init(&(discover_mock_data.work), bt_gatt_discover_work);
-	k_delayed_work_submit(&(discover_mock_data.work), K_MSEC(5));
+	k_delayed_work_init(&(mock_data->read_work), bt_gatt_read_work);
+	k_delayed_work_submit(&(mock_data->read_work), K_MSEC(5));
 	return 0;
 }
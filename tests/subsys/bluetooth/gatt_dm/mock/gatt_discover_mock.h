@@ -80,15 +80,34 @@
 		.handle = _handle                    \
 	}
 
+/** Length of the database hash returned by the bt_gatt_read mock. */
+#define BT_GATT_DISCOVER_MOCK_DB_HASH_LEN 16
+
 /**
  * @brief GATT discover mock setup
  *
  * This function setups the mock for @ref bt_gatt_discover function.
+ * It also clears the database hash and the discovery counter.
  *
  * @param attr The array of the attribute
  * @param len  The size of the array
  */
 void bt_gatt_discover_mock_setup(const struct bt_gatt_attr *attr, size_t len);
 
+/**
+ * @brief Set the database hash returned by the bt_gatt_read mock
+ *
+ * @param db_hash Hash of @ref BT_GATT_DISCOVER_MOCK_DB_HASH_LEN bytes,
+ *                or NULL if the peer has no Database Hash characteristic.
+ */
+void bt_gatt_discover_mock_db_hash_set(const uint8_t *db_hash);
+
+/**
+ * @brief Get the number of bt_gatt_discover calls
+ *
+ * @return Number of calls since the last @ref bt_gatt_discover_mock_setup.
+ */
+size_t bt_gatt_discover_mock_cnt_get(void);
+
 /** @} */
 #endif /* #define BT_GATT_DISCOVERY_MOCK_H_ */
@@ -7,15 +7,28 @@
 #include <kernel.h>
 #include <stddef.h>
 #include <sys/util.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/conn.h>
+#include <bluetooth/hci.h>
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt_dm.h>
+#include <host/conn_internal.h>
 #include "../mock/gatt_discover_mock.h"
 
 /* Timeout for the discovery in ms */
 #define SERVICE_DISCOVERY_TIMEOUT 2000
 
-static char dummy_conn;
-K_SEM_DEFINE(discovery_finished, 0, 1);
+/* Connections to peers with public, public and random private addresses */
+static struct bt_conn test_conn[] = {
+	{ .le.dst = { .type = BT_ADDR_LE_PUBLIC,
+		      .a.val = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00 } } },
+	{ .le.dst = { .type = BT_ADDR_LE_PUBLIC,
+		      .a.val = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 } } },
+	{ .le.dst = { .type = BT_ADDR_LE_RANDOM,
+		      .a.val = { 0x03, 0x00, 0x00, 0x00, 0x00, 0x40 } } },
+};
+
+K_SEM_DEFINE(discovery_finished, 0, ARRAY_SIZE(test_conn));
 
 
 const struct bt_gatt_attr discover_sim[] = {
@@ -77,14 +90,16 @@ void test_setup(void)
 {
 	k_sem_reset(&discovery_finished);
 	bt_gatt_discover_mock_setup(discover_sim, ARRAY_SIZE(discover_sim));
+	bt_gatt_dm_cache_clear(NULL);
 }
 
-struct bt_gatt_dm *run_dm(const struct bt_uuid *svc_uuid)
+struct bt_gatt_dm *run_dm_conn(struct bt_conn *conn,
+			       const struct bt_uuid *svc_uuid)
 {
 	struct bt_gatt_dm *dm;
 	int err;
 
-	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn,
+	err = bt_gatt_dm_start(conn,
 				   svc_uuid,
 				   &test_hids_cb,
 				   &dm);
@@ -96,6 +111,11 @@ struct bt_gatt_dm *run_dm(const struct bt_uuid *svc_uuid)
 	return dm;
 }
 
+struct bt_gatt_dm *run_dm(const struct bt_uuid *svc_uuid)
+{
+	return run_dm_conn(&test_conn[0], svc_uuid);
+}
+
 struct bt_gatt_dm *run_dm_next(struct bt_gatt_dm *dm)
 {
 	int err;
@@ -344,6 +364,42 @@ void test_gatt_HIDS_chrc_by_uuid(void)
 	zassert_equal(0, bt_gatt_dm_attr_cnt(dm), "Parameter count after clearing: %d", bt_gatt_dm_attr_cnt(dm));
 }
 
+void test_gatt_HIDS_arena(void)
+{
+	static uint32_t arena[128];
+	struct bt_gatt_dm *dm;
+	const struct bt_gatt_dm_attr *attr_chrc;
+	const struct bt_gatt_chrc *chrc_val;
+	int err;
+
+	err = bt_gatt_dm_start_arena(&test_conn[0],
+				     BT_UUID_HIDS,
+				     &test_hids_cb,
+				     &dm,
+				     arena,
+				     sizeof(arena));
+	zassert_false(err, "bt_gatt_dm_start_arena finished with error: %d", err);
+
+	err = k_sem_take(&discovery_finished, K_MSEC(SERVICE_DISCOVERY_TIMEOUT));
+	zassert_equal(0, err, "It seems that no callback function was called: %d", err);
+
+	zassert_not_null(dm, "Device Manager pointer not set");
+	zassert_equal(11,
+		      bt_gatt_dm_attr_cnt(dm),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm));
+
+	attr_chrc = bt_gatt_dm_char_by_uuid(dm, BT_UUID_HIDS_REPORT);
+	zassert_not_null(attr_chrc, "Unexpected NULL");
+	chrc_val = bt_gatt_dm_attr_chrc_val(attr_chrc);
+	zassert_true((uint8_t *)chrc_val >= (uint8_t *)arena &&
+		     (uint8_t *)chrc_val < (uint8_t *)arena + sizeof(arena),
+		     "Attribute data not stored in the arena");
+
+	bt_gatt_dm_data_release(dm);
+	zassert_equal(0, bt_gatt_dm_attr_cnt(dm), "Parameter count after clearing: %d", bt_gatt_dm_attr_cnt(dm));
+}
+
 void test_gatt_generic_serv(void)
 {
 	struct bt_gatt_dm *dm;
@@ -376,6 +432,185 @@ void test_gatt_generic_serv(void)
 	/* No cleanup here - cleanup is done in run_dm_next */
 }
 
+/* Discoveries on two connections at the same time */
+void test_gatt_concurrent(void)
+{
+	struct bt_gatt_dm *dm[2];
+	const struct bt_gatt_dm_attr *attr_serv;
+	struct bt_gatt_dm *dm_busy;
+	int err;
+
+	err = bt_gatt_dm_start(&test_conn[0], BT_UUID_HIDS,
+			       &test_hids_cb, &dm[0]);
+	zassert_false(err, "bt_gatt_dm_start finished with error: %d", err);
+	err = bt_gatt_dm_start(&test_conn[1], BT_UUID_DIS,
+			       &test_hids_cb, &dm[1]);
+	zassert_false(err, "bt_gatt_dm_start finished with error: %d", err);
+
+	/* All the instances are in use */
+	err = bt_gatt_dm_start(&test_conn[2], BT_UUID_DIS,
+			       &test_hids_cb, &dm_busy);
+	zassert_equal(-EALREADY, err, "Unexpected error: %d", err);
+
+	for (size_t i = 0; i < ARRAY_SIZE(dm); i++) {
+		err = k_sem_take(&discovery_finished,
+				 K_MSEC(SERVICE_DISCOVERY_TIMEOUT));
+		zassert_equal(0, err, "Discovery not finished: %d", err);
+	}
+
+	zassert_not_null(dm[0], "Device Manager pointer not set");
+	zassert_not_null(dm[1], "Device Manager pointer not set");
+	zassert_not_equal(dm[0], dm[1], "Instance used twice");
+
+	zassert_equal_ptr(&test_conn[0], bt_gatt_dm_conn_get(dm[0]),
+			  "Unexpected connection");
+	attr_serv = bt_gatt_dm_service_get(dm[0]);
+	zassert_true(!bt_uuid_cmp(BT_UUID_HIDS,
+		     bt_gatt_dm_attr_service_val(attr_serv)->uuid),
+		     "Invalid service detected");
+	zassert_equal(11, bt_gatt_dm_attr_cnt(dm[0]),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm[0]));
+
+	zassert_equal_ptr(&test_conn[1], bt_gatt_dm_conn_get(dm[1]),
+			  "Unexpected connection");
+	attr_serv = bt_gatt_dm_service_get(dm[1]);
+	zassert_true(!bt_uuid_cmp(BT_UUID_DIS,
+		     bt_gatt_dm_attr_service_val(attr_serv)->uuid),
+		     "Invalid service detected");
+	zassert_equal(5, bt_gatt_dm_attr_cnt(dm[1]),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm[1]));
+
+	bt_gatt_dm_data_release(dm[0]);
+	bt_gatt_dm_data_release(dm[1]);
+}
+
+#if defined(CONFIG_BT_GATT_DM_CACHE)
+static const uint8_t db_hash[BT_GATT_DISCOVER_MOCK_DB_HASH_LEN] = {
+	0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+	0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10
+};
+
+static const uint8_t db_hash_changed[BT_GATT_DISCOVER_MOCK_DB_HASH_LEN] = {
+	0x10, 0x0f, 0x0e, 0x0d, 0x0c, 0x0b, 0x0a, 0x09,
+	0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01
+};
+
+/* Run the HIDS discovery and check if it was done by the peer */
+static void run_dm_cached(struct bt_conn *conn, bool discovered)
+{
+	const struct bt_gatt_dm_attr *attr;
+	struct bt_gatt_dm *dm;
+	size_t discover_cnt = bt_gatt_discover_mock_cnt_get();
+
+	dm = run_dm_conn(conn, BT_UUID_HIDS);
+	zassert_not_null(dm, "Device Manager pointer not set");
+
+	if (discovered) {
+		zassert_not_equal(discover_cnt,
+				  bt_gatt_discover_mock_cnt_get(),
+				  "Discovery data restored from the cache");
+	} else {
+		zassert_equal(discover_cnt,
+			      bt_gatt_discover_mock_cnt_get(),
+			      "Discovery data not restored from the cache");
+	}
+
+	attr = NULL;
+	for (int i = 2; i <= 11; ++i) {
+		attr = bt_gatt_dm_attr_next(dm, attr);
+		zassert_not_null(attr, "Attr handle: %d", i);
+		zassert_equal(i, attr->handle, "Attr handle: %d", i);
+	}
+	attr = bt_gatt_dm_attr_next(dm, attr);
+	zassert_is_null(attr, "Attr after 11 should be NULL");
+
+	attr = bt_gatt_dm_char_by_uuid(dm, BT_UUID_HIDS_REPORT);
+	zassert_not_null(attr, "Unexpected NULL");
+	zassert_equal(BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+		      bt_gatt_dm_attr_chrc_val(attr)->properties,
+		      "Unexpected HIDS_REPORT properties");
+	attr = bt_gatt_dm_desc_by_uuid(dm, attr, BT_UUID_GATT_CCC);
+	zassert_not_null(attr, "Unexpected NULL");
+	zassert_equal(8, attr->handle, "Unexpected handle: %d", attr->handle);
+
+	bt_gatt_dm_data_release(dm);
+}
+
+void test_gatt_cache_hit(void)
+{
+	bt_gatt_discover_mock_db_hash_set(db_hash);
+
+	run_dm_cached(&test_conn[0], true);
+	run_dm_cached(&test_conn[0], false);
+	run_dm_cached(&test_conn[0], false);
+}
+
+void test_gatt_cache_miss(void)
+{
+	struct bt_gatt_dm *dm;
+
+	/* No database hash on the peer */
+	run_dm_cached(&test_conn[0], true);
+	run_dm_cached(&test_conn[0], true);
+
+	bt_gatt_discover_mock_db_hash_set(db_hash);
+	run_dm_cached(&test_conn[0], true);
+
+	/* Another peer */
+	run_dm_cached(&test_conn[1], true);
+
+	/* Another service */
+	dm = run_dm_conn(&test_conn[0], BT_UUID_DIS);
+	zassert_not_null(dm, "Device Manager pointer not set");
+	zassert_equal(5, bt_gatt_dm_attr_cnt(dm),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm));
+	bt_gatt_dm_data_release(dm);
+
+	/* The peer database changed */
+	bt_gatt_discover_mock_db_hash_set(db_hash_changed);
+	run_dm_cached(&test_conn[0], true);
+	run_dm_cached(&test_conn[0], false);
+
+	/* Unresolved random private address */
+	run_dm_cached(&test_conn[2], true);
+	run_dm_cached(&test_conn[2], true);
+}
+
+void test_gatt_cache_clear(void)
+{
+	bt_gatt_discover_mock_db_hash_set(db_hash);
+
+	run_dm_cached(&test_conn[0], true);
+	run_dm_cached(&test_conn[1], true);
+
+	bt_gatt_dm_cache_clear(&test_conn[0].le.dst);
+	run_dm_cached(&test_conn[0], true);
+	run_dm_cached(&test_conn[1], false);
+
+	bt_gatt_dm_cache_clear(NULL);
+	run_dm_cached(&test_conn[0], true);
+	run_dm_cached(&test_conn[1], true);
+}
+#else
+void test_gatt_cache_hit(void)
+{
+	ztest_test_skip();
+}
+
+void test_gatt_cache_miss(void)
+{
+	ztest_test_skip();
+}
+
+void test_gatt_cache_clear(void)
+{
+	ztest_test_skip();
+}
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 void test_main(void)
 {
 	ztest_test_suite(
@@ -387,7 +622,12 @@ void test_main(void)
 		ztest_unit_test_setup_teardown(test_gatt_HIDS_attr_by_handle, test_setup, unit_test_noop),
 		ztest_unit_test_setup_teardown(test_gatt_HIDS_next_chrc_access, test_setup, unit_test_noop),
 		ztest_unit_test_setup_teardown(test_gatt_HIDS_chrc_by_uuid, test_setup, unit_test_noop),
-		ztest_unit_test_setup_teardown(test_gatt_generic_serv, test_setup, unit_test_noop)
+		ztest_unit_test_setup_teardown(test_gatt_HIDS_arena, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_generic_serv, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_concurrent, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_hit, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_miss, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_clear, test_setup, unit_test_noop)
 	);
 
 	ztest_run_test_suite(test_gatt);
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <bluetooth/conn.h>
+#include <bluetooth/gatt.h>
+#include <bluetooth/services/nus.h>
+
+#define CHUNK_LEN (CONFIG_BT_L2CAP_TX_MTU - 3)
+
+static uint8_t conn_obj;
+static struct bt_conn *const conn = (struct bt_conn *)&conn_obj;
+static int conn_refs;
+
+static struct bt_gatt_notify_params sent[16];
+static size_t sent_count;
+
+/* Bluetooth stack mocks. */
+
+ssize_t bt_gatt_attr_read_service(struct bt_conn *conn,
+				  const struct bt_gatt_attr *attr,
+				  void *buf, uint16_t len, uint16_t offset)
+{
+	return 0;
+}
+
+ssize_t bt_gatt_attr_read_chrc(struct bt_conn *conn,
+			       const struct bt_gatt_attr *attr, void *buf,
+			       uint16_t len, uint16_t offset)
+{
+	return 0;
+}
+
+ssize_t bt_gatt_attr_read_ccc(struct bt_conn *conn,
+			      const struct bt_gatt_attr *attr, void *buf,
+			      uint16_t len, uint16_t offset)
+{
+	return 0;
+}
+
+ssize_t bt_gatt_attr_write_ccc(struct bt_conn *conn,
+			       const struct bt_gatt_attr *attr,
+			       const void *buf, uint16_t len, uint16_t offset,
+			       uint8_t flags)
+{
+	return len;
+}
+
+bool bt_gatt_is_subscribed(struct bt_conn *conn,
+			   const struct bt_gatt_attr *attr, uint16_t ccc_value)
+{
+	return true;
+}
+
+uint16_t bt_gatt_get_mtu(struct bt_conn *conn)
+{
+	return CONFIG_BT_L2CAP_TX_MTU;
+}
+
+int bt_gatt_notify_cb(struct bt_conn *conn,
+		      struct bt_gatt_notify_params *params)
+{
+	zassert_true(sent_count < ARRAY_SIZE(sent), "Too many notifications");
+
+	/* Completion is reported by the test through sent_complete(). */
+	sent[sent_count++] = *params;
+
+	return 0;
+}
+
+struct bt_conn *bt_conn_ref(struct bt_conn *conn)
+{
+	conn_refs++;
+
+	return conn;
+}
+
+void bt_conn_unref(struct bt_conn *conn)
+{
+	conn_refs--;
+}
+
+static void sent_complete(size_t i)
+{
+	sent[i].func(conn, sent[i].user_data);
+}
+
+static void stream_write(uint32_t len)
+{
+	static uint8_t data[CONFIG_BT_GATT_NUS_STREAM_BUF_SIZE];
+
+	zassert_equal(bt_gatt_nus_stream_write(data, len), len, NULL);
+
+	/* Let the system workqueue send the data. */
+	k_sleep(K_MSEC(10));
+}
+
+static void setup(void)
+{
+	sent_count = 0;
+	zassert_equal(bt_gatt_nus_stream_start(conn), 0, NULL);
+}
+
+static void teardown(void)
+{
+	bt_gatt_nus_stream_stop();
+	zassert_equal(conn_refs, 0, "Connection reference leaked");
+}
+
+static void test_tx_max(void)
+{
+	stream_write(CONFIG_BT_GATT_NUS_STREAM_TX_MAX * CHUNK_LEN + 5);
+	zassert_equal(sent_count, CONFIG_BT_GATT_NUS_STREAM_TX_MAX, NULL);
+
+	for (size_t i = 0; i < sent_count; i++) {
+		zassert_equal(sent[i].len, CHUNK_LEN, NULL);
+	}
+
+	/* The partial chunk is sent when the link is idle. */
+	for (size_t i = 0; i < CONFIG_BT_GATT_NUS_STREAM_TX_MAX; i++) {
+		sent_complete(i);
+	}
+	k_sleep(K_MSEC(10));
+
+	zassert_equal(sent_count, CONFIG_BT_GATT_NUS_STREAM_TX_MAX + 1, NULL);
+	zassert_equal(sent[sent_count - 1].len, 5, NULL);
+}
+
+static void test_restart_after_disconnect(void)
+{
+	size_t stale_count;
+
+	/* The link is lost with all notifications in flight. */
+	stream_write(CONFIG_BT_GATT_NUS_STREAM_TX_MAX * CHUNK_LEN);
+	zassert_equal(sent_count, CONFIG_BT_GATT_NUS_STREAM_TX_MAX, NULL);
+	stale_count = sent_count;
+
+	bt_gatt_nus_stream_stop();
+	zassert_equal(bt_gatt_nus_stream_start(conn), 0, NULL);
+
+	/* The restarted stream is idle, so a partial chunk is sent. */
+	stream_write(5);
+	zassert_equal(sent_count, stale_count + 1, NULL);
+	zassert_equal(sent[sent_count - 1].len, 5, NULL);
+
+	/* Late completions of the old stream do not free up slots of the
+	 * new one.
+	 */
+	for (size_t i = 0; i < stale_count; i++) {
+		sent_complete(i);
+	}
+	k_sleep(K_MSEC(10));
+
+	stream_write(CONFIG_BT_GATT_NUS_STREAM_TX_MAX * CHUNK_LEN);
+	zassert_equal(sent_count,
+		      stale_count + CONFIG_BT_GATT_NUS_STREAM_TX_MAX, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(test_nus,
+			 ztest_unit_test_setup_teardown(test_tx_max,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(
+				test_restart_after_disconnect,
+				setup, teardown));
+	ztest_run_test_suite(test_nus);
+}
@@ -0,0 +1,1061 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <sys/byteorder.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/uuid.h>
+#include <bluetooth/scan.h>
+
+#define FILTER_TYPE_CNT (BT_SCAN_FILTER_TYPE_MANUFACTURER_DATA + 1)
+#define FILTER_CNT_MAX 4
+#define ADV_DATA_MAX_LEN 31
+#define ROUNDS 100
+#define REPORTS_PER_ROUND 200
+
+BUILD_ASSERT(CONFIG_BT_SCAN_NAME_CNT <= FILTER_CNT_MAX);
+BUILD_ASSERT(CONFIG_BT_SCAN_SHORT_NAME_CNT <= FILTER_CNT_MAX);
+BUILD_ASSERT(CONFIG_BT_SCAN_ADDRESS_CNT <= FILTER_CNT_MAX);
+BUILD_ASSERT(CONFIG_BT_SCAN_UUID_CNT <= FILTER_CNT_MAX);
+BUILD_ASSERT(CONFIG_BT_SCAN_APPEARANCE_CNT <= FILTER_CNT_MAX);
+BUILD_ASSERT(CONFIG_BT_SCAN_MANUFACTURER_DATA_CNT <= FILTER_CNT_MAX);
+
+static bt_le_scan_cb_t *scan_cb;
+static int conn_create_count;
+static int connecting_error_count;
+
+/* Last report outcome seen by the scan callbacks. */
+static bool report_done;
+static bool report_match;
+static struct bt_scan_filter_match report_status;
+
+/* Bluetooth stack mocks. */
+
+int bt_le_scan_start(const struct bt_le_scan_param *param,
+		     bt_le_scan_cb_t cb)
+{
+	scan_cb = cb;
+
+	return 0;
+}
+
+int bt_le_scan_stop(void)
+{
+	return 0;
+}
+
+int bt_conn_le_create(const bt_addr_le_t *peer,
+		      const struct bt_conn_le_create_param *create_param,
+		      const struct bt_le_conn_param *conn_param,
+		      struct bt_conn **conn)
+{
+	conn_create_count++;
+
+	return -ENOMEM;
+}
+
+void bt_conn_unref(struct bt_conn *conn)
+{
+}
+
+static void scan_filter_match(struct bt_scan_device_info *device_info,
+			      struct bt_scan_filter_match *filter_match,
+			      bool connectable)
+{
+	report_done = true;
+	report_match = true;
+	report_status = *filter_match;
+}
+
+static void scan_filter_no_match(struct bt_scan_device_info *device_info,
+				 bool connectable)
+{
+	report_done = true;
+	report_match = false;
+}
+
+static void scan_connecting_error(struct bt_scan_device_info *device_info)
+{
+	connecting_error_count++;
+}
+
+BT_SCAN_CB_INIT(scan_cb_data, scan_filter_match, scan_filter_no_match,
+		scan_connecting_error, NULL);
+
+/* Reference matcher, comparing each filter in turn as the library did
+ * before the filters were compiled into prefix trees and hash tables.
+ */
+static struct {
+	char name[CONFIG_BT_SCAN_NAME_CNT][CONFIG_BT_SCAN_NAME_MAX_LEN + 1];
+	size_t name_cnt;
+
+	struct {
+		char name[CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN + 1];
+		uint8_t min_len;
+	} short_name[CONFIG_BT_SCAN_SHORT_NAME_CNT];
+	size_t short_name_cnt;
+
+	bt_addr_le_t addr[CONFIG_BT_SCAN_ADDRESS_CNT];
+	size_t addr_cnt;
+
+	struct bt_uuid_128 uuid[CONFIG_BT_SCAN_UUID_CNT];
+	size_t uuid_cnt;
+
+	uint16_t appearance[CONFIG_BT_SCAN_APPEARANCE_CNT];
+	size_t appearance_cnt;
+
+	struct {
+		uint8_t data[CONFIG_BT_SCAN_MANUFACTURER_DATA_MAX_LEN];
+		uint8_t len;
+	} md[CONFIG_BT_SCAN_MANUFACTURER_DATA_CNT];
+	size_t md_cnt;
+
+	uint8_t mode;
+	bool all_mode;
+
+	uint32_t hits[FILTER_TYPE_CNT][FILTER_CNT_MAX];
+} ref;
+
+/* Report outcome of the reference matcher. */
+struct ref_result {
+	bool match;
+	uint8_t match_cnt;
+
+	/* Matched filter of each type. */
+	bool type_match[FILTER_TYPE_CNT];
+	size_t idx[FILTER_TYPE_CNT];
+
+	uint8_t name_len;
+	uint8_t short_name_len;
+
+	uint8_t uuid[CONFIG_BT_SCAN_UUID_CNT];
+	uint8_t uuid_cnt;
+};
+
+static bool ref_uuid_find(const uint8_t *data, uint8_t data_len,
+			  uint8_t uuid_len, const struct bt_uuid *target)
+{
+	for (size_t i = 0; i < data_len; i += uuid_len) {
+		struct bt_uuid_128 uuid;
+
+		zassert_true(bt_uuid_create(&uuid.uuid, &data[i], uuid_len),
+			     NULL);
+
+		if (bt_uuid_cmp(&uuid.uuid, target) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void ref_uuid_check(struct ref_result *res, const uint8_t *data,
+			   uint8_t data_len, uint8_t uuid_len)
+{
+	const size_t type = BT_SCAN_FILTER_TYPE_UUID;
+	uint8_t cnt = 0;
+	bool match;
+
+	for (size_t i = 0; i < ref.uuid_cnt; i++) {
+		if (ref_uuid_find(data, data_len, uuid_len,
+				  &ref.uuid[i].uuid)) {
+			res->uuid[cnt++] = i;
+
+			if (!ref.all_mode) {
+				break;
+			}
+		} else if (ref.all_mode) {
+			break;
+		}
+	}
+
+	res->uuid_cnt = cnt;
+
+	match = ref.all_mode ? (cnt == ref.uuid_cnt) : (cnt > 0);
+	if (!match) {
+		return;
+	}
+
+	for (size_t i = 0; i < cnt; i++) {
+		ref.hits[type][res->uuid[i]]++;
+	}
+
+	res->type_match[type] = true;
+	res->match_cnt++;
+}
+
+static void ref_field_check(struct ref_result *res, uint8_t ad_type,
+			    const uint8_t *data, uint8_t data_len)
+{
+	size_t type;
+	size_t i;
+
+	switch (ad_type) {
+	case BT_DATA_NAME_COMPLETE:
+		if (!(ref.mode & BT_SCAN_NAME_FILTER)) {
+			return;
+		}
+
+		type = BT_SCAN_FILTER_TYPE_NAME;
+		for (i = 0; i < ref.name_cnt; i++) {
+			if (!strncmp(ref.name[i], (const char *)data,
+				     data_len)) {
+				res->name_len = data_len;
+				break;
+			}
+		}
+
+		if (i == ref.name_cnt) {
+			return;
+		}
+		break;
+
+	case BT_DATA_NAME_SHORTENED:
+		if (!(ref.mode & BT_SCAN_SHORT_NAME_FILTER)) {
+			return;
+		}
+
+		type = BT_SCAN_FILTER_TYPE_SHORT_NAME;
+		for (i = 0; i < ref.short_name_cnt; i++) {
+			if ((data_len >= ref.short_name[i].min_len) &&
+			    !strncmp(ref.short_name[i].name,
+				     (const char *)data, data_len)) {
+				res->short_name_len = data_len;
+				break;
+			}
+		}
+
+		if (i == ref.short_name_cnt) {
+			return;
+		}
+		break;
+
+	case BT_DATA_GAP_APPEARANCE:
+		if (!(ref.mode & BT_SCAN_APPEARANCE_FILTER)) {
+			return;
+		}
+
+		type = BT_SCAN_FILTER_TYPE_APPEARANCE;
+		for (i = 0; i < ref.appearance_cnt; i++) {
+			if ((data_len == sizeof(uint16_t)) &&
+			    (sys_get_be16(data) == ref.appearance[i])) {
+				break;
+			}
+		}
+
+		if (i == ref.appearance_cnt) {
+			return;
+		}
+		break;
+
+	case BT_DATA_MANUFACTURER_DATA:
+		if (!(ref.mode & BT_SCAN_MANUFACTURER_DATA_FILTER)) {
+			return;
+		}
+
+		type = BT_SCAN_FILTER_TYPE_MANUFACTURER_DATA;
+		for (i = 0; i < ref.md_cnt; i++) {
+			if ((ref.md[i].len <= data_len) &&
+			    !memcmp(ref.md[i].data, data, ref.md[i].len)) {
+				break;
+			}
+		}
+
+		if (i == ref.md_cnt) {
+			return;
+		}
+		break;
+
+	case BT_DATA_UUID16_SOME:
+	case BT_DATA_UUID16_ALL:
+		if (ref.mode & BT_SCAN_UUID_FILTER) {
+			ref_uuid_check(res, data, data_len, 2);
+		}
+		return;
+
+	case BT_DATA_UUID32_SOME:
+	case BT_DATA_UUID32_ALL:
+		if (ref.mode & BT_SCAN_UUID_FILTER) {
+			ref_uuid_check(res, data, data_len, 4);
+		}
+		return;
+
+	case BT_DATA_UUID128_SOME:
+	case BT_DATA_UUID128_ALL:
+		if (ref.mode & BT_SCAN_UUID_FILTER) {
+			ref_uuid_check(res, data, data_len, 16);
+		}
+		return;
+
+	default:
+		return;
+	}
+
+	ref.hits[type][i]++;
+	res->type_match[type] = true;
+	res->idx[type] = i;
+	res->match_cnt++;
+}
+
+static void ref_report(struct ref_result *res, const bt_addr_le_t *addr,
+		       const uint8_t *ad, size_t ad_len)
+{
+	const size_t type = BT_SCAN_FILTER_TYPE_ADDR;
+	uint8_t filter_cnt = 0;
+	bool any_match = false;
+
+	memset(res, 0, sizeof(*res));
+
+	for (uint8_t mode = ref.mode; mode; mode &= mode - 1) {
+		filter_cnt++;
+	}
+
+	if (ref.mode & BT_SCAN_ADDR_FILTER) {
+		for (size_t i = 0; i < ref.addr_cnt; i++) {
+			if (!bt_addr_le_cmp(addr, &ref.addr[i])) {
+				ref.hits[type][i]++;
+				res->type_match[type] = true;
+				res->idx[type] = i;
+				res->match_cnt++;
+				break;
+			}
+		}
+	}
+
+	/* Same walk as bt_data_parse(). */
+	while (ad_len > 1) {
+		uint8_t len = ad[0];
+
+		if ((len == 0) || (len > ad_len - 1)) {
+			break;
+		}
+
+		ref_field_check(res, ad[1], &ad[2], len - 1);
+
+		ad += len + 1;
+		ad_len -= len + 1;
+	}
+
+	for (size_t i = 0; i < FILTER_TYPE_CNT; i++) {
+		any_match |= res->type_match[i];
+	}
+
+	res->match = ref.all_mode ? (res->match_cnt == filter_cnt) : any_match;
+}
+
+/* Deterministic pseudo-random numbers (xorshift32). */
+static uint32_t rand_state;
+
+static uint32_t rand_get(uint32_t n)
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+
+	return rand_state % n;
+}
+
+/* Names over a small alphabet, so that they share prefixes. */
+static size_t name_gen(char *name, size_t max_len, bool nul)
+{
+	const char alphabet[] = "abc";
+	size_t len = rand_get(max_len) + 1;
+
+	for (size_t i = 0; i < len; i++) {
+		name[i] = alphabet[rand_get(sizeof(alphabet) - 1)];
+	}
+
+	if (nul && !rand_get(4)) {
+		name[rand_get(len)] = '\0';
+	}
+
+	name[len] = '\0';
+
+	return len;
+}
+
+static void addr_get(bt_addr_le_t *addr, uint32_t index)
+{
+	addr->type = BT_ADDR_LE_RANDOM;
+	sys_put_le32(index * 0x9e3779b9, &addr->a.val[0]);
+	sys_put_le16(0xc000 | index, &addr->a.val[4]);
+}
+
+static void addr_gen(bt_addr_le_t *addr)
+{
+	addr_get(addr, rand_get(2 * CONFIG_BT_SCAN_ADDRESS_CNT));
+}
+
+/* Bluetooth Base UUID in little-endian order, without the 32-bit value. */
+static const uint8_t base_uuid[12] = {
+	0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00
+};
+
+static const uint8_t custom_uuid[16] = {
+	0x9e, 0xca, 0xdc, 0x24, 0x0e, 0xe5, 0xa9, 0xe0,
+	0x93, 0xf3, 0xa3, 0xb5, 0x01, 0x00, 0x40, 0x6e
+};
+
+/* UUID values; the last one stands for the custom 128-bit UUID. */
+static const uint32_t uuid_vals[] = {
+	0x180d, 0x180f, 0x1812, 0x12345678, 0
+};
+
+/* Encodes a UUID in the given length, or returns 0 if it does not fit. */
+static uint8_t uuid_gen(uint8_t *buf, size_t val_idx, uint8_t len)
+{
+	uint32_t val = uuid_vals[val_idx];
+	bool custom = (val_idx == ARRAY_SIZE(uuid_vals) - 1);
+
+	switch (len) {
+	case 2:
+		if (custom || (val > UINT16_MAX)) {
+			return 0;
+		}
+
+		sys_put_le16(val, buf);
+		break;
+
+	case 4:
+		if (custom) {
+			return 0;
+		}
+
+		sys_put_le32(val, buf);
+		break;
+
+	default:
+		if (custom) {
+			memcpy(buf, custom_uuid, sizeof(custom_uuid));
+		} else {
+			memcpy(buf, base_uuid, sizeof(base_uuid));
+			sys_put_le32(val, &buf[sizeof(base_uuid)]);
+		}
+		break;
+	}
+
+	return len;
+}
+
+static const uint16_t appearances[] = { 0x03c1, 0x03c2, 0x0340 };
+
+static const uint8_t md_pool[][3] = {
+	{ 0x59, 0x00, 0x01 },
+	{ 0x59, 0x00, 0x02 },
+	{ 0x4c, 0x00, 0x02 },
+};
+
+static size_t md_gen(uint8_t *buf, size_t max_len)
+{
+	size_t len = rand_get(max_len) + 1;
+	const uint8_t *pool = md_pool[rand_get(ARRAY_SIZE(md_pool))];
+
+	for (size_t i = 0; i < len; i++) {
+		buf[i] = (i < sizeof(md_pool[0])) ? pool[i] : rand_get(4);
+	}
+
+	return len;
+}
+
+static void filters_gen(void)
+{
+	uint8_t buf[16];
+	int err;
+
+	bt_scan_filter_remove_all();
+	memset(&ref, 0, sizeof(ref));
+
+	for (size_t n = rand_get(CONFIG_BT_SCAN_NAME_CNT + 1); n; n--) {
+		char name[CONFIG_BT_SCAN_NAME_MAX_LEN + 1];
+		size_t i;
+
+		name_gen(name, 4, false);
+		err = bt_scan_filter_add(BT_SCAN_FILTER_TYPE_NAME, name);
+		zassert_equal(err, 0, "Name filter add failed: %d", err);
+
+		for (i = 0; i < ref.name_cnt; i++) {
+			if (!strcmp(ref.name[i], name)) {
+				break;
+			}
+		}
+
+		if (i == ref.name_cnt) {
+			strcpy(ref.name[ref.name_cnt++], name);
+		}
+	}
+
+	for (size_t n = rand_get(CONFIG_BT_SCAN_SHORT_NAME_CNT + 1); n; n--) {
+		char name[CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN + 1];
+		struct bt_scan_short_name short_name = {
+			.name = name,
+		};
+		size_t i;
+
+		short_name.min_len = rand_get(name_gen(name, 4, false) + 1);
+		err = bt_scan_filter_add(BT_SCAN_FILTER_TYPE_SHORT_NAME,
+					 &short_name);
+		zassert_equal(err, 0, "Short name filter add failed: %d", err);
+
+		for (i = 0; i < ref.short_name_cnt; i++) {
+			if (!strcmp(ref.short_name[i].name, name)) {
+				break;
+			}
+		}
+
+		if (i == ref.short_name_cnt) {
+			strcpy(ref.short_name[i].name, name);
+			ref.short_name[i].min_len = short_name.min_len;
+			ref.short_name_cnt++;
+		}
+	}
+
+	for (size_t n = rand_get(CONFIG_BT_SCAN_ADDRESS_CNT + 1); n; n--) {
+		bt_addr_le_t addr;
+		size_t i;
+
+		addr_gen(&addr);
+		err = bt_scan_filter_add(BT_SCAN_FILTER_TYPE_ADDR, &addr);
+		zassert_equal(err, 0, "Address filter add failed: %d", err);
+
+		for (i = 0; i < ref.addr_cnt; i++) {
+			if (!bt_addr_le_cmp(&ref.addr[i], &addr)) {
+				break;
+			}
+		}
+
+		if (i == ref.addr_cnt) {
+			bt_addr_le_copy(&ref.addr[ref.addr_cnt++], &addr);
+		}
+	}
+
+	for (size_t n = rand_get(CONFIG_BT_SCAN_UUID_CNT + 1); n; n--) {
+		const uint8_t lens[] = { 2, 4, 16 };
+		struct bt_uuid_128 uuid;
+		uint8_t len;
+		size_t i;
+
+		do {
+			len = uuid_gen(buf, rand_get(ARRAY_SIZE(uuid_vals)),
+				       lens[rand_get(ARRAY_SIZE(lens))]);
+		} while (!len);
+
+		zassert_true(bt_uuid_create(&uuid.uuid, buf, len), NULL);
+		err = bt_scan_filter_add(BT_SCAN_FILTER_TYPE_UUID, &uuid);
+		zassert_equal(err, 0, "UUID filter add failed: %d", err);
+
+		for (i = 0; i < ref.uuid_cnt; i++) {
+			if (!bt_uuid_cmp(&ref.uuid[i].uuid, &uuid.uuid)) {
+				break;
+			}
+		}
+
+		if (i == ref.uuid_cnt) {
+			ref.uuid[ref.uuid_cnt++] = uuid;
+		}
+	}
+
+	for (size_t n = rand_get(CONFIG_BT_SCAN_APPEARANCE_CNT + 1); n; n--) {
+		uint16_t appearance =
+			appearances[rand_get(ARRAY_SIZE(appearances))];
+		size_t i;
+
+		err = bt_scan_filter_add(BT_SCAN_FILTER_TYPE_APPEARANCE,
+					 &appearance);
+		zassert_equal(err, 0, "Appearance filter add failed: %d", err);
+
+		for (i = 0; i < ref.appearance_cnt; i++) {
+			if (ref.appearance[i] == appearance) {
+				break;
+			}
+		}
+
+		if (i == ref.appearance_cnt) {
+			ref.appearance[ref.appearance_cnt++] = appearance;
+		}
+	}
+
+	for (size_t n = rand_get(CONFIG_BT_SCAN_MANUFACTURER_DATA_CNT + 1); n;
+	     n--) {
+		struct bt_scan_manufacturer_data md = {
+			.data = buf,
+		};
+		size_t i;
+
+		md.data_len = md_gen(buf, 4);
+		err = bt_scan_filter_add(BT_SCAN_FILTER_TYPE_MANUFACTURER_DATA,
+					 &md);
+		zassert_equal(err, 0, "Manufacturer data filter add failed: %d",
+			      err);
+
+		/* A filter is a duplicate if its data starts with the data
+		 * of an existing filter.
+		 */
+		for (i = 0; i < ref.md_cnt; i++) {
+			if ((ref.md[i].len <= md.data_len) &&
+			    !memcmp(ref.md[i].data, buf, ref.md[i].len)) {
+				break;
+			}
+		}
+
+		if (i == ref.md_cnt) {
+			memcpy(ref.md[i].data, buf, md.data_len);
+			ref.md[i].len = md.data_len;
+			ref.md_cnt++;
+		}
+	}
+
+	ref.mode = rand_get(BT_SCAN_ALL_FILTER) + 1;
+	ref.all_mode = rand_get(2);
+
+	err = bt_scan_filter_enable(ref.mode, ref.all_mode);
+	zassert_equal(err, 0, "Filter enable failed: %d", err);
+}
+
+static size_t field_gen(uint8_t *buf, size_t max_len)
+{
+	const uint8_t uuid_types[][2] = {
+		{ BT_DATA_UUID16_ALL, 2 },
+		{ BT_DATA_UUID16_SOME, 2 },
+		{ BT_DATA_UUID32_ALL, 4 },
+		{ BT_DATA_UUID128_ALL, 16 },
+		{ BT_DATA_UUID128_SOME, 16 },
+	};
+	uint8_t data[ADV_DATA_MAX_LEN];
+	uint8_t type;
+	size_t len = 0;
+
+	if (max_len < 2) {
+		return 0;
+	}
+
+	switch (rand_get(6)) {
+	case 0:
+		type = BT_DATA_NAME_COMPLETE;
+		len = name_gen((char *)data, CONFIG_BT_SCAN_NAME_MAX_LEN + 1,
+			       true);
+		break;
+
+	case 1:
+		type = BT_DATA_NAME_SHORTENED;
+		len = name_gen((char *)data,
+			       CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN + 1, true);
+		break;
+
+	case 2:
+		type = BT_DATA_GAP_APPEARANCE;
+		sys_put_be16(appearances[rand_get(ARRAY_SIZE(appearances))],
+			     data);
+		data[2] = 0;
+		len = sizeof(uint16_t) + !rand_get(8);
+		break;
+
+	case 3:
+		type = BT_DATA_MANUFACTURER_DATA;
+		len = md_gen(data, 6);
+		break;
+
+	case 4: {
+		size_t t = rand_get(ARRAY_SIZE(uuid_types));
+
+		type = uuid_types[t][0];
+		for (size_t n = rand_get(3) + 1; n; n--) {
+			if (len + uuid_types[t][1] > max_len - 2) {
+				break;
+			}
+
+			len += uuid_gen(&data[len],
+					rand_get(ARRAY_SIZE(uuid_vals)),
+					uuid_types[t][1]);
+		}
+		break;
+	}
+
+	default:
+		type = BT_DATA_FLAGS;
+		data[0] = BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR;
+		len = 1;
+		break;
+	}
+
+	if (len + 2 > max_len) {
+		return 0;
+	}
+
+	buf[0] = len + 1;
+	buf[1] = type;
+	memcpy(&buf[2], data, len);
+
+	return len + 2;
+}
+
+static size_t report_gen(uint8_t *ad)
+{
+	size_t len = 0;
+
+	for (size_t n = rand_get(5); n; n--) {
+		size_t field_len = field_gen(&ad[len], ADV_DATA_MAX_LEN - len);
+
+		if (!field_len) {
+			break;
+		}
+
+		len += field_len;
+	}
+
+	/* Early termination and truncated fields. */
+	if ((len < ADV_DATA_MAX_LEN - 2) && !rand_get(16)) {
+		ad[len++] = rand_get(2) ? 0 : ADV_DATA_MAX_LEN;
+		ad[len++] = BT_DATA_NAME_COMPLETE;
+	}
+
+	return len;
+}
+
+/* Returns true if the report is passed on to the callbacks. */
+static bool report_send(const bt_addr_le_t *addr, int8_t rssi,
+			uint8_t adv_type, uint8_t *ad, size_t len)
+{
+	struct net_buf_simple buf;
+
+	net_buf_simple_init_with_data(&buf, ad, len);
+
+	report_done = false;
+	scan_cb(addr, rssi, adv_type, &buf);
+
+	/* The buffer is left untouched for the application. */
+	zassert_equal_ptr(buf.data, ad, NULL);
+	zassert_equal(buf.len, len, NULL);
+
+	return report_done;
+}
+
+static void status_check(const struct ref_result *res)
+{
+	const struct bt_scan_filter_match *status = &report_status;
+	size_t idx;
+
+	zassert_equal(status->name.match,
+		      res->type_match[BT_SCAN_FILTER_TYPE_NAME], NULL);
+	if (status->name.match) {
+		idx = res->idx[BT_SCAN_FILTER_TYPE_NAME];
+		zassert_false(strcmp(status->name.name, ref.name[idx]), NULL);
+		zassert_equal(status->name.len, res->name_len, NULL);
+	}
+
+	zassert_equal(status->short_name.match,
+		      res->type_match[BT_SCAN_FILTER_TYPE_SHORT_NAME], NULL);
+	if (status->short_name.match) {
+		idx = res->idx[BT_SCAN_FILTER_TYPE_SHORT_NAME];
+		zassert_false(strcmp(status->short_name.name,
+				     ref.short_name[idx].name), NULL);
+		zassert_equal(status->short_name.len, res->short_name_len,
+			      NULL);
+	}
+
+	zassert_equal(status->addr.match,
+		      res->type_match[BT_SCAN_FILTER_TYPE_ADDR], NULL);
+	if (status->addr.match) {
+		idx = res->idx[BT_SCAN_FILTER_TYPE_ADDR];
+		zassert_false(bt_addr_le_cmp(status->addr.addr,
+					     &ref.addr[idx]), NULL);
+	}
+
+	zassert_equal(status->uuid.match,
+		      res->type_match[BT_SCAN_FILTER_TYPE_UUID], NULL);
+	if (status->uuid.match) {
+		zassert_equal(status->uuid.count, res->uuid_cnt, NULL);
+		for (size_t i = 0; i < res->uuid_cnt; i++) {
+			idx = res->uuid[i];
+			zassert_false(bt_uuid_cmp(status->uuid.uuid[i],
+						  &ref.uuid[idx].uuid), NULL);
+		}
+	}
+
+	zassert_equal(status->appearance.match,
+		      res->type_match[BT_SCAN_FILTER_TYPE_APPEARANCE], NULL);
+	if (status->appearance.match) {
+		idx = res->idx[BT_SCAN_FILTER_TYPE_APPEARANCE];
+		zassert_equal(*status->appearance.appearance,
+			      ref.appearance[idx], NULL);
+	}
+
+	zassert_equal(status->manufacturer_data.match,
+		      res->type_match[BT_SCAN_FILTER_TYPE_MANUFACTURER_DATA],
+		      NULL);
+	if (status->manufacturer_data.match) {
+		idx = res->idx[BT_SCAN_FILTER_TYPE_MANUFACTURER_DATA];
+		zassert_equal(status->manufacturer_data.len, ref.md[idx].len,
+			      NULL);
+		zassert_false(memcmp(status->manufacturer_data.data,
+				     ref.md[idx].data, ref.md[idx].len), NULL);
+	}
+}
+
+static void hits_check(void)
+{
+	for (size_t type = 0; type < FILTER_TYPE_CNT; type++) {
+		uint32_t hits[FILTER_CNT_MAX];
+		size_t count = ARRAY_SIZE(hits);
+		int err;
+
+		err = bt_scan_filter_hits_get(type, hits, &count);
+		zassert_equal(err, 0, NULL);
+
+		for (size_t i = 0; i < count; i++) {
+			zassert_equal(hits[i], ref.hits[type][i],
+				      "Filter type %d index %d: %u hits, "
+				      "expected %u", (int)type, (int)i,
+				      hits[i], ref.hits[type][i]);
+		}
+	}
+}
+
+static void setup(void)
+{
+	bt_scan_init(NULL);
+	zassert_equal(bt_scan_start(BT_SCAN_TYPE_SCAN_PASSIVE), 0, NULL);
+	zassert_not_null(scan_cb, NULL);
+}
+
+static void teardown(void)
+{
+	bt_scan_stop();
+}
+
+static void test_replay(void)
+{
+	uint8_t ad[ADV_DATA_MAX_LEN];
+	struct ref_result res;
+	bt_addr_le_t addr;
+	size_t len;
+
+	rand_state = 0x2545f491;
+
+	for (size_t round = 0; round < ROUNDS; round++) {
+		filters_gen();
+
+		for (size_t n = 0; n < REPORTS_PER_ROUND; n++) {
+			addr_gen(&addr);
+			len = report_gen(ad);
+
+			/* The duplicate filter is tested separately. */
+			bt_scan_duplicate_cache_clear();
+
+			ref_report(&res, &addr, ad, len);
+			zassert_true(report_send(&addr, -40,
+						 BT_GAP_ADV_TYPE_ADV_IND,
+						 ad, len), NULL);
+
+			zassert_equal(report_match, res.match,
+				      "Round %d report %d", (int)round, (int)n);
+			if (res.match) {
+				status_check(&res);
+			}
+		}
+
+		hits_check();
+	}
+}
+
+static void name_report_send(const char *name, size_t len)
+{
+	const bt_addr_le_t addr = {
+		.type = BT_ADDR_LE_RANDOM,
+	};
+	uint8_t ad[ADV_DATA_MAX_LEN];
+
+	ad[0] = len + 1;
+	ad[1] = BT_DATA_NAME_COMPLETE;
+	memcpy(&ad[2], name, len);
+
+	zassert_true(report_send(&addr, -40, BT_GAP_ADV_TYPE_ADV_IND, ad,
+				 len + 2), NULL);
+}
+
+static void test_name_nul(void)
+{
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_NAME, "abc"),
+		      0, NULL);
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_NAME, "abcde"),
+		      0, NULL);
+	zassert_equal(bt_scan_filter_enable(BT_SCAN_NAME_FILTER, false), 0,
+		      NULL);
+
+	/* A name padded with NUL characters ends at the first one. */
+	name_report_send("abc\0", 4);
+	zassert_true(report_match, NULL);
+	zassert_false(strcmp(report_status.name.name, "abc"), NULL);
+
+	name_report_send("abcde\0\0", 7);
+	zassert_true(report_match, NULL);
+	zassert_false(strcmp(report_status.name.name, "abcde"), NULL);
+
+	name_report_send("abcd\0", 5);
+	zassert_false(report_match, NULL);
+
+	name_report_send("ab\0", 3);
+	zassert_false(report_match, NULL);
+
+	/* Advertised names may be shortened. */
+	name_report_send("abcd", 4);
+	zassert_true(report_match, NULL);
+	zassert_false(strcmp(report_status.name.name, "abcde"), NULL);
+}
+
+static bool dup_report_send(uint32_t index, int8_t rssi, uint8_t adv_type,
+			    uint8_t data)
+{
+	uint8_t ad[] = { 2, BT_DATA_MANUFACTURER_DATA, data };
+	bt_addr_le_t addr;
+
+	addr_get(&addr, index);
+
+	return report_send(&addr, rssi, adv_type, ad, sizeof(ad));
+}
+
+static void dup_stats_check(uint32_t passed, uint32_t suppressed,
+			    uint32_t evicted)
+{
+	struct bt_scan_duplicate_stats stats;
+
+	bt_scan_duplicate_stats_get(&stats);
+	zassert_equal(stats.passed, passed, NULL);
+	zassert_equal(stats.suppressed, suppressed, NULL);
+	zassert_equal(stats.evicted, evicted, NULL);
+}
+
+static void test_dup_ttl(void)
+{
+	const uint8_t type = BT_GAP_ADV_TYPE_ADV_NONCONN_IND;
+
+	bt_scan_duplicate_filter_set(100, 0);
+
+	zassert_true(dup_report_send(0, -40, type, 0), NULL);
+	zassert_false(dup_report_send(0, -40, type, 0), NULL);
+
+	/* Reports of another advertising type are tracked separately. */
+	zassert_true(dup_report_send(0, -40, BT_GAP_ADV_TYPE_SCAN_RSP, 0),
+		     NULL);
+
+	k_sleep(K_MSEC(50));
+	zassert_false(dup_report_send(0, -40, type, 0), NULL);
+
+	/* The time-out counts from the last report passed on. */
+	k_sleep(K_MSEC(100));
+	zassert_true(dup_report_send(0, -40, type, 0), NULL);
+	zassert_false(dup_report_send(0, -40, type, 0), NULL);
+
+	/* Changed advertising data is passed on at once. */
+	zassert_true(dup_report_send(0, -40, type, 1), NULL);
+
+	dup_stats_check(4, 3, 0);
+}
+
+static void test_dup_rssi(void)
+{
+	const uint8_t type = BT_GAP_ADV_TYPE_ADV_NONCONN_IND;
+
+	bt_scan_duplicate_filter_set(0, 10);
+
+	zassert_true(dup_report_send(0, -40, type, 0), NULL);
+	zassert_false(dup_report_send(0, -45, type, 0), NULL);
+	zassert_false(dup_report_send(0, -31, type, 0), NULL);
+
+	/* The change is relative to the last report passed on. */
+	zassert_true(dup_report_send(0, -30, type, 0), NULL);
+	zassert_false(dup_report_send(0, -39, type, 0), NULL);
+	zassert_true(dup_report_send(0, -40, type, 0), NULL);
+
+	dup_stats_check(3, 3, 0);
+}
+
+static void test_dup_lru(void)
+{
+	const uint8_t type = BT_GAP_ADV_TYPE_ADV_NONCONN_IND;
+
+	bt_scan_duplicate_filter_set(0, 0);
+
+	for (uint32_t i = 0; i < CONFIG_BT_SCAN_DUPLICATE_CACHE_SIZE; i++) {
+		zassert_true(dup_report_send(i, -40, type, 0), NULL);
+	}
+
+	/* Device 0 becomes the most recently seen. */
+	zassert_false(dup_report_send(0, -40, type, 0), NULL);
+
+	/* Device 1, seen least recently, is replaced. */
+	zassert_true(dup_report_send(CONFIG_BT_SCAN_DUPLICATE_CACHE_SIZE, -40,
+				     type, 0), NULL);
+	zassert_true(dup_report_send(1, -40, type, 0), NULL);
+	zassert_false(dup_report_send(0, -40, type, 0), NULL);
+
+	/* Device 2 was replaced by device 1. */
+	zassert_true(dup_report_send(2, -40, type, 0), NULL);
+
+	dup_stats_check(CONFIG_BT_SCAN_DUPLICATE_CACHE_SIZE + 3, 2, 3);
+}
+
+static void test_dup_connect(void)
+{
+	const struct bt_scan_init_param init = {
+		.connect_if_match = true,
+	};
+	bt_addr_le_t addr;
+
+	addr_get(&addr, 0);
+
+	bt_scan_init(&init);
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_ADDR, &addr), 0,
+		      NULL);
+	zassert_equal(bt_scan_filter_enable(BT_SCAN_ADDR_FILTER, false), 0,
+		      NULL);
+	zassert_equal(bt_scan_start(BT_SCAN_TYPE_SCAN_PASSIVE), 0, NULL);
+	bt_scan_duplicate_filter_set(0, 0);
+
+	conn_create_count = 0;
+	connecting_error_count = 0;
+
+	/* A failed connection is retried on the next report. */
+	zassert_true(dup_report_send(0, -40, BT_GAP_ADV_TYPE_ADV_IND, 0),
+		     NULL);
+	zassert_true(report_match, NULL);
+	zassert_equal(conn_create_count, 1, NULL);
+	zassert_equal(connecting_error_count, 1, NULL);
+
+	zassert_true(dup_report_send(0, -40, BT_GAP_ADV_TYPE_ADV_IND, 0),
+		     NULL);
+	zassert_equal(conn_create_count, 2, NULL);
+	zassert_equal(connecting_error_count, 2, NULL);
+
+	/* Other reports are still suppressed. */
+	zassert_true(dup_report_send(0, -40, BT_GAP_ADV_TYPE_SCAN_RSP, 0),
+		     NULL);
+	zassert_false(dup_report_send(0, -40, BT_GAP_ADV_TYPE_SCAN_RSP, 0),
+		      NULL);
+	zassert_equal(conn_create_count, 3, NULL);
+
+	dup_stats_check(1, 1, 0);
+}
+
+void test_main(void)
+{
+	bt_scan_cb_register(&scan_cb_data);
+
+	ztest_test_suite(test_scan,
+			 ztest_unit_test_setup_teardown(test_replay,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_name_nul,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_dup_ttl,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_dup_rssi,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_dup_lru,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_dup_connect,
+							setup, teardown));
+	ztest_run_test_suite(test_scan);
+}
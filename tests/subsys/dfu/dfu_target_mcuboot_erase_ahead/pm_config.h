@@ -0,0 +1,7 @@
+/* generated file copied to simplify building the test */
+#ifndef PM_CONFIG_H__
+#define PM_CONFIG_H__
+#define PM_MCUBOOT_SECONDARY_ID 2
+#define PM_MCUBOOT_SECONDARY_ADDRESS 0x82000
+#define PM_MCUBOOT_SECONDARY_SIZE 0x5e000
+#endif /* PM_CONFIG_H__ */
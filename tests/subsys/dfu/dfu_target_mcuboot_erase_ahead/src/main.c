@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <device.h>
+#include <drivers/flash.h>
+#include <storage/flash_map.h>
+#include <dfu/mcuboot.h>
+#include <pm_config.h>
+#include <dfu_target.h>
+#include <dfu_target_mcuboot.h>
+#include <dfu_flash_pipe.h>
+
+#define PAGE_SIZE CONFIG_DFU_TARGET_MCUBOOT_PAGE_SIZE
+#define SLOT_SIZE PM_MCUBOOT_SECONDARY_SIZE
+#define IMAGE_SIZE (64 * PAGE_SIZE + 123)
+/* Largest chunk written at a time, as a download fragment. */
+#define FRAGMENT_SIZE_MAX 1024
+/* Time between fragments while the download waits for data. */
+#define FRAGMENT_INTERVAL_MS 20
+
+/* Flash timing of the nRF9160. */
+#define ERASE_TIME_US 87500
+#define WRITE_WORD_TIME_US 41
+#define ERASED_VAL 0xff
+#define FLASH_DEV_NAME "FLASH_MOCK"
+
+/* Flash simulator, standing in for the MCUboot secondary slot. */
+static uint8_t flash[SLOT_SIZE];
+static bool flash_open;
+static uint32_t flash_erases;
+static size_t flash_page_size;
+
+static const struct flash_area slot = {
+	.fa_id = PM_MCUBOOT_SECONDARY_ID,
+	.fa_off = PM_MCUBOOT_SECONDARY_ADDRESS,
+	.fa_size = SLOT_SIZE,
+	.fa_dev_name = FLASH_DEV_NAME,
+};
+
+/* Flash device, only used to look up the page size. */
+static const struct flash_driver_api flash_mock_api;
+
+static int flash_mock_init(struct device *dev)
+{
+	return 0;
+}
+
+DEVICE_AND_API_INIT(flash_mock, FLASH_DEV_NAME, flash_mock_init, NULL, NULL,
+		    POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEVICE,
+		    &flash_mock_api);
+
+int z_impl_flash_get_page_info_by_offs(struct device *dev, off_t offset,
+				       struct flash_pages_info *info)
+{
+	info->start_offset = ROUND_DOWN(offset, flash_page_size);
+	info->size = flash_page_size;
+	info->index = offset / flash_page_size;
+
+	return 0;
+}
+
+int flash_area_open(uint8_t id, const struct flash_area **fa)
+{
+	zassert_equal(id, PM_MCUBOOT_SECONDARY_ID, NULL);
+	zassert_false(flash_open, "Flash area opened twice");
+
+	flash_open = true;
+	*fa = &slot;
+
+	return 0;
+}
+
+void flash_area_close(const struct flash_area *fa)
+{
+	zassert_true(flash_open, NULL);
+	flash_open = false;
+}
+
+int flash_area_read(const struct flash_area *fa, off_t off, void *dst,
+		    size_t len)
+{
+	zassert_true(off + len <= SLOT_SIZE, NULL);
+	memcpy(dst, flash + off, len);
+
+	return 0;
+}
+
+int flash_area_write(const struct flash_area *fa, off_t off, const void *src,
+		     size_t len)
+{
+	const uint8_t *data = src;
+
+	/* Small fragments are coalesced into page writes. */
+	zassert_equal(off % PAGE_SIZE, 0, "Unaligned write at 0x%x",
+		      (uint32_t)off);
+	zassert_equal(len, PAGE_SIZE, "Partial page write");
+
+	for (size_t i = 0; i < len; i++) {
+		zassert_equal(flash[off + i], ERASED_VAL,
+			      "Write to page 0x%x that is not blank",
+			      (uint32_t)off);
+	}
+
+	memcpy(flash + off, data, len);
+	k_busy_wait(len / sizeof(uint32_t) * WRITE_WORD_TIME_US);
+
+	return 0;
+}
+
+int flash_area_erase(const struct flash_area *fa, off_t off, size_t len)
+{
+	zassert_equal(off % PAGE_SIZE, 0, NULL);
+	zassert_equal(len % PAGE_SIZE, 0, NULL);
+	zassert_true(off + len <= SLOT_SIZE, NULL);
+
+	memset(flash + off, ERASED_VAL, len);
+	flash_erases += len / PAGE_SIZE;
+
+	/* The CPU stalls while a page is erased. */
+	k_busy_wait(len / PAGE_SIZE * ERASE_TIME_US);
+
+	return 0;
+}
+
+uint8_t flash_area_erased_val(const struct flash_area *fa)
+{
+	return ERASED_VAL;
+}
+
+static bool upgrade_requested;
+
+int boot_request_upgrade(int permanent)
+{
+	/* The image trailer is written to the last page. */
+	for (size_t i = SLOT_SIZE - PAGE_SIZE; i < SLOT_SIZE; i++) {
+		zassert_equal(flash[i], ERASED_VAL, "Trailer page not blank");
+	}
+
+	upgrade_requested = true;
+
+	return 0;
+}
+
+static uint8_t image[IMAGE_SIZE];
+static uint32_t rand_state = 1;
+
+static size_t fragment_size(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+
+	return 1 + (rand_state >> 16) % FRAGMENT_SIZE_MAX;
+}
+
+struct download_result {
+	uint32_t total_ms;
+	uint32_t max_stall_us;
+	struct dfu_flash_pipe_stats stats;
+};
+
+static void download(int interval_ms, struct download_result *result)
+{
+	uint32_t start = k_uptime_get_32();
+	uint32_t cycles;
+	uint32_t stall;
+	size_t offset = 0;
+	size_t n;
+
+	memset(result, 0, sizeof(*result));
+	upgrade_requested = false;
+
+	zassert_equal(dfu_target_mcuboot_init(IMAGE_SIZE, NULL), 0, NULL);
+
+	while (offset < IMAGE_SIZE) {
+		n = MIN(fragment_size(), IMAGE_SIZE - offset);
+
+		cycles = k_cycle_get_32();
+		zassert_equal(dfu_target_mcuboot_write(image + offset, n), 0,
+			      NULL);
+		stall = k_cyc_to_us_floor32(k_cycle_get_32() - cycles);
+		result->max_stall_us = MAX(result->max_stall_us, stall);
+
+		offset += n;
+
+		if (interval_ms) {
+			k_sleep(K_MSEC(interval_ms));
+		}
+	}
+
+	zassert_equal(dfu_target_mcuboot_offset_get(&n), 0, NULL);
+	zassert_equal(n, IMAGE_SIZE, NULL);
+
+	zassert_equal(dfu_target_mcuboot_done(true), 0, NULL);
+	zassert_true(upgrade_requested, NULL);
+	zassert_false(flash_open, "Flash area not closed");
+
+	result->total_ms = k_uptime_get_32() - start;
+	dfu_flash_pipe_stats_get(&result->stats);
+
+	zassert_mem_equal(flash, image, IMAGE_SIZE, "Image corrupted");
+	for (size_t i = IMAGE_SIZE; i < ROUND_UP(IMAGE_SIZE, PAGE_SIZE); i++) {
+		zassert_equal(flash[i], ERASED_VAL, "Padding not blank");
+	}
+
+	zassert_equal(result->stats.pages_programmed,
+		      ROUND_UP(IMAGE_SIZE, PAGE_SIZE) / PAGE_SIZE, NULL);
+
+	TC_PRINT("DFU of %u bytes: %u ms, worst stall %u us, "
+		 "%u pages erased ahead, %u inline, %u skipped\n",
+		 IMAGE_SIZE, result->total_ms, result->max_stall_us,
+		 result->stats.pages_erased, result->stats.pages_erased_inline,
+		 result->stats.pages_skipped);
+}
+
+static void setup(void)
+{
+	/* Slot holding a previous image. */
+	memset(flash, 0, sizeof(flash));
+	flash_erases = 0;
+	flash_page_size = PAGE_SIZE;
+
+	for (size_t i = 0; i < sizeof(image); i++) {
+		image[i] = fragment_size();
+	}
+}
+
+static void test_erase_ahead(void)
+{
+	struct download_result result;
+
+	download(FRAGMENT_INTERVAL_MS, &result);
+
+	/* Pages are erased while waiting for data, not in the write path. */
+	zassert_equal(result.stats.pages_erased,
+		      result.stats.pages_programmed, NULL);
+	zassert_true(result.max_stall_us < ERASE_TIME_US,
+		     "Write stalled for a page erase");
+}
+
+static void test_erase_blank_skip(void)
+{
+	struct download_result result;
+
+	memset(flash, ERASED_VAL, sizeof(flash));
+
+	download(FRAGMENT_INTERVAL_MS, &result);
+
+	zassert_equal(flash_erases, 0, "Blank page erased");
+	zassert_equal(result.stats.pages_erased, 0, NULL);
+	zassert_equal(result.stats.pages_erased_inline, 0, NULL);
+}
+
+static void test_erase_no_gaps(void)
+{
+	struct download_result result;
+
+	/* Data arriving without pause can outrun the erase-ahead, which then
+	 * falls back to erasing in the write path.
+	 */
+	download(0, &result);
+
+	/* Every page is erased once, and so is the trailer page. */
+	zassert_equal(result.stats.pages_erased +
+		      result.stats.pages_erased_inline,
+		      result.stats.pages_programmed + 1, NULL);
+	zassert_equal(flash_erases, result.stats.pages_programmed + 1, NULL);
+}
+
+static void test_erase_abort(void)
+{
+	size_t offset;
+
+	zassert_equal(dfu_target_mcuboot_init(IMAGE_SIZE, NULL), 0, NULL);
+	zassert_equal(dfu_target_mcuboot_write(image, PAGE_SIZE + 10), 0,
+		      NULL);
+	zassert_equal(dfu_target_mcuboot_offset_get(&offset), 0, NULL);
+	zassert_equal(offset, PAGE_SIZE + 10, NULL);
+
+	zassert_equal(dfu_target_mcuboot_write(image, IMAGE_SIZE), -EFBIG,
+		      NULL);
+
+	zassert_equal(dfu_target_mcuboot_done(false), 0, NULL);
+	zassert_false(flash_open, "Flash area not closed");
+	zassert_equal(dfu_target_mcuboot_offset_get(&offset), 0, NULL);
+	zassert_equal(offset, 0, NULL);
+}
+
+static void test_page_size_check(void)
+{
+	/* Erasing a quarter of a flash page is not possible. */
+	flash_page_size = 4 * PAGE_SIZE;
+	zassert_equal(dfu_target_mcuboot_init(IMAGE_SIZE, NULL), -EINVAL,
+		      NULL);
+	zassert_false(flash_open, "Flash area not closed");
+
+	/* Erasing several flash pages at a time is. */
+	flash_page_size = PAGE_SIZE / 4;
+	zassert_equal(dfu_target_mcuboot_init(IMAGE_SIZE, NULL), 0, NULL);
+	zassert_equal(dfu_target_mcuboot_done(false), 0, NULL);
+	zassert_false(flash_open, "Flash area not closed");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(dfu_target_mcuboot_erase_ahead,
+			 ztest_unit_test_setup_teardown(test_erase_ahead,
+							setup, unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_erase_blank_skip,
+							setup, unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_erase_no_gaps,
+							setup, unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_erase_abort,
+							setup, unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_page_size_check,
+							setup, unit_test_noop));
+	ztest_run_test_suite(dfu_target_mcuboot_erase_ahead);
+}
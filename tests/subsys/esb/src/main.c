@@ -0,0 +1,491 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+
+#include <esb.h>
+#include "radio_sim.h"
+
+#define PIPE 0
+#define PACKETS 1000
+#define PAYLOAD_LENGTH 32
+#define ACK_PAYLOAD_LENGTH 8
+#define RETRANSMIT_DELAY_US 600
+#define THROUGHPUT_PACKETS 200
+
+#define RUN_STEP_US 1000
+#define RUN_TIMEOUT_US 5000000
+
+static uint32_t rx_count;
+static uint32_t rx_invalid;
+static uint32_t rx_next_seq;
+/* Read received payloads with claim and release instead of a copy. */
+static bool rx_claim;
+/* Leave received payloads in the RX FIFO. */
+static bool rx_hold;
+
+static uint32_t tx_total;
+static uint32_t tx_written;
+static uint32_t tx_failed;
+static uint8_t tx_length;
+/* Number of pipes that the payloads are written to in turn. */
+static uint8_t tx_pipes;
+
+static void rx_check(const struct esb_payload *payload)
+{
+	uint32_t seq;
+
+	if (!radio_sim_payload_check(payload->data, payload->length, &seq) ||
+	    seq != rx_next_seq) {
+		rx_invalid++;
+	}
+
+	rx_next_seq = seq + 1;
+	rx_count++;
+}
+
+static void rx_drain(void)
+{
+	static struct esb_payload rx_payload;
+	const struct esb_payload *payload;
+
+	if (rx_claim) {
+		while (esb_claim_rx_payload(&payload) == 0) {
+			rx_check(payload);
+			zassert_equal(esb_release_rx_payload(payload), 0, NULL);
+		}
+	} else {
+		while (esb_read_rx_payload(&rx_payload) == 0) {
+			rx_check(&rx_payload);
+		}
+	}
+}
+
+static void tx_fill(void)
+{
+	static struct esb_payload tx_payload;
+
+	while (tx_written < tx_total) {
+		tx_payload.pipe = PIPE + tx_written % tx_pipes;
+		tx_payload.length = tx_length;
+		radio_sim_payload_fill(tx_payload.data, tx_payload.length,
+				       tx_written);
+		if (esb_write_payload(&tx_payload) != 0) {
+			break;
+		}
+		tx_written++;
+	}
+}
+
+static void event_handler(const struct esb_evt *event)
+{
+	switch (event->evt_id) {
+	case ESB_EVENT_TX_SUCCESS:
+		tx_fill();
+		break;
+
+	case ESB_EVENT_TX_FAILED:
+		tx_failed++;
+		(void)esb_start_tx();
+		break;
+
+	case ESB_EVENT_RX_RECEIVED:
+		if (!rx_hold) {
+			rx_drain();
+		}
+		break;
+	}
+}
+
+static void esb_setup(enum esb_mode mode, enum esb_protocol protocol)
+{
+	struct esb_config config = ESB_DEFAULT_CONFIG;
+
+	if (protocol == ESB_PROTOCOL_ESB) {
+		struct esb_config legacy = ESB_LEGACY_CONFIG;
+
+		config = legacy;
+	}
+
+	config.mode = mode;
+	config.event_handler = event_handler;
+	config.payload_length = PAYLOAD_LENGTH;
+	config.retransmit_delay = RETRANSMIT_DELAY_US;
+	config.retransmit_count = 10;
+
+	rx_count = 0;
+	rx_invalid = 0;
+	rx_next_seq = 0;
+	rx_claim = false;
+	rx_hold = false;
+	tx_total = 0;
+	tx_written = 0;
+	tx_failed = 0;
+	tx_length = PAYLOAD_LENGTH;
+	tx_pipes = 1;
+
+	radio_sim_reset();
+	zassert_equal(esb_init(&config), 0, NULL);
+}
+
+static void peer_start(enum radio_sim_peer_mode mode, bool dpl,
+		       uint8_t length, uint32_t count, uint32_t drop_every)
+{
+	struct radio_sim_peer_config config = {
+		.mode = mode,
+		.dpl = dpl,
+		.fast_ramp_up = IS_ENABLED(CONFIG_ESB_TX_BURST),
+		.pipe = PIPE,
+		.length = length,
+		.count = count,
+		.drop_every = drop_every,
+		.retransmit_delay_us = RETRANSMIT_DELAY_US,
+	};
+
+	radio_sim_peer_start(&config);
+}
+
+static bool prx_done(void)
+{
+	return radio_sim_peer_done();
+}
+
+static bool ptx_done(void)
+{
+	struct radio_sim_peer_stats stats;
+
+	radio_sim_peer_stats_get(&stats);
+
+	return stats.rx >= tx_total && esb_is_idle();
+}
+
+/* Run the simulation until done() and return the elapsed time. */
+static uint32_t run_until(bool (*done)(void))
+{
+	uint64_t start = radio_sim_time_us();
+
+	while (!done() &&
+	       radio_sim_time_us() - start < RUN_TIMEOUT_US) {
+		radio_sim_run(RUN_STEP_US);
+	}
+
+	zassert_true(done(), "Simulation timed out");
+
+	return radio_sim_time_us() - start;
+}
+
+static uint32_t isr_cycles_avg(IRQn_Type irq)
+{
+	struct radio_sim_isr_stats stats;
+
+	radio_sim_isr_stats_get(irq, &stats);
+
+	return stats.count ? (uint32_t)(stats.cycles / stats.count) : 0;
+}
+
+static void print_result(const char *name, uint32_t packets, uint32_t us)
+{
+	TC_PRINT("%s: %u packets/s, radio ISR %u cycles, event ISR %u "
+		 "cycles\n", name, (uint32_t)((uint64_t)packets * 1000000 / us),
+		 isr_cycles_avg(RADIO_IRQn), isr_cycles_avg(ESB_EVT_IRQ));
+}
+
+static void prx_receive(bool claim)
+{
+	struct radio_sim_peer_stats stats;
+	uint32_t us;
+
+	esb_setup(ESB_MODE_PRX, ESB_PROTOCOL_ESB_DPL);
+	rx_claim = claim;
+
+	zassert_equal(esb_start_rx(), 0, NULL);
+	peer_start(RADIO_SIM_PEER_PTX, true, PAYLOAD_LENGTH, PACKETS, 0);
+
+	us = run_until(prx_done);
+	radio_sim_peer_stats_get(&stats);
+
+	print_result(claim ? "PRX claim" : "PRX read", PACKETS, us);
+
+	zassert_equal(rx_count, PACKETS, NULL);
+	zassert_equal(rx_invalid, 0, NULL);
+	zassert_equal(stats.tx, PACKETS, "Unexpected retransmissions");
+	zassert_equal(stats.rx_missed, 0, NULL);
+
+	zassert_equal(esb_stop_rx(), 0, NULL);
+	esb_disable();
+}
+
+static void test_prx_read(void)
+{
+	prx_receive(false);
+}
+
+static void test_prx_claim(void)
+{
+	prx_receive(true);
+}
+
+static void test_prx_legacy(void)
+{
+	esb_setup(ESB_MODE_PRX, ESB_PROTOCOL_ESB);
+
+	zassert_equal(esb_start_rx(), 0, NULL);
+	peer_start(RADIO_SIM_PEER_PTX, false, PAYLOAD_LENGTH, PACKETS, 0);
+
+	run_until(prx_done);
+
+	zassert_equal(rx_count, PACKETS, NULL);
+	zassert_equal(rx_invalid, 0, NULL);
+
+	zassert_equal(esb_stop_rx(), 0, NULL);
+	esb_disable();
+}
+
+/* Packets that arrive while the RX FIFO is full must not overwrite the
+ * payloads in it.
+ */
+static void test_prx_rx_fifo_full(void)
+{
+	struct radio_sim_peer_stats stats;
+	uint32_t count = CONFIG_ESB_RX_FIFO_SIZE + 4;
+
+	esb_setup(ESB_MODE_PRX, ESB_PROTOCOL_ESB_DPL);
+	rx_claim = true;
+	rx_hold = true;
+
+	zassert_equal(esb_start_rx(), 0, NULL);
+	peer_start(RADIO_SIM_PEER_PTX, true, PAYLOAD_LENGTH, count, 0);
+
+	radio_sim_run(20 * RUN_STEP_US);
+	radio_sim_peer_stats_get(&stats);
+
+	zassert_equal(stats.acked, CONFIG_ESB_RX_FIFO_SIZE, NULL);
+	zassert_true(stats.tx > stats.acked, "Peer not retransmitting");
+
+	rx_drain();
+	zassert_equal(rx_count, CONFIG_ESB_RX_FIFO_SIZE, NULL);
+	zassert_equal(rx_invalid, 0, NULL);
+
+	rx_hold = false;
+	run_until(prx_done);
+
+	zassert_equal(rx_count, count, NULL);
+	zassert_equal(rx_invalid, 0, NULL);
+
+	zassert_equal(esb_stop_rx(), 0, NULL);
+	esb_disable();
+}
+
+static void test_claim_release(void)
+{
+	const struct esb_payload *payload;
+	const struct esb_payload *claimed;
+	struct esb_payload copy;
+
+	esb_setup(ESB_MODE_PRX, ESB_PROTOCOL_ESB_DPL);
+	rx_hold = true;
+
+	zassert_equal(esb_claim_rx_payload(&payload), -ENODATA, NULL);
+	zassert_equal(esb_claim_rx_payload(NULL), -EINVAL, NULL);
+
+	zassert_equal(esb_start_rx(), 0, NULL);
+	peer_start(RADIO_SIM_PEER_PTX, true, PAYLOAD_LENGTH, 2, 0);
+	run_until(prx_done);
+
+	zassert_equal(esb_claim_rx_payload(&claimed), 0, NULL);
+	zassert_equal(claimed->length, PAYLOAD_LENGTH, NULL);
+	zassert_equal(claimed->pipe, PIPE, NULL);
+	zassert_false(claimed->noack, NULL);
+	rx_check(claimed);
+
+	zassert_equal(esb_claim_rx_payload(&payload), -EBUSY, NULL);
+	zassert_equal(esb_read_rx_payload(&copy), -EBUSY, NULL);
+	zassert_equal(esb_flush_rx(), -EBUSY, NULL);
+	zassert_equal(esb_release_rx_payload(&copy), -EINVAL, NULL);
+
+	zassert_equal(esb_release_rx_payload(claimed), 0, NULL);
+	zassert_equal(esb_release_rx_payload(claimed), -EINVAL, NULL);
+
+	zassert_equal(esb_read_rx_payload(&copy), 0, NULL);
+	rx_check(&copy);
+	zassert_equal(rx_invalid, 0, NULL);
+
+	zassert_equal(esb_claim_rx_payload(&payload), -ENODATA, NULL);
+	zassert_equal(esb_flush_rx(), 0, NULL);
+
+	zassert_equal(esb_stop_rx(), 0, NULL);
+	esb_disable();
+	zassert_equal(esb_claim_rx_payload(&payload), -EACCES, NULL);
+}
+
+static void ptx_send(const char *name, uint8_t ack_length,
+		     uint32_t drop_every)
+{
+	struct radio_sim_peer_stats stats;
+	uint32_t us;
+
+	esb_setup(ESB_MODE_PTX, ESB_PROTOCOL_ESB_DPL);
+	rx_claim = true;
+	tx_total = drop_every ? PACKETS / 10 : PACKETS;
+
+	peer_start(RADIO_SIM_PEER_PRX, true, ack_length, 0, drop_every);
+	tx_fill();
+
+	us = run_until(ptx_done);
+	radio_sim_peer_stats_get(&stats);
+
+	print_result(name, tx_total, us);
+
+	zassert_equal(stats.rx, tx_total, NULL);
+	zassert_equal(stats.rx_invalid, 0, NULL);
+	zassert_equal(stats.rx_out_of_order, 0, NULL);
+	zassert_equal(stats.rx_missed, 0, NULL);
+	zassert_equal(tx_failed, 0, NULL);
+
+	if (ack_length) {
+		zassert_equal(rx_count, tx_total, NULL);
+		zassert_equal(rx_invalid, 0, NULL);
+	}
+
+	if (drop_every) {
+		zassert_true(stats.rx_dropped > 0, NULL);
+	}
+
+	esb_disable();
+}
+
+static void test_ptx(void)
+{
+	ptx_send("PTX", 0, 0);
+}
+
+static void test_ptx_ack_payload(void)
+{
+	ptx_send("PTX ACK payload", ACK_PAYLOAD_LENGTH, 0);
+}
+
+static void test_ptx_retransmit(void)
+{
+	ptx_send("PTX retransmit", ACK_PAYLOAD_LENGTH, 3);
+}
+
+/* Payloads for different pipes are sent in the order they were written, also
+ * when packets are lost.
+ */
+static void test_ptx_pipes(void)
+{
+	struct radio_sim_peer_stats stats;
+
+	esb_setup(ESB_MODE_PTX, ESB_PROTOCOL_ESB_DPL);
+	rx_claim = true;
+	tx_total = PACKETS / 10;
+	tx_pipes = 2;
+
+	peer_start(RADIO_SIM_PEER_PRX, true, ACK_PAYLOAD_LENGTH, 0, 3);
+	tx_fill();
+
+	run_until(ptx_done);
+	radio_sim_peer_stats_get(&stats);
+
+	zassert_equal(stats.rx, tx_total, NULL);
+	zassert_equal(stats.rx_invalid, 0, NULL);
+	zassert_equal(stats.rx_out_of_order, 0, NULL);
+	zassert_equal(tx_failed, 0, NULL);
+	zassert_equal(rx_count, tx_total, NULL);
+	zassert_equal(rx_invalid, 0, NULL);
+
+	esb_disable();
+}
+
+static const struct {
+	enum esb_bitrate bitrate;
+	const char *name;
+} bitrates[] = {
+	{ ESB_BITRATE_1MBPS, "1 Mbps" },
+	{ ESB_BITRATE_2MBPS, "2 Mbps" },
+	{ ESB_BITRATE_1MBPS_BLE, "1 Mbps BLE" },
+#if defined(CONFIG_SOC_SERIES_NRF52X)
+	{ ESB_BITRATE_2MBPS_BLE, "2 Mbps BLE" },
+#endif
+};
+
+static const uint8_t payload_lengths[] = { 1, 8, 32, 64, 128, 252 };
+
+static void ptx_throughput(enum esb_bitrate bitrate, const char *name,
+			   uint8_t length)
+{
+	struct radio_sim_peer_stats stats;
+	uint32_t packets_per_s;
+	uint32_t air_us;
+	uint32_t us;
+
+	esb_setup(ESB_MODE_PTX, ESB_PROTOCOL_ESB_DPL);
+	zassert_equal(esb_set_bitrate(bitrate), 0, NULL);
+	tx_total = THROUGHPUT_PACKETS;
+	tx_length = length;
+
+	peer_start(RADIO_SIM_PEER_PRX, true, 0, 0, 0);
+	tx_fill();
+
+	us = run_until(ptx_done);
+	air_us = radio_sim_air_time_us();
+	radio_sim_peer_stats_get(&stats);
+
+	packets_per_s = (uint64_t)tx_total * 1000000 / us;
+	TC_PRINT("%-10s %3u bytes: %5u packets/s, %4u kbit/s, %2u%% on air\n",
+		 name, length, packets_per_s, packets_per_s * length * 8 / 1000,
+		 air_us * 100 / us);
+
+	zassert_equal(stats.rx, tx_total, NULL);
+	zassert_equal(stats.rx_missed, 0, NULL);
+	zassert_equal(tx_failed, 0, NULL);
+
+	if (IS_ENABLED(CONFIG_ESB_TX_BURST)) {
+		/* Without burst mode, each packet takes at least two normal
+		 * ramp-ups besides the time on air.
+		 */
+		zassert_true(us - air_us <
+			     tx_total * 2 * RADIO_SIM_RAMP_UP_US,
+			     "Burst not chained");
+	}
+
+	esb_disable();
+}
+
+static void test_ptx_throughput(void)
+{
+	uint8_t length;
+
+	for (size_t i = 0; i < ARRAY_SIZE(bitrates); i++) {
+		for (size_t j = 0; j < ARRAY_SIZE(payload_lengths); j++) {
+			length = payload_lengths[j];
+			if (length > CONFIG_ESB_MAX_PAYLOAD_LENGTH) {
+				break;
+			}
+
+			ptx_throughput(bitrates[i].bitrate, bitrates[i].name,
+				       length);
+		}
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(esb,
+			 ztest_unit_test(test_prx_read),
+			 ztest_unit_test(test_prx_claim),
+			 ztest_unit_test(test_prx_legacy),
+			 ztest_unit_test(test_prx_rx_fifo_full),
+			 ztest_unit_test(test_claim_release),
+			 ztest_unit_test(test_ptx),
+			 ztest_unit_test(test_ptx_ack_payload),
+			 ztest_unit_test(test_ptx_retransmit),
+			 ztest_unit_test(test_ptx_pipes),
+			 ztest_unit_test(test_ptx_throughput));
+	ztest_run_test_suite(esb);
+}
@@ -0,0 +1,1138 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <zephyr.h>
+#include <sys/__assert.h>
+
+#include "radio_sim.h"
+
+/* Discrete-event model of the RADIO, TIMER and PPI peripherals used by ESB
+ * and of a second ESB node, the peer, that talks to the device under test.
+ *
+ * ESB programs the peripherals through the register structures below. Each
+ * access first executes the tasks written since the previous access and the
+ * events that are due, so the code sees the hardware react as it would on
+ * the chip. Time only advances in radio_sim_run() and when the code waits
+ * in a loop for an event.
+ *
+ * The radio of the peer is not modeled, it transmits and receives with
+ * fixed turnaround times. Packets that start while the peer is not receiving
+ * are missed.
+ */
+
+#define NS_PER_US 1000ULL
+
+#define EVENT_QUEUE_SIZE 16
+#define IRQ_COUNT 32
+#define PIPE_COUNT 8
+#define TIMER_CC_COUNT 4
+#define PPI_CH_COUNT ARRAY_SIZE(ppi.CH)
+
+/* Register accesses without anything happening, after which the code is
+ * assumed to wait for the hardware.
+ */
+#define SPIN_LIMIT 1000
+
+#define PREAMBLE_BITS 8
+#define RSSI_SAMPLE 40
+#define PACKET_SIZE_MAX 255
+
+enum radio_state {
+	RADIO_DISABLED,
+	RADIO_TXRU,
+	RADIO_TXIDLE,
+	RADIO_TX,
+	RADIO_TXDISABLE,
+	RADIO_RXRU,
+	RADIO_RXIDLE,
+	RADIO_RX,
+	RADIO_RXDISABLE,
+};
+
+enum sim_event_type {
+	/* Events of the radio of the device. */
+	EVT_RADIO_READY,
+	EVT_RADIO_ADDRESS,
+	EVT_RADIO_END,
+	EVT_RADIO_DISABLED,
+	/* End of the preamble and end of a packet sent by the peer. */
+	EVT_AIR_SYNC,
+	EVT_AIR_END,
+	/* Timers of the peer. */
+	EVT_PEER_TX,
+	EVT_PEER_RETRANSMIT,
+};
+
+struct sim_event {
+	uint64_t time;
+	uint32_t order;
+	enum sim_event_type type;
+	bool used;
+};
+
+struct frame {
+	uint8_t pipe;
+	uint8_t header[2];
+	uint8_t length;
+	uint8_t data[PACKET_SIZE_MAX];
+	uint16_t crc;
+	uint64_t start;
+	uint64_t end;
+};
+
+struct irq {
+	void (*isr)(void);
+	uint32_t priority;
+	bool enabled;
+	bool pending;
+	struct radio_sim_isr_stats stats;
+};
+
+struct pipe_state {
+	bool valid;
+	uint8_t pid;
+	uint16_t crc;
+	uint32_t ack_seq;
+};
+
+static NRF_RADIO_Type radio;
+static NRF_TIMER_Type timer;
+static NRF_PPI_Type ppi;
+
+/* Simulated time, in nanoseconds. */
+static uint64_t now;
+static struct sim_event events[EVENT_QUEUE_SIZE];
+static uint32_t event_order;
+static uint32_t idle_syncs;
+/* Time with a packet on air. */
+static uint64_t air_time;
+
+static enum radio_state radio_state;
+static uint32_t radio_inten;
+/* Value of PACKETPTR when the radio was started. */
+static uint8_t *radio_packet;
+static struct frame radio_frame;
+static bool radio_rx_locked;
+
+static bool timer_running;
+/* Time when the counter was zero, while the timer runs. */
+static uint64_t timer_base;
+/* Counter value, while the timer is stopped. */
+static uint32_t timer_counter;
+/* Compare channels that can generate an event. */
+static uint32_t timer_armed;
+
+static uint32_t ppi_chen;
+
+static struct irq irqs[IRQ_COUNT];
+static uint32_t irq_locked;
+static bool in_isr;
+
+static struct radio_sim_peer_config peer_cfg;
+static struct radio_sim_peer_stats peer_stats;
+static struct frame peer_frame;
+static struct frame air_frame;
+static struct pipe_state peer_pipes[PIPE_COUNT];
+static uint32_t peer_seq;
+static uint8_t peer_pid;
+static uint32_t peer_frames;
+static uint32_t peer_ack_seq;
+static uint32_t peer_rx_seq;
+static bool peer_wait_ack;
+static uint64_t peer_ack_deadline;
+/* Time from which the radio of the peer receives. */
+static uint64_t peer_rx_ready;
+
+static void sync(void);
+static void irq_dispatch(void);
+static void peer_on_frame(const struct frame *frame);
+static void peer_on_air_end(void);
+static void peer_send(void);
+static void peer_retransmit(void);
+
+static inline uint64_t cycles(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+	return __builtin_ia32_rdtsc();
+#else
+	return k_cycle_get_32();
+#endif
+}
+
+static uint64_t ramp_up_ns(bool fast)
+{
+	return (fast ? RADIO_SIM_FAST_RAMP_UP_US : RADIO_SIM_RAMP_UP_US) *
+	       NS_PER_US;
+}
+
+static uint16_t crc16(const uint8_t *data, size_t len, uint16_t crc)
+{
+	for (size_t i = 0; i < len; i++) {
+		crc ^= (uint16_t)data[i] << 8;
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+
+	return crc;
+}
+
+static void frame_crc(struct frame *frame)
+{
+	frame->crc = crc16(frame->header, sizeof(frame->header), 0xFFFF);
+	frame->crc = crc16(frame->data, frame->length, frame->crc);
+}
+
+static void event_add(enum sim_event_type type, uint64_t time)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(events); i++) {
+		if (!events[i].used) {
+			events[i].used = true;
+			events[i].type = type;
+			events[i].time = time;
+			events[i].order = event_order++;
+			return;
+		}
+	}
+
+	__ASSERT(false, "Event queue full");
+}
+
+static void event_cancel(enum sim_event_type type)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(events); i++) {
+		if (events[i].used && events[i].type == type) {
+			events[i].used = false;
+		}
+	}
+}
+
+static uint32_t bit_ns(void)
+{
+	switch (radio.MODE) {
+	case RADIO_MODE_MODE_Nrf_2Mbit:
+	case RADIO_MODE_MODE_Ble_2Mbit:
+		return 500;
+	case RADIO_MODE_MODE_Nrf_250Kbit:
+		return 4000;
+	default:
+		return 1000;
+	}
+}
+
+static uint32_t address_bits(void)
+{
+	uint32_t balen = (radio.PCNF1 & RADIO_PCNF1_BALEN_Msk) >>
+			 RADIO_PCNF1_BALEN_Pos;
+
+	return PREAMBLE_BITS + (balen + 1) * 8;
+}
+
+/* Length of the payload of a packet, as the radio of the device sees it. */
+static uint8_t packet_length(uint8_t s0_or_length)
+{
+	uint32_t lflen = (radio.PCNF0 & RADIO_PCNF0_LFLEN_Msk) >>
+			 RADIO_PCNF0_LFLEN_Pos;
+	uint32_t maxlen = (radio.PCNF1 & RADIO_PCNF1_MAXLEN_Msk) >>
+			  RADIO_PCNF1_MAXLEN_Pos;
+	uint32_t statlen = (radio.PCNF1 & RADIO_PCNF1_STATLEN_Msk) >>
+			   RADIO_PCNF1_STATLEN_Pos;
+	uint32_t length = statlen;
+
+	if (lflen > 0) {
+		length += s0_or_length & BIT_MASK(lflen);
+	}
+
+	return MIN(length, maxlen);
+}
+
+static uint64_t air_time_ns(uint8_t length)
+{
+	uint32_t bits = address_bits();
+
+	bits += ((radio.PCNF0 & RADIO_PCNF0_S0LEN_Msk) >>
+		 RADIO_PCNF0_S0LEN_Pos) * 8;
+	bits += (radio.PCNF0 & RADIO_PCNF0_LFLEN_Msk) >> RADIO_PCNF0_LFLEN_Pos;
+	bits += (radio.PCNF0 & RADIO_PCNF0_S1LEN_Msk) >> RADIO_PCNF0_S1LEN_Pos;
+	bits += length * 8;
+	bits += (radio.CRCCNF & RADIO_CRCCNF_LEN_Msk) * 8;
+
+	return (uint64_t)bits * bit_ns();
+}
+
+static void irq_pend(IRQn_Type irq)
+{
+	irqs[irq].pending = true;
+}
+
+static void task(uint32_t address);
+
+static void ppi_event(volatile uint32_t *event)
+{
+	uint32_t address = (uint32_t)(uintptr_t)event;
+
+	for (size_t i = 0; i < PPI_CH_COUNT; i++) {
+		if ((ppi_chen & BIT(i)) && ppi.CH[i].EEP == address) {
+			task(ppi.CH[i].TEP);
+		}
+	}
+}
+
+static uint64_t timer_tick_ns(void)
+{
+	/* 16 MHz base clock. */
+	return (125ULL << timer.PRESCALER) / 2;
+}
+
+static void timer_start(void)
+{
+	if (!timer_running) {
+		timer_running = true;
+		timer_base = now - timer_counter * timer_tick_ns();
+	}
+}
+
+static void timer_stop(void)
+{
+	if (timer_running) {
+		timer_running = false;
+		timer_counter = (now - timer_base) / timer_tick_ns();
+	}
+}
+
+static void timer_clear(void)
+{
+	timer_counter = 0;
+	timer_base = now;
+	timer_armed = BIT_MASK(TIMER_CC_COUNT);
+
+	/* A compare value of zero does not match again right away. */
+	for (size_t i = 0; i < TIMER_CC_COUNT; i++) {
+		if (timer.CC[i] == 0) {
+			timer_armed &= ~BIT(i);
+		}
+	}
+}
+
+/* Find the next compare event of the timer. */
+static bool timer_next(uint64_t *time, size_t *channel)
+{
+	bool found = false;
+
+	if (!timer_running) {
+		return false;
+	}
+
+	for (size_t i = 0; i < TIMER_CC_COUNT; i++) {
+		uint64_t t = timer_base + timer.CC[i] * timer_tick_ns();
+
+		if (!(timer_armed & BIT(i))) {
+			continue;
+		}
+
+		if (t < now) {
+			/* The counter is past the compare value. */
+			timer_armed &= ~BIT(i);
+			continue;
+		}
+
+		if (!found || t < *time) {
+			*time = t;
+			*channel = i;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+static void timer_compare(size_t channel)
+{
+	timer_armed &= ~BIT(channel);
+	timer.EVENTS_COMPARE[channel] = 1;
+	ppi_event(&timer.EVENTS_COMPARE[channel]);
+
+	if (timer.SHORTS & BIT(channel)) {
+		timer_clear();
+	}
+	if (timer.SHORTS & BIT(channel + 8)) {
+		timer_stop();
+	}
+}
+
+static void radio_fire(volatile uint32_t *event, uint32_t int_mask)
+{
+	*event = 1;
+	ppi_event(event);
+
+	if (radio_inten & int_mask) {
+		irq_pend(RADIO_IRQn);
+	}
+}
+
+static void radio_cancel(void)
+{
+	event_cancel(EVT_RADIO_READY);
+	event_cancel(EVT_RADIO_ADDRESS);
+	event_cancel(EVT_RADIO_END);
+	radio_rx_locked = false;
+}
+
+static void radio_enable(enum radio_state ramp_up)
+{
+	if (radio_state == RADIO_DISABLED) {
+		radio_state = ramp_up;
+		event_add(EVT_RADIO_READY,
+			  now + ramp_up_ns(radio.MODECNF0 &
+					   RADIO_MODECNF0_RU_Msk));
+	}
+}
+
+static void radio_start(void)
+{
+	uint8_t *packet = (uint8_t *)(uintptr_t)radio.PACKETPTR;
+
+	if (radio_state == RADIO_RXIDLE) {
+		radio_state = RADIO_RX;
+		radio_packet = packet;
+		radio_rx_locked = false;
+		return;
+	}
+
+	if (radio_state != RADIO_TXIDLE) {
+		return;
+	}
+
+	radio_state = RADIO_TX;
+	radio_frame.pipe = radio.TXADDRESS;
+	radio_frame.header[0] = packet[0];
+	radio_frame.header[1] = packet[1];
+	radio_frame.length = packet_length(packet[0]);
+	memcpy(radio_frame.data, &packet[2], radio_frame.length);
+	frame_crc(&radio_frame);
+	radio_frame.start = now;
+	radio_frame.end = now + air_time_ns(radio_frame.length);
+
+	event_add(EVT_RADIO_ADDRESS, now + address_bits() * bit_ns());
+	event_add(EVT_RADIO_END, radio_frame.end);
+}
+
+static void radio_disable(void)
+{
+	switch (radio_state) {
+	case RADIO_TXRU:
+	case RADIO_TXIDLE:
+	case RADIO_TX:
+		radio_cancel();
+		radio_state = RADIO_TXDISABLE;
+		event_add(EVT_RADIO_DISABLED,
+			  now + RADIO_SIM_TX_DISABLE_US * NS_PER_US);
+		break;
+
+	case RADIO_RXRU:
+	case RADIO_RXIDLE:
+	case RADIO_RX:
+		radio_cancel();
+		radio_state = RADIO_RXDISABLE;
+		event_add(EVT_RADIO_DISABLED, now);
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void radio_ready(void)
+{
+	radio_state = (radio_state == RADIO_TXRU) ? RADIO_TXIDLE :
+						    RADIO_RXIDLE;
+	radio_fire(&radio.EVENTS_READY, RADIO_INTENSET_READY_Msk);
+
+	if (radio.SHORTS & RADIO_SHORTS_READY_START_Msk) {
+		radio_start();
+	}
+}
+
+static void radio_end(void)
+{
+	radio_state = (radio_state == RADIO_TX) ? RADIO_TXIDLE : RADIO_RXIDLE;
+	radio_fire(&radio.EVENTS_END, RADIO_INTENSET_END_Msk);
+
+	if (radio.SHORTS & RADIO_SHORTS_END_DISABLE_Msk) {
+		radio_disable();
+	}
+}
+
+static void radio_tx_end(void)
+{
+	air_time += radio_frame.end - radio_frame.start;
+	peer_on_frame(&radio_frame);
+	radio_end();
+}
+
+static void radio_disabled(void)
+{
+	radio_state = RADIO_DISABLED;
+	radio_fire(&radio.EVENTS_DISABLED, RADIO_INTENSET_DISABLED_Msk);
+
+	if (radio.SHORTS & RADIO_SHORTS_DISABLED_TXEN_Msk) {
+		radio_enable(RADIO_TXRU);
+	} else if (radio.SHORTS & RADIO_SHORTS_DISABLED_RXEN_Msk) {
+		radio_enable(RADIO_RXRU);
+	}
+}
+
+/* The preamble of a packet from the peer has been sent. */
+static void radio_rx_sync(void)
+{
+	if (radio_state != RADIO_RX || radio_rx_locked ||
+	    !(radio.RXADDRESSES & BIT(air_frame.pipe))) {
+		return;
+	}
+
+	radio_rx_locked = true;
+	event_add(EVT_RADIO_ADDRESS,
+		  air_frame.start + address_bits() * bit_ns());
+}
+
+/* The packet from the peer has been sent. */
+static void radio_rx_end(void)
+{
+	uint8_t length;
+
+	if (radio_state != RADIO_RX || !radio_rx_locked) {
+		return;
+	}
+
+	radio_rx_locked = false;
+
+	/* Received data is written to RAM at PACKETPTR. */
+	length = packet_length(air_frame.header[0]);
+	radio_packet[0] = air_frame.header[0];
+	radio_packet[1] = air_frame.header[1];
+	memset(&radio_packet[2], 0, length);
+	memcpy(&radio_packet[2], air_frame.data, MIN(length, air_frame.length));
+
+	radio.RXMATCH = air_frame.pipe;
+	radio.RXCRC = air_frame.crc;
+	radio.CRCSTATUS = 1;
+	radio.RSSISAMPLE = RSSI_SAMPLE;
+
+	radio_end();
+}
+
+static void task(uint32_t address)
+{
+	if (address == (uint32_t)(uintptr_t)&radio.TASKS_TXEN) {
+		radio_enable(RADIO_TXRU);
+	} else if (address == (uint32_t)(uintptr_t)&radio.TASKS_RXEN) {
+		radio_enable(RADIO_RXRU);
+	} else if (address == (uint32_t)(uintptr_t)&radio.TASKS_START) {
+		radio_start();
+	} else if (address == (uint32_t)(uintptr_t)&radio.TASKS_DISABLE) {
+		radio_disable();
+	} else if (address == (uint32_t)(uintptr_t)&timer.TASKS_START) {
+		timer_start();
+	} else if (address == (uint32_t)(uintptr_t)&timer.TASKS_STOP) {
+		timer_stop();
+	} else if (address == (uint32_t)(uintptr_t)&timer.TASKS_CLEAR) {
+		timer_clear();
+	} else if (address == (uint32_t)(uintptr_t)&timer.TASKS_SHUTDOWN) {
+		timer_stop();
+		timer_clear();
+	}
+}
+
+static bool task_triggered(volatile uint32_t *reg)
+{
+	if (*reg) {
+		*reg = 0;
+		task((uint32_t)(uintptr_t)reg);
+		return true;
+	}
+
+	return false;
+}
+
+/* Handle the registers written since the previous access. */
+static bool sync_registers(void)
+{
+	bool progress = false;
+
+	/* Set and clear registers read back the current mask. */
+	radio_inten |= radio.INTENSET;
+	radio_inten &= ~radio.INTENCLR;
+	radio.INTENSET = radio_inten;
+	radio.INTENCLR = 0;
+
+	ppi_chen |= ppi.CHENSET;
+	ppi_chen &= ~ppi.CHENCLR;
+	ppi.CHEN = ppi_chen;
+	ppi.CHENSET = ppi_chen;
+	ppi.CHENCLR = 0;
+
+	progress |= task_triggered(&radio.TASKS_TXEN);
+	progress |= task_triggered(&radio.TASKS_RXEN);
+	progress |= task_triggered(&radio.TASKS_START);
+	progress |= task_triggered(&radio.TASKS_STOP);
+	progress |= task_triggered(&radio.TASKS_DISABLE);
+	radio.TASKS_RSSISTART = 0;
+	radio.TASKS_RSSISTOP = 0;
+
+	progress |= task_triggered(&timer.TASKS_START);
+	progress |= task_triggered(&timer.TASKS_STOP);
+	progress |= task_triggered(&timer.TASKS_CLEAR);
+	progress |= task_triggered(&timer.TASKS_SHUTDOWN);
+
+	return progress;
+}
+
+static bool next_event(uint64_t *time)
+{
+	struct sim_event *next = NULL;
+	size_t channel;
+	uint64_t timer_time;
+
+	for (size_t i = 0; i < ARRAY_SIZE(events); i++) {
+		if (events[i].used &&
+		    (next == NULL || events[i].time < next->time ||
+		     (events[i].time == next->time &&
+		      events[i].order < next->order))) {
+			next = &events[i];
+		}
+	}
+
+	if (timer_next(&timer_time, &channel) &&
+	    (next == NULL || timer_time < next->time)) {
+		*time = timer_time;
+		return true;
+	}
+
+	if (next != NULL) {
+		*time = next->time;
+		return true;
+	}
+
+	return false;
+}
+
+/* Process the next event, if it is due. */
+static bool process_event(void)
+{
+	struct sim_event *next = NULL;
+	enum sim_event_type type;
+	size_t channel;
+	uint64_t timer_time;
+
+	for (size_t i = 0; i < ARRAY_SIZE(events); i++) {
+		if (events[i].used && events[i].time <= now &&
+		    (next == NULL || events[i].time < next->time ||
+		     (events[i].time == next->time &&
+		      events[i].order < next->order))) {
+			next = &events[i];
+		}
+	}
+
+	if (timer_next(&timer_time, &channel) && timer_time <= now &&
+	    (next == NULL || timer_time < next->time)) {
+		timer_compare(channel);
+		return true;
+	}
+
+	if (next == NULL) {
+		return false;
+	}
+
+	next->used = false;
+	type = next->type;
+
+	switch (type) {
+	case EVT_RADIO_READY:
+		radio_ready();
+		break;
+	case EVT_RADIO_ADDRESS:
+		radio_fire(&radio.EVENTS_ADDRESS, RADIO_INTENSET_ADDRESS_Msk);
+		break;
+	case EVT_RADIO_END:
+		radio_tx_end();
+		break;
+	case EVT_RADIO_DISABLED:
+		radio_disabled();
+		break;
+	case EVT_AIR_SYNC:
+		radio_rx_sync();
+		break;
+	case EVT_AIR_END:
+		radio_rx_end();
+		peer_on_air_end();
+		break;
+	case EVT_PEER_TX:
+		peer_send();
+		break;
+	case EVT_PEER_RETRANSMIT:
+		peer_retransmit();
+		break;
+	}
+
+	return true;
+}
+
+static void sync(void)
+{
+	bool progress = sync_registers();
+	uint64_t time;
+
+	while (process_event()) {
+		progress = true;
+	}
+
+	if (progress) {
+		idle_syncs = 0;
+		return;
+	}
+
+	if (++idle_syncs > SPIN_LIMIT && next_event(&time)) {
+		/* The code waits for the hardware. */
+		idle_syncs = 0;
+		now = time;
+		while (process_event()) {
+		}
+	}
+}
+
+NRF_RADIO_Type *radio_sim_radio(void)
+{
+	sync();
+	return &radio;
+}
+
+NRF_TIMER_Type *radio_sim_timer(void)
+{
+	sync();
+	return &timer;
+}
+
+NRF_PPI_Type *radio_sim_ppi(void)
+{
+	sync();
+	return &ppi;
+}
+
+static void irq_dispatch(void)
+{
+	struct irq *next;
+	uint64_t start;
+	uint32_t spent;
+
+	while (!in_isr && !irq_locked) {
+		next = NULL;
+
+		for (size_t i = 0; i < ARRAY_SIZE(irqs); i++) {
+			if (irqs[i].pending && irqs[i].enabled &&
+			    irqs[i].isr != NULL &&
+			    (next == NULL ||
+			     irqs[i].priority < next->priority)) {
+				next = &irqs[i];
+			}
+		}
+
+		if (next == NULL) {
+			return;
+		}
+
+		next->pending = false;
+		in_isr = true;
+		idle_syncs = 0;
+
+		start = cycles();
+		next->isr();
+		spent = cycles() - start;
+
+		in_isr = false;
+
+		next->stats.count++;
+		next->stats.cycles += spent;
+		next->stats.cycles_max = MAX(next->stats.cycles_max, spent);
+
+		sync();
+	}
+}
+
+void radio_sim_irq_connect(IRQn_Type irq, uint32_t priority,
+			   void (*isr)(void))
+{
+	irqs[irq].isr = isr;
+	irqs[irq].priority = priority;
+}
+
+void radio_sim_irq_enable(IRQn_Type irq)
+{
+	irqs[irq].enabled = true;
+	irq_dispatch();
+}
+
+void radio_sim_irq_disable(IRQn_Type irq)
+{
+	irqs[irq].enabled = false;
+}
+
+void radio_sim_irq_pend(IRQn_Type irq)
+{
+	irq_pend(irq);
+}
+
+void radio_sim_irq_unpend(IRQn_Type irq)
+{
+	irqs[irq].pending = false;
+}
+
+uint32_t radio_sim_irq_lock(void)
+{
+	uint32_t key = irq_locked;
+
+	irq_locked = 1;
+
+	return key;
+}
+
+void radio_sim_irq_unlock(uint32_t key)
+{
+	irq_locked = key;
+	irq_dispatch();
+}
+
+void radio_sim_payload_fill(uint8_t *data, uint8_t length, uint32_t seq)
+{
+	for (size_t i = 0; i < length; i++) {
+		data[i] = (i < sizeof(seq)) ? (uint8_t)(seq >> (8 * i)) :
+					      (uint8_t)(seq + i);
+	}
+}
+
+bool radio_sim_payload_check(const uint8_t *data, uint8_t length,
+			     uint32_t *seq)
+{
+	uint32_t value = 0;
+
+	for (size_t i = 0; i < length; i++) {
+		if (i < sizeof(value)) {
+			value |= (uint32_t)data[i] << (8 * i);
+		} else if (data[i] != (uint8_t)(value + i)) {
+			return false;
+		}
+	}
+
+	*seq = value;
+
+	return true;
+}
+
+static void air_send(const struct frame *frame)
+{
+	air_frame = *frame;
+	air_frame.start = now;
+	air_frame.end = now + air_time_ns(frame->length);
+	air_time += air_frame.end - air_frame.start;
+
+	event_add(EVT_AIR_SYNC, now + PREAMBLE_BITS * bit_ns());
+	event_add(EVT_AIR_END,
+		  air_frame.end + RADIO_SIM_RX_CHAIN_DELAY_US * NS_PER_US);
+}
+
+static void peer_data_frame(void)
+{
+	peer_frame.pipe = peer_cfg.pipe;
+	peer_frame.length = peer_cfg.length;
+
+	if (peer_cfg.dpl) {
+		peer_frame.header[0] = peer_cfg.length;
+		peer_frame.header[1] = (peer_pid << 1) | 0x01;
+	} else {
+		peer_frame.header[0] = peer_pid;
+		peer_frame.header[1] = 0;
+	}
+
+	radio_sim_payload_fill(peer_frame.data, peer_frame.length, peer_seq);
+	frame_crc(&peer_frame);
+}
+
+static void peer_ack_frame(const struct frame *frame, uint32_t ack_seq)
+{
+	peer_frame.pipe = frame->pipe;
+
+	if (peer_cfg.dpl) {
+		peer_frame.length = peer_cfg.length;
+		peer_frame.header[0] = peer_cfg.length;
+		peer_frame.header[1] = frame->header[1];
+		radio_sim_payload_fill(peer_frame.data, peer_frame.length,
+				       ack_seq);
+	} else {
+		peer_frame.length = 0;
+		peer_frame.header[0] = frame->header[0];
+		peer_frame.header[1] = 0;
+	}
+
+	frame_crc(&peer_frame);
+}
+
+static void peer_check(const struct frame *frame)
+{
+	uint32_t mask = UINT32_MAX;
+	uint32_t seq;
+
+	if (!radio_sim_payload_check(frame->data, frame->length, &seq)) {
+		peer_stats.rx_invalid++;
+		return;
+	}
+
+	if (frame->length < sizeof(seq)) {
+		/* The packet number is truncated. */
+		mask = BIT_MASK(8 * frame->length);
+	}
+
+	if (seq != (peer_rx_seq & mask)) {
+		peer_stats.rx_out_of_order++;
+	}
+
+	peer_rx_seq++;
+}
+
+/* Check if the radio of the peer receives a packet. */
+static bool peer_rx_on(const struct frame *frame)
+{
+	if (frame->start < peer_rx_ready) {
+		peer_stats.rx_missed++;
+		return false;
+	}
+
+	return true;
+}
+
+/* A packet from the device was received by the PRX peer. */
+static void peer_prx_receive(const struct frame *frame)
+{
+	struct pipe_state *pipe = &peer_pipes[frame->pipe];
+	uint8_t pid;
+	bool ack;
+
+	if (!peer_rx_on(frame)) {
+		return;
+	}
+
+	/* Without an ACK, the peer restarts the receiver. */
+	peer_rx_ready = frame->end + RADIO_SIM_RX_CHAIN_DELAY_US * NS_PER_US +
+			ramp_up_ns(peer_cfg.fast_ramp_up);
+
+	if (peer_cfg.drop_every != 0 &&
+	    (++peer_frames % peer_cfg.drop_every) == 0) {
+		peer_stats.rx_dropped++;
+		return;
+	}
+
+	pid = peer_cfg.dpl ? (frame->header[1] >> 1) : frame->header[0];
+	ack = peer_cfg.dpl ? (frame->header[1] & 0x01) : true;
+
+	if (!pipe->valid || pipe->pid != pid || pipe->crc != frame->crc) {
+		/* Not a retransmission. */
+		pipe->valid = true;
+		pipe->pid = pid;
+		pipe->crc = frame->crc;
+		pipe->ack_seq = peer_ack_seq;
+
+		peer_stats.rx++;
+		peer_check(frame);
+
+		if (ack && peer_cfg.dpl && peer_cfg.length > 0) {
+			peer_ack_seq++;
+			peer_stats.ack_payloads++;
+		}
+	}
+
+	if (ack) {
+		/* The receiver is restarted after the ACK, see peer_send(). */
+		peer_rx_ready = UINT64_MAX;
+		peer_ack_frame(frame, pipe->ack_seq);
+		event_add(EVT_PEER_TX, frame->end +
+			  RADIO_SIM_RX_CHAIN_DELAY_US * NS_PER_US +
+			  ramp_up_ns(peer_cfg.fast_ramp_up));
+	}
+}
+
+/* A packet from the device was received by the PTX peer. */
+static void peer_ptx_receive(const struct frame *frame)
+{
+	if (!peer_wait_ack || frame->pipe != peer_cfg.pipe ||
+	    frame->start > peer_ack_deadline || !peer_rx_on(frame)) {
+		return;
+	}
+
+	peer_wait_ack = false;
+	event_cancel(EVT_PEER_RETRANSMIT);
+	peer_stats.acked++;
+
+	if (peer_cfg.dpl && frame->length > 0) {
+		peer_stats.rx++;
+		peer_check(frame);
+	}
+
+	if (peer_stats.acked < peer_cfg.count) {
+		peer_seq++;
+		peer_pid = (peer_pid + 1) & 0x03;
+		peer_data_frame();
+		event_add(EVT_PEER_TX, frame->end +
+			  (RADIO_SIM_RX_CHAIN_DELAY_US +
+			   RADIO_SIM_PEER_ISR_US) * NS_PER_US +
+			  ramp_up_ns(peer_cfg.fast_ramp_up));
+	}
+}
+
+static void peer_on_frame(const struct frame *frame)
+{
+	switch (peer_cfg.mode) {
+	case RADIO_SIM_PEER_PRX:
+		peer_prx_receive(frame);
+		break;
+	case RADIO_SIM_PEER_PTX:
+		peer_ptx_receive(frame);
+		break;
+	default:
+		break;
+	}
+}
+
+static void peer_send(void)
+{
+	air_send(&peer_frame);
+
+	if (peer_cfg.mode == RADIO_SIM_PEER_PTX) {
+		peer_stats.tx++;
+	}
+
+	/* The receiver ramps up right after the packet. */
+	peer_rx_ready = air_frame.end +
+			RADIO_SIM_TX_DISABLE_US * NS_PER_US +
+			ramp_up_ns(peer_cfg.fast_ramp_up);
+}
+
+static void peer_on_air_end(void)
+{
+	if (peer_cfg.mode != RADIO_SIM_PEER_PTX) {
+		return;
+	}
+
+	peer_wait_ack = true;
+	peer_ack_deadline = air_frame.end +
+			    RADIO_SIM_PEER_ACK_WAIT_US * NS_PER_US;
+	event_add(EVT_PEER_RETRANSMIT,
+		  air_frame.end + peer_cfg.retransmit_delay_us * NS_PER_US);
+}
+
+static void peer_retransmit(void)
+{
+	if (peer_wait_ack) {
+		peer_wait_ack = false;
+		peer_send();
+	}
+}
+
+void radio_sim_peer_start(const struct radio_sim_peer_config *config)
+{
+	peer_cfg = *config;
+	memset(&peer_stats, 0, sizeof(peer_stats));
+	memset(peer_pipes, 0, sizeof(peer_pipes));
+	peer_seq = 0;
+	peer_pid = 0;
+	peer_frames = 0;
+	peer_ack_seq = 0;
+	peer_rx_seq = 0;
+	peer_wait_ack = false;
+	peer_rx_ready = 0;
+
+	event_cancel(EVT_PEER_TX);
+	event_cancel(EVT_PEER_RETRANSMIT);
+
+	if (peer_cfg.mode == RADIO_SIM_PEER_PTX && peer_cfg.count > 0) {
+		peer_data_frame();
+		event_add(EVT_PEER_TX,
+			  now + ramp_up_ns(peer_cfg.fast_ramp_up));
+	}
+}
+
+void radio_sim_peer_stats_get(struct radio_sim_peer_stats *stats)
+{
+	*stats = peer_stats;
+}
+
+bool radio_sim_peer_done(void)
+{
+	return peer_stats.acked >= peer_cfg.count;
+}
+
+void radio_sim_isr_stats_get(IRQn_Type irq, struct radio_sim_isr_stats *stats)
+{
+	*stats = irqs[irq].stats;
+}
+
+uint64_t radio_sim_time_us(void)
+{
+	return now / NS_PER_US;
+}
+
+uint64_t radio_sim_air_time_us(void)
+{
+	return air_time / NS_PER_US;
+}
+
+void radio_sim_run(uint32_t duration_us)
+{
+	uint64_t end = now + duration_us * NS_PER_US;
+	uint64_t time;
+
+	for (;;) {
+		idle_syncs = 0;
+		sync();
+		irq_dispatch();
+
+		if (!next_event(&time) || time > end) {
+			break;
+		}
+
+		now = time;
+	}
+
+	now = MAX(now, end);
+}
+
+void radio_sim_reset(void)
+{
+	memset(&radio, 0, sizeof(radio));
+	memset(&timer, 0, sizeof(timer));
+	memset(&ppi, 0, sizeof(ppi));
+	memset(events, 0, sizeof(events));
+	memset(irqs, 0, sizeof(irqs));
+	memset(&peer_cfg, 0, sizeof(peer_cfg));
+	memset(&peer_stats, 0, sizeof(peer_stats));
+
+	now = 0;
+	event_order = 0;
+	idle_syncs = 0;
+	air_time = 0;
+
+	radio_state = RADIO_DISABLED;
+	radio_inten = 0;
+	radio_packet = NULL;
+	radio_rx_locked = false;
+
+	timer_running = false;
+	timer_base = 0;
+	timer_counter = 0;
+	timer_armed = 0;
+
+	ppi_chen = 0;
+
+	irq_locked = 0;
+	in_isr = false;
+}
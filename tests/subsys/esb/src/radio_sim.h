@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef RADIO_SIM_H_
+#define RADIO_SIM_H_
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <nrf.h>
+
+/* Radio timing, in microseconds. */
+#define RADIO_SIM_RAMP_UP_US 130
+#define RADIO_SIM_FAST_RAMP_UP_US 40
+#define RADIO_SIM_TX_DISABLE_US 6
+/* Delay of the END event after the last bit of a received packet. */
+#define RADIO_SIM_RX_CHAIN_DELAY_US 8
+
+/* Time from the END event of an ACK until the peer starts the TX ramp-up of
+ * the next packet: the RX disable and the radio interrupt.
+ */
+#define RADIO_SIM_PEER_ISR_US 10
+/* Latest start of an ACK after the end of a packet sent by the peer. */
+#define RADIO_SIM_PEER_ACK_WAIT_US 250
+
+/* Role of the simulated peer. The peer uses the same protocol, bitrate and
+ * address length as the device under test.
+ */
+enum radio_sim_peer_mode {
+	RADIO_SIM_PEER_OFF,
+	RADIO_SIM_PEER_PRX,
+	RADIO_SIM_PEER_PTX,
+};
+
+struct radio_sim_peer_config {
+	enum radio_sim_peer_mode mode;
+	/* Dynamic payload length, as in ESB_PROTOCOL_ESB_DPL. */
+	bool dpl;
+	/* Fast radio ramp-up, as in CONFIG_ESB_TX_BURST. */
+	bool fast_ramp_up;
+	/* PTX: pipe of the packets. */
+	uint8_t pipe;
+	/* PTX: payload length. PRX: length of the ACK payloads, or 0. */
+	uint8_t length;
+	/* PTX: number of packets to send. */
+	uint32_t count;
+	/* PRX: ignore every Nth packet, 0 for none. */
+	uint32_t drop_every;
+	/* PTX: time between retransmissions. */
+	uint32_t retransmit_delay_us;
+};
+
+struct radio_sim_peer_stats {
+	/* Packets sent, including retransmissions. */
+	uint32_t tx;
+	/* PTX: packets acknowledged by the device. */
+	uint32_t acked;
+	/* Packets received from the device, without retransmissions. */
+	uint32_t rx;
+	/* Packets ignored because of drop_every. */
+	uint32_t rx_dropped;
+	/* Packets that started while the radio of the peer was not
+	 * receiving.
+	 */
+	uint32_t rx_missed;
+	/* Packets received from the device that are not the packet after the
+	 * previous one, in the order of radio_sim_payload_fill().
+	 */
+	uint32_t rx_out_of_order;
+	/* Payloads received from the device that do not follow the pattern
+	 * of radio_sim_payload_fill().
+	 */
+	uint32_t rx_invalid;
+	/* PRX: ACKs sent with a payload. */
+	uint32_t ack_payloads;
+};
+
+struct radio_sim_isr_stats {
+	uint32_t count;
+	uint64_t cycles;
+	uint32_t cycles_max;
+};
+
+/* Reset the peripherals, the interrupts, the peer and the time. */
+void radio_sim_reset(void);
+
+/* Advance the simulated time, running the interrupts that are raised. */
+void radio_sim_run(uint32_t duration_us);
+
+uint64_t radio_sim_time_us(void);
+
+/* Time with a packet on air, sent either by the device or by the peer. */
+uint64_t radio_sim_air_time_us(void);
+
+void radio_sim_peer_start(const struct radio_sim_peer_config *config);
+
+void radio_sim_peer_stats_get(struct radio_sim_peer_stats *stats);
+
+/* Check if the PTX peer has sent all its packets. */
+bool radio_sim_peer_done(void);
+
+/* Host CPU cycles spent in an interrupt handler. The cycles include the
+ * simulation of the peripheral accesses.
+ */
+void radio_sim_isr_stats_get(IRQn_Type irq, struct radio_sim_isr_stats *stats);
+
+/* Fill a payload with a pattern that identifies packet number seq. */
+void radio_sim_payload_fill(uint8_t *data, uint8_t length, uint32_t seq);
+
+/* Check the pattern of a payload and get the packet number. Packet numbers
+ * are truncated to the length of short payloads.
+ */
+bool radio_sim_payload_check(const uint8_t *data, uint8_t length,
+			     uint32_t *seq);
+
+#endif /* RADIO_SIM_H_ */
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Stand-in for the nRF MDK header. The RADIO, TIMER and PPI peripherals and
+ * the interrupt controller used by ESB are provided by the radio simulator.
+ * Every access to a peripheral goes through the simulator, which executes
+ * the tasks that were written since the previous access.
+ */
+#ifndef NRF_STUB_H_
+#define NRF_STUB_H_
+
+#include <zephyr/types.h>
+#include <sys/util.h>
+#include <irq.h>
+
+#define __CORTEX_M (0x00U)
+
+#define __REV(x) __builtin_bswap32(x)
+#define __ALIGN(n) __aligned(n)
+
+typedef enum {
+	RADIO_IRQn = 1,
+	TIMER2_IRQn = 10,
+	SWI0_IRQn = 20,
+} IRQn_Type;
+
+typedef struct {
+	volatile uint32_t TASKS_TXEN;
+	volatile uint32_t TASKS_RXEN;
+	volatile uint32_t TASKS_START;
+	volatile uint32_t TASKS_STOP;
+	volatile uint32_t TASKS_DISABLE;
+	volatile uint32_t TASKS_RSSISTART;
+	volatile uint32_t TASKS_RSSISTOP;
+	volatile uint32_t EVENTS_READY;
+	volatile uint32_t EVENTS_ADDRESS;
+	volatile uint32_t EVENTS_PAYLOAD;
+	volatile uint32_t EVENTS_END;
+	volatile uint32_t EVENTS_DISABLED;
+	volatile uint32_t EVENTS_BCMATCH;
+	volatile uint32_t SHORTS;
+	volatile uint32_t INTENSET;
+	volatile uint32_t INTENCLR;
+	volatile uint32_t CRCSTATUS;
+	volatile uint32_t RXMATCH;
+	volatile uint32_t RXCRC;
+	volatile uint32_t PACKETPTR;
+	volatile uint32_t FREQUENCY;
+	volatile uint32_t TXPOWER;
+	volatile uint32_t MODE;
+	volatile uint32_t PCNF0;
+	volatile uint32_t PCNF1;
+	volatile uint32_t BASE0;
+	volatile uint32_t BASE1;
+	volatile uint32_t PREFIX0;
+	volatile uint32_t PREFIX1;
+	volatile uint32_t TXADDRESS;
+	volatile uint32_t RXADDRESSES;
+	volatile uint32_t CRCCNF;
+	volatile uint32_t CRCPOLY;
+	volatile uint32_t CRCINIT;
+	volatile uint32_t RSSISAMPLE;
+	volatile uint32_t BCC;
+	volatile uint32_t MODECNF0;
+} NRF_RADIO_Type;
+
+typedef struct {
+	volatile uint32_t TASKS_START;
+	volatile uint32_t TASKS_STOP;
+	volatile uint32_t TASKS_COUNT;
+	volatile uint32_t TASKS_CLEAR;
+	volatile uint32_t TASKS_SHUTDOWN;
+	volatile uint32_t EVENTS_COMPARE[4];
+	volatile uint32_t SHORTS;
+	volatile uint32_t INTENSET;
+	volatile uint32_t INTENCLR;
+	volatile uint32_t MODE;
+	volatile uint32_t BITMODE;
+	volatile uint32_t PRESCALER;
+	volatile uint32_t CC[4];
+} NRF_TIMER_Type;
+
+typedef struct {
+	volatile uint32_t EEP;
+	volatile uint32_t TEP;
+} PPI_CH_Type;
+
+typedef struct {
+	volatile uint32_t CHEN;
+	volatile uint32_t CHENSET;
+	volatile uint32_t CHENCLR;
+	PPI_CH_Type CH[20];
+} NRF_PPI_Type;
+
+NRF_RADIO_Type *radio_sim_radio(void);
+NRF_TIMER_Type *radio_sim_timer(void);
+NRF_PPI_Type *radio_sim_ppi(void);
+
+#define NRF_RADIO (radio_sim_radio())
+#define NRF_TIMER2 (radio_sim_timer())
+#define NRF_PPI (radio_sim_ppi())
+
+void radio_sim_irq_connect(IRQn_Type irq, uint32_t priority,
+			   void (*isr)(void));
+void radio_sim_irq_enable(IRQn_Type irq);
+void radio_sim_irq_disable(IRQn_Type irq);
+void radio_sim_irq_pend(IRQn_Type irq);
+void radio_sim_irq_unpend(IRQn_Type irq);
+uint32_t radio_sim_irq_lock(void);
+void radio_sim_irq_unlock(uint32_t key);
+
+#undef IRQ_DIRECT_CONNECT
+#define IRQ_DIRECT_CONNECT(irq_p, priority_p, isr_p, flags_p) \
+	radio_sim_irq_connect(irq_p, priority_p, isr_p)
+
+#undef irq_enable
+#define irq_enable(irq) radio_sim_irq_enable(irq)
+#undef irq_disable
+#define irq_disable(irq) radio_sim_irq_disable(irq)
+#undef irq_lock
+#define irq_lock() radio_sim_irq_lock()
+#undef irq_unlock
+#define irq_unlock(key) radio_sim_irq_unlock(key)
+
+#define NVIC_SetPendingIRQ(irq) radio_sim_irq_pend(irq)
+#define NVIC_ClearPendingIRQ(irq) radio_sim_irq_unpend(irq)
+
+#define RADIO_SHORTS_READY_START_Pos 0
+#define RADIO_SHORTS_READY_START_Msk BIT(RADIO_SHORTS_READY_START_Pos)
+#define RADIO_SHORTS_READY_START_Enabled 1
+#define RADIO_SHORTS_END_DISABLE_Pos 1
+#define RADIO_SHORTS_END_DISABLE_Msk BIT(RADIO_SHORTS_END_DISABLE_Pos)
+#define RADIO_SHORTS_END_DISABLE_Enabled 1
+#define RADIO_SHORTS_DISABLED_TXEN_Msk BIT(2)
+#define RADIO_SHORTS_DISABLED_RXEN_Msk BIT(3)
+#define RADIO_SHORTS_ADDRESS_RSSISTART_Msk BIT(4)
+#define RADIO_SHORTS_ADDRESS_BCSTART_Msk BIT(6)
+#define RADIO_SHORTS_DISABLED_RSSISTOP_Msk BIT(8)
+
+#define RADIO_INTENSET_READY_Msk BIT(0)
+#define RADIO_INTENSET_ADDRESS_Msk BIT(1)
+#define RADIO_INTENSET_PAYLOAD_Msk BIT(2)
+#define RADIO_INTENSET_END_Msk BIT(3)
+#define RADIO_INTENSET_DISABLED_Msk BIT(4)
+
+#define RADIO_PCNF0_LFLEN_Pos 0
+#define RADIO_PCNF0_LFLEN_Msk (0xFUL << RADIO_PCNF0_LFLEN_Pos)
+#define RADIO_PCNF0_S0LEN_Pos 8
+#define RADIO_PCNF0_S0LEN_Msk (0x1UL << RADIO_PCNF0_S0LEN_Pos)
+#define RADIO_PCNF0_S1LEN_Pos 16
+#define RADIO_PCNF0_S1LEN_Msk (0xFUL << RADIO_PCNF0_S1LEN_Pos)
+
+#define RADIO_PCNF1_MAXLEN_Pos 0
+#define RADIO_PCNF1_MAXLEN_Msk (0xFFUL << RADIO_PCNF1_MAXLEN_Pos)
+#define RADIO_PCNF1_STATLEN_Pos 8
+#define RADIO_PCNF1_STATLEN_Msk (0xFFUL << RADIO_PCNF1_STATLEN_Pos)
+#define RADIO_PCNF1_BALEN_Pos 16
+#define RADIO_PCNF1_BALEN_Msk (0x7UL << RADIO_PCNF1_BALEN_Pos)
+#define RADIO_PCNF1_ENDIAN_Pos 24
+#define RADIO_PCNF1_ENDIAN_Big 1
+#define RADIO_PCNF1_WHITEEN_Pos 25
+#define RADIO_PCNF1_WHITEEN_Disabled 0
+
+#define RADIO_MODE_MODE_Pos 0
+#define RADIO_MODE_MODE_Nrf_1Mbit 0
+#define RADIO_MODE_MODE_Nrf_2Mbit 1
+#define RADIO_MODE_MODE_Nrf_250Kbit 2
+#define RADIO_MODE_MODE_Ble_1Mbit 3
+#define RADIO_MODE_MODE_Ble_2Mbit 4
+
+#define RADIO_MODECNF0_RU_Pos 0
+#define RADIO_MODECNF0_RU_Msk (0x1UL << RADIO_MODECNF0_RU_Pos)
+#define RADIO_MODECNF0_RU_Default 0
+#define RADIO_MODECNF0_RU_Fast 1
+
+#define RADIO_CRCCNF_LEN_Pos 0
+#define RADIO_CRCCNF_LEN_Msk (0x3UL << RADIO_CRCCNF_LEN_Pos)
+#define RADIO_CRCCNF_LEN_Disabled 0
+#define RADIO_CRCCNF_LEN_One 1
+#define RADIO_CRCCNF_LEN_Two 2
+
+#define RADIO_TXPOWER_TXPOWER_Pos 0
+#define RADIO_TXPOWER_TXPOWER_Pos4dBm 0x04
+#define RADIO_TXPOWER_TXPOWER_Pos3dBm 0x03
+#define RADIO_TXPOWER_TXPOWER_0dBm 0x00
+#define RADIO_TXPOWER_TXPOWER_Neg4dBm 0xFC
+#define RADIO_TXPOWER_TXPOWER_Neg8dBm 0xF8
+#define RADIO_TXPOWER_TXPOWER_Neg12dBm 0xF4
+#define RADIO_TXPOWER_TXPOWER_Neg16dBm 0xF0
+#define RADIO_TXPOWER_TXPOWER_Neg20dBm 0xEC
+#define RADIO_TXPOWER_TXPOWER_Neg30dBm 0xE2
+#define RADIO_TXPOWER_TXPOWER_Neg40dBm 0xD8
+
+#define TIMER_BITMODE_BITMODE_16Bit 0
+#define TIMER_SHORTS_COMPARE0_CLEAR_Msk BIT(0)
+#define TIMER_SHORTS_COMPARE1_CLEAR_Msk BIT(1)
+#define TIMER_SHORTS_COMPARE0_STOP_Msk BIT(8)
+#define TIMER_SHORTS_COMPARE1_STOP_Msk BIT(9)
+
+#endif /* NRF_STUB_H_ */
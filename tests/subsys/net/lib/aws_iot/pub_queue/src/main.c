@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <stdio.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <aws_iot_pub_queue.h>
+
+#define TOPIC "$aws/things/my-thing/shadow/update"
+#define QUEUE_SIZE CONFIG_AWS_IOT_PUBLISH_QUEUE_COUNT
+#define BROKER_LOG_SIZE 64
+#define DRAIN_ROUNDS 100
+
+/* Stand-in for the broker, recording what the queue publishes. */
+struct broker_msg {
+	uint16_t message_id;
+	uint8_t qos;
+	uint8_t dup;
+	char payload[16];
+};
+
+static struct {
+	bool online;
+	/* Number of messages accepted before the connection drops. */
+	int budget;
+	/* Acknowledge QoS 1 messages while they are being sent. */
+	bool ack_inline;
+	size_t count;
+	struct broker_msg log[BROKER_LOG_SIZE];
+} broker;
+
+static int broker_publish(const struct mqtt_publish_param *param)
+{
+	struct broker_msg *msg;
+	size_t len = param->message.payload.len;
+
+	if (!broker.online || broker.budget == 0) {
+		broker.online = false;
+		return -ENOTCONN;
+	}
+
+	if (broker.budget > 0) {
+		broker.budget--;
+	}
+
+	zassert_equal(param->message.topic.topic.size, strlen(TOPIC), NULL);
+	zassert_mem_equal(param->message.topic.topic.utf8, TOPIC,
+			  strlen(TOPIC), NULL);
+
+	if (broker.count < BROKER_LOG_SIZE) {
+		msg = &broker.log[broker.count];
+		msg->message_id = param->message_id;
+		msg->qos = param->message.topic.qos;
+		msg->dup = param->dup_flag;
+		len = MIN(len, sizeof(msg->payload) - 1);
+		memcpy(msg->payload, param->message.payload.data, len);
+		msg->payload[len] = '\0';
+	}
+
+	broker.count++;
+
+	if (broker.ack_inline &&
+	    param->message.topic.qos == MQTT_QOS_1_AT_LEAST_ONCE) {
+		zassert_true(aws_iot_pub_queue_ack(param->message_id), NULL);
+	}
+
+	return 0;
+}
+
+static void broker_connect(int budget)
+{
+	broker.online = true;
+	broker.budget = budget;
+	broker.count = 0;
+}
+
+static int msg_add(uint16_t id, enum mqtt_qos qos)
+{
+	struct mqtt_publish_param param = { 0 };
+	char payload[16];
+
+	snprintf(payload, sizeof(payload), "msg-%u", id);
+
+	param.message.topic.qos = qos;
+	param.message.topic.topic.utf8 = (const uint8_t *)TOPIC;
+	param.message.topic.topic.size = strlen(TOPIC);
+	param.message.payload.data = (uint8_t *)payload;
+	param.message.payload.len = strlen(payload);
+	param.message_id = id;
+
+	/* The queue keeps its own copy. */
+	return aws_iot_pub_queue_add(&param);
+}
+
+static void broker_msg_check(size_t index, uint16_t id, uint8_t dup)
+{
+	char payload[16];
+
+	snprintf(payload, sizeof(payload), "msg-%u", id);
+
+	zassert_equal(broker.log[index].message_id, id,
+		      "Message %u out of order", (unsigned int)index);
+	zassert_equal(broker.log[index].dup, dup, NULL);
+	zassert_equal(strcmp(broker.log[index].payload, payload), 0, NULL);
+}
+
+/* Only messages restored from storage get new IDs, which is not enabled
+ * in this test.
+ */
+static uint16_t message_id_next(void)
+{
+	zassert_unreachable("Message ID requested");
+
+	return 0;
+}
+
+static void setup(void)
+{
+	memset(&broker, 0, sizeof(broker));
+	zassert_equal(aws_iot_pub_queue_init(broker_publish, message_id_next),
+		      0, NULL);
+	zassert_equal(aws_iot_pub_queue_count(), 0, NULL);
+}
+
+static void teardown(void)
+{
+	zassert_equal(aws_iot_pub_queue_count(), 0, "Queue not empty");
+}
+
+static void test_pub_queue_order(void)
+{
+	for (uint16_t id = 1; id <= 6; id++) {
+		zassert_equal(msg_add(id, (id & 1) ? MQTT_QOS_0_AT_MOST_ONCE :
+						   MQTT_QOS_1_AT_LEAST_ONCE),
+			      0, NULL);
+	}
+
+	zassert_equal(aws_iot_pub_queue_count(), 6, NULL);
+	zassert_equal(aws_iot_pub_queue_pending(), 6, NULL);
+
+	zassert_equal(aws_iot_pub_queue_drain(true), -ENOTCONN, NULL);
+	zassert_equal(aws_iot_pub_queue_pending(), 6, NULL);
+
+	broker_connect(-1);
+	zassert_equal(aws_iot_pub_queue_drain(true), 0, NULL);
+	zassert_equal(broker.count, 6, NULL);
+
+	for (uint16_t id = 1; id <= 6; id++) {
+		broker_msg_check(id - 1, id, 0);
+	}
+
+	/* QoS 0 messages are freed once sent, QoS 1 wait for a PUBACK. */
+	zassert_equal(aws_iot_pub_queue_pending(), 0, NULL);
+	zassert_equal(aws_iot_pub_queue_count(), 3, NULL);
+
+	/* Sent messages are not sent again unless resending. */
+	zassert_equal(aws_iot_pub_queue_drain(false), 0, NULL);
+	zassert_equal(broker.count, 6, NULL);
+
+	zassert_false(aws_iot_pub_queue_ack(1), "QoS 0 message acked");
+	zassert_true(aws_iot_pub_queue_ack(4), NULL);
+	zassert_true(aws_iot_pub_queue_ack(2), NULL);
+	zassert_true(aws_iot_pub_queue_ack(6), NULL);
+	zassert_false(aws_iot_pub_queue_ack(6), "Message acked twice");
+}
+
+static void test_pub_queue_reconnect(void)
+{
+	for (uint16_t id = 10; id < 14; id++) {
+		zassert_equal(msg_add(id, MQTT_QOS_1_AT_LEAST_ONCE), 0, NULL);
+	}
+
+	/* Not yet sent messages can not be acknowledged. */
+	zassert_false(aws_iot_pub_queue_ack(10), NULL);
+
+	/* The connection drops after two messages. */
+	broker_connect(2);
+	zassert_equal(aws_iot_pub_queue_drain(true), -ENOTCONN, NULL);
+	zassert_equal(broker.count, 2, NULL);
+	broker_msg_check(0, 10, 0);
+	broker_msg_check(1, 11, 0);
+	zassert_equal(aws_iot_pub_queue_pending(), 2, NULL);
+	zassert_equal(aws_iot_pub_queue_count(), 4, NULL);
+
+	/* Only the first one was acknowledged before the connection
+	 * dropped.
+	 */
+	zassert_true(aws_iot_pub_queue_ack(10), NULL);
+
+	/* After reconnecting, the unacknowledged message is resent from the
+	 * queue before the rest is sent.
+	 */
+	broker_connect(-1);
+	zassert_equal(aws_iot_pub_queue_drain(true), 0, NULL);
+	zassert_equal(broker.count, 3, NULL);
+	broker_msg_check(0, 11, 1);
+	broker_msg_check(1, 12, 0);
+	broker_msg_check(2, 13, 0);
+
+	for (uint16_t id = 11; id < 14; id++) {
+		zassert_true(aws_iot_pub_queue_ack(id), NULL);
+	}
+}
+
+static void test_pub_queue_limits(void)
+{
+	struct mqtt_publish_param param = { 0 };
+	static uint8_t payload[CONFIG_AWS_IOT_PUBLISH_QUEUE_PAYLOAD_LEN + 1];
+
+	param.message.topic.qos = MQTT_QOS_0_AT_MOST_ONCE;
+	param.message.topic.topic.utf8 = (const uint8_t *)TOPIC;
+	param.message.topic.topic.size = strlen(TOPIC);
+	param.message.payload.data = payload;
+	param.message.payload.len = sizeof(payload);
+	param.message_id = 1;
+
+	zassert_equal(aws_iot_pub_queue_add(&param), -EMSGSIZE, NULL);
+
+	param.message.payload.len = sizeof(payload) - 1;
+	zassert_equal(aws_iot_pub_queue_add(&param), 0, NULL);
+
+	for (uint16_t id = 2; id <= QUEUE_SIZE; id++) {
+		zassert_equal(msg_add(id, MQTT_QOS_0_AT_MOST_ONCE), 0, NULL);
+	}
+
+	zassert_equal(msg_add(QUEUE_SIZE + 1, MQTT_QOS_0_AT_MOST_ONCE),
+		      -ENOMEM, NULL);
+
+	broker_connect(-1);
+	zassert_equal(aws_iot_pub_queue_drain(true), 0, NULL);
+	zassert_equal(broker.count, QUEUE_SIZE, NULL);
+}
+
+static void test_pub_queue_ack_during_send(void)
+{
+	for (uint16_t id = 20; id < 20 + QUEUE_SIZE; id++) {
+		zassert_equal(msg_add(id, MQTT_QOS_1_AT_LEAST_ONCE), 0, NULL);
+	}
+
+	/* A PUBACK processed while the message is still being sent must not
+	 * free it under the drain.
+	 */
+	broker_connect(-1);
+	broker.ack_inline = true;
+	zassert_equal(aws_iot_pub_queue_drain(true), 0, NULL);
+	zassert_equal(broker.count, QUEUE_SIZE, NULL);
+}
+
+static void test_pub_queue_drain_throughput(void)
+{
+	uint32_t start;
+	uint32_t cycles = 0;
+	uint16_t id = 1;
+
+	for (int round = 0; round < DRAIN_ROUNDS; round++) {
+		uint16_t first = id;
+
+		broker.online = false;
+
+		for (int i = 0; i < QUEUE_SIZE; i++) {
+			zassert_equal(msg_add(id++, MQTT_QOS_1_AT_LEAST_ONCE),
+				      0, NULL);
+		}
+
+		broker_connect(-1);
+
+		start = k_cycle_get_32();
+		zassert_equal(aws_iot_pub_queue_drain(true), 0, NULL);
+		for (uint16_t ack = first; ack != id; ack++) {
+			(void)aws_iot_pub_queue_ack(ack);
+		}
+		cycles += k_cycle_get_32() - start;
+
+		zassert_equal(broker.count, QUEUE_SIZE, NULL);
+		zassert_equal(aws_iot_pub_queue_count(), 0, NULL);
+	}
+
+	TC_PRINT("Drained %u messages, %u cycles/message\n",
+		 DRAIN_ROUNDS * QUEUE_SIZE, cycles / (DRAIN_ROUNDS * QUEUE_SIZE));
+}
+
+void test_main(void)
+{
+	ztest_test_suite(aws_iot_pub_queue,
+			 ztest_unit_test_setup_teardown(test_pub_queue_order,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(
+				test_pub_queue_reconnect, setup, teardown),
+			 ztest_unit_test_setup_teardown(test_pub_queue_limits,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(
+				test_pub_queue_ack_during_send, setup,
+				teardown),
+			 ztest_unit_test_setup_teardown(
+				test_pub_queue_drain_throughput, setup,
+				teardown));
+	ztest_run_test_suite(aws_iot_pub_queue);
+}
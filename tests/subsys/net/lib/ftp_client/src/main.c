@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/ftp_client.h>
+
+#define SERVER_ADDR "127.0.0.1"
+#define SERVER_PORT 2121
+/* Port of the data connection, as given in the PASV reply. */
+#define DATA_PORT ((8 << 8) + 74)
+#define PASV_REPLY "227 Entering Passive Mode (127,0,0,1,8,74).\r\n"
+
+#define SERVER_STACK_SIZE 2048
+#define SERVER_PRIORITY K_PRIO_PREEMPT(1)
+
+#define CHUNK_LEN 1000
+#define CHUNK_COUNT 3
+#define FILE_SIZE_MAX (4 * CHUNK_LEN)
+
+static K_THREAD_STACK_DEFINE(server_stack, SERVER_STACK_SIZE);
+static struct k_thread server_thread_data;
+static K_SEM_DEFINE(server_ready, 0, 1);
+
+static uint8_t server_file[FILE_SIZE_MAX];
+static size_t server_file_len;
+static size_t server_rest;
+static const char *server_stor_reply;
+static int server_pasv_count;
+static char server_cmd[128];
+
+/* FTP server stand-in, serving a single file over the loopback
+ * interface.
+ */
+
+static int server_listen(uint16_t port)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(port),
+	};
+	int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+	zassert_true(sock >= 0, "socket() failed: %d", errno);
+	zassert_equal(inet_pton(AF_INET, SERVER_ADDR, &addr.sin_addr), 1,
+		      NULL);
+	zassert_equal(bind(sock, (struct sockaddr *)&addr, sizeof(addr)), 0,
+		      "bind() failed: %d", errno);
+	zassert_equal(listen(sock, 1), 0, "listen() failed: %d", errno);
+
+	return sock;
+}
+
+static void server_reply(int sock, const char *reply)
+{
+	zassert_equal(send(sock, reply, strlen(reply), 0), strlen(reply),
+		      NULL);
+}
+
+static void server_stor(int ctrl_sock, int data_listen_sock)
+{
+	int data_sock = accept(data_listen_sock, NULL, NULL);
+	size_t len = server_rest;
+	int ret;
+
+	zassert_true(data_sock >= 0, "accept() failed: %d", errno);
+	server_reply(ctrl_sock, "150 Ok to send data.\r\n");
+
+	do {
+		ret = recv(data_sock, &server_file[len],
+			   sizeof(server_file) - len, 0);
+		if (ret > 0) {
+			len += ret;
+		}
+	} while (ret > 0);
+
+	close(data_sock);
+	server_file_len = len;
+	server_reply(ctrl_sock, server_stor_reply);
+}
+
+static void server_retr(int ctrl_sock, int data_listen_sock)
+{
+	int data_sock = accept(data_listen_sock, NULL, NULL);
+	size_t len = server_file_len - server_rest;
+
+	zassert_true(data_sock >= 0, "accept() failed: %d", errno);
+	server_reply(ctrl_sock, "150 Opening BINARY mode data connection.\r\n");
+
+	zassert_equal(send(data_sock, &server_file[server_rest], len, 0), len,
+		      NULL);
+
+	close(data_sock);
+	server_reply(ctrl_sock, "226 Transfer complete.\r\n");
+}
+
+static void server_session(int ctrl_sock, int data_listen_sock)
+{
+	char reply[32];
+	int ret;
+
+	server_reply(ctrl_sock, "220 Ready.\r\n");
+
+	while (true) {
+		ret = recv(ctrl_sock, server_cmd, sizeof(server_cmd) - 1, 0);
+		if (ret <= 0) {
+			break;
+		}
+		server_cmd[ret] = '\0';
+
+		if (!strncmp(server_cmd, "OPTS", 4)) {
+			server_reply(ctrl_sock, "200 Always in UTF8 mode.\r\n");
+		} else if (!strncmp(server_cmd, "USER", 4)) {
+			server_reply(ctrl_sock, "331 Password required.\r\n");
+		} else if (!strncmp(server_cmd, "PASS", 4)) {
+			server_reply(ctrl_sock, "230 Login successful.\r\n");
+		} else if (!strncmp(server_cmd, "PASV", 4)) {
+			server_pasv_count++;
+			server_reply(ctrl_sock, PASV_REPLY);
+		} else if (!strncmp(server_cmd, "REST", 4)) {
+			server_rest = strtoul(&server_cmd[5], NULL, 10);
+			server_reply(ctrl_sock, "350 Restart position ok.\r\n");
+		} else if (!strncmp(server_cmd, "STOR", 4)) {
+			server_stor(ctrl_sock, data_listen_sock);
+			server_rest = 0;
+		} else if (!strncmp(server_cmd, "RETR", 4)) {
+			server_retr(ctrl_sock, data_listen_sock);
+			server_rest = 0;
+		} else if (!strncmp(server_cmd, "SIZE", 4)) {
+			snprintf(reply, sizeof(reply), "213 %u\r\n",
+				 (unsigned int)server_file_len);
+			server_reply(ctrl_sock, reply);
+		} else if (!strncmp(server_cmd, "QUIT", 4)) {
+			server_reply(ctrl_sock, "221 Goodbye.\r\n");
+			break;
+		} else {
+			server_reply(ctrl_sock, "502 Not implemented.\r\n");
+		}
+	}
+
+	close(ctrl_sock);
+}
+
+static void server_thread(void *p1, void *p2, void *p3)
+{
+	int ctrl_listen_sock = server_listen(SERVER_PORT);
+	int data_listen_sock = server_listen(DATA_PORT);
+	int ctrl_sock;
+
+	k_sem_give(&server_ready);
+
+	while (true) {
+		ctrl_sock = accept(ctrl_listen_sock, NULL, NULL);
+		zassert_true(ctrl_sock >= 0, "accept() failed: %d", errno);
+
+		server_session(ctrl_sock, data_listen_sock);
+	}
+}
+
+static void ftp_callback(const uint8_t *msg, uint16_t len)
+{
+}
+
+static void chunk_fill(uint8_t *buf, size_t offset, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		buf[i] = (uint8_t)(offset + i);
+	}
+}
+
+static void stream_put(size_t offset, size_t chunk_count)
+{
+	static uint8_t chunk[CHUNK_LEN];
+
+	zassert_equal(ftp_stream_put_open("file", offset), 0, NULL);
+
+	for (size_t i = 0; i < chunk_count; i++) {
+		chunk_fill(chunk, offset + i * CHUNK_LEN, CHUNK_LEN);
+		zassert_equal(ftp_stream_write(chunk, CHUNK_LEN), 0, NULL);
+		zassert_equal(ftp_stream_progress(),
+			      offset + (i + 1) * CHUNK_LEN, NULL);
+	}
+}
+
+static void file_check(size_t len)
+{
+	static uint8_t expected[FILE_SIZE_MAX];
+
+	chunk_fill(expected, 0, len);
+	zassert_equal(server_file_len, len, NULL);
+	zassert_mem_equal(server_file, expected, len, NULL);
+}
+
+static void setup(void)
+{
+	server_pasv_count = 0;
+	server_stor_reply = "226 Transfer complete.\r\n";
+
+	zassert_equal(ftp_open(SERVER_ADDR, SERVER_PORT, -1), FTP_CODE_200,
+		      NULL);
+	zassert_equal(ftp_login("user", "password"), FTP_CODE_230, NULL);
+}
+
+static void teardown(void)
+{
+	zassert_equal(ftp_close(), FTP_CODE_221, NULL);
+}
+
+static void test_stream_put(void)
+{
+	stream_put(0, CHUNK_COUNT);
+	zassert_equal(ftp_stream_close(), FTP_CODE_226, NULL);
+
+	/* All chunks go over a single data connection. */
+	zassert_equal(server_pasv_count, 1, NULL);
+	file_check(CHUNK_COUNT * CHUNK_LEN);
+}
+
+static void test_stream_put_resume(void)
+{
+	stream_put(0, CHUNK_COUNT);
+	zassert_equal(ftp_stream_close(), FTP_CODE_226, NULL);
+
+	stream_put(CHUNK_COUNT * CHUNK_LEN, 1);
+	zassert_equal(ftp_stream_close(), FTP_CODE_226, NULL);
+
+	file_check((CHUNK_COUNT + 1) * CHUNK_LEN);
+}
+
+static void test_stream_get_resume(void)
+{
+	static uint8_t buf[FILE_SIZE_MAX];
+	static uint8_t expected[FILE_SIZE_MAX];
+	size_t offset = CHUNK_LEN;
+	size_t len = 0;
+	int ret;
+
+	stream_put(0, CHUNK_COUNT);
+	zassert_equal(ftp_stream_close(), FTP_CODE_226, NULL);
+
+	zassert_equal(ftp_stream_get_open("file", offset), 0, NULL);
+
+	do {
+		ret = ftp_stream_read(&buf[len], sizeof(buf) - len);
+		zassert_true(ret >= 0, "Read failed: %d", ret);
+		len += ret;
+	} while (ret > 0);
+
+	zassert_equal(ftp_stream_close(), FTP_CODE_226, NULL);
+
+	chunk_fill(expected, offset, CHUNK_COUNT * CHUNK_LEN - offset);
+	zassert_equal(len, CHUNK_COUNT * CHUNK_LEN - offset, NULL);
+	zassert_mem_equal(buf, expected, len, NULL);
+	zassert_equal(ftp_stream_progress(), CHUNK_COUNT * CHUNK_LEN, NULL);
+}
+
+static void test_stream_put_error(void)
+{
+	server_stor_reply = "552 Exceeded storage allocation.\r\n";
+
+	/* The error reply ends the wait for the transfer to complete. */
+	stream_put(0, 1);
+	zassert_equal(ftp_stream_close(), 552, NULL);
+}
+
+static void test_size(void)
+{
+	size_t size;
+
+	stream_put(0, CHUNK_COUNT);
+	zassert_equal(ftp_stream_close(), FTP_CODE_226, NULL);
+
+	zassert_equal(ftp_size("file", &size), FTP_CODE_213, NULL);
+	zassert_equal(size, CHUNK_COUNT * CHUNK_LEN, NULL);
+}
+
+void test_main(void)
+{
+	zassert_equal(ftp_init(ftp_callback, ftp_callback), 0, NULL);
+
+	k_thread_create(&server_thread_data, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack),
+			server_thread, NULL, NULL, NULL,
+			SERVER_PRIORITY, 0, K_NO_WAIT);
+	zassert_equal(k_sem_take(&server_ready, K_SECONDS(1)), 0, NULL);
+
+	ztest_test_suite(test_ftp_client,
+			 ztest_unit_test_setup_teardown(test_stream_put,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_stream_put_resume,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_stream_get_resume,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_stream_put_error,
+							setup, teardown),
+			 ztest_unit_test_setup_teardown(test_size,
+							setup, teardown));
+	ztest_run_test_suite(test_ftp_client);
+}
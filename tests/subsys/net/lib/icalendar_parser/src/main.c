@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <stdio.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <net/icalendar_parser.h>
+
+/* Size of the generated calendar feed. */
+#define STREAM_SIZE (4 * 1024 * 1024)
+/* Largest chunk passed to the parser, as a download fragment. */
+#define FRAGMENT_SIZE_MAX 1024
+
+static const char calendar[] =
+	"BEGIN:VCALENDAR\r\n"
+	"VERSION:2.0\r\n"
+	"PRODID:-//hacksw/handcal//NONSGML v1.0//EN\r\n"
+	"BEGIN:VTIMEZONE\r\n"
+	"TZID:Europe/Oslo\r\n"
+	"BEGIN:STANDARD\r\n"
+	"DTSTART:19701025T030000\r\n"
+	"END:STANDARD\r\n"
+	"END:VTIMEZONE\r\n"
+	"BEGIN:VEVENT\r\n"
+	"UID:19970610T172345Z-AF23B2@example.com\r\n"
+	"DTSTAMP:19970610T172345Z\r\n"
+	"DTSTART;TZID=Europe/Oslo:19970714T170000\r\n"
+	"DTEND:19970715T040000Z\r\n"
+	"SUMMARY:Bastille Day Party\r\n"
+	"DESCRIPTION:A description that is long enough to be folded\r\n"
+	"  over two lines.\r\n"
+	"BEGIN:VALARM\r\n"
+	"ACTION:DISPLAY\r\n"
+	"SUMMARY:Alarm\r\n"
+	"END:VALARM\r\n"
+	"LOCATION:Paris\r\n"
+	"END:VEVENT\r\n"
+	"BEGIN:VTODO\r\n"
+	"SUMMARY:Todo\r\n"
+	"END:VTODO\r\n"
+	"BEGIN:VEVENT\r\n"
+	"SUMMARY;LANGUAGE=fr:Fete\r\n"
+	"END:VEVENT\r\n"
+	"END:VCALENDAR\r\n";
+
+static struct icalendar_parser ical;
+static struct ical_parser_evt events[4];
+static size_t event_count;
+static size_t stop_after;
+
+static int store_event(const struct ical_parser_evt *evt)
+{
+	if (event_count < ARRAY_SIZE(events)) {
+		events[event_count] = *evt;
+	}
+
+	event_count++;
+
+	return (stop_after && event_count == stop_after) ? 1 : 0;
+}
+
+static void parse_in_chunks(const char *data, size_t len, size_t chunk)
+{
+	for (size_t i = 0; i < len; i += chunk) {
+		size_t n = MIN(chunk, len - i);
+
+		zassert_equal(ical_parser_parse(&ical, data + i, n), n, NULL);
+	}
+
+	zassert_equal(ical_parser_finish(&ical), 0, NULL);
+}
+
+static void check_calendar_events(void)
+{
+	zassert_equal(event_count, 4, NULL);
+
+	zassert_equal(events[0].id, ICAL_EVT_VTIMEZONE, NULL);
+	zassert_equal(events[0].error, ICAL_ERROR_COM_NOT_SUPPORTED, NULL);
+
+	zassert_equal(events[1].id, ICAL_EVT_VEVENT, NULL);
+	zassert_equal(events[1].error, ICAL_ERROR_NONE, NULL);
+	zassert_equal(strcmp(events[1].ical_com.summary, "Bastille Day Party"),
+		      0, NULL);
+	zassert_equal(strcmp(events[1].ical_com.description,
+			     "A description that is long enough to be folded"
+			     " over two lines."),
+		      0, "Folded line not unfolded");
+	zassert_equal(strcmp(events[1].ical_com.location, "Paris"), 0, NULL);
+	zassert_equal(strcmp(events[1].ical_com.dtstart, "19970714T170000"),
+		      0, NULL);
+	zassert_equal(strcmp(events[1].ical_com.dtend, "19970715T040000Z"),
+		      0, NULL);
+
+	zassert_equal(events[2].id, ICAL_EVT_VTODO, NULL);
+	zassert_equal(events[2].error, ICAL_ERROR_COM_NOT_SUPPORTED, NULL);
+
+	zassert_equal(events[3].id, ICAL_EVT_VEVENT, NULL);
+	zassert_equal(events[3].error, ICAL_ERROR_SUMMARY, NULL);
+}
+
+static void setup(void)
+{
+	event_count = 0;
+	stop_after = 0;
+	zassert_equal(ical_parser_init(&ical, store_event), 0, NULL);
+}
+
+static void test_ical_parser_whole(void)
+{
+	parse_in_chunks(calendar, strlen(calendar), strlen(calendar));
+	check_calendar_events();
+}
+
+static void test_ical_parser_chunks(void)
+{
+	/* Every split point, including inside line breaks and folds. */
+	for (size_t chunk = 1; chunk < 32; chunk++) {
+		setup();
+		parse_in_chunks(calendar, strlen(calendar), chunk);
+		check_calendar_events();
+	}
+}
+
+static void test_ical_parser_stop(void)
+{
+	size_t len = strlen(calendar);
+	size_t parsed;
+
+	stop_after = 2;
+	parsed = ical_parser_parse(&ical, calendar, len);
+	zassert_true(parsed < len, "Parsing not stopped");
+	zassert_equal(event_count, 2, NULL);
+
+	/* Parsing resumes where it stopped. */
+	stop_after = 0;
+	parse_in_chunks(calendar + parsed, len - parsed, len);
+	check_calendar_events();
+}
+
+static void test_ical_parser_finish(void)
+{
+	/* The calendar without the line break after END:VCALENDAR. */
+	size_t len = strlen(calendar) - 2;
+	/* The calendar up to the END:VEVENT line of the last component. */
+	size_t event_len = strlen(calendar) - strlen("END:VCALENDAR\r\n");
+
+	zassert_equal(ical_parser_parse(&ical, calendar, len), len, NULL);
+	zassert_equal(ical_parser_finish(&ical), 0, NULL);
+	check_calendar_events();
+
+	/* The last event is only sent at the end of the stream. */
+	event_count = 0;
+	zassert_equal(ical_parser_parse(&ical, calendar, event_len), event_len,
+		      NULL);
+	zassert_equal(event_count, 3, NULL);
+	zassert_equal(ical_parser_finish(&ical), -ENODATA,
+		      "Missing END:VCALENDAR not reported");
+	check_calendar_events();
+
+	/* The parser is ready for the next stream. */
+	event_count = 0;
+	parse_in_chunks(calendar, strlen(calendar), strlen(calendar));
+	check_calendar_events();
+}
+
+static char fragment[FRAGMENT_SIZE_MAX];
+static size_t fragment_len;
+static size_t fragment_size;
+static uint32_t rand_state = 1;
+static size_t stream_len;
+
+static void fragment_flush(void)
+{
+	zassert_equal(ical_parser_parse(&ical, fragment, fragment_len),
+		      fragment_len, NULL);
+
+	stream_len += fragment_len;
+	fragment_len = 0;
+
+	/* Fragments of varying size, split at any position. */
+	rand_state = rand_state * 1103515245 + 12345;
+	fragment_size = 1 + (rand_state >> 16) % FRAGMENT_SIZE_MAX;
+}
+
+static void stream_write(const char *data, size_t len)
+{
+	while (len) {
+		size_t n = MIN(len, fragment_size - fragment_len);
+
+		memcpy(fragment + fragment_len, data, n);
+		fragment_len += n;
+		data += n;
+		len -= n;
+
+		if (fragment_len == fragment_size) {
+			fragment_flush();
+		}
+	}
+}
+
+static int check_stream_event(const struct ical_parser_evt *evt)
+{
+	char summary[32];
+
+	zassert_equal(evt->id, ICAL_EVT_VEVENT, NULL);
+	zassert_equal(evt->error, ICAL_ERROR_NONE, NULL);
+
+	snprintf(summary, sizeof(summary), "Event %u",
+		 (unsigned int)event_count);
+	zassert_equal(strcmp(evt->ical_com.summary, summary), 0,
+		      "Event %u out of order", (unsigned int)event_count);
+
+	event_count++;
+	return 0;
+}
+
+static void test_ical_parser_stream(void)
+{
+	char event[512];
+	size_t generated = 0;
+	uint32_t start;
+	uint32_t cycles;
+	size_t len;
+
+	event_count = 0;
+	zassert_equal(ical_parser_init(&ical, check_stream_event), 0, NULL);
+	fragment_size = FRAGMENT_SIZE_MAX;
+
+	start = k_cycle_get_32();
+
+	stream_write("BEGIN:VCALENDAR\r\nVERSION:2.0\r\n", 30);
+
+	while (stream_len < STREAM_SIZE) {
+		len = snprintf(event, sizeof(event),
+			       "BEGIN:VEVENT\r\n"
+			       "DTSTART:20200101T%06u\r\n"
+			       "DTEND:20200101T%06u\r\n"
+			       "SUMMARY:Event %u\r\n"
+			       "DESCRIPTION:Generated event with a description"
+			       " that is folded\r\n"
+			       "  into several content lines to exercise the"
+			       " unfolding\r\n"
+			       "  window.\r\n"
+			       "END:VEVENT\r\n",
+			       (unsigned int)(generated % 1000000),
+			       (unsigned int)(generated % 1000000),
+			       (unsigned int)generated);
+		stream_write(event, len);
+		generated++;
+	}
+
+	stream_write("END:VCALENDAR\r\n", 15);
+	fragment_flush();
+	zassert_equal(ical_parser_finish(&ical), 0, NULL);
+
+	cycles = k_cycle_get_32() - start;
+
+	zassert_equal(event_count, generated, NULL);
+
+	TC_PRINT("Parsed %u bytes, %u events, parser size %u bytes, "
+		 "%u cycles\n", (unsigned int)stream_len,
+		 (unsigned int)event_count, (unsigned int)sizeof(ical),
+		 cycles);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(icalendar_parser,
+			 ztest_unit_test_setup_teardown(test_ical_parser_whole,
+							setup, unit_test_noop),
+			 ztest_unit_test_setup_teardown(
+				test_ical_parser_chunks, setup, unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_ical_parser_stop,
+							setup, unit_test_noop),
+			 ztest_unit_test_setup_teardown(
+				test_ical_parser_finish, setup, unit_test_noop),
+			 ztest_unit_test(test_ical_parser_stream));
+	ztest_run_test_suite(icalendar_parser);
+}
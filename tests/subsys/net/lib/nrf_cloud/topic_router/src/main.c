@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <stdio.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <nrf_cloud_topic_router.h>
+
+#define CLIENT_ID "nrf-352656100000000"
+#define ROUTE_CNT 64
+#define TOPIC_MAX_LEN 64
+#define MATCH_ROUNDS 100
+
+static char topics[ROUTE_CNT][TOPIC_MAX_LEN];
+static struct nrf_cloud_topic_route routes[ROUTE_CNT];
+static uint16_t slots[2 * ROUTE_CNT + 1];
+static struct nrf_cloud_topic_router router;
+
+static void routes_build(size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i++) {
+		routes[i].len = snprintf(topics[i], TOPIC_MAX_LEN,
+					 "$aws/things/%s/route/%u",
+					 CLIENT_ID, (unsigned int)i);
+		routes[i].topic = topics[i];
+		routes[i].id = 1000 + i;
+	}
+
+	zassert_equal(nrf_cloud_topic_router_init(&router, routes, cnt,
+						  slots, 2 * cnt + 1),
+		      0, NULL);
+}
+
+static void test_topic_router_match(void)
+{
+	uint32_t id;
+
+	routes_build(ROUTE_CNT);
+
+	for (size_t i = 0; i < ROUTE_CNT; i++) {
+		zassert_true(nrf_cloud_topic_router_match(&router, topics[i],
+							  routes[i].len, &id),
+			     "Route %u not matched", (unsigned int)i);
+		zassert_equal(id, routes[i].id, NULL);
+	}
+}
+
+static void test_topic_router_no_match(void)
+{
+	const char *unknown = "$aws/things/" CLIENT_ID "/shadow/update";
+	char topic[TOPIC_MAX_LEN + 1];
+	uint32_t id;
+
+	routes_build(ROUTE_CNT);
+
+	zassert_false(nrf_cloud_topic_router_match(&router, unknown,
+						   strlen(unknown), &id), NULL);
+
+	/* Prefixes and extensions of a topic are different topics: */
+	zassert_false(nrf_cloud_topic_router_match(&router, topics[10],
+						   routes[10].len - 1, &id),
+		      NULL);
+
+	strcpy(topic, topics[10]);
+	strcat(topic, "/");
+	zassert_false(nrf_cloud_topic_router_match(&router, topic,
+						   strlen(topic), &id), NULL);
+}
+
+static void test_topic_router_duplicate(void)
+{
+	routes_build(2);
+	routes[1] = routes[0];
+
+	zassert_equal(nrf_cloud_topic_router_init(&router, routes, 2, slots,
+						  5),
+		      -EEXIST, NULL);
+	zassert_equal(nrf_cloud_topic_router_init(&router, routes, 2, slots,
+						  2),
+		      -ENOMEM, NULL);
+}
+
+static void test_topic_router_cost(void)
+{
+	uint32_t start;
+	uint32_t cycles;
+	uint32_t id;
+
+	/* Matching compares at most max_probe + 1 topics, which must not grow
+	 * with the number of routes.
+	 */
+	for (size_t cnt = 4; cnt <= ROUTE_CNT; cnt *= 2) {
+		routes_build(cnt);
+
+		start = k_cycle_get_32();
+		for (int round = 0; round < MATCH_ROUNDS; round++) {
+			for (size_t i = 0; i < cnt; i++) {
+				(void)nrf_cloud_topic_router_match(
+					&router, topics[i], routes[i].len, &id);
+			}
+		}
+		cycles = k_cycle_get_32() - start;
+
+		TC_PRINT("%u routes: at most %u comparisons, %u cycles/match\n",
+			 (unsigned int)cnt, (unsigned int)router.max_probe + 1,
+			 cycles / (MATCH_ROUNDS * cnt));
+
+		zassert_true(router.max_probe < 4, "Too many collisions");
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf_cloud_topic_router,
+			 ztest_unit_test(test_topic_router_match),
+			 ztest_unit_test(test_topic_router_no_match),
+			 ztest_unit_test(test_topic_router_duplicate),
+			 ztest_unit_test(test_topic_router_cost));
+	ztest_run_test_suite(nrf_cloud_topic_router);
+}
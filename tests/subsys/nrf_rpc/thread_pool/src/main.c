@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+
+#include "nrf_rpc_os.h"
+
+/* Destination group identifier in the nRF RPC packet header. */
+#define GROUP_ID_IDX 4
+#define PACKET_LEN 8
+
+#define GROUP_URGENT 0
+#define GROUP_SLOW 1
+
+#define ROUNDS 10
+#define SLOW_PACKETS 4
+#define SLOW_WORK_US 2000
+#define WORK_TIMEOUT K_SECONDS(1)
+
+/* Priority of the rpmsg receive thread, which queues the packets. */
+#define RX_PRIORITY -1
+
+static uint8_t packets[SLOW_PACKETS + 1][PACKET_LEN];
+static uint32_t urgent_queued;
+static uint32_t urgent_latency_us;
+
+static K_SEM_DEFINE(urgent_sem, 0, 1);
+static K_SEM_DEFINE(slow_sem, 0, SLOW_PACKETS);
+
+static void work(const uint8_t *data, size_t len)
+{
+	zassert_equal(len, PACKET_LEN, NULL);
+
+	switch (data[GROUP_ID_IDX]) {
+	case GROUP_URGENT:
+		urgent_latency_us = k_cyc_to_us_floor32(k_cycle_get_32() -
+							urgent_queued);
+		k_sem_give(&urgent_sem);
+		break;
+
+	case GROUP_SLOW:
+		k_busy_wait(SLOW_WORK_US);
+		k_sem_give(&slow_sem);
+		break;
+
+	default:
+		zassert_unreachable("Unknown group %u", data[GROUP_ID_IDX]);
+	}
+}
+
+static void packet_send(uint8_t *packet, uint8_t group_id)
+{
+	memset(packet, 0, PACKET_LEN);
+	packet[GROUP_ID_IDX] = group_id;
+
+	nrf_rpc_os_thread_pool_send(packet, PACKET_LEN);
+}
+
+/* A burst of slow commands followed by an event that must be handled
+ * quickly. Returns the time the event waited for a thread.
+ */
+static uint32_t burst_then_urgent(void)
+{
+	for (size_t i = 0; i < SLOW_PACKETS; i++) {
+		packet_send(packets[i], GROUP_SLOW);
+	}
+
+	/* Let the slow work start. */
+	k_sleep(K_USEC(SLOW_WORK_US / 4));
+
+	urgent_queued = k_cycle_get_32();
+	packet_send(packets[SLOW_PACKETS], GROUP_URGENT);
+
+	zassert_equal(k_sem_take(&urgent_sem, WORK_TIMEOUT), 0,
+		      "Urgent packet not handled");
+
+	for (size_t i = 0; i < SLOW_PACKETS; i++) {
+		zassert_equal(k_sem_take(&slow_sem, WORK_TIMEOUT), 0,
+			      "Slow packet not handled");
+	}
+
+	return urgent_latency_us;
+}
+
+static void test_head_of_line(void)
+{
+	uint32_t max_us = 0;
+	uint32_t total_us = 0;
+	uint32_t us;
+
+	k_thread_priority_set(k_current_get(), RX_PRIORITY);
+
+	for (size_t i = 0; i < ROUNDS; i++) {
+		us = burst_then_urgent();
+		max_us = MAX(max_us, us);
+		total_us += us;
+	}
+
+	TC_PRINT("Urgent packet behind %u slow packets: avg %u us, "
+		 "max %u us\n", SLOW_PACKETS, total_us / ROUNDS, max_us);
+
+	if (IS_ENABLED(CONFIG_NRF_RPC_THREAD_POOL_LANES)) {
+		zassert_true(max_us < SLOW_WORK_US,
+			     "Urgent packet waited for slow work");
+	} else {
+		zassert_true(max_us >= SLOW_WORK_US,
+			     "Head-of-line blocking not reproduced");
+	}
+}
+
+#if defined(CONFIG_NRF_RPC_THREAD_POOL_LANES)
+
+static void print_lane(const char *name, struct nrf_rpc_os_lane_stats *stats)
+{
+	TC_PRINT("%-6s lane: %u packets, %u stolen, depth max %u, "
+		 "wait avg %u us, max %u us\n", name, stats->packets,
+		 stats->stolen, stats->depth_max,
+		 stats->packets ?
+		 (uint32_t)(stats->wait_total_us / stats->packets) : 0,
+		 stats->wait_max_us);
+}
+
+static void test_lane_stats(void)
+{
+	struct nrf_rpc_os_lane_stats high;
+	struct nrf_rpc_os_lane_stats low;
+
+	nrf_rpc_os_lane_stats_reset();
+
+	k_thread_priority_set(k_current_get(), RX_PRIORITY);
+
+	for (size_t i = 0; i < ROUNDS; i++) {
+		burst_then_urgent();
+	}
+
+	nrf_rpc_os_lane_stats_get(NRF_RPC_OS_LANE_HIGH, &high);
+	nrf_rpc_os_lane_stats_get(NRF_RPC_OS_LANE_LOW, &low);
+
+	print_lane("high", &high);
+	print_lane("low", &low);
+
+	zassert_equal(high.packets, ROUNDS, NULL);
+	zassert_equal(high.stolen, 0, NULL);
+	zassert_true(high.wait_max_us < SLOW_WORK_US, NULL);
+
+	zassert_equal(low.packets, ROUNDS * SLOW_PACKETS, NULL);
+	zassert_equal(low.depth, 0, NULL);
+	zassert_true(low.depth_max > 0, NULL);
+	/* Idle threads of the normal lane help with the slow work. */
+	zassert_true(low.stolen > 0, "No work stolen from the low lane");
+}
+
+static void test_lane_set(void)
+{
+	uint8_t group_id = CONFIG_NRF_RPC_THREAD_POOL_LANE_GROUPS;
+
+	zassert_equal(nrf_rpc_os_lane_set(group_id, NRF_RPC_OS_LANE_HIGH),
+		      -EINVAL, NULL);
+	zassert_equal(nrf_rpc_os_lane_set(GROUP_SLOW, NRF_RPC_OS_LANE_COUNT),
+		      -EINVAL, NULL);
+}
+
+#else
+
+static void test_lane_stats(void)
+{
+	ztest_test_skip();
+}
+
+static void test_lane_set(void)
+{
+	ztest_test_skip();
+}
+
+#endif /* defined(CONFIG_NRF_RPC_THREAD_POOL_LANES) */
+
+void test_main(void)
+{
+	zassert_equal(nrf_rpc_os_init(work), 0, NULL);
+
+#if defined(CONFIG_NRF_RPC_THREAD_POOL_LANES)
+	zassert_equal(nrf_rpc_os_lane_set(GROUP_URGENT, NRF_RPC_OS_LANE_HIGH),
+		      0, NULL);
+	zassert_equal(nrf_rpc_os_lane_set(GROUP_SLOW, NRF_RPC_OS_LANE_LOW),
+		      0, NULL);
+#endif
+
+	ztest_test_suite(nrf_rpc_thread_pool,
+			 ztest_unit_test(test_head_of_line),
+			 ztest_unit_test(test_lane_stats),
+			 ztest_unit_test(test_lane_set));
+	ztest_run_test_suite(nrf_rpc_thread_pool);
+}
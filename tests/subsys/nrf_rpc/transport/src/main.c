@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <limits.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <sys/byteorder.h>
+
+#include "nrf_rpc.h"
+#include "nrf_rpc_rpmsg.h"
+
+#define ROUNDS 1000
+#define SENDERS 4
+#define BURST 250
+#define PACKET_LEN 32
+#define PACKET_LEN_MIN 8
+#define PACKET_LEN_MAX 64
+#define HDR_LEN 5
+#define RX_TIMEOUT K_MSEC(100)
+
+#define SENDER_STACK_SIZE 2048
+#define SENDER_PRIORITY 5
+
+static uint32_t rx_seq[SENDERS];
+static struct k_sem rx_sem[SENDERS];
+
+static void receive_handler(const uint8_t *packet, size_t len)
+{
+	uint8_t sender = packet[0];
+	uint32_t seq = sys_get_le32(packet + 1);
+
+	zassert_true(len >= HDR_LEN, NULL);
+	zassert_true(sender < SENDERS, NULL);
+	zassert_equal(seq, rx_seq[sender],
+		      "Packet %u of sender %u out of order", seq, sender);
+
+	for (size_t i = HDR_LEN; i < len; i++) {
+		zassert_equal(packet[i], (uint8_t)(seq + i),
+			      "Packet corrupted");
+	}
+
+	rx_seq[sender]++;
+	k_sem_give(&rx_sem[sender]);
+}
+
+static void packet_send(uint8_t sender, uint32_t seq, size_t len)
+{
+	uint8_t *buf;
+
+	nrf_rpc_tr_alloc_tx_buf(&buf, len);
+	zassert_not_null(buf, NULL);
+
+	/* Serialized in place, in the rpmsg buffer with zero-copy. */
+	buf[0] = sender;
+	sys_put_le32(seq, buf + 1);
+	for (size_t i = HDR_LEN; i < len; i++) {
+		buf[i] = seq + i;
+	}
+
+	zassert_equal(nrf_rpc_tr_send(buf, len), 0, NULL);
+}
+
+static void print_stats(uint32_t packets)
+{
+#if defined(CONFIG_NRF_RPC_TR_RPMSG_NOCOPY)
+	static struct nrf_rpc_tr_stats prev;
+	struct nrf_rpc_tr_stats stats;
+
+	nrf_rpc_tr_stats_get(&stats);
+
+	zassert_equal(stats.packets - prev.packets, packets, NULL);
+	TC_PRINT("%u packets in %u frames\n", packets,
+		 stats.frames - prev.frames);
+
+	prev = stats;
+#endif
+}
+
+static void setup(void)
+{
+	for (size_t i = 0; i < SENDERS; i++) {
+		rx_seq[i] = 0;
+		k_sem_init(&rx_sem[i], 0, UINT_MAX);
+	}
+}
+
+static void test_transport_round_trip(void)
+{
+	uint32_t max_us = 0;
+	uint64_t total_us = 0;
+	uint32_t start;
+	uint32_t us;
+
+	for (uint32_t i = 0; i < ROUNDS; i++) {
+		start = k_cycle_get_32();
+
+		packet_send(0, i, PACKET_LEN);
+		zassert_equal(k_sem_take(&rx_sem[0], RX_TIMEOUT), 0,
+			      "Packet %u not received", i);
+
+		us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+		max_us = MAX(max_us, us);
+		total_us += us;
+	}
+
+	TC_PRINT("Round trip: avg %u us, max %u us, %u calls/s\n",
+		 (uint32_t)(total_us / ROUNDS), max_us,
+		 (uint32_t)(ROUNDS * 1000000ULL / MAX(total_us, 1)));
+	print_stats(ROUNDS);
+}
+
+static K_THREAD_STACK_ARRAY_DEFINE(sender_stacks, SENDERS, SENDER_STACK_SIZE);
+static struct k_thread sender_threads[SENDERS];
+
+static void sender_thread(void *p1, void *p2, void *p3)
+{
+	uint8_t sender = (uintptr_t)p1;
+	uint32_t rand_state = sender + 1;
+	size_t len;
+
+	for (uint32_t i = 0; i < BURST; i++) {
+		rand_state = rand_state * 1103515245 + 12345;
+		len = PACKET_LEN_MIN +
+		      (rand_state >> 16) % (PACKET_LEN_MAX - PACKET_LEN_MIN);
+
+		packet_send(sender, i, len);
+	}
+}
+
+static void test_transport_burst(void)
+{
+	uint32_t start = k_cycle_get_32();
+	uint32_t us;
+
+	for (uintptr_t i = 0; i < SENDERS; i++) {
+		k_thread_create(&sender_threads[i], sender_stacks[i],
+				K_THREAD_STACK_SIZEOF(sender_stacks[i]),
+				sender_thread, (void *)i, NULL, NULL,
+				SENDER_PRIORITY, 0, K_NO_WAIT);
+	}
+
+	for (size_t i = 0; i < SENDERS; i++) {
+		for (size_t j = 0; j < BURST; j++) {
+			zassert_equal(k_sem_take(&rx_sem[i], RX_TIMEOUT), 0,
+				      "Packet %u of sender %u not received",
+				      j, i);
+		}
+	}
+
+	us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+	TC_PRINT("Burst of %u packets from %u threads: %u us, %u calls/s\n",
+		 SENDERS * BURST, SENDERS, us,
+		 (uint32_t)(SENDERS * BURST * 1000000ULL / MAX(us, 1)));
+	print_stats(SENDERS * BURST);
+}
+
+static void test_transport_drop(void)
+{
+#if defined(CONFIG_NRF_RPC_TR_RPMSG_NOCOPY)
+	struct nrf_rpc_tr_stats before;
+	struct nrf_rpc_tr_stats after;
+	uint8_t *buf;
+
+	nrf_rpc_tr_stats_get(&before);
+
+	/* Buffers that are not sent leave padding in the frame. */
+	nrf_rpc_tr_alloc_tx_buf(&buf, PACKET_LEN);
+	zassert_not_null(buf, NULL);
+	nrf_rpc_tr_free_tx_buf(buf);
+
+	packet_send(0, 0, PACKET_LEN);
+	zassert_equal(k_sem_take(&rx_sem[0], RX_TIMEOUT), 0, NULL);
+
+	/* Packets that do not fit in an rpmsg buffer are refused. */
+	nrf_rpc_tr_alloc_tx_buf(&buf, 1024);
+	zassert_is_null(buf, NULL);
+
+	packet_send(0, 1, PACKET_LEN);
+	zassert_equal(k_sem_take(&rx_sem[0], RX_TIMEOUT), 0, NULL);
+
+	nrf_rpc_tr_stats_get(&after);
+	zassert_equal(after.dropped - before.dropped, 1, NULL);
+	zassert_equal(after.packets - before.packets, 2, NULL);
+#else
+	ztest_test_skip();
+#endif
+}
+
+void test_main(void)
+{
+	zassert_equal(nrf_rpc_tr_init(receive_handler), 0, NULL);
+
+	ztest_test_suite(nrf_rpc_transport,
+			 ztest_unit_test_setup_teardown(
+				test_transport_round_trip, setup,
+				unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_transport_burst,
+							setup, unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_transport_drop,
+							setup, unit_test_noop));
+	ztest_run_test_suite(nrf_rpc_transport);
+}
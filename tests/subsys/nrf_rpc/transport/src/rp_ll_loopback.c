@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <zephyr.h>
+
+#include "rp_ll.h"
+
+/* Loopback stand-in for the rpmsg layer. Frames sent by the transport are
+ * received by the same transport from a thread that plays the remote core.
+ *
+ * Time only advances on native_posix where it is spent explicitly, so the
+ * cost of the rpmsg operations is modeled with busy waits.
+ */
+
+/* Payload of a 512 byte rpmsg buffer. */
+#define FRAME_SIZE 496
+/* Number of buffers in a vring. */
+#define FRAME_COUNT 16
+/* Time to pass a frame to the other core: the virtqueue update, the IPM
+ * notification and the receive work queue.
+ */
+#define FRAME_COST_US 20
+/* Bytes copied into shared memory per microsecond. */
+#define COPY_BYTES_PER_US 32
+
+#define RX_STACK_SIZE 2048
+#define RX_PRIORITY -1
+
+struct frame_msg {
+	uint8_t *buf;
+	size_t len;
+};
+
+K_MEM_SLAB_DEFINE(frame_slab, FRAME_SIZE, FRAME_COUNT, 4);
+K_MSGQ_DEFINE(frame_queue, sizeof(struct frame_msg), FRAME_COUNT, 4);
+
+static struct rp_ll_endpoint *remote_ep;
+
+static void rx_thread(void *p1, void *p2, void *p3)
+{
+	struct frame_msg msg;
+
+	while (1) {
+		k_msgq_get(&frame_queue, &msg, K_FOREVER);
+
+		if (remote_ep != NULL && msg.len > 0) {
+			remote_ep->callback(remote_ep, RP_LL_EVENT_DATA,
+					    msg.buf, msg.len);
+		}
+
+		k_mem_slab_free(&frame_slab, (void **)&msg.buf);
+	}
+}
+
+K_THREAD_DEFINE(rx_thread_id, RX_STACK_SIZE, rx_thread, NULL, NULL, NULL,
+		RX_PRIORITY, 0, 0);
+
+int rp_ll_init(void)
+{
+	return 0;
+}
+
+void rp_ll_uninit(void)
+{
+}
+
+int rp_ll_endpoint_init(struct rp_ll_endpoint *endpoint,
+	int endpoint_number, rp_ll_event_handler callback, void *user_data)
+{
+	endpoint->callback = callback;
+	remote_ep = endpoint;
+
+	callback(endpoint, RP_LL_EVENT_CONNECTED, NULL, 0);
+
+	return 0;
+}
+
+void rp_ll_endpoint_uninit(struct rp_ll_endpoint *endpoint)
+{
+	remote_ep = NULL;
+}
+
+uint8_t *rp_ll_tx_buf_get(struct rp_ll_endpoint *endpoint, size_t *size)
+{
+	uint8_t *buf;
+
+	if (k_mem_slab_alloc(&frame_slab, (void **)&buf, K_FOREVER)) {
+		*size = 0;
+		return NULL;
+	}
+
+	*size = FRAME_SIZE;
+
+	return buf;
+}
+
+int rp_ll_send_nocopy(struct rp_ll_endpoint *endpoint, uint8_t *buf,
+		      size_t buf_len)
+{
+	struct frame_msg msg = {
+		.buf = buf,
+		.len = buf_len,
+	};
+
+	k_busy_wait(FRAME_COST_US);
+
+	return k_msgq_put(&frame_queue, &msg, K_FOREVER);
+}
+
+int rp_ll_send(struct rp_ll_endpoint *endpoint, const uint8_t *buf,
+	       size_t buf_len)
+{
+	size_t size;
+	uint8_t *frame;
+
+	if (buf_len > FRAME_SIZE) {
+		return RPMSG_ERR_BUFF_SIZE;
+	}
+
+	/* rpmsg_send() gets a buffer and copies the packet into it. */
+	frame = rp_ll_tx_buf_get(endpoint, &size);
+	memcpy(frame, buf, buf_len);
+	k_busy_wait(buf_len / COPY_BYTES_PER_US);
+
+	return rp_ll_send_nocopy(endpoint, frame, buf_len);
+}
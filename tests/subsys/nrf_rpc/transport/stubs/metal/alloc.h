@@ -0,0 +1,10 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Empty stand-in for the libmetal header. */
+#ifndef METAL_ALLOC_STUB_H_
+#define METAL_ALLOC_STUB_H_
+#endif /* METAL_ALLOC_STUB_H_ */
@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) 2020 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Stand-in for the nRF RPC core header, with what the transport uses. */
+#ifndef NRF_RPC_STUB_H_
+#define NRF_RPC_STUB_H_
+
+#include <zephyr.h>
+#include <errno.h>
+
+#include "nrf_rpc_rpmsg.h"
+
+#define NRF_EIO EIO
+#define NRF_ENOMEM ENOMEM
+#define NRF_EINVAL EINVAL
+
+#define NRF_RPC_ASSERT(_expr) __ASSERT_NO_MSG(_expr)
+
+#endif /* NRF_RPC_STUB_H_ */